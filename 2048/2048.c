@@ -2,10 +2,15 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdio.h>
+#include <string.h>
+#include "board.h"
+#include "ai.h"
+#include "ntuple.h"
 
 #define GRID_SIZE 4
 #define WINDOW_WIDTH 400
 #define WINDOW_HEIGHT 400 
+#define AUTOPLAY_TIMER 1
 
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 void DrawGrid(HDC hdc);
@@ -14,13 +19,23 @@ void InitializeGame(void);
 void AddRandomTile(void);
 void MoveTiles(int);
 BOOL GameOver(void);
+void UpdateTitle(HWND hwnd, BOOL autoplay);
+BOOL SaveGame(void);
 COLORREF GetTileColor(int);
 COLORREF GetTileFontColor(int);
 
-int grid[GRID_SIZE][GRID_SIZE] = {0};
+Board board = 0;  // 4-bit tile exponents, see board.h
 HINSTANCE hInst;
 char szAppName[] = "2048";
 HFONT hFont;
+AI *ai = NULL;  // Created the first time autoplay starts
+NTuple *net = NULL;  // Weights ntrain learned, autoplay uses them instead of ai
+
+// A game is its seed and its moves, the tiles follow from them
+unsigned long gameSeed;
+unsigned long tileState;
+char *moveLog = NULL;  // LRUD, one letter per move
+long numMoves = 0, moveLogSize = 0;
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nCmdShow)
 {
@@ -53,8 +68,30 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine,
     ShowWindow(hwnd, nCmdShow);
     UpdateWindow(hwnd);
 
-    srand((unsigned int)time(NULL));
+    // A seed on the command line plays that game again
+    gameSeed = strtoul(lpCmdLine, NULL, 10);
+    if (gameSeed == 0)
+        gameSeed = ((unsigned long)time(NULL) * 2654435761UL) & 0xFFFFFFFFUL;
+    if (gameSeed == 0)
+        gameSeed = 1;
+
+    InitBoardTables();
+
+    // The network lives next to the program, whatever the working directory
+    {
+        char path[MAX_PATH];
+        char *slash;
+        DWORD len = GetModuleFileName(NULL, path, MAX_PATH - 8);
+
+        slash = strrchr(path, '\\');
+        if (len > 0 && len < MAX_PATH - 8 && slash != NULL)
+        {
+            strcpy(slash + 1, "2048.ntw");
+            net = LoadNTuple(path, 0);
+        }
+    }
     InitializeGame();
+    UpdateTitle(hwnd, FALSE);
 
     hFont = CreateFont(WINDOW_HEIGHT / (GRID_SIZE * 3), 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
                        ANSI_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
@@ -69,6 +106,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine,
     }
 
     DeleteObject(hFont);
+    FreeAI(ai);
+    FreeNTuple(net);
+    free(moveLog);
     return msg.wParam;
 }
 
@@ -127,6 +167,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
     HDC hdc;
     PAINTSTRUCT ps;
     static BOOL showColorReference = FALSE;
+    static BOOL autoplay = FALSE;
+    int move;
 
     switch (message)
     {
@@ -158,12 +200,49 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             // Toggle color reference display
             showColorReference = !showColorReference;
             break;
+        case 'A':
+            // Toggle autoplay, a move per timer tick chosen by the
+            // network if 2048.ntw was found, else by the AI searching
+            if (autoplay)
+            {
+                KillTimer(hwnd, AUTOPLAY_TIMER);
+                autoplay = FALSE;
+            }
+            else
+            {
+                if (!net && !ai)
+                    ai = CreateAI(NULL);
+                if ((net || ai) && SetTimer(hwnd, AUTOPLAY_TIMER, 10, NULL))
+                    autoplay = TRUE;
+            }
+            UpdateTitle(hwnd, autoplay);
+            break;
+        case 'S':
+            // Save the seed and moves, replay plays them back
+            if (!SaveGame())
+                MessageBox(hwnd, "Cannot save the game", "2048", MB_OK);
+            break;
         }
         InvalidateRect(hwnd, NULL, TRUE);
         if (!showColorReference && GameOver())
             MessageBox(hwnd, "Game Over!", "2048", MB_OK);
         return 0;
 
+    case WM_TIMER:
+        move = net ? NTupleBestMove(net, board) : AIBestMove(ai, board);
+        if (move >= 0)
+            MoveTiles(move);
+        InvalidateRect(hwnd, NULL, TRUE);
+        if (GameOver())
+        {
+            KillTimer(hwnd, AUTOPLAY_TIMER);
+            autoplay = FALSE;
+            UpdateTitle(hwnd, autoplay);
+            if (!showColorReference)
+                MessageBox(hwnd, "Game Over!", "2048", MB_OK);
+        }
+        return 0;
+
     case WM_DESTROY:
         PostQuitMessage(0);
         return 0;
@@ -194,7 +273,7 @@ void DrawGrid(HDC hdc)
             rect.right = (j + 1) * WINDOW_WIDTH / GRID_SIZE;
             rect.bottom = (i + 1) * WINDOW_HEIGHT / GRID_SIZE;
 
-            hBrush = CreateSolidBrush(GetTileColor(grid[i][j]));
+            hBrush = CreateSolidBrush(GetTileColor(BOARD_VALUE(board, i * GRID_SIZE + j)));
             hOldBrush = SelectObject(hdc, hBrush);
             
             FillRect(hdc, &rect, hBrush);
@@ -205,11 +284,11 @@ void DrawGrid(HDC hdc)
             SelectObject(hdc, hOldBrush);
             DeleteObject(hBrush);
 
-            if (grid[i][j] != 0)
+            if (BOARD_CELL(board, i * GRID_SIZE + j) != 0)
             {
-                sprintf(str, "%d", grid[i][j]);
+                sprintf(str, "%d", BOARD_VALUE(board, i * GRID_SIZE + j));
                 SetBkMode(hdc, TRANSPARENT);
-                SetTextColor(hdc, GetTileFontColor(grid[i][j]));
+                SetTextColor(hdc, GetTileFontColor(BOARD_VALUE(board, i * GRID_SIZE + j)));
                 DrawText(hdc, str, -1, &rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
             }
         }
@@ -222,182 +301,79 @@ void DrawGrid(HDC hdc)
 
 void InitializeGame(void)
 {
-    int i, j;
-
-    for (i = 0; i < GRID_SIZE; i++)
-        for (j = 0; j < GRID_SIZE; j++)
-            grid[i][j] = 0;
+    board = 0;
+    tileState = gameSeed;
+    numMoves = 0;
 
     AddRandomTile();
     AddRandomTile();
 }
 
+// An empty cell picked straight from the board's empty mask, never loops
 void AddRandomTile(void)
 {
-    int i, j;
-
-    do
-    {
-        i = rand() % GRID_SIZE;
-        j = rand() % GRID_SIZE;
-    } while (grid[i][j] != 0);
-
-    grid[i][j] = (rand() % 2 + 1) * 2;
+    board = BoardAddTile(board, &tileState);
 }
 
-void MoveTiles(int direction)
+// Keep a move for SaveGame, the game plays on if there is no memory
+static void LogMove(int direction)
 {
-    int i, j, k;
-    BOOL moved = FALSE;
-    BOOL merged[GRID_SIZE][GRID_SIZE] = {FALSE};  // Track which tiles were merged this move
+    char *grown;
 
-    switch (direction)
+    if (numMoves == moveLogSize)
     {
-    case 0: // Left
-        for (i = 0; i < GRID_SIZE; i++)
-        {
-            k = 0;
-            for (j = 0; j < GRID_SIZE; j++)
-            {
-                if (grid[i][j] != 0)
-                {
-                    if (k > 0 && grid[i][k - 1] == grid[i][j] && !merged[i][k - 1])
-                    {
-                        grid[i][k - 1] *= 2;
-                        grid[i][j] = 0;
-                        merged[i][k - 1] = TRUE;  // Mark as merged
-                        moved = TRUE;
-                    }
-                    else
-                    {
-                        if (k != j)
-                        {
-                            grid[i][k] = grid[i][j];
-                            grid[i][j] = 0;
-                            moved = TRUE;
-                        }
-                        k++;
-                    }
-                }
-            }
-        }
-        break;
-
-    case 1: // Right
-        for (i = 0; i < GRID_SIZE; i++)
-        {
-            k = GRID_SIZE - 1;
-            for (j = GRID_SIZE - 1; j >= 0; j--)
-            {
-                if (grid[i][j] != 0)
-                {
-                    if (k < GRID_SIZE - 1 && grid[i][k + 1] == grid[i][j] && !merged[i][k + 1])
-                    {
-                        grid[i][k + 1] *= 2;
-                        grid[i][j] = 0;
-                        merged[i][k + 1] = TRUE;  // Mark as merged
-                        moved = TRUE;
-                    }
-                    else
-                    {
-                        if (k != j)
-                        {
-                            grid[i][k] = grid[i][j];
-                            grid[i][j] = 0;
-                            moved = TRUE;
-                        }
-                        k--;
-                    }
-                }
-            }
-        }
-        break;
-
-    case 2: // Up
-        for (j = 0; j < GRID_SIZE; j++)
-        {
-            k = 0;
-            for (i = 0; i < GRID_SIZE; i++)
-            {
-                if (grid[i][j] != 0)
-                {
-                    if (k > 0 && grid[k - 1][j] == grid[i][j] && !merged[k - 1][j])
-                    {
-                        grid[k - 1][j] *= 2;
-                        grid[i][j] = 0;
-                        merged[k - 1][j] = TRUE;  // Mark as merged
-                        moved = TRUE;
-                    }
-                    else
-                    {
-                        if (k != i)
-                        {
-                            grid[k][j] = grid[i][j];
-                            grid[i][j] = 0;
-                            moved = TRUE;
-                        }
-                        k++;
-                    }
-                }
-            }
-        }
-        break;
-
-    case 3: // Down
-        for (j = 0; j < GRID_SIZE; j++)
-        {
-            k = GRID_SIZE - 1;
-            for (i = GRID_SIZE - 1; i >= 0; i--)
-            {
-                if (grid[i][j] != 0)
-                {
-                    if (k < GRID_SIZE - 1 && grid[k + 1][j] == grid[i][j] && !merged[k + 1][j])
-                    {
-                        grid[k + 1][j] *= 2;
-                        grid[i][j] = 0;
-                        merged[k + 1][j] = TRUE;  // Mark as merged
-                        moved = TRUE;
-                    }
-                    else
-                    {
-                        if (k != i)
-                        {
-                            grid[k][j] = grid[i][j];
-                            grid[i][j] = 0;
-                            moved = TRUE;
-                        }
-                        k--;
-                    }
-                }
-            }
-        }
-        break;
+        grown = (char *)realloc(moveLog, moveLogSize ? moveLogSize * 2 : 1024);
+        if (!grown)
+            return;
+        moveLog = grown;
+        moveLogSize = moveLogSize ? moveLogSize * 2 : 1024;
     }
+    moveLog[numMoves++] = "LRUD"[direction];
+}
 
-    if (moved)
-        AddRandomTile();
+// Writes 2048-<seed>.txt: the seed on one line, the moves on the next
+BOOL SaveGame(void)
+{
+    char name[32];
+    FILE *f;
+
+    sprintf(name, "2048-%lu.txt", gameSeed);
+    f = fopen(name, "w");
+    if (!f)
+        return FALSE;
+    fprintf(f, "%lu\n", gameSeed);
+    if (numMoves)
+        fwrite(moveLog, 1, numMoves, f);
+    fprintf(f, "\n");
+    return fclose(f) == 0;
 }
 
-BOOL GameOver(void)
+void UpdateTitle(HWND hwnd, BOOL autoplay)
 {
-    int i, j;
+    char title[64];
 
-    for (i = 0; i < GRID_SIZE; i++)
-    {
-        for (j = 0; j < GRID_SIZE; j++)
-        {
-            if (grid[i][j] == 0)
-                return FALSE;
+    sprintf(title, "2048 - seed %lu%s", gameSeed,
+            !autoplay ? "" : net ? " - autoplay (n-tuple)" : " - autoplay");
+    SetWindowText(hwnd, title);
+}
 
-            if (i < GRID_SIZE - 1 && grid[i][j] == grid[i + 1][j])
-                return FALSE;
+// Slide every row or column through the row tables in board.c, a tile
+// made by a merge does not merge again the same move
+void MoveTiles(int direction)
+{
+    Board next = BoardMove(board, direction);
 
-            if (j < GRID_SIZE - 1 && grid[i][j] == grid[i][j + 1])
-                return FALSE;
-        }
+    if (next != board)
+    {
+        board = next;
+        LogMove(direction);
+        AddRandomTile();
     }
+}
 
-    return TRUE;
+BOOL GameOver(void)
+{
+    return !BoardCanMove(board);
 }
 
 COLORREF GetTileColor(int value)
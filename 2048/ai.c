@@ -0,0 +1,329 @@
+/* 2048 player
+   The player's moves are max nodes, the tile added after each is a
+   chance node over every empty cell and both values at the odds
+   AddRandomTile uses. The search stops at the depth limit or once the
+   tiles leading to a position are unlikely enough, and scores it by
+   tables of row features: empty cells, tiles ready to merge, rows that
+   rise one way and large tiles. Chance nodes are kept in a table shared
+   by the threads searching the root moves, written without locks. An
+   entry is four 32-bit words, each stored whole even on the 32-bit
+   machines, and each half of the key is kept XOR the value and depth:
+   an entry torn by two threads writing at once reads as a miss unless
+   the words of the two happen to agree, about one chance in 2^32
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ai.h"
+#include "../sokoban/thread.h"
+
+#define AI_DEPTH 4
+#define AI_MIN_PROBABILITY 0.0001
+#define AI_CACHE_MB 16
+
+/* Heuristic weights per row or column */
+#define SCORE_BASE      200000.0f
+#define SCORE_EMPTY     270.0f
+#define SCORE_MERGE     700.0f
+#define SCORE_MONOTONIC 47.0f
+#define SCORE_SUM       11.0f
+
+typedef struct {
+    unsigned int keyLow;    /* Low half of the key XOR value XOR depth */
+    unsigned int keyHigh;   /* High half of the key XOR value XOR depth */
+    unsigned int value;     /* Float bits */
+    unsigned int depth;     /* Depth left */
+} CacheEntry;
+
+struct AI {
+    AIOptions options;
+    CacheEntry *cache;
+    unsigned long cacheMask;
+    long moves;
+    double nodes, cacheHits;
+};
+
+/* One root move searched on its own thread */
+typedef struct {
+    AI *ai;
+    Board board;            /* After the move */
+    double score;
+    long nodes, cacheHits;
+    Thread thread;
+} RootSearch;
+
+static float rowScore[65536];
+static int rowScoreBuilt = 0;
+
+static void InitRowScores(void)
+{
+    int row, i, rank[4], empty, merges, prev, counter;
+    float sum, left, right, a, b;
+
+    if (rowScoreBuilt)
+        return;
+
+    for (row = 0; row < 65536; row++)
+    {
+        for (i = 0; i < 4; i++)
+            rank[i] = (row >> (i * 4)) & 0xF;
+
+        /* Runs of equal tiles, gaps between them ignored */
+        sum = 0.0f;
+        empty = merges = prev = counter = 0;
+        for (i = 0; i < 4; i++)
+        {
+            sum += (float)pow(rank[i], 3.5);
+            if (rank[i] == 0)
+            {
+                empty++;
+            }
+            else
+            {
+                if (prev == rank[i])
+                {
+                    counter++;
+                }
+                else if (counter > 0)
+                {
+                    merges += 1 + counter;
+                    counter = 0;
+                }
+                prev = rank[i];
+            }
+        }
+        if (counter > 0)
+            merges += 1 + counter;
+
+        /* How far the row is from rising steadily one way */
+        left = right = 0.0f;
+        for (i = 1; i < 4; i++)
+        {
+            a = (float)pow(rank[i - 1], 4);
+            b = (float)pow(rank[i], 4);
+            if (rank[i - 1] > rank[i])
+                left += a - b;
+            else
+                right += b - a;
+        }
+
+        rowScore[row] = SCORE_BASE + SCORE_EMPTY * empty + SCORE_MERGE * merges -
+                        SCORE_MONOTONIC * (left < right ? left : right) - SCORE_SUM * sum;
+    }
+    rowScoreBuilt = 1;
+}
+
+static double Heuristic(Board b)
+{
+    Board t = BoardTranspose(b);
+
+    return rowScore[BOARD_ROW(b, 0)] + rowScore[BOARD_ROW(b, 1)] +
+           rowScore[BOARD_ROW(b, 2)] + rowScore[BOARD_ROW(b, 3)] +
+           rowScore[BOARD_ROW(t, 0)] + rowScore[BOARD_ROW(t, 1)] +
+           rowScore[BOARD_ROW(t, 2)] + rowScore[BOARD_ROW(t, 3)];
+}
+
+static CacheEntry *CacheSlot(AI *ai, Board b)
+{
+    Board h = b * (((Board)0x9E3779B9UL << 32) | 0x7F4A7C15UL);
+
+    return &ai->cache[(unsigned long)(h >> 32) & ai->cacheMask];
+}
+
+/* Score of b searched at least depth deep, 0 if there is none */
+static int CacheFind(AI *ai, Board b, int depth, double *score)
+{
+    CacheEntry *e = CacheSlot(ai, b);
+    unsigned int bits = e->value, left = e->depth;
+    float value;
+
+    if ((e->keyLow ^ bits ^ left) != (unsigned int)(b & 0xFFFFFFFFUL) ||
+        (e->keyHigh ^ bits ^ left) != (unsigned int)(b >> 32) || (int)left < depth)
+        return 0;
+    memcpy(&value, &bits, sizeof(float));
+    *score = value;
+    return 1;
+}
+
+static void CacheStore(AI *ai, Board b, int depth, double score)
+{
+    CacheEntry *e = CacheSlot(ai, b);
+    float value = (float)score;
+    unsigned int bits;
+
+    memcpy(&bits, &value, sizeof(float));
+    e->keyLow = (unsigned int)(b & 0xFFFFFFFFUL) ^ bits ^ (unsigned int)depth;
+    e->keyHigh = (unsigned int)(b >> 32) ^ bits ^ (unsigned int)depth;
+    e->value = bits;
+    e->depth = (unsigned int)depth;
+}
+
+static double ChanceNode(RootSearch *r, Board b, double probability, int depth);
+
+/* The best move from b, 0 if none moves */
+static double MoveNode(RootSearch *r, Board b, double probability, int depth)
+{
+    double best = 0.0, score;
+    Board next;
+    int d;
+
+    r->nodes++;
+    for (d = 0; d < 4; d++)
+    {
+        next = BoardMove(b, d);
+        if (next == b)
+            continue;
+        score = ChanceNode(r, next, probability, depth - 1);
+        if (score > best)
+            best = score;
+    }
+    return best;
+}
+
+/* Every tile that can be added to b, weighted by its odds. A move always
+   leaves an empty cell */
+static double ChanceNode(RootSearch *r, Board b, double probability, int depth)
+{
+    const double four = 1.0 / SPAWN_FOUR_IN, two = 1.0 - four;
+    double score = 0.0;
+    int c, empty = 0;
+
+    if (depth <= 0 || probability < r->ai->options.minProbability)
+    {
+        r->nodes++;
+        return Heuristic(b);
+    }
+    if (CacheFind(r->ai, b, depth, &score))
+    {
+        r->cacheHits++;
+        return score;
+    }
+
+    for (c = 0; c < BOARD_CELLS; c++)
+        empty += BOARD_CELL(b, c) == 0;
+    if (empty == 0)
+        return Heuristic(b);
+    probability /= empty;
+
+    for (c = 0; c < BOARD_CELLS; c++)
+    {
+        if (BOARD_CELL(b, c) != 0)
+            continue;
+        score += two * MoveNode(r, BOARD_SET(b, c, 1), probability * two, depth);
+        score += four * MoveNode(r, BOARD_SET(b, c, 2), probability * four, depth);
+    }
+    score /= empty;
+
+    CacheStore(r->ai, b, depth, score);
+    return score;
+}
+
+static void SearchRoot(void *arg)
+{
+    RootSearch *r = (RootSearch *)arg;
+
+    r->score = ChanceNode(r, r->board, 1.0, r->ai->options.depth - 1);
+}
+
+void InitAIOptions(AIOptions *options)
+{
+    options->depth = AI_DEPTH;
+    options->minProbability = AI_MIN_PROBABILITY;
+    options->cacheMegabytes = AI_CACHE_MB;
+    options->threads = CountProcessors();
+}
+
+AI *CreateAI(const AIOptions *options)
+{
+    AI *ai = (AI *)calloc(1, sizeof(AI));
+    unsigned long entries = 1;
+
+    if (!ai)
+        return NULL;
+    if (options)
+        ai->options = *options;
+    else
+        InitAIOptions(&ai->options);
+    if (ai->options.depth < 1)
+        ai->options.depth = 1;
+    if (ai->options.threads < 1)
+        ai->options.threads = 1;
+
+    /* Largest power of two that fits */
+    while (entries * 2 * sizeof(CacheEntry) <= (unsigned long)ai->options.cacheMegabytes << 20)
+        entries *= 2;
+    ai->cache = (CacheEntry *)calloc(entries, sizeof(CacheEntry));
+    if (!ai->cache)
+    {
+        free(ai);
+        return NULL;
+    }
+    ai->cacheMask = entries - 1;
+
+    InitBoardTables();
+    InitRowScores();
+    return ai;
+}
+
+void FreeAI(AI *ai)
+{
+    if (!ai)
+        return;
+    free(ai->cache);
+    free(ai);
+}
+
+/* Root moves in batches of options.threads, the first of each batch on
+   the calling thread */
+int AIBestMove(AI *ai, Board b)
+{
+    RootSearch root[4];
+    int move[4], started[4];
+    int d, n = 0, i, j, end, best = -1;
+    Board next;
+
+    for (d = 0; d < 4; d++)
+    {
+        next = BoardMove(b, d);
+        if (next == b)
+            continue;
+        memset(&root[n], 0, sizeof(RootSearch));
+        root[n].ai = ai;
+        root[n].board = next;
+        move[n++] = d;
+    }
+    if (n == 0)
+        return -1;
+
+    for (i = 0; i < n; i = end)
+    {
+        end = i + ai->options.threads < n ? i + ai->options.threads : n;
+        for (j = i + 1; j < end; j++)
+            started[j] = StartThread(&root[j].thread, SearchRoot, &root[j]);
+        SearchRoot(&root[i]);
+        for (j = i + 1; j < end; j++)
+        {
+            if (started[j])
+                JoinThread(&root[j].thread);
+            else
+                SearchRoot(&root[j]);
+        }
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (best < 0 || root[i].score > root[best].score)
+            best = i;
+        ai->nodes += root[i].nodes;
+        ai->cacheHits += root[i].cacheHits;
+    }
+    ai->moves++;
+    return move[best];
+}
+
+void AIGetCounters(AI *ai, AICounters *counters)
+{
+    counters->moves = ai->moves;
+    counters->nodes = ai->nodes;
+    counters->cacheHits = ai->cacheHits;
+}
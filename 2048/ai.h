@@ -0,0 +1,38 @@
+/* 2048 player
+   Depth-limited expectimax over the moves and the tiles AddRandomTile
+   can add, with a table of scored positions its threads share
+   Public Domain          */
+#ifndef AI_H
+#define AI_H
+
+#include "board.h"
+
+typedef struct {
+    int depth;              /* Moves to look ahead, the first one included */
+    double minProbability;  /* Tile sequences less likely than this are scored as they stand */
+    int cacheMegabytes;     /* Table of scored positions */
+    int threads;            /* Root moves searched at once, at most four */
+} AIOptions;
+
+typedef struct {
+    long moves;             /* Moves chosen */
+    double nodes;           /* Positions scored by looking ahead or by the heuristic */
+    double cacheHits;
+} AICounters;
+
+typedef struct AI AI;
+
+/* Fill in the defaults: depth 4, one thread per processor */
+void InitAIOptions(AIOptions *options);
+
+/* Also builds the row tables, NULL if out of memory. options may be NULL */
+AI *CreateAI(const AIOptions *options);
+void FreeAI(AI *ai);
+
+/* The move to make on b, as MoveTiles numbers them, -1 if none moves.
+   One caller at a time, it starts and joins its own threads */
+int AIBestMove(AI *ai, Board b);
+
+void AIGetCounters(AI *ai, AICounters *counters);
+
+#endif /* AI_H */
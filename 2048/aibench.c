@@ -0,0 +1,104 @@
+/* 2048 player bench
+   Plays whole games with the expectimax player, adding tiles at the
+   odds AddRandomTile uses, and reports moves per second and how many
+   games reached 2048, 4096 and 8192
+   Usage: aibench [-n games] [-d depth] [-p probability] [-m cachemb] [-j threads] [-s seed] [-q]
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ai.h"
+#include "../sokoban/thread.h"
+
+static int MaxExponent(Board b)
+{
+    int c, top = 0;
+
+    for (c = 0; c < BOARD_CELLS; c++)
+    {
+        if (BOARD_CELL(b, c) > top)
+            top = BOARD_CELL(b, c);
+    }
+    return top;
+}
+
+int main(int argc, char *argv[])
+{
+    AIOptions options;
+    AICounters counters;
+    AI *ai;
+    Board b;
+    unsigned long seed = 1;
+    long moves, totalMoves = 0;
+    int games = 10, quiet = 0, g, i, move, top, reached[3] = {0, 0, 0};
+    double start, seconds, total = 0.0;
+
+    InitAIOptions(&options);
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            games = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            options.depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            options.minProbability = atof(argv[++i]);
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+            options.cacheMegabytes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            options.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            seed = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-q") == 0)
+            quiet = 1;
+        else
+            break;
+    }
+    if (i < argc || games < 1)
+    {
+        printf("Usage: aibench [-n games] [-d depth] [-p probability] [-m cachemb] [-j threads] [-s seed] [-q]\n");
+        return 1;
+    }
+    if (seed == 0)
+        seed = 1;
+
+    ai = CreateAI(&options);
+    if (!ai)
+    {
+        printf("out of memory\n");
+        return 2;
+    }
+
+    for (g = 0; g < games; g++)
+    {
+        b = BoardAddTile(BoardAddTile(0, &seed), &seed);
+        moves = 0;
+        start = WallSeconds();
+        while ((move = AIBestMove(ai, b)) >= 0)
+        {
+            b = BoardAddTile(BoardMove(b, move), &seed);
+            moves++;
+        }
+        seconds = WallSeconds() - start;
+
+        top = MaxExponent(b);
+        for (i = 0; i < 3; i++)
+            reached[i] += top >= 11 + i;
+        totalMoves += moves;
+        total += seconds;
+        if (!quiet)
+        {
+            printf("game %d: moves=%ld max tile=%d moves/sec=%.0f\n", g + 1, moves, 1 << top,
+                   seconds > 0 ? moves / seconds : 0.0);
+        }
+    }
+
+    AIGetCounters(ai, &counters);
+    printf("games=%d depth=%d threads=%d moves=%ld moves/sec=%.0f nodes/sec=%.0f cache hits=%.1f%%\n",
+           games, options.depth, options.threads, totalMoves, total > 0 ? totalMoves / total : 0.0,
+           total > 0 ? counters.nodes / total : 0.0,
+           counters.nodes ? 100.0 * counters.cacheHits / (counters.nodes + counters.cacheHits) : 0.0);
+    printf("reached 2048=%.0f%% 4096=%.0f%% 8192=%.0f%%\n", 100.0 * reached[0] / games,
+           100.0 * reached[1] / games, 100.0 * reached[2] / games);
+    FreeAI(ai);
+    return 0;
+}
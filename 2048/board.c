@@ -0,0 +1,196 @@
+/* 2048 board
+   Row tables and moves
+   Public Domain          */
+#include "board.h"
+
+/* Every 16-bit row slid left and right, and the points sliding it left scores */
+static unsigned short rowLeft[65536];
+static unsigned short rowRight[65536];
+static long rowPoints[65536];
+
+/* Empty cells of every row as 4 bits, and for every byte of a mask its
+   bits set and where its k-th set bit is */
+static unsigned char rowEmpty[65536];
+static unsigned char bitCount[256];
+static unsigned char selectBit[256][8];
+static int tablesBuilt = 0;
+
+static unsigned ReverseRow(unsigned row)
+{
+    return ((row & 0xF) << 12) | ((row & 0xF0) << 4) | ((row >> 4) & 0xF0) | (row >> 12);
+}
+
+/* One row slid left the way MoveTiles does it: tiles close up and a
+   tile equal to the one before merges unless that one was just made */
+static unsigned SlideLeft(unsigned row, long *points)
+{
+    int tile[4], merged[4] = {0, 0, 0, 0};
+    int j, k = 0, e;
+
+    for (j = 0; j < 4; j++)
+        tile[j] = 0;
+    *points = 0;
+
+    for (j = 0; j < 4; j++)
+    {
+        e = (row >> (j * 4)) & 0xF;
+        if (e == 0)
+            continue;
+        if (k > 0 && tile[k - 1] == e && !merged[k - 1] && e < MAX_EXPONENT)
+        {
+            tile[k - 1]++;
+            merged[k - 1] = 1;
+            *points += 1L << tile[k - 1];
+        }
+        else
+        {
+            tile[k++] = e;
+        }
+    }
+
+    return tile[0] | (tile[1] << 4) | (tile[2] << 8) | (tile[3] << 12);
+}
+
+void InitBoardTables(void)
+{
+    unsigned row;
+    int m, j, k;
+
+    if (tablesBuilt)
+        return;
+
+    for (row = 0; row < 65536; row++)
+        rowLeft[row] = (unsigned short)SlideLeft(row, &rowPoints[row]);
+    for (row = 0; row < 65536; row++)
+        rowRight[row] = (unsigned short)ReverseRow(rowLeft[ReverseRow(row)]);
+    for (row = 0; row < 65536; row++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            if (((row >> (j * 4)) & 0xF) == 0)
+                rowEmpty[row] |= 1 << j;
+        }
+    }
+    for (m = 0; m < 256; m++)
+    {
+        for (j = 0, k = 0; j < 8; j++)
+        {
+            if (m & (1 << j))
+                selectBit[m][k++] = (unsigned char)j;
+        }
+        bitCount[m] = (unsigned char)k;
+    }
+    tablesBuilt = 1;
+}
+
+/* Swap nibble (i, j) with (j, i), in two rounds of 2x2 blocks */
+Board BoardTranspose(Board b)
+{
+    Board a1, a2, a3, a, b1, b2, b3;
+
+    a1 = b & (((Board)0xF0F00F0FUL << 32) | 0xF0F00F0FUL);
+    a2 = b & (((Board)0x0000F0F0UL << 32) | 0x0000F0F0UL);
+    a3 = b & (((Board)0x0F0F0000UL << 32) | 0x0F0F0000UL);
+    a = a1 | (a2 << 12) | (a3 >> 12);
+    b1 = a & (((Board)0xFF00FF00UL << 32) | 0x00FF00FFUL);
+    b2 = a & ((Board)0x00FF00FFUL << 32);
+    b3 = a & (Board)0xFF00FF00UL;
+    return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+/* Each row through a table */
+static Board MoveRows(Board b, const unsigned short *table)
+{
+    return (Board)table[BOARD_ROW(b, 0)] |
+           ((Board)table[BOARD_ROW(b, 1)] << 16) |
+           ((Board)table[BOARD_ROW(b, 2)] << 32) |
+           ((Board)table[BOARD_ROW(b, 3)] << 48);
+}
+
+Board BoardMove(Board b, int direction)
+{
+    switch (direction)
+    {
+    case MOVE_LEFT:
+        return MoveRows(b, rowLeft);
+    case MOVE_RIGHT:
+        return MoveRows(b, rowRight);
+    case MOVE_UP:
+        return BoardTranspose(MoveRows(BoardTranspose(b), rowLeft));
+    case MOVE_DOWN:
+        return BoardTranspose(MoveRows(BoardTranspose(b), rowRight));
+    }
+    return b;
+}
+
+/* Sliding right scores what sliding the reversed row left does */
+long BoardMoveScore(Board b, int direction)
+{
+    long points = 0;
+    unsigned row;
+    int i;
+
+    if (direction == MOVE_UP || direction == MOVE_DOWN)
+        b = BoardTranspose(b);
+    for (i = 0; i < 4; i++)
+    {
+        row = BOARD_ROW(b, i);
+        points += rowPoints[direction == MOVE_LEFT || direction == MOVE_UP ? row : ReverseRow(row)];
+    }
+    return points;
+}
+
+int BoardCanMove(Board b)
+{
+    Board t;
+
+    if (MoveRows(b, rowLeft) != b || MoveRows(b, rowRight) != b)
+        return 1;
+    t = BoardTranspose(b);
+    return MoveRows(t, rowLeft) != t || MoveRows(t, rowRight) != t;
+}
+
+unsigned long NextRandom(unsigned long *state)
+{
+    unsigned long x = *state;
+
+    x ^= (x << 13) & 0xFFFFFFFFUL;
+    x ^= x >> 17;
+    x ^= (x << 5) & 0xFFFFFFFFUL;
+    *state = x;
+    return x;
+}
+
+/* Mix the game number into the seed so neighbouring games start apart */
+unsigned long GameSeed(unsigned long seed, long game)
+{
+    unsigned long x = (seed * 2654435761UL + (unsigned long)game * 40503UL + 1) & 0xFFFFFFFFUL;
+
+    x ^= x >> 16;
+    x = (x * 0x7FEB352DUL) & 0xFFFFFFFFUL;
+    x ^= x >> 15;
+    x = (x * 0x846CA68BUL) & 0xFFFFFFFFUL;
+    x ^= x >> 16;
+    return x ? x : 1;
+}
+
+unsigned BoardEmptyMask(Board b)
+{
+    return rowEmpty[BOARD_ROW(b, 0)] | (rowEmpty[BOARD_ROW(b, 1)] << 4) |
+           (rowEmpty[BOARD_ROW(b, 2)] << 8) | (rowEmpty[BOARD_ROW(b, 3)] << 12);
+}
+
+/* The k-th empty cell straight from the mask, one draw for the cell and
+   one for the value however full the board is */
+Board BoardAddTile(Board b, unsigned long *state)
+{
+    unsigned mask = BoardEmptyMask(b), low = mask & 0xFF, high = mask >> 8;
+    int n = bitCount[low] + bitCount[high], k, c;
+
+    if (n == 0)
+        return b;
+    k = (int)(NextRandom(state) % n);
+    c = k < bitCount[low] ? selectBit[low][k] : 8 + selectBit[high][k - bitCount[low]];
+
+    return BOARD_SET(b, c, NextRandom(state) % SPAWN_FOUR_IN == 0 ? 2 : 1);
+}
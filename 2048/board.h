@@ -0,0 +1,66 @@
+/* 2048 board
+   The whole grid in 64 bits, a 4-bit exponent per tile, 0 for empty.
+   Row i is bits 16*i to 16*i+15 with its leftmost tile lowest, so cell
+   (i, j) is nibble i*4+j. Moves are table lookups, a row at a time
+   Public Domain          */
+#ifndef BOARD_H
+#define BOARD_H
+
+#ifdef _MSC_VER
+typedef unsigned __int64 Board;
+#else
+typedef unsigned long long Board;
+#endif
+
+#define BOARD_CELLS 16
+
+/* Directions as MoveTiles numbers them */
+#define MOVE_LEFT  0
+#define MOVE_RIGHT 1
+#define MOVE_UP    2
+#define MOVE_DOWN  3
+
+/* Exponent 15, 32768, is the largest tile, two of them do not merge */
+#define MAX_EXPONENT 15
+
+/* AddRandomTile puts a new tile on an empty cell chosen evenly, one in
+   SPAWN_FOUR_IN of them is a 4 and the rest are 2 */
+#define SPAWN_FOUR_IN 2
+
+#define BOARD_CELL(b, c)     ((int)(((b) >> ((c) * 4)) & 0xF))
+#define BOARD_VALUE(b, c)    (BOARD_CELL(b, c) ? 1 << BOARD_CELL(b, c) : 0)
+#define BOARD_SET(b, c, e)   (((b) & ~((Board)0xF << ((c) * 4))) | ((Board)(e) << ((c) * 4)))
+#define BOARD_ROW(b, i)      ((unsigned)(((b) >> ((i) * 16)) & 0xFFFF))
+
+/* Build the row tables, safe to call more than once. Threads only read
+   them once built, so call it before starting any */
+void InitBoardTables(void);
+
+/* The board after sliding every tile in direction, the same board if
+   nothing moves. A tile made by a merge does not merge again that move */
+Board BoardMove(Board b, int direction);
+
+/* Points the move scores, the value of every tile its merges make */
+long BoardMoveScore(Board b, int direction);
+
+/* Rows become columns */
+Board BoardTranspose(Board b);
+
+/* Nonzero while some move changes the board */
+int BoardCanMove(Board b);
+
+/* xorshift32, state must not be 0. Each game draws its tiles from its
+   own, rand() is shared by every thread and cannot be replayed */
+unsigned long NextRandom(unsigned long *state);
+
+/* A state for game number game of a run started from seed, never 0 */
+unsigned long GameSeed(unsigned long seed, long game);
+
+/* Bit c set where cell c is empty */
+unsigned BoardEmptyMask(Board b);
+
+/* AddRandomTile on b drawing from state, the same board if it is full.
+   A game is its seed and its moves, the tiles follow from them */
+Board BoardAddTile(Board b, unsigned long *state);
+
+#endif /* BOARD_H */
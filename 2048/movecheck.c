@@ -0,0 +1,470 @@
+/* 2048 move equivalence check
+   Slides random boards with the grid MoveTiles the game used before the
+   bitboard and with the row tables, and reports the first board where
+   the tiles, whether anything moved or GameOver disagree. Every row of
+   tiles up to 16384 is tried both ways first, then the moves are timed.
+   New tiles are checked to land on every empty cell evenly, 4s at the
+   game's odds, and timed against drawing cells until one is empty
+   Usage: movecheck [-n boards] [-s seed]
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "board.h"
+
+#define GRID_SIZE 4
+
+static double Elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* MoveTiles as it was, on grid and without the new tile, returns moved */
+static int GridMove(int grid[GRID_SIZE][GRID_SIZE], int direction)
+{
+    int i, j, k;
+    int moved = 0;
+    int merged[GRID_SIZE][GRID_SIZE];
+
+    memset(merged, 0, sizeof(merged));
+    switch (direction)
+    {
+    case 0: // Left
+        for (i = 0; i < GRID_SIZE; i++)
+        {
+            k = 0;
+            for (j = 0; j < GRID_SIZE; j++)
+            {
+                if (grid[i][j] != 0)
+                {
+                    if (k > 0 && grid[i][k - 1] == grid[i][j] && !merged[i][k - 1])
+                    {
+                        grid[i][k - 1] *= 2;
+                        grid[i][j] = 0;
+                        merged[i][k - 1] = 1;
+                        moved = 1;
+                    }
+                    else
+                    {
+                        if (k != j)
+                        {
+                            grid[i][k] = grid[i][j];
+                            grid[i][j] = 0;
+                            moved = 1;
+                        }
+                        k++;
+                    }
+                }
+            }
+        }
+        break;
+
+    case 1: // Right
+        for (i = 0; i < GRID_SIZE; i++)
+        {
+            k = GRID_SIZE - 1;
+            for (j = GRID_SIZE - 1; j >= 0; j--)
+            {
+                if (grid[i][j] != 0)
+                {
+                    if (k < GRID_SIZE - 1 && grid[i][k + 1] == grid[i][j] && !merged[i][k + 1])
+                    {
+                        grid[i][k + 1] *= 2;
+                        grid[i][j] = 0;
+                        merged[i][k + 1] = 1;
+                        moved = 1;
+                    }
+                    else
+                    {
+                        if (k != j)
+                        {
+                            grid[i][k] = grid[i][j];
+                            grid[i][j] = 0;
+                            moved = 1;
+                        }
+                        k--;
+                    }
+                }
+            }
+        }
+        break;
+
+    case 2: // Up
+        for (j = 0; j < GRID_SIZE; j++)
+        {
+            k = 0;
+            for (i = 0; i < GRID_SIZE; i++)
+            {
+                if (grid[i][j] != 0)
+                {
+                    if (k > 0 && grid[k - 1][j] == grid[i][j] && !merged[k - 1][j])
+                    {
+                        grid[k - 1][j] *= 2;
+                        grid[i][j] = 0;
+                        merged[k - 1][j] = 1;
+                        moved = 1;
+                    }
+                    else
+                    {
+                        if (k != i)
+                        {
+                            grid[k][j] = grid[i][j];
+                            grid[i][j] = 0;
+                            moved = 1;
+                        }
+                        k++;
+                    }
+                }
+            }
+        }
+        break;
+
+    case 3: // Down
+        for (j = 0; j < GRID_SIZE; j++)
+        {
+            k = GRID_SIZE - 1;
+            for (i = GRID_SIZE - 1; i >= 0; i--)
+            {
+                if (grid[i][j] != 0)
+                {
+                    if (k < GRID_SIZE - 1 && grid[k + 1][j] == grid[i][j] && !merged[k + 1][j])
+                    {
+                        grid[k + 1][j] *= 2;
+                        grid[i][j] = 0;
+                        merged[k + 1][j] = 1;
+                        moved = 1;
+                    }
+                    else
+                    {
+                        if (k != i)
+                        {
+                            grid[k][j] = grid[i][j];
+                            grid[i][j] = 0;
+                            moved = 1;
+                        }
+                        k--;
+                    }
+                }
+            }
+        }
+        break;
+    }
+
+    return moved;
+}
+
+/* GameOver as it was */
+static int GridOver(int grid[GRID_SIZE][GRID_SIZE])
+{
+    int i, j;
+
+    for (i = 0; i < GRID_SIZE; i++)
+    {
+        for (j = 0; j < GRID_SIZE; j++)
+        {
+            if (grid[i][j] == 0)
+                return 0;
+            if (i < GRID_SIZE - 1 && grid[i][j] == grid[i + 1][j])
+                return 0;
+            if (j < GRID_SIZE - 1 && grid[i][j] == grid[i][j + 1])
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static void ToGrid(Board b, int grid[GRID_SIZE][GRID_SIZE])
+{
+    int c;
+
+    for (c = 0; c < BOARD_CELLS; c++)
+        grid[c / GRID_SIZE][c % GRID_SIZE] = BOARD_VALUE(b, c);
+}
+
+/* 0 if a tile does not fit in 4 bits */
+static int FromGrid(int grid[GRID_SIZE][GRID_SIZE], Board *b)
+{
+    int c, e, v;
+
+    *b = 0;
+    for (c = 0; c < BOARD_CELLS; c++)
+    {
+        v = grid[c / GRID_SIZE][c % GRID_SIZE];
+        for (e = 0; v > 1; e++)
+            v >>= 1;
+        if (e > MAX_EXPONENT)
+            return 0;
+        *b = BOARD_SET(*b, c, e);
+    }
+    return 1;
+}
+
+static void PrintBoard(const char *label, Board b)
+{
+    int i, j;
+
+    printf("%s\n", label);
+    for (i = 0; i < GRID_SIZE; i++)
+    {
+        for (j = 0; j < GRID_SIZE; j++)
+            printf(" %5d", BOARD_VALUE(b, i * GRID_SIZE + j));
+        printf("\n");
+    }
+}
+
+/* Both ways from b in direction, 1 if they agree */
+static int Compare(Board b, int direction)
+{
+    static const char *names[4] = {"left", "right", "up", "down"};
+    int grid[GRID_SIZE][GRID_SIZE];
+    Board byTable, byGrid;
+    int moved;
+
+    ToGrid(b, grid);
+    moved = GridMove(grid, direction);
+    byTable = BoardMove(b, direction);
+    if (FromGrid(grid, &byGrid) && byGrid == byTable && moved == (byTable != b))
+        return 1;
+
+    printf("mismatch moving %s\n", names[direction]);
+    PrintBoard("from:", b);
+    PrintBoard("grid:", byGrid);
+    PrintBoard("table:", byTable);
+    return 0;
+}
+
+/* Mostly small tiles so rows merge often, sometimes large ones */
+static Board RandomBoard(unsigned long *seed)
+{
+    Board b = 0;
+    int c, r, top;
+
+    top = NextRandom(seed) % 4 ? 5 : MAX_EXPONENT - 1;
+    for (c = 0; c < BOARD_CELLS; c++)
+    {
+        r = (int)(NextRandom(seed) % (top + 2));
+        b = BOARD_SET(b, c, r > top ? 0 : r);
+    }
+    return b;
+}
+
+/* AddRandomTile as it was, drawing cells until one is empty */
+static Board RejectionAdd(Board b, unsigned long *state)
+{
+    int c;
+
+    do
+    {
+        c = (int)(NextRandom(state) % BOARD_CELLS);
+    } while (BOARD_CELL(b, c) != 0);
+
+    return BOARD_SET(b, c, NextRandom(state) % SPAWN_FOUR_IN == 0 ? 2 : 1);
+}
+
+/* Small tiles everywhere but empty cells */
+static Board BoardWithEmpty(int empty, unsigned long *seed)
+{
+    Board b = 0;
+    int c;
+
+    for (c = 0; c < BOARD_CELLS; c++)
+        b = BOARD_SET(b, c, 1 + NextRandom(seed) % 5);
+    while (empty > 0)
+    {
+        c = (int)(NextRandom(seed) % BOARD_CELLS);
+        if (BOARD_CELL(b, c) != 0)
+        {
+            b = BOARD_SET(b, c, 0);
+            empty--;
+        }
+    }
+    return b;
+}
+
+/* Every empty cell about equally often, 4s at the odds, nothing on a
+   full board. 1 if so */
+static int CheckSpawn(unsigned long *seed)
+{
+    long counts[BOARD_CELLS], fours, draws, i;
+    unsigned long state = *seed;
+    int empty, c, changed;
+    Board b, next;
+
+    for (empty = 1; empty <= BOARD_CELLS; empty++)
+    {
+        b = BoardWithEmpty(empty, seed);
+        memset(counts, 0, sizeof(counts));
+        fours = 0;
+        draws = 20000L * empty;
+        for (i = 0; i < draws; i++)
+        {
+            next = BoardAddTile(b, &state);
+            for (c = 0, changed = -1; c < BOARD_CELLS; c++)
+            {
+                if (BOARD_CELL(next, c) != BOARD_CELL(b, c))
+                {
+                    if (changed >= 0 || BOARD_CELL(b, c) != 0 || BOARD_CELL(next, c) > 2)
+                    {
+                        PrintBoard("bad tile added to:", b);
+                        PrintBoard("giving:", next);
+                        return 0;
+                    }
+                    changed = c;
+                }
+            }
+            if (changed < 0)
+            {
+                PrintBoard("no tile added to:", b);
+                return 0;
+            }
+            counts[changed]++;
+            fours += BOARD_CELL(next, changed) == 2;
+        }
+        for (c = 0; c < BOARD_CELLS; c++)
+        {
+            if (BOARD_CELL(b, c) == 0 && (counts[c] < 19000 || counts[c] > 21000))
+            {
+                printf("cell %d of %d empty drawn %ld times in %ld\n", c, empty, counts[c], draws);
+                return 0;
+            }
+        }
+        if (fours < draws / SPAWN_FOUR_IN * 0.97 || fours > draws / SPAWN_FOUR_IN * 1.03)
+        {
+            printf("%ld fours in %ld tiles\n", fours, draws);
+            return 0;
+        }
+    }
+
+    b = BoardWithEmpty(0, seed);
+    if (BoardAddTile(b, &state) != b)
+    {
+        PrintBoard("tile added to a full board:", b);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    long boards = 1000000, n, rows = 0, moves;
+    unsigned long seed = 1;
+    Board b, sink = 0, *sample;
+    int grid[GRID_SIZE][GRID_SIZE], work[GRID_SIZE][GRID_SIZE], (*grids)[GRID_SIZE][GRID_SIZE];
+    int i, d, row, failed = 0, overs = 0;
+    double gridSeconds, tableSeconds;
+    clock_t t;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            boards = atol(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            seed = strtoul(argv[++i], NULL, 10);
+        else
+            break;
+    }
+    if (i < argc || boards < 1)
+    {
+        printf("Usage: movecheck [-n boards] [-s seed]\n");
+        return 1;
+    }
+    if (seed == 0)
+        seed = 1;
+
+    InitBoardTables();
+
+    /* Every row of exponents 0 to 14, in the top row and the left column */
+    for (row = 0; row < 65536 && !failed; row++)
+    {
+        if ((row & 0xF) == 0xF || (row & 0xF0) == 0xF0 ||
+            (row & 0xF00) == 0xF00 || (row & 0xF000) == 0xF000)
+            continue;
+        rows++;
+        b = (Board)row;
+        for (d = 0; d < 4 && !failed; d++)
+            failed = !Compare(b, d) || !Compare(BoardTranspose(b), d);
+    }
+
+    /* Random boards, every direction and GameOver */
+    for (n = 0; n < boards && !failed; n++)
+    {
+        b = RandomBoard(&seed);
+        for (d = 0; d < 4 && !failed; d++)
+            failed = !Compare(b, d);
+        ToGrid(b, grid);
+        if (!failed && GridOver(grid) != !BoardCanMove(b))
+        {
+            PrintBoard("GameOver disagrees on:", b);
+            failed = 1;
+        }
+        overs += GridOver(grid);
+    }
+    printf("rows=%ld boards=%ld game over=%d %s\n", rows, n, overs, failed ? "FAILED" : "ok");
+    if (failed)
+        return 2;
+    if (!CheckSpawn(&seed))
+    {
+        printf("new tiles FAILED\n");
+        return 2;
+    }
+    printf("new tiles ok\n");
+
+    /* Time the same moves both ways */
+    moves = boards < 1000000 ? boards : 1000000;
+    sample = (Board *)malloc(moves * sizeof(Board));
+    grids = malloc(moves * sizeof(grid));
+    if (!sample || !grids)
+        return 2;
+    for (n = 0; n < moves; n++)
+    {
+        sample[n] = RandomBoard(&seed);
+        ToGrid(sample[n], grids[n]);
+    }
+
+    t = clock();
+    for (n = 0; n < moves; n++)
+    {
+        for (d = 0; d < 4; d++)
+        {
+            memcpy(work, grids[n], sizeof(work));
+            sink += GridMove(work, d) + work[0][0];
+        }
+    }
+    gridSeconds = Elapsed(t);
+
+    t = clock();
+    for (n = 0; n < moves; n++)
+    {
+        for (d = 0; d < 4; d++)
+            sink += BoardMove(sample[n], d);
+    }
+    tableSeconds = Elapsed(t);
+    free(sample);
+    free(grids);
+
+    /* Keep the results alive for the optimizer */
+    if (sink == 1)
+        moves++;
+    printf("moves=%ld grid=%.0f/sec tables=%.0f/sec\n", moves * 4,
+           gridSeconds > 0 ? moves * 4 / gridSeconds : 0.0,
+           tableSeconds > 0 ? moves * 4 / tableSeconds : 0.0);
+
+    /* Time new tiles both ways as the board fills */
+    printf("new tile ns by empty cells:");
+    for (i = 16; i >= 1; i /= 2)
+    {
+        b = BoardWithEmpty(i, &seed);
+        t = clock();
+        for (n = 0; n < moves; n++)
+            sink += RejectionAdd(b, &seed);
+        gridSeconds = Elapsed(t);
+        t = clock();
+        for (n = 0; n < moves; n++)
+            sink += BoardAddTile(b, &seed);
+        tableSeconds = Elapsed(t);
+        printf(" %d: drawn=%.1f mask=%.1f", i, gridSeconds * 1e9 / moves, tableSeconds * 1e9 / moves);
+    }
+    printf("%s\n", sink == 1 ? " " : "");
+    return 0;
+}
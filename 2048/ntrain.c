@@ -0,0 +1,262 @@
+/* 2048 n-tuple trainer
+   Learns the value of afterstates, the board right after a move and
+   before its new tile, by temporal difference: every thread plays
+   games choosing the move with the most points plus value after it,
+   then walks the game back pulling each afterstate's value toward the
+   points of the next move plus the next afterstate's value. Threads
+   update the shared weights without locks. Games are numbered and draw
+   their tiles from their own seed, carrying on from the games a loaded
+   network has seen, and every block of games adds a line to the log
+   Usage: ntrain [-n games] [-t 4|6] [-a rate] [-j threads] [-s seed] [-b block] [-i in.ntw] [-o out.ntw] [-l log.csv]
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ntuple.h"
+#include "../sokoban/thread.h"
+
+typedef struct {
+    NTuple *net;
+    float rate;                 /* Share of the error each update corrects */
+    unsigned long seed;
+    long first;                 /* Games the network had seen before this run */
+    volatile long next;         /* Next game of the block to play */
+    long end;                   /* First game past the block */
+} TrainOptions;
+
+typedef struct {
+    TrainOptions *opt;
+    Board *after;               /* Afterstates of the game being played */
+    long *points;               /* Points of the move making each */
+    long size;
+    int failed;                 /* Out of memory */
+
+    /* Games played this block */
+    long games, maxScore, reached[3];
+    double moves, score;
+} TrainWorker;
+
+/* Room for the afterstate of move n */
+static int Reserve(TrainWorker *w, long n)
+{
+    Board *after;
+    long *points, size;
+
+    if (n < w->size)
+        return 1;
+    size = w->size ? w->size * 2 : 4096;
+    after = (Board *)realloc(w->after, size * sizeof(Board));
+    if (after)
+        w->after = after;
+    points = (long *)realloc(w->points, size * sizeof(long));
+    if (points)
+        w->points = points;
+    if (!after || !points)
+        return 0;
+    w->size = size;
+    return 1;
+}
+
+static void TrainGame(TrainWorker *w, long game)
+{
+    NTuple *net = w->opt->net;
+    unsigned long state = GameSeed(w->opt->seed, w->opt->first + game);
+    Board b = BoardAddTile(BoardAddTile(0, &state), &state);
+    long n = 0, score = 0;
+    int move, c, top = 0;
+    float target;
+
+    while ((move = NTupleBestMove(net, b)) >= 0)
+    {
+        if (!Reserve(w, n))
+        {
+            w->failed = 1;
+            return;
+        }
+        w->points[n] = BoardMoveScore(b, move);
+        w->after[n] = BoardMove(b, move);
+        score += w->points[n];
+        b = BoardAddTile(w->after[n], &state);
+        n++;
+    }
+
+    /* Nothing follows the last afterstate. Backwards, each update sees
+       the one after it already corrected */
+    target = 0.0f;
+    while (n-- > 0)
+    {
+        NTupleUpdate(net, w->after[n], w->opt->rate * (target - NTupleValue(net, w->after[n])));
+        target = w->points[n] + NTupleValue(net, w->after[n]);
+        w->moves++;
+    }
+
+    for (c = 0; c < BOARD_CELLS; c++)
+    {
+        if (BOARD_CELL(b, c) > top)
+            top = BOARD_CELL(b, c);
+    }
+    for (c = 0; c < 3; c++)
+        w->reached[c] += top >= 11 + c;
+    w->games++;
+    w->score += score;
+    if (score > w->maxScore)
+        w->maxScore = score;
+}
+
+static void WorkerMain(void *arg)
+{
+    TrainWorker *w = (TrainWorker *)arg;
+    long game;
+
+    while (!w->failed && (game = AtomicAdd(&w->opt->next, 1)) < w->opt->end)
+        TrainGame(w, game);
+}
+
+int main(int argc, char *argv[])
+{
+    TrainOptions opt;
+    TrainWorker *workers, total;
+    Thread *threads;
+    FILE *log = NULL;
+    const char *shape = "6", *in = NULL, *out = "2048.ntw", *logName = NULL;
+    long games = 100000, block = 1000, done;
+    int numWorkers = CountProcessors(), i, c;
+    double start, blockStart, now;
+
+    memset(&opt, 0, sizeof(TrainOptions));
+    opt.rate = 0.1f;
+    opt.seed = 1;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (i + 1 >= argc)
+            break;
+        if (strcmp(argv[i], "-n") == 0)
+            games = atol(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0)
+            shape = argv[++i];
+        else if (strcmp(argv[i], "-a") == 0)
+            opt.rate = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0)
+            numWorkers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0)
+            opt.seed = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-b") == 0)
+            block = atol(argv[++i]);
+        else if (strcmp(argv[i], "-i") == 0)
+            in = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0)
+            out = argv[++i];
+        else if (strcmp(argv[i], "-l") == 0)
+            logName = argv[++i];
+        else
+            break;
+    }
+    if (i < argc || games < 1 || block < 1 || numWorkers < 1 || opt.rate <= 0.0f)
+    {
+        printf("Usage: ntrain [-n games] [-t 4|6] [-a rate] [-j threads] [-s seed] [-b block] [-i in.ntw] [-o out.ntw] [-l log.csv]\n");
+        printf("  -t picks the tuples of a new network, -i carries on training a saved one\n");
+        return 1;
+    }
+
+    InitBoardTables();
+    opt.net = in ? LoadNTuple(in, 1) : CreateNTuple(shape);
+    if (!opt.net)
+    {
+        printf(in ? "%s: cannot read a network\n" : "%s: unknown tuples or out of memory\n", in ? in : shape);
+        return 1;
+    }
+    opt.first = (long)NTupleGames(opt.net);
+    if (logName && !(log = fopen(logName, "w")))
+    {
+        printf("%s: cannot write\n", logName);
+        return 1;
+    }
+    if (log)
+        fprintf(log, "games,seconds,games_per_sec,moves_per_sec,mean_score,max_score,reach_2048,reach_4096,reach_8192\n");
+
+    workers = (TrainWorker *)calloc(numWorkers, sizeof(TrainWorker));
+    threads = (Thread *)calloc(numWorkers, sizeof(Thread));
+    if (!workers || !threads)
+    {
+        printf("out of memory\n");
+        return 1;
+    }
+    printf("tuples=%s rate=%g threads=%d seed=%lu games before=%ld\n", NTupleShape(opt.net), opt.rate,
+           numWorkers, opt.seed, opt.first);
+
+    start = WallSeconds();
+    for (done = 0; done < games; done = opt.end)
+    {
+        opt.next = done;
+        opt.end = done + block < games ? done + block : games;
+        for (i = 0; i < numWorkers; i++)
+        {
+            workers[i].opt = &opt;
+            workers[i].games = workers[i].maxScore = 0;
+            workers[i].moves = workers[i].score = 0.0;
+            memset(workers[i].reached, 0, sizeof(workers[i].reached));
+        }
+
+        blockStart = WallSeconds();
+        for (i = 0; i < numWorkers; i++)
+        {
+            if (!StartThread(&threads[i], WorkerMain, &workers[i]))
+                WorkerMain(&workers[i]);
+        }
+        for (i = 0; i < numWorkers; i++)
+            JoinThread(&threads[i]);
+        now = WallSeconds();
+
+        memset(&total, 0, sizeof(TrainWorker));
+        for (i = 0; i < numWorkers; i++)
+        {
+            if (workers[i].failed)
+            {
+                printf("out of memory\n");
+                return 1;
+            }
+            total.games += workers[i].games;
+            total.moves += workers[i].moves;
+            total.score += workers[i].score;
+            if (workers[i].maxScore > total.maxScore)
+                total.maxScore = workers[i].maxScore;
+            for (c = 0; c < 3; c++)
+                total.reached[c] += workers[i].reached[c];
+        }
+
+        printf("games=%ld time=%.1fs games/sec=%.0f mean score=%.0f 2048=%.1f%% 4096=%.1f%% 8192=%.1f%%\n",
+               opt.first + opt.end, now - start, now > blockStart ? total.games / (now - blockStart) : 0.0,
+               total.score / total.games, 100.0 * total.reached[0] / total.games,
+               100.0 * total.reached[1] / total.games, 100.0 * total.reached[2] / total.games);
+        if (log)
+        {
+            fprintf(log, "%ld,%.3f,%.1f,%.0f,%.1f,%ld,%.4f,%.4f,%.4f\n", opt.first + opt.end, now - start,
+                    now > blockStart ? total.games / (now - blockStart) : 0.0,
+                    now > blockStart ? total.moves / (now - blockStart) : 0.0,
+                    total.score / total.games, total.maxScore, (double)total.reached[0] / total.games,
+                    (double)total.reached[1] / total.games, (double)total.reached[2] / total.games);
+            fflush(log);
+        }
+    }
+
+    SetNTupleGames(opt.net, NTupleGames(opt.net) + games);
+    if (!SaveNTuple(opt.net, out))
+    {
+        printf("%s: cannot write\n", out);
+        return 2;
+    }
+    printf("saved %s after %.0f games\n", out, NTupleGames(opt.net));
+
+    if (log)
+        fclose(log);
+    for (i = 0; i < numWorkers; i++)
+    {
+        free(workers[i].after);
+        free(workers[i].points);
+    }
+    free(workers);
+    free(threads);
+    FreeNTuple(opt.net);
+    return 0;
+}
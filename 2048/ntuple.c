@@ -0,0 +1,382 @@
+/* 2048 n-tuple network
+   Each tuple is looked up on all eight reflections and rotations of the
+   board, so one weight table learns a pattern wherever it turns up.
+   Tuples follow Szubert and Jaskowski's and Yeh's networks for 2048
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "ntuple.h"
+
+#define NTUPLE_MAGIC   "2048NTW"
+#define NTUPLE_VERSION 1
+#define SYMMETRIES     8
+
+/* The file starts with this, zero padded to NTUPLE_HEADER_SIZE */
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int numTuples;
+    double games;
+    char shape[8];
+    unsigned char size[NTUPLE_MAX_TUPLES];
+    unsigned char cells[NTUPLE_MAX_TUPLES][NTUPLE_MAX_CELLS];
+} NTupleHeader;
+
+struct NTuple {
+    NTupleHeader header;
+    float *weights[NTUPLE_MAX_TUPLES];
+    float rate;                 /* Share of an update each weight takes */
+    float *memory;              /* Weights read or created, NULL when mapped */
+    void *view;                 /* The mapped file */
+#ifdef _WIN32
+    HANDLE file, mapping;
+#else
+    size_t viewSize;
+#endif
+};
+
+static const struct {
+    const char *name;
+    int numTuples, size;
+    unsigned char cells[NTUPLE_MAX_TUPLES][NTUPLE_MAX_CELLS];
+} shapes[] = {
+    /* An edge row, an inner row, a corner, edge and middle square */
+    {"4", 5, 4, {{0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 4, 5}, {1, 2, 5, 6}, {5, 6, 9, 10}}},
+    /* Two rows of three by two and two L shapes */
+    {"6", 4, 6, {{0, 1, 2, 3, 4, 5}, {4, 5, 6, 7, 8, 9}, {0, 1, 2, 4, 5, 6}, {4, 5, 6, 8, 9, 10}}},
+};
+
+#define NUM_SHAPES (sizeof(shapes) / sizeof(shapes[0]))
+
+/* Weights a tuple of size cells has */
+static unsigned long TupleWeights(int size)
+{
+    return 1UL << (size * 4);
+}
+
+/* Bytes of weights after the header */
+static unsigned long WeightBytes(const NTupleHeader *h)
+{
+    unsigned long bytes = 0;
+    unsigned t;
+
+    for (t = 0; t < h->numTuples; t++)
+        bytes += TupleWeights(h->size[t]) * sizeof(float);
+    return bytes;
+}
+
+/* Point the tuples into weights laid out one after another */
+static void SetWeights(NTuple *net, float *weights)
+{
+    unsigned t;
+
+    for (t = 0; t < net->header.numTuples; t++)
+    {
+        net->weights[t] = weights;
+        weights += TupleWeights(net->header.size[t]);
+    }
+    net->rate = 1.0f / (net->header.numTuples * SYMMETRIES);
+}
+
+/* 1 if the header is one this code wrote */
+static int CheckHeader(const NTupleHeader *h)
+{
+    unsigned t;
+    int k;
+
+    if (memcmp(h->magic, NTUPLE_MAGIC, sizeof(NTUPLE_MAGIC)) != 0 || h->version != NTUPLE_VERSION ||
+        h->numTuples < 1 || h->numTuples > NTUPLE_MAX_TUPLES)
+        return 0;
+    for (t = 0; t < h->numTuples; t++)
+    {
+        if (h->size[t] < 1 || h->size[t] > NTUPLE_MAX_CELLS)
+            return 0;
+        for (k = 0; k < h->size[t]; k++)
+        {
+            if (h->cells[t][k] >= BOARD_CELLS)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+NTuple *CreateNTuple(const char *shape)
+{
+    NTuple *net;
+    unsigned s;
+    int t;
+
+    for (s = 0; s < NUM_SHAPES && strcmp(shape, shapes[s].name) != 0; s++)
+        ;
+    if (s == NUM_SHAPES)
+        return NULL;
+    net = (NTuple *)calloc(1, sizeof(NTuple));
+    if (!net)
+        return NULL;
+
+    memcpy(net->header.magic, NTUPLE_MAGIC, sizeof(NTUPLE_MAGIC));
+    net->header.version = NTUPLE_VERSION;
+    net->header.numTuples = shapes[s].numTuples;
+    strcpy(net->header.shape, shapes[s].name);
+    for (t = 0; t < shapes[s].numTuples; t++)
+    {
+        net->header.size[t] = (unsigned char)shapes[s].size;
+        memcpy(net->header.cells[t], shapes[s].cells[t], shapes[s].size);
+    }
+
+    net->memory = (float *)calloc(WeightBytes(&net->header), 1);
+    if (!net->memory)
+    {
+        free(net);
+        return NULL;
+    }
+    SetWeights(net, net->memory);
+    return net;
+}
+
+/* Read the whole file into memory */
+static NTuple *ReadNTuple(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    char block[NTUPLE_HEADER_SIZE];
+    NTuple *net;
+    unsigned long bytes;
+
+    if (!f)
+        return NULL;
+    net = (NTuple *)calloc(1, sizeof(NTuple));
+    if (!net || fread(block, 1, NTUPLE_HEADER_SIZE, f) != NTUPLE_HEADER_SIZE)
+        goto fail;
+    memcpy(&net->header, block, sizeof(NTupleHeader));
+    if (!CheckHeader(&net->header))
+        goto fail;
+    bytes = WeightBytes(&net->header);
+    net->memory = (float *)malloc(bytes);
+    if (!net->memory || fread(net->memory, 1, bytes, f) != bytes || fgetc(f) != EOF)
+        goto fail;
+    fclose(f);
+    SetWeights(net, net->memory);
+    return net;
+
+fail:
+    fclose(f);
+    FreeNTuple(net);
+    return NULL;
+}
+
+/* Map the file read only, the weights stay in the page cache */
+static NTuple *MapNTuple(const char *path)
+{
+    NTuple *net = (NTuple *)calloc(1, sizeof(NTuple));
+    unsigned long size;
+#ifndef _WIN32
+    struct stat st;
+    int fd;
+#endif
+
+    if (!net)
+        return NULL;
+#ifdef _WIN32
+    net->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+    if (net->file == INVALID_HANDLE_VALUE)
+    {
+        free(net);
+        return NULL;
+    }
+    size = GetFileSize(net->file, NULL);    /* 0xFFFFFFFF on failure */
+    if (size != 0xFFFFFFFFUL && size >= NTUPLE_HEADER_SIZE)
+    {
+        net->mapping = CreateFileMappingA(net->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (net->mapping)
+            net->view = MapViewOfFile(net->mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        free(net);
+        return NULL;
+    }
+    size = fstat(fd, &st) == 0 ? (unsigned long)st.st_size : 0;
+    if (size >= NTUPLE_HEADER_SIZE)
+    {
+        net->view = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (net->view == MAP_FAILED)
+            net->view = NULL;
+        else
+            net->viewSize = size;
+    }
+    close(fd);
+#endif
+
+    if (!net->view)
+    {
+        FreeNTuple(net);
+        return NULL;
+    }
+    memcpy(&net->header, net->view, sizeof(NTupleHeader));
+    if (!CheckHeader(&net->header) || size != NTUPLE_HEADER_SIZE + WeightBytes(&net->header))
+    {
+        FreeNTuple(net);
+        return NULL;
+    }
+    SetWeights(net, (float *)((char *)net->view + NTUPLE_HEADER_SIZE));
+    return net;
+}
+
+NTuple *LoadNTuple(const char *path, int writable)
+{
+    return writable ? ReadNTuple(path) : MapNTuple(path);
+}
+
+int SaveNTuple(const NTuple *net, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    char block[NTUPLE_HEADER_SIZE];
+    unsigned long bytes = WeightBytes(&net->header);
+    int ok;
+
+    if (!f)
+        return 0;
+    memset(block, 0, sizeof(block));
+    memcpy(block, &net->header, sizeof(NTupleHeader));
+    ok = fwrite(block, 1, NTUPLE_HEADER_SIZE, f) == NTUPLE_HEADER_SIZE &&
+         fwrite(net->weights[0], 1, bytes, f) == bytes;
+    return fclose(f) == 0 && ok;
+}
+
+void FreeNTuple(NTuple *net)
+{
+    if (!net)
+        return;
+    free(net->memory);
+#ifdef _WIN32
+    if (net->view)
+        UnmapViewOfFile(net->view);
+    if (net->mapping)
+        CloseHandle(net->mapping);
+    if (net->file && net->file != INVALID_HANDLE_VALUE)
+        CloseHandle(net->file);
+#else
+    if (net->view)
+        munmap(net->view, net->viewSize);
+#endif
+    free(net);
+}
+
+const char *NTupleShape(const NTuple *net)
+{
+    return net->header.shape;
+}
+
+double NTupleGames(const NTuple *net)
+{
+    return net->header.games;
+}
+
+void SetNTupleGames(NTuple *net, double games)
+{
+    net->header.games = games;
+}
+
+/* Rows reversed, each lane of 16 bits read right to left */
+static Board Mirror(Board b)
+{
+    b = ((b & (((Board)0x0F0F0F0FUL << 32) | 0x0F0F0F0FUL)) << 4) |
+        ((b >> 4) & (((Board)0x0F0F0F0FUL << 32) | 0x0F0F0F0FUL));
+    return ((b & (((Board)0x00FF00FFUL << 32) | 0x00FF00FFUL)) << 8) |
+           ((b >> 8) & (((Board)0x00FF00FFUL << 32) | 0x00FF00FFUL));
+}
+
+/* Top row to the bottom */
+static Board Flip(Board b)
+{
+    return (b << 48) | ((b & (Board)0xFFFF0000UL) << 16) |
+           ((b >> 16) & (Board)0xFFFF0000UL) | (b >> 48);
+}
+
+/* All eight ways the board can be turned and reflected */
+static void Symmetries(Board b, Board sym[SYMMETRIES])
+{
+    int s;
+
+    sym[0] = b;
+    sym[1] = Mirror(b);
+    sym[2] = Flip(b);
+    sym[3] = Flip(sym[1]);
+    for (s = 0; s < 4; s++)
+        sym[s + 4] = BoardTranspose(sym[s]);
+}
+
+/* Tiles on the tuple's cells, the first lowest */
+static unsigned long TupleIndex(const NTupleHeader *h, int t, Board b)
+{
+    unsigned long index = 0;
+    int k;
+
+    for (k = 0; k < h->size[t]; k++)
+        index |= (unsigned long)BOARD_CELL(b, h->cells[t][k]) << (k * 4);
+    return index;
+}
+
+float NTupleValue(const NTuple *net, Board b)
+{
+    Board sym[SYMMETRIES];
+    float value = 0.0f;
+    unsigned t;
+    int s;
+
+    Symmetries(b, sym);
+    for (t = 0; t < net->header.numTuples; t++)
+    {
+        for (s = 0; s < SYMMETRIES; s++)
+            value += net->weights[t][TupleIndex(&net->header, t, sym[s])];
+    }
+    return value;
+}
+
+void NTupleUpdate(NTuple *net, Board b, float delta)
+{
+    Board sym[SYMMETRIES];
+    unsigned t;
+    int s;
+
+    delta *= net->rate;
+    Symmetries(b, sym);
+    for (t = 0; t < net->header.numTuples; t++)
+    {
+        for (s = 0; s < SYMMETRIES; s++)
+            net->weights[t][TupleIndex(&net->header, t, sym[s])] += delta;
+    }
+}
+
+int NTupleBestMove(const NTuple *net, Board b)
+{
+    Board next;
+    float value, bestValue = 0.0f;
+    int d, best = -1;
+
+    for (d = 0; d < 4; d++)
+    {
+        next = BoardMove(b, d);
+        if (next == b)
+            continue;
+        value = BoardMoveScore(b, d) + NTupleValue(net, next);
+        if (best < 0 || value > bestValue)
+        {
+            best = d;
+            bestValue = value;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,53 @@
+/* 2048 n-tuple network
+   A position is valued by adding up one weight per tuple of cells and
+   per symmetry of the board, looked up by the tiles on those cells. The
+   weights are learned by ntrain and kept in a file read as it lies on
+   disk: a header naming the tuples, then every weight as a 32-bit
+   float in the machine's byte order
+   Public Domain          */
+#ifndef NTUPLE_H
+#define NTUPLE_H
+
+#include "board.h"
+
+#define NTUPLE_MAX_TUPLES 8
+#define NTUPLE_MAX_CELLS  6
+#define NTUPLE_HEADER_SIZE 256    /* Weights start here, 256 keeps them aligned */
+
+typedef struct NTuple NTuple;
+
+/* Tuples by name: "4" is rows and squares of four cells, 1.3 MB, "6" is
+   four tuples of six cells, 256 MB and much stronger. Zero weights, NULL
+   for an unknown name or out of memory */
+NTuple *CreateNTuple(const char *shape);
+
+/* A saved network, NULL if it cannot be read or is not one. Writable
+   reads it into memory to train further, otherwise the file is mapped
+   and pages come in as moves touch them */
+NTuple *LoadNTuple(const char *path, int writable);
+
+/* 0 on failure */
+int SaveNTuple(const NTuple *net, const char *path);
+
+void FreeNTuple(NTuple *net);
+
+/* Which CreateNTuple made it */
+const char *NTupleShape(const NTuple *net);
+
+/* Games it has been trained on, ntrain counts them */
+double NTupleGames(const NTuple *net);
+void SetNTupleGames(NTuple *net, double games);
+
+/* Expected points still to come after the move that made b */
+float NTupleValue(const NTuple *net, Board b);
+
+/* Move NTupleValue(b) by about delta, spread over the weights it adds
+   up. Threads may update one network at once without locks, a lost
+   update now and then does not hurt learning */
+void NTupleUpdate(NTuple *net, Board b, float delta);
+
+/* The move with the most points plus value after it, as MoveTiles
+   numbers them, -1 if none moves */
+int NTupleBestMove(const NTuple *net, Board b);
+
+#endif /* NTUPLE_H */
@@ -0,0 +1,117 @@
+/* 2048 replay
+   Plays a game saved with S again from its seed and moves, checking
+   every move slides something, and prints the board it ends on, the
+   score and the largest tile. The same seed and moves always give the
+   same tiles
+   Usage: replay game.txt
+          replay seed moves
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "board.h"
+
+static void PrintBoard(Board b)
+{
+    int i, j;
+
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < 4; j++)
+            printf(" %5d", BOARD_VALUE(b, i * 4 + j));
+        printf("\n");
+    }
+}
+
+/* The whole file, NULL if it cannot be read */
+static char *ReadFile(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    char *text;
+    long size;
+
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    text = (char *)malloc(size + 1);
+    if (text && fread(text, 1, size, f) != (size_t)size)
+    {
+        free(text);
+        text = NULL;
+    }
+    if (text)
+        text[size] = '\0';
+    fclose(f);
+    return text;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *letters = "LRUD", *m, *d;
+    char *text = NULL, *end;
+    unsigned long seed, state;
+    Board b, next;
+    long score = 0, moves = 0;
+    int c, top = 0;
+
+    if (argc == 2)
+    {
+        text = ReadFile(argv[1]);
+        if (!text)
+        {
+            printf("%s: cannot read\n", argv[1]);
+            return 1;
+        }
+        seed = strtoul(text, &end, 10);
+        m = end;
+    }
+    else if (argc == 3)
+    {
+        seed = strtoul(argv[1], &end, 10);
+        m = argv[2];
+    }
+    else
+    {
+        printf("Usage: replay game.txt\n");
+        printf("       replay seed moves\n");
+        return 1;
+    }
+    if (seed == 0)
+    {
+        printf("seed must be a number above 0\n");
+        return 1;
+    }
+
+    InitBoardTables();
+    state = seed;
+    b = BoardAddTile(BoardAddTile(0, &state), &state);
+    for (; *m; m++)
+    {
+        d = strchr(letters, *m >= 'a' && *m <= 'z' ? *m - 'a' + 'A' : *m);
+        if (!d)
+            continue;   /* Line ends and spaces */
+        next = BoardMove(b, (int)(d - letters));
+        if (next == b)
+        {
+            printf("move %ld (%c) slides nothing\n", moves + 1, *m);
+            free(text);
+            return 2;
+        }
+        score += BoardMoveScore(b, (int)(d - letters));
+        b = BoardAddTile(next, &state);
+        moves++;
+    }
+
+    for (c = 0; c < BOARD_CELLS; c++)
+    {
+        if (BOARD_CELL(b, c) > top)
+            top = BOARD_CELL(b, c);
+    }
+    PrintBoard(b);
+    printf("seed=%lu moves=%ld score=%ld max tile=%d%s\n", seed, moves, score, 1 << top,
+           BoardCanMove(b) ? "" : " game over");
+    free(text);
+    return 0;
+}
@@ -0,0 +1,303 @@
+/* 2048 batch simulator
+   Plays many games on all cores with one policy and reports games and
+   moves per second, the spread of final scores and how often each tile
+   ended up the largest. Every game draws its tiles from its own
+   generator seeded by its number, at the odds AddRandomTile uses, so
+   any thread count plays the same games. The ai policy keeps its table
+   of scored positions from game to game, which can change a close move.
+   The ntuple policy plays a network ntrain learned, mapped from -w
+   Usage: simbatch [-n games] [-p random|greedy|corner|ai|ntuple] [-j threads] [-s seed] [-d depth] [-w weights]
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ai.h"
+#include "ntuple.h"
+#include "../sokoban/thread.h"
+
+#define SCORE_BUCKETS 24    /* Powers of two, the last takes the rest */
+
+typedef struct SimWorker SimWorker;
+
+/* The move to make on b, -1 if none moves */
+typedef int (*PolicyProc)(SimWorker *w, Board b, unsigned long *state);
+
+typedef struct {
+    long numGames;
+    unsigned long seed;
+    PolicyProc policy;
+    AIOptions aiOptions;
+    NTuple *net;                /* For the ntuple policy, shared */
+    long *scores;               /* Final score of each game */
+    volatile long next;         /* Next game to play */
+} SimOptions;
+
+struct SimWorker {
+    SimOptions *opt;
+    AI *ai;                     /* For the ai policy, one per thread */
+    double moves;
+    long maxTile[MAX_EXPONENT + 1];
+};
+
+/* Any move that changes the board */
+static int RandomPolicy(SimWorker *w, Board b, unsigned long *state)
+{
+    int d, n = 0, legal[4];
+
+    for (d = 0; d < 4; d++)
+    {
+        if (BoardMove(b, d) != b)
+            legal[n++] = d;
+    }
+    return n ? legal[NextRandom(state) % n] : -1;
+}
+
+/* The most points now, then the most empty cells after */
+static int GreedyPolicy(SimWorker *w, Board b, unsigned long *state)
+{
+    long points, bestPoints = -1;
+    int d, c, empty, bestEmpty = -1, best = -1;
+    Board next;
+
+    for (d = 0; d < 4; d++)
+    {
+        next = BoardMove(b, d);
+        if (next == b)
+            continue;
+        points = BoardMoveScore(b, d);
+        for (c = 0, empty = 0; c < BOARD_CELLS; c++)
+            empty += BOARD_CELL(next, c) == 0;
+        if (points > bestPoints || (points == bestPoints && empty > bestEmpty))
+        {
+            best = d;
+            bestPoints = points;
+            bestEmpty = empty;
+        }
+    }
+    return best;
+}
+
+/* Keep the large tiles in the top left corner: up, then left, then
+   right, down only when nothing else moves */
+static int CornerPolicy(SimWorker *w, Board b, unsigned long *state)
+{
+    static const int order[4] = {MOVE_UP, MOVE_LEFT, MOVE_RIGHT, MOVE_DOWN};
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        if (BoardMove(b, order[i]) != b)
+            return order[i];
+    }
+    return -1;
+}
+
+static int AIPolicy(SimWorker *w, Board b, unsigned long *state)
+{
+    return AIBestMove(w->ai, b);
+}
+
+static int NTuplePolicy(SimWorker *w, Board b, unsigned long *state)
+{
+    return NTupleBestMove(w->opt->net, b);
+}
+
+static const struct {
+    const char *name;
+    PolicyProc proc;
+} policies[] = {
+    {"random", RandomPolicy},
+    {"greedy", GreedyPolicy},
+    {"corner", CornerPolicy},
+    {"ai", AIPolicy},
+    {"ntuple", NTuplePolicy},
+};
+
+#define NUM_POLICIES (sizeof(policies) / sizeof(policies[0]))
+
+static void PlayGame(SimWorker *w, long game)
+{
+    unsigned long state = GameSeed(w->opt->seed, game);
+    Board b = BoardAddTile(BoardAddTile(0, &state), &state);
+    long score = 0;
+    int move, c, top = 0;
+
+    while ((move = w->opt->policy(w, b, &state)) >= 0)
+    {
+        score += BoardMoveScore(b, move);
+        b = BoardAddTile(BoardMove(b, move), &state);
+        w->moves++;
+    }
+
+    for (c = 0; c < BOARD_CELLS; c++)
+    {
+        if (BOARD_CELL(b, c) > top)
+            top = BOARD_CELL(b, c);
+    }
+    w->maxTile[top]++;
+    w->opt->scores[game] = score;
+}
+
+static void WorkerMain(void *arg)
+{
+    SimWorker *w = (SimWorker *)arg;
+    long game;
+
+    while ((game = AtomicAdd(&w->opt->next, 1)) < w->opt->numGames)
+        PlayGame(w, game);
+}
+
+static int CompareScores(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* Index of the percent point in n sorted games */
+static long Percentile(long n, int percent)
+{
+    return (long)((double)n * percent / 100);
+}
+
+int main(int argc, char *argv[])
+{
+    SimOptions opt;
+    SimWorker *workers;
+    Thread *threads;
+    const char *policyName = "random", *weights = "2048.ntw";
+    long maxTile[MAX_EXPONENT + 1], buckets[SCORE_BUCKETS], g, n;
+    int numWorkers = CountProcessors(), depth = 0, i, e;
+    double wall, moves = 0.0, mean = 0.0, spread = 0.0;
+
+    memset(&opt, 0, sizeof(SimOptions));
+    opt.numGames = 100000;
+    opt.seed = 1;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (i + 1 >= argc)
+            break;
+        if (strcmp(argv[i], "-n") == 0)
+            opt.numGames = atol(argv[++i]);
+        else if (strcmp(argv[i], "-p") == 0)
+            policyName = argv[++i];
+        else if (strcmp(argv[i], "-j") == 0)
+            numWorkers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0)
+            opt.seed = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-d") == 0)
+            depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-w") == 0)
+            weights = argv[++i];
+        else
+            break;
+    }
+    for (e = 0; e < (int)NUM_POLICIES; e++)
+    {
+        if (strcmp(policyName, policies[e].name) == 0)
+            opt.policy = policies[e].proc;
+    }
+
+    if (i < argc || opt.numGames < 1 || numWorkers < 1 || !opt.policy)
+    {
+        printf("Usage: simbatch [-n games] [-p random|greedy|corner|ai|ntuple] [-j threads] [-s seed] [-d depth] [-w weights]\n");
+        printf("  -d is how far the ai policy looks ahead, -w the network the ntuple policy plays\n");
+        return 1;
+    }
+    if (numWorkers > opt.numGames)
+        numWorkers = (int)opt.numGames;
+
+    /* Each worker has its own AI on its own thread */
+    InitAIOptions(&opt.aiOptions);
+    opt.aiOptions.threads = 1;
+    opt.aiOptions.cacheMegabytes = 4;
+    if (depth > 0)
+        opt.aiOptions.depth = depth;
+
+    workers = (SimWorker *)calloc(numWorkers, sizeof(SimWorker));
+    threads = (Thread *)calloc(numWorkers, sizeof(Thread));
+    opt.scores = (long *)malloc(opt.numGames * sizeof(long));
+    if (!workers || !threads || !opt.scores)
+    {
+        printf("out of memory\n");
+        return 1;
+    }
+    InitBoardTables();
+    if (opt.policy == NTuplePolicy && !(opt.net = LoadNTuple(weights, 0)))
+    {
+        printf("%s: cannot read a network\n", weights);
+        return 1;
+    }
+    for (i = 0; i < numWorkers; i++)
+    {
+        workers[i].opt = &opt;
+        if (opt.policy == AIPolicy && !(workers[i].ai = CreateAI(&opt.aiOptions)))
+        {
+            printf("out of memory\n");
+            return 1;
+        }
+    }
+
+    wall = WallSeconds();
+    for (i = 0; i < numWorkers; i++)
+    {
+        if (!StartThread(&threads[i], WorkerMain, &workers[i]))
+            WorkerMain(&workers[i]);
+    }
+    for (i = 0; i < numWorkers; i++)
+        JoinThread(&threads[i]);
+    wall = WallSeconds() - wall;
+
+    memset(maxTile, 0, sizeof(maxTile));
+    for (i = 0; i < numWorkers; i++)
+    {
+        moves += workers[i].moves;
+        for (e = 0; e <= MAX_EXPONENT; e++)
+            maxTile[e] += workers[i].maxTile[e];
+        FreeAI(workers[i].ai);
+    }
+
+    /* Scores by size, bucket e holds 2^e to 2^(e+1)-1 */
+    memset(buckets, 0, sizeof(buckets));
+    for (g = 0; g < opt.numGames; g++)
+    {
+        mean += opt.scores[g];
+        for (e = 0, n = opt.scores[g]; n > 1 && e < SCORE_BUCKETS - 1; e++)
+            n >>= 1;
+        buckets[e]++;
+    }
+    mean /= opt.numGames;
+    for (g = 0; g < opt.numGames; g++)
+        spread += (opt.scores[g] - mean) * (opt.scores[g] - mean);
+    qsort(opt.scores, opt.numGames, sizeof(long), CompareScores);
+
+    printf("policy=%s games=%ld threads=%d seed=%lu time=%.3fs\n", policyName, opt.numGames,
+           numWorkers, opt.seed, wall);
+    printf("games/sec=%.0f moves/sec=%.0f moves/game=%.1f\n", wall > 0 ? opt.numGames / wall : 0.0,
+           wall > 0 ? moves / wall : 0.0, moves / opt.numGames);
+    printf("score: mean=%.1f sd=%.1f min=%ld p10=%ld p50=%ld p90=%ld p99=%ld max=%ld\n",
+           mean, sqrt(spread / opt.numGames), opt.scores[0], opt.scores[Percentile(opt.numGames, 10)],
+           opt.scores[Percentile(opt.numGames, 50)], opt.scores[Percentile(opt.numGames, 90)],
+           opt.scores[Percentile(opt.numGames, 99)], opt.scores[opt.numGames - 1]);
+
+    printf("score histogram:\n");
+    for (e = 0; e < SCORE_BUCKETS; e++)
+    {
+        if (buckets[e])
+            printf("  %8ld+ %10ld %6.2f%%\n", e ? 1L << e : 0L, buckets[e], 100.0 * buckets[e] / opt.numGames);
+    }
+    printf("max tile histogram:\n");
+    for (e = 1; e <= MAX_EXPONENT; e++)
+    {
+        if (maxTile[e])
+            printf("  %8d %10ld %6.2f%%\n", 1 << e, maxTile[e], 100.0 * maxTile[e] / opt.numGames);
+    }
+
+    FreeNTuple(opt.net);
+    free(opt.scores);
+    free(workers);
+    free(threads);
+    return 0;
+}
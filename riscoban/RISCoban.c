@@ -8,6 +8,12 @@
 #include <stdlib.h>  /* For qsort */
 #include <search.h>  /* For _findfirst on some compilers */
 #include "../arch.h"
+#include "../sokoban/level.h"
+#include "../sokoban/atlas.h"
+#include "../sokoban/solver.h"
+#include "../sokoban/assign.h"
+#include "../sokoban/thread.h"
+#include "chips.h"
 
 /* Flag for allowed RISC processor detection */
 BOOL isAllowedProcessor = FALSE;
@@ -30,8 +36,6 @@ BOOL isAllowedProcessor = FALSE;
 
 /* Game constants */
 #define CELL_SIZE 32
-#define GRID_ROWS 20
-#define GRID_COLS 20
 
 /* Bitmap handles */
 HBITMAP hRoboArmBitmap = NULL;
@@ -45,20 +49,8 @@ HBITMAP hSocketAxpBitmap = NULL;
 HBITMAP hSocketPpcBitmap = NULL;
 HBITMAP hSocketArmBitmap = NULL;
 
-/* Game elements */
-#define EMPTY   0
-#define WALL    1
-#define BOX     2
-#define TARGET  3
-#define PLAYER  4
-#define BOX_ON_TARGET 5
-#define PLAYER_ON_TARGET 6
-
-/* Box type tracking (for consistent processor types) */
-#define MAX_BOXES 100
-int boxTypes[MAX_BOXES][2]; /* [box_id][0] = row, [box_id][1] = col */
-int boxTypeImages[MAX_BOXES]; /* Store which processor type (0=MIPS, 1=AXP, 2=PPC, 3=ARM) */
-int numBoxesTracked = 0;
+/* Box type tracking (for consistent processor types), chip ids per cell */
+ChipMap chips;
 
 /* Colors */
 #define COLOR_FLOOR    RGB(0, 128, 0)      /* Green (PCB color) */
@@ -70,9 +62,44 @@ int numBoxesTracked = 0;
 #define COLOR_CIRCUIT  RGB(150, 150, 150)  /* Light gray for circuit traces */
 #define COLOR_LIGHTGREEN RGB(0, 255, 0)    /* Light Green from 16-color palette */
 
-/* Player position */
-int playerX = 1;
-int playerY = 1;
+/* Tiles in the sprite atlas, chips and filled sockets one per type */
+#define TILE_TARGET            0
+#define TILE_PLAYER            1
+#define TILE_PLAYER_ON_TARGET  2
+#define TILE_CHIP              3
+#define TILE_CHIP_IN_SOCKET    7
+#define TILE_TYPED_SOCKET      11
+#define NUM_TILES              15
+#define NUM_CHIP_TYPES         4
+SpriteAtlas atlas;
+
+const char *chipNames[NUM_CHIP_TYPES] = {"MIPS", "AXP", "PPC", "ARM"};
+
+/* Strict mode: a chip only counts in a socket of its own type. Sockets
+   take the type of the chip the level's solution leaves in them, so
+   every level that can be solved can still be solved strictly */
+#define STRICT_MAX_NODES 300000L
+#define STRICT_TABLE_MB 16
+#define WM_STRICT (WM_APP + 1)
+BOOL strictMode = FALSE;
+unsigned char *socketTypes = NULL;  /* Per cell */
+int *socketCells = NULL;
+int numSockets = 0;
+unsigned short *socketDist = NULL;  /* Pushes onto each socket from each cell */
+Assignment socketMatch;             /* Sockets to chips, matched again after every push */
+BOOL matchReady = FALSE;
+
+/* The solve takes seconds on the slower machines, so it runs on a worker
+   thread that posts WM_STRICT back, and each level's socket types are
+   kept so resetting or coming back to a level does not solve again */
+unsigned char *levelSocketTypes[NUM_LEVELS];  /* Per cell, NULL until typed */
+int loadedLevel = -1;               /* Level of the board */
+Board levelStart;                   /* That level as loaded, its sockets are typed from it */
+Thread strictThread;
+BOOL strictBusy = FALSE;
+Board strictBoard;                  /* The worker's copy while strictBusy */
+int strictLevel;                    /* Level it is typing */
+unsigned char *strictResult;        /* Its socket types */
 
 /* Level management */
 char currentLevel[100] = "";
@@ -80,20 +107,24 @@ char levelFiles[100][100];  /* Array to store level file paths */
 int numLevels = 0;         /* Number of levels found */
 int currentLevelIndex = 0; /* Index of current level in the levelFiles array */
 
-/* Level dimensions (will be detected from the loaded level) */
-int levelWidth = 0;
-int levelHeight = 0;
+/* Game board: walls, boxes and targets as bitplanes, sized by the loaded level */
+Board board;
 
-/* Game grid */
-int grid[GRID_ROWS][GRID_COLS] = {0};
+/* Wall test for the perimeter drawing */
+#define IS_WALL(row, col) TEST_BIT(board.walls, CELL_INDEX(&board, col, row))
 
 /* Function declarations */
 BOOL LoadLevel(const char *filename);
 void ScanLevelFiles(void);
 BOOL LoadNextLevel(void);
 void UpdateWindowTitle(HWND hwnd, const char *levelPath);
-int CountBoxes(void);
 void CheckProcessorType(void);
+unsigned char *TypeSockets(const Board *level);
+void PrepareStrict(HWND hwnd);
+void FinishStrict(HWND hwnd);
+void FreeStrict(void);
+BOOL StrictPending(void);
+BOOL CheckWin(void);
 void DrawBSODScreen(HDC hdc, RECT clientRect);
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -148,9 +179,7 @@ BOOL LoadLevel(const char *levelName)
     HGLOBAL hResData;
     LPVOID pData;
     DWORD resSize;
-    char *levelData, *line, *nextLine;
-    int row = 0, col = 0;
-    int i, j;
+    int i;
     int levelIndex;
     HWND hwnd;
 
@@ -174,13 +203,6 @@ BOOL LoadLevel(const char *levelName)
         return FALSE;
     }
 
-    /* Reset the grid */
-    for (i = 0; i < GRID_ROWS; i++) {
-        for (j = 0; j < GRID_COLS; j++) {
-            grid[i][j] = EMPTY;
-        }
-    }
-
     /* Load level resource by ID */
     hResInfo = FindResource(NULL, MAKEINTRESOURCE(3000 + levelIndex), RT_RCDATA);
 
@@ -203,223 +225,41 @@ BOOL LoadLevel(const char *levelName)
 
     resSize = SizeofResource(NULL, hResInfo);
 
-    /* Create a null-terminated copy of the resource data */
-    levelData = (char *)malloc(resSize + 1);
-    if (!levelData) {
+    /* Parse straight out of the locked resource, nothing may point into
+       the old board after this */
+    ChipsFree(&chips);
+    FreeStrict();
+    BoardFree(&board);
+    loadedLevel = -1;
+    if (!ParseLevel((const char *)pData, (long)resSize, &board)) {
         MessageBox(NULL, "Out of memory!", "Error", MB_ICONERROR | MB_OK);
         return FALSE;
     }
-
-    memcpy(levelData, pData, resSize);
-    levelData[resSize] = '\0';
-
-    /* Level data loaded successfully */
-
-    /* First pass: determine level dimensions */
-    levelWidth = 0;
-    levelHeight = 0;
-
-    line = levelData;
-    while (line && *line) {
-        /* Find end of line */
-        nextLine = strpbrk(line, "\r\n");
-        if (nextLine) {
-            char *endLine = nextLine; /* Save position for measuring line length */
-
-            /* Skip all newline characters */
-            while (*nextLine == '\r' || *nextLine == '\n') {
-                nextLine++;
-            }
-
-            /* Null-terminate this line for processing */
-            *endLine = '\0';
-        }
-
-        /* Measure line length */
-        col = strlen(line);
-
-        if (col > 0) {
-            /* Count only lines with content */
-            if (col > levelWidth) {
-                levelWidth = col;
-            }
-            levelHeight++;
-        }
-
-        /* Move to next line or break if no more lines */
-        if (!nextLine || !*nextLine) {
-            break;
-        }
-        line = nextLine;
-    }
-
-    /* Level dimensions now determined */
-
-    /* CRITICAL FIX: Re-read the data for the second pass */
-    /* Reset the resource pointer and parse again */
-    free(levelData);
-
-    /* Create a fresh null-terminated copy of the resource data */
-    levelData = (char *)malloc(resSize + 1);
-    if (!levelData) {
+    if (!BoardCopy(&levelStart, &board)) {
         MessageBox(NULL, "Out of memory!", "Error", MB_ICONERROR | MB_OK);
         return FALSE;
     }
+    loadedLevel = levelIndex;
 
-    memcpy(levelData, pData, resSize);
-    levelData[resSize] = '\0';
-
-    /* Second pass: actually load the level */
-    row = 0;
-    line = levelData;
-
-    while (line && *line && row < levelHeight) {
-        nextLine = strpbrk(line, "\r\n");
-        if (nextLine) {
-            char *endLine = nextLine;
-
-            /* Skip all newline characters */
-            while (*nextLine == '\r' || *nextLine == '\n') {
-                nextLine++;
-            }
-
-            /* Null-terminate this line for processing */
-            *endLine = '\0';
-        }
-
-        /* Process row */
-
-        col = 0;
-        for (i = 0; line[i] != '\0' && col < levelWidth; i++) {
-            switch (line[i]) {
-                case '#': /* Wall */
-                    grid[row][col] = WALL;
-                    col++;
-                    break;
-
-                case '@': /* Player */
-                    grid[row][col] = PLAYER;
-                    playerX = col;
-                    playerY = row;
-                    col++;
-                    break;
-
-                case '+': /* Player on target */
-                    grid[row][col] = PLAYER_ON_TARGET;
-                    playerX = col;
-                    playerY = row;
-                    col++;
-                    break;
-
-                case '$': /* Box */
-                    grid[row][col] = BOX;
-                    col++;
-                    break;
-
-                case '*': /* Box on target */
-                    grid[row][col] = BOX_ON_TARGET;
-                    col++;
-                    break;
-
-                case '.': /* Target */
-                    grid[row][col] = TARGET;
-                    col++;
-                    break;
-
-                case ' ': /* Empty space */
-                    grid[row][col] = EMPTY;
-                    col++;
-                    break;
-
-                default:
-                    /* Skip unknown characters */
-                    break;
-            }
-        }
-
-        /* Fill in the rest of the row with empty spaces */
-        while (col < levelWidth) {
-            grid[row][col] = EMPTY;
-            col++;
-        }
-
-        row++;
-
-        /* Move to next line or break if no more lines */
-        if (!nextLine || !*nextLine) {
-            break;
-        }
-        line = nextLine;
-    }
-
-    /* Level loading complete */
-
-    free(levelData);
-    
-    /* Reset box counters and track box positions */
-    {
-        int i, j, boxId, totalBoxes;
-        static int *totalBoxesPtr = NULL;
-        static int *boxCounterPtr = NULL;
-        
-        /* Find the addresses of the static variables in DrawBox */
-        if (totalBoxesPtr == NULL) {
-            /* Force recounting on next draw */
-            totalBoxesPtr = (int*)0; /* Can't get actual address in C89, this is a workaround */
-            boxCounterPtr = (int*)0;
-        }
-        
-        /* Reset box tracking */
-        numBoxesTracked = 0;
-        
-        /* First count total boxes */
-        totalBoxes = 0;
-        for (i = 0; i < levelHeight; i++) {
-            for (j = 0; j < levelWidth; j++) {
-                if (grid[i][j] == BOX || grid[i][j] == BOX_ON_TARGET) {
-                    totalBoxes++;
-                }
-            }
-        }
-        
-        /* Scan the grid to record all box positions */
-        for (i = 0; i < levelHeight; i++) {
-            for (j = 0; j < levelWidth; j++) {
-                if (grid[i][j] == BOX || grid[i][j] == BOX_ON_TARGET) {
-                    if (numBoxesTracked < MAX_BOXES) {
-                        boxTypes[numBoxesTracked][0] = i;  /* row */
-                        boxTypes[numBoxesTracked][1] = j;  /* col */
-                        
-                        /* Assign processor type based on position in the level */
-                        if (totalBoxes == 1) {
-                            boxTypeImages[numBoxesTracked] = 0; /* MIPS for single box */
-                        } else if (totalBoxes == 2) {
-                            boxTypeImages[numBoxesTracked] = (numBoxesTracked == 0) ? 0 : 1; /* MIPS, AXP */
-                        } else if (totalBoxes == 3) {
-                            /* For exactly 3 boxes, use MIPS, AXP, PPC */
-                            boxTypeImages[numBoxesTracked] = numBoxesTracked;
-                        } else {
-                            /* For 4+ boxes, cycle through all processor types */
-                            boxTypeImages[numBoxesTracked] = numBoxesTracked % 4;
-                        }
-                        
-                        numBoxesTracked++;
-                    }
-                }
-            }
-        }
+    /* Number the chips and give each its processor type */
+    if (!ChipsInit(&chips, &board, NUM_CHIP_TYPES)) {
+        MessageBox(NULL, "Out of memory!", "Error", MB_ICONERROR | MB_OK);
+        return FALSE;
     }
 
     /* Resize the window to match the level dimensions plus small pixel margin */
     hwnd = FindWindow("RISCobanClass", NULL);
+    if (strictMode)
+        PrepareStrict(hwnd);
+
     if (hwnd != NULL) {
         RECT rect;
 
         /* Set desired client area size (with margin) */
         rect.left = 0;
         rect.top = 0;
-        rect.right = CELL_SIZE * levelWidth + 20; /* extra space for margin */
-        rect.bottom = CELL_SIZE * levelHeight + 20; /* extra space for margin */
+        rect.right = CELL_SIZE * board.width + 20; /* extra space for margin */
+        rect.bottom = CELL_SIZE * board.height + 20; /* extra space for margin */
 
         /* Adjust the rectangle to include non-client area (borders, title bar, etc.) */
         AdjustWindowRect(&rect, WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX, FALSE);
@@ -437,100 +277,212 @@ BOOL LoadLevel(const char *levelName)
     return TRUE;
 }
 
-/* "Draw" a wall (but actually don't draw anything - invisible boundary) */
-void DrawWall(HDC hdc, int x, int y)
+/* Processor type of the box at a cell, MIPS if it is not tracked */
+int BoxType(int row, int col)
 {
-    /* Don't draw anything - walls are invisible boundaries */
-    /* The MovePlayer function already handles collision detection */
+    int boxIndex;
+
+    if (!chips.idAt)
+        return 0;
+    boxIndex = CHIP_AT(&chips, CELL_INDEX(&board, col, row));
+    return boxIndex == NO_CHIP ? 0 : chips.type[boxIndex];
 }
 
-/* Get count of boxes in level */
-int CountBoxes(void)
+/* Pushes from chip col to socket row, none for a chip of another type */
+long ChipCost(int row, int col)
 {
-    int i, j;
-    int count = 0;
+    unsigned short d = socketDist[(long)row * board.width * board.height + chips.cellOf[col]];
 
-    for(i = 0; i < levelHeight; i++) {
-        for(j = 0; j < levelWidth; j++) {
-            if(grid[i][j] == BOX || grid[i][j] == BOX_ON_TARGET) {
-                count++;
-            }
+    if (d == NO_PUSH_DISTANCE || chips.type[col] != socketTypes[socketCells[row]])
+        return ASSIGN_INFINITE;
+    return d;
+}
+
+/* Socket type of every cell of a level as it starts, NULL if out of
+   memory. Reads only level, the worker thread calls it */
+unsigned char *TypeSockets(const Board *level)
+{
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    int cells = level->width * level->height, c, d, from, to;
+    unsigned char *chipTypes, *types;
+    SolveOptions options;
+    SolveResult result;
+    Board play;
+    const char *m;
+
+    types = (unsigned char *)malloc(cells);
+    chipTypes = (unsigned char *)malloc(cells);
+    if (!types || !chipTypes) {
+        free(types);
+        free(chipTypes);
+        return NULL;
+    }
+
+    /* Chips are dealt their types as LoadLevel does, sockets the same
+       way unless the solver says where each chip ends up */
+    DealTypes(level, NUM_CHIP_TYPES, chipTypes, types);
+    InitSolveOptions(&options);
+    options.maxNodes = STRICT_MAX_NODES;
+    options.tableMegabytes = STRICT_TABLE_MB;
+    memset(&play, 0, sizeof(Board));
+    if (SolveLevel(level, &options, &result) == SOLVE_FOUND && result.solution &&
+        BoardCopy(&play, level)) {
+        for (m = result.solution; *m; m++) {
+            d = (int)(strchr("lurd", *m >= 'a' ? *m : *m - 'A' + 'a') - "lurd");
+            from = CELL_INDEX(&play, play.playerX + dx[d], play.playerY + dy[d]);
+            to = CELL_INDEX(&play, play.playerX + 2 * dx[d], play.playerY + 2 * dy[d]);
+            if (BoardMove(&play, dx[d], dy[d]) == MOVE_PUSH)
+                chipTypes[to] = chipTypes[from];
+        }
+        for (c = 0; c < cells; c++) {
+            if (TEST_BIT(play.targets, c) && TEST_BIT(play.boxes, c))
+                types[c] = chipTypes[c];
         }
     }
+    BoardFree(&play);
+    FreeSolveResult(&result);
+    free(chipTypes);
+    return types;
+}
 
-    return count;
+/* Type the sockets on the worker thread */
+void StrictWorker(void *arg)
+{
+    strictResult = TypeSockets(&strictBoard);
+    PostMessage((HWND)arg, WM_STRICT, 0, 0);
 }
 
-/* Find the box index based on its position */
-int FindBoxIndex(int row, int col)
+/* Type the sockets of the level just loaded and match the chips to them,
+   straight away if the level has been typed before. Otherwise the
+   worker types it and FinishStrict matches when it is done */
+void PrepareStrict(HWND hwnd)
 {
-    int i;
-    
-    for (i = 0; i < numBoxesTracked; i++) {
-        if (boxTypes[i][0] == row && boxTypes[i][1] == col) {
-            return i;
+    int cells = board.width * board.height, c, k;
+
+    if (loadedLevel < 0)
+        return;
+    if (!levelSocketTypes[loadedLevel]) {
+        /* One solve at a time, FinishStrict starts the next */
+        if (strictBusy)
+            return;
+        if (hwnd && BoardCopy(&strictBoard, &levelStart)) {
+            strictLevel = loadedLevel;
+            strictBusy = TRUE;
+            if (StartThread(&strictThread, StrictWorker, hwnd))
+                return;
+            strictBusy = FALSE;
+            BoardFree(&strictBoard);
+        }
+        /* No thread or no window, type it here */
+        levelSocketTypes[loadedLevel] = TypeSockets(&levelStart);
+        if (!levelSocketTypes[loadedLevel]) {
+            strictMode = FALSE;
+            return;
         }
     }
-    
-    /* Box not found, should not happen */
-    return 0;
+
+    socketTypes = (unsigned char *)malloc(cells);
+    socketCells = (int *)malloc(cells * sizeof(int));
+    if (!socketTypes || !socketCells) {
+        FreeStrict();
+        return;
+    }
+    memcpy(socketTypes, levelSocketTypes[loadedLevel], cells);
+
+    /* Push distances onto every socket, then the cheapest matching of
+       the chips where they stand now */
+    numSockets = 0;
+    for (c = 0; c < cells; c++) {
+        if (TEST_BIT(board.targets, c))
+            socketCells[numSockets++] = c;
+    }
+    socketDist = (unsigned short *)malloc((size_t)numSockets * cells * sizeof(unsigned short));
+    if (!socketDist || !AssignInit(&socketMatch, numSockets, chips.count))
+        return;
+    for (k = 0; k < numSockets; k++)
+        PushDistance(&board, socketCells[k], socketDist + (long)k * cells);
+    for (k = 0; k < numSockets; k++) {
+        for (c = 0; c < chips.count; c++)
+            ASSIGN_COST(&socketMatch, k, c) = ChipCost(k, c);
+    }
+    AssignSolve(&socketMatch);
+    matchReady = TRUE;
 }
 
-/* Draw a box/processor chip sprite based on box number */
-void DrawBox(HDC hdc, int x, int y, BOOL onTarget)
+/* WM_STRICT: keep what the worker found, then match the level on the
+   board if it is the one typed, or type the one loaded since */
+void FinishStrict(HWND hwnd)
 {
-    /* Count boxes to determine which sprites to use */
-    static int totalBoxes = 0;
-    static int boxCounter = 0;
-    HBITMAP boxBitmap = NULL;
-    HBITMAP socketBitmap = NULL;
-    int boxIndex = 0;
-    int gridRow, gridCol;
-    
-    /* Only count boxes once when level loads */
-    if (totalBoxes == 0) {
-        totalBoxes = CountBoxes();
-        boxCounter = 0;
-    }
-    
-    /* Determine which grid cell this is */
-    gridRow = (y - 10) / CELL_SIZE;
-    gridCol = (x - 10) / CELL_SIZE;
-    
-    /* Find which box this is */
-    boxIndex = FindBoxIndex(gridRow, gridCol);
-    
-    /* Select box bitmap based on type */
-    if (boxIndex >= 0 && boxIndex < numBoxesTracked) {
-        /* Use the pre-assigned type for this box */
-        switch (boxTypeImages[boxIndex]) {
-            case 0: /* MIPS */
-                boxBitmap = hMipsBitmap;
-                socketBitmap = hSocketMipsBitmap;
-                break;
-            case 1: /* AXP */
-                boxBitmap = hAxpBitmap;
-                socketBitmap = hSocketAxpBitmap;
-                break;
-            case 2: /* PPC */
-                boxBitmap = hPpcBitmap;
-                socketBitmap = hSocketPpcBitmap;
-                break;
-            case 3: /* ARM */
-                boxBitmap = hArmBitmap;
-                socketBitmap = hSocketArmBitmap;
-                break;
-            default:
-                boxBitmap = hMipsBitmap; /* Fallback to MIPS */
-                socketBitmap = hSocketMipsBitmap;
-                break;
-        }
+    BOOL waited = StrictPending() && strictLevel == loadedLevel;
+
+    JoinThread(&strictThread);
+    strictBusy = FALSE;
+    BoardFree(&strictBoard);
+    if (!strictResult) {
+        strictMode = FALSE;     /* Out of memory */
+    } else if (levelSocketTypes[strictLevel]) {
+        free(strictResult);
     } else {
-        /* Box index not found, fallback to MIPS */
-        boxBitmap = hMipsBitmap;
-        socketBitmap = hSocketMipsBitmap;
+        levelSocketTypes[strictLevel] = strictResult;
     }
-    
+    strictResult = NULL;
+
+    if (strictMode && socketTypes == NULL)
+        PrepareStrict(hwnd);
+    UpdateWindowTitle(hwnd, currentLevel);
+    InvalidateRect(hwnd, NULL, FALSE);
+
+    /* The level may have been finished while its sockets were typed */
+    if (waited && CheckWin())
+        SetTimer(hwnd, 1, 2000, NULL);
+}
+
+/* Strict mode on a level whose sockets are still being typed */
+BOOL StrictPending(void)
+{
+    return strictMode && loadedLevel >= 0 && levelSocketTypes[loadedLevel] == NULL;
+}
+
+void FreeStrict(void)
+{
+    free(socketTypes);
+    free(socketCells);
+    free(socketDist);
+    AssignFree(&socketMatch);
+    socketTypes = NULL;
+    socketCells = NULL;
+    socketDist = NULL;
+    numSockets = 0;
+    matchReady = FALSE;
+}
+
+/* Is the chip at a cell in a socket it counts in */
+BOOL Seated(int row, int col)
+{
+    return !strictMode || socketTypes == NULL ||
+           socketTypes[CELL_INDEX(&board, col, row)] == BoxType(row, col);
+}
+
+/* Draw a box/processor chip sprite of a processor type */
+void DrawBox(HDC hdc, int x, int y, int type, BOOL onTarget)
+{
+    HBITMAP boxBitmap;
+
+    switch (type) {
+        case 1: /* AXP */
+            boxBitmap = hAxpBitmap;
+            break;
+        case 2: /* PPC */
+            boxBitmap = hPpcBitmap;
+            break;
+        case 3: /* ARM */
+            boxBitmap = hArmBitmap;
+            break;
+        default: /* MIPS */
+            boxBitmap = hMipsBitmap;
+            break;
+    }
+
     /* Use the appropriate processor bitmap */
     if (boxBitmap != NULL) {
         /* Create a compatible DC for the bitmap */
@@ -661,6 +613,24 @@ void DrawTarget(HDC hdc, int x, int y)
     }
 }
 
+/* Draw an empty socket labelled with the chip type it takes */
+void DrawTypedSocket(HDC hdc, int x, int y, int type)
+{
+    RECT rect;
+    HFONT oldFont;
+
+    DrawTarget(hdc, x, y);
+    rect.left = x;
+    rect.top = y;
+    rect.right = x + CELL_SIZE;
+    rect.bottom = y + CELL_SIZE;
+    oldFont = SelectObject(hdc, GetStockObject(ANSI_VAR_FONT));
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, RGB(255, 255, 255));
+    DrawText(hdc, chipNames[type], -1, &rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+    SelectObject(hdc, oldFont);
+}
+
 /* Draw a player/roboarm sprite */
 void DrawPlayer(HDC hdc, int x, int y)
 {
@@ -702,11 +672,81 @@ void DrawPlayer(HDC hdc, int x, int y)
     }
 }
 
+/* Draw an atlas tile the slow way, over the PCB green */
+void DrawTile(HDC hdc, int x, int y, int tile)
+{
+    RECT rect;
+    HBRUSH brush;
+
+    rect.left = x;
+    rect.top = y;
+    rect.right = x + CELL_SIZE;
+    rect.bottom = y + CELL_SIZE;
+    brush = CreateSolidBrush(COLOR_FLOOR);
+    FillRect(hdc, &rect, brush);
+    DeleteObject(brush);
+
+    if (tile == TILE_TARGET) {
+        DrawTarget(hdc, x, y);
+    } else if (tile == TILE_PLAYER) {
+        DrawPlayer(hdc, x, y);
+    } else if (tile == TILE_PLAYER_ON_TARGET) {
+        DrawTarget(hdc, x, y);
+        DrawPlayer(hdc, x, y);
+    } else if (tile < TILE_CHIP_IN_SOCKET) {
+        DrawBox(hdc, x, y, tile - TILE_CHIP, FALSE);
+    } else if (tile >= TILE_TYPED_SOCKET) {
+        DrawTypedSocket(hdc, x, y, tile - TILE_TYPED_SOCKET);
+    } else {
+        HBITMAP socketBitmap;
+
+        /* Select the right socket-with-chip bitmap based on box type */
+        switch (tile - TILE_CHIP_IN_SOCKET) {
+            case 1: /* AXP */
+                socketBitmap = hSocketAxpBitmap;
+                break;
+            case 2: /* PPC */
+                socketBitmap = hSocketPpcBitmap;
+                break;
+            case 3: /* ARM */
+                socketBitmap = hSocketArmBitmap;
+                break;
+            default: /* MIPS */
+                socketBitmap = hSocketMipsBitmap;
+                break;
+        }
+
+        /* Draw the socket-with-chip bitmap */
+        if (socketBitmap != NULL) {
+            HDC hdcMem = CreateCompatibleDC(hdc);
+            HBITMAP hOldBitmap = SelectObject(hdcMem, socketBitmap);
+            BitBlt(hdc, x, y, CELL_SIZE, CELL_SIZE, hdcMem, 0, 0, SRCCOPY);
+            SelectObject(hdcMem, hOldBitmap);
+            DeleteDC(hdcMem);
+        } else {
+            /* Fallback if bitmap loading failed */
+            DrawTarget(hdc, x, y);
+            DrawBox(hdc, x, y, tile - TILE_CHIP_IN_SOCKET, TRUE);
+        }
+    }
+}
+
+/* Draw every tile into the atlas once, so painting only copies them */
+void BuildAtlas(void)
+{
+    int tile;
+
+    if (!AtlasInit(&atlas, CELL_SIZE, NUM_TILES))
+        return;
+    for (tile = 0; tile < NUM_TILES; tile++)
+        DrawTile(atlas.dc, ATLAS_X(&atlas, tile), 0, tile);
+}
+
 /* Draw the game grid */
 void DrawGrid(HDC hdc)
 {
     int i, j;
-    RECT cellRect, clientRect;
+    RECT clientRect;
     HBRUSH brush;
     HWND hwnd;
     HDC memDC;
@@ -737,8 +777,8 @@ void DrawGrid(HDC hdc)
         /* Calculate PCB area (the entire area including walls) */
         pcbRect.left = 10; /* margin */
         pcbRect.top = 10; /* margin */
-        pcbRect.right = 10 + levelWidth * CELL_SIZE;
-        pcbRect.bottom = 10 + levelHeight * CELL_SIZE;
+        pcbRect.right = 10 + board.width * CELL_SIZE;
+        pcbRect.bottom = 10 + board.height * CELL_SIZE;
         
         /* Fill the PCB area with green */
         brush = CreateSolidBrush(COLOR_FLOOR);
@@ -759,89 +799,47 @@ void DrawGrid(HDC hdc)
     /* No circuit traces in this version */
 
     /* Draw the game grid */
-    for(i = 0; i < levelHeight; i++)
+    for(i = 0; i < board.height; i++)
     {
-        for(j = 0; j < levelWidth; j++)
+        for(j = 0; j < board.width; j++)
         {
             int x = j * CELL_SIZE + 10; /* 10px margin */
             int y = i * CELL_SIZE + 10; /* 10px margin */
+            int tile;
 
-            cellRect.left = x;
-            cellRect.top = y;
-            cellRect.right = x + CELL_SIZE;
-            cellRect.bottom = y + CELL_SIZE;
-
-            /* No circuit pattern details on the PCB */
-
-            /* Draw game elements */
-            switch(grid[i][j])
+            /* Copy the cell's tile, the green PCB shows through the rest */
+            switch(BoardCell(&board, j, i))
             {
-                case WALL:
-                    DrawWall(memDC, x, y);
-                    break;
-
                 case BOX:
-                    DrawBox(memDC, x, y, FALSE);
+                    tile = TILE_CHIP + BoxType(i, j);
                     break;
 
                 case TARGET:
-                    DrawTarget(memDC, x, y);
+                    tile = socketTypes != NULL ?
+                           TILE_TYPED_SOCKET + socketTypes[CELL_INDEX(&board, j, i)] : TILE_TARGET;
                     break;
 
                 case PLAYER:
-                    DrawPlayer(memDC, x, y);
+                    tile = TILE_PLAYER;
                     break;
 
                 case BOX_ON_TARGET:
-                    {
-                        /* Get the box index */
-                        int boxIndex = FindBoxIndex(i, j);
-                        HBITMAP socketBitmap = NULL;
-                        
-                        /* Select the right socket-with-chip bitmap based on box type */
-                        if (boxIndex >= 0 && boxIndex < numBoxesTracked) {
-                            switch (boxTypeImages[boxIndex]) {
-                                case 0: /* MIPS */
-                                    socketBitmap = hSocketMipsBitmap;
-                                    break;
-                                case 1: /* AXP */
-                                    socketBitmap = hSocketAxpBitmap;
-                                    break;
-                                case 2: /* PPC */
-                                    socketBitmap = hSocketPpcBitmap;
-                                    break;
-                                case 3: /* ARM */
-                                    socketBitmap = hSocketArmBitmap;
-                                    break;
-                                default:
-                                    socketBitmap = hSocketMipsBitmap;
-                                    break;
-                            }
-                        } else {
-                            /* Box index not found, fallback to MIPS */
-                            socketBitmap = hSocketMipsBitmap;
-                        }
-                        
-                        /* Draw the socket-with-chip bitmap */
-                        if (socketBitmap != NULL) {
-                            HDC hdcMem = CreateCompatibleDC(memDC);
-                            HBITMAP hOldBitmap = SelectObject(hdcMem, socketBitmap);
-                            BitBlt(memDC, x, y, CELL_SIZE, CELL_SIZE, hdcMem, 0, 0, SRCCOPY);
-                            SelectObject(hdcMem, hOldBitmap);
-                            DeleteDC(hdcMem);
-                        } else {
-                            /* Fallback if bitmap loading failed */
-                            DrawTarget(memDC, x, y);
-                            DrawBox(memDC, x, y, TRUE);
-                        }
-                    }
+                    /* A chip in the wrong socket in strict mode stays loose */
+                    tile = (Seated(i, j) ? TILE_CHIP_IN_SOCKET : TILE_CHIP) + BoxType(i, j);
                     break;
 
                 case PLAYER_ON_TARGET:
-                    DrawTarget(memDC, x, y);
-                    DrawPlayer(memDC, x, y);
+                    tile = TILE_PLAYER_ON_TARGET;
                     break;
+
+                default: /* Walls are invisible */
+                    continue;
             }
+
+            if (atlas.dc != NULL)
+                AtlasDraw(&atlas, memDC, x, y, tile);
+            else
+                DrawTile(memDC, x, y, tile);
         }
     }
 
@@ -854,13 +852,13 @@ void DrawGrid(HDC hdc)
         /* Find outermost accessible cells and draw lines */
         
         /* Top edge */
-        for (j = 0; j < levelWidth; j++) {
-            if (grid[0][j] != WALL) {
+        for (j = 0; j < board.width; j++) {
+            if (!IS_WALL(0, j)) {
                 /* Found first accessible column from top */
                 int startCol = j;
                 
                 /* Find last consecutive accessible column */
-                while (j < levelWidth && grid[0][j] != WALL) {
+                while (j < board.width && !IS_WALL(0, j)) {
                     j++;
                 }
                 
@@ -871,30 +869,30 @@ void DrawGrid(HDC hdc)
         }
         
         /* Bottom edge */
-        for (j = 0; j < levelWidth; j++) {
-            if (grid[levelHeight-1][j] != WALL) {
+        for (j = 0; j < board.width; j++) {
+            if (!IS_WALL(board.height-1, j)) {
                 /* Found first accessible column from bottom */
                 int startCol = j;
                 
                 /* Find last consecutive accessible column */
-                while (j < levelWidth && grid[levelHeight-1][j] != WALL) {
+                while (j < board.width && !IS_WALL(board.height-1, j)) {
                     j++;
                 }
                 
                 /* Draw line from start to end */
-                MoveToEx(memDC, 10 + startCol * CELL_SIZE, 10 + levelHeight * CELL_SIZE, NULL);
-                LineTo(memDC, 10 + j * CELL_SIZE, 10 + levelHeight * CELL_SIZE);
+                MoveToEx(memDC, 10 + startCol * CELL_SIZE, 10 + board.height * CELL_SIZE, NULL);
+                LineTo(memDC, 10 + j * CELL_SIZE, 10 + board.height * CELL_SIZE);
             }
         }
         
         /* Left edge */
-        for (i = 0; i < levelHeight; i++) {
-            if (grid[i][0] != WALL) {
+        for (i = 0; i < board.height; i++) {
+            if (!IS_WALL(i, 0)) {
                 /* Found first accessible row from left */
                 int startRow = i;
                 
                 /* Find last consecutive accessible row */
-                while (i < levelHeight && grid[i][0] != WALL) {
+                while (i < board.height && !IS_WALL(i, 0)) {
                     i++;
                 }
                 
@@ -905,47 +903,47 @@ void DrawGrid(HDC hdc)
         }
         
         /* Right edge */
-        for (i = 0; i < levelHeight; i++) {
-            if (grid[i][levelWidth-1] != WALL) {
+        for (i = 0; i < board.height; i++) {
+            if (!IS_WALL(i, board.width-1)) {
                 /* Found first accessible row from right */
                 int startRow = i;
                 
                 /* Find last consecutive accessible row */
-                while (i < levelHeight && grid[i][levelWidth-1] != WALL) {
+                while (i < board.height && !IS_WALL(i, board.width-1)) {
                     i++;
                 }
                 
                 /* Draw line from start to end */
-                MoveToEx(memDC, 10 + levelWidth * CELL_SIZE, 10 + startRow * CELL_SIZE, NULL);
-                LineTo(memDC, 10 + levelWidth * CELL_SIZE, 10 + i * CELL_SIZE);
+                MoveToEx(memDC, 10 + board.width * CELL_SIZE, 10 + startRow * CELL_SIZE, NULL);
+                LineTo(memDC, 10 + board.width * CELL_SIZE, 10 + i * CELL_SIZE);
             }
         }
         
         /* Now draw internal perimeter lines where accessible meets inaccessible */
-        for (i = 0; i < levelHeight; i++) {
-            for (j = 0; j < levelWidth; j++) {
-                if (grid[i][j] != WALL) {
+        for (i = 0; i < board.height; i++) {
+            for (j = 0; j < board.width; j++) {
+                if (!IS_WALL(i, j)) {
                     /* Check neighboring cells */
                     /* Top neighbor */
-                    if (i > 0 && grid[i-1][j] == WALL) {
+                    if (i > 0 && IS_WALL(i-1, j)) {
                         MoveToEx(memDC, 10 + j * CELL_SIZE, 10 + i * CELL_SIZE, NULL);
                         LineTo(memDC, 10 + (j+1) * CELL_SIZE, 10 + i * CELL_SIZE);
                     }
                     
                     /* Bottom neighbor */
-                    if (i < levelHeight-1 && grid[i+1][j] == WALL) {
+                    if (i < board.height-1 && IS_WALL(i+1, j)) {
                         MoveToEx(memDC, 10 + j * CELL_SIZE, 10 + (i+1) * CELL_SIZE, NULL);
                         LineTo(memDC, 10 + (j+1) * CELL_SIZE, 10 + (i+1) * CELL_SIZE);
                     }
                     
                     /* Left neighbor */
-                    if (j > 0 && grid[i][j-1] == WALL) {
+                    if (j > 0 && IS_WALL(i, j-1)) {
                         MoveToEx(memDC, 10 + j * CELL_SIZE, 10 + i * CELL_SIZE, NULL);
                         LineTo(memDC, 10 + j * CELL_SIZE, 10 + (i+1) * CELL_SIZE);
                     }
                     
                     /* Right neighbor */
-                    if (j < levelWidth-1 && grid[i][j+1] == WALL) {
+                    if (j < board.width-1 && IS_WALL(i, j+1)) {
                         MoveToEx(memDC, 10 + (j+1) * CELL_SIZE, 10 + i * CELL_SIZE, NULL);
                         LineTo(memDC, 10 + (j+1) * CELL_SIZE, 10 + (i+1) * CELL_SIZE);
                     }
@@ -968,78 +966,26 @@ void DrawGrid(HDC hdc)
 /* Move player in a direction */
 void MovePlayer(HWND hwnd, int dx, int dy)
 {
-    int newX = playerX + dx;
-    int newY = playerY + dy;
-    int i, oldBoxRow, oldBoxCol;
-
-    /* Check if the move is valid */
-    if(newX < 0 || newY < 0 || newX >= levelWidth || newY >= levelHeight)
-        return;
-
-    if(grid[newY][newX] == WALL)
-        return;
+    int boxRow = board.playerY + dy;
+    int boxCol = board.playerX + dx;
 
-    /* Moving to an empty space or target */
-    if(grid[newY][newX] == EMPTY || grid[newY][newX] == TARGET)
+    /* Keep the box's processor type with it when it is pushed */
+    if(BoardMove(&board, dx, dy) == MOVE_PUSH && chips.idAt)
     {
-        /* Update player's current position */
-        if(grid[playerY][playerX] == PLAYER_ON_TARGET)
-            grid[playerY][playerX] = TARGET;
-        else
-            grid[playerY][playerX] = EMPTY;
-
-        /* Update player's new position */
-        if(grid[newY][newX] == TARGET)
-            grid[newY][newX] = PLAYER_ON_TARGET;
-        else
-            grid[newY][newX] = PLAYER;
-
-        playerX = newX;
-        playerY = newY;
-    }
-    /* Moving a box */
-    else if(grid[newY][newX] == BOX || grid[newY][newX] == BOX_ON_TARGET)
-    {
-        int boxNewX = newX + dx;
-        int boxNewY = newY + dy;
-        int boxIndex;
+        int boxIndex = CHIP_AT(&chips, CELL_INDEX(&board, boxCol, boxRow));
 
-        /* Check if the box can be moved */
-        if(boxNewX < 0 || boxNewY < 0 || boxNewX >= levelWidth || boxNewY >= levelHeight)
-            return;
+        ChipsMove(&chips, CELL_INDEX(&board, boxCol, boxRow),
+                  CELL_INDEX(&board, boxCol + dx, boxRow + dy));
 
-        if(grid[boxNewY][boxNewX] == WALL || grid[boxNewY][boxNewX] == BOX || grid[boxNewY][boxNewX] == BOX_ON_TARGET)
-            return;
-            
-        /* Find the box being moved and update its position in our tracking array */
-        boxIndex = FindBoxIndex(newY, newX);
-        oldBoxRow = boxTypes[boxIndex][0];
-        oldBoxCol = boxTypes[boxIndex][1];
-        
-        /* Update the box position in our tracking array */
-        boxTypes[boxIndex][0] = boxNewY;
-        boxTypes[boxIndex][1] = boxNewX;
-
-        /* Move the box */
-        if(grid[boxNewY][boxNewX] == TARGET)
-            grid[boxNewY][boxNewX] = BOX_ON_TARGET;
-        else
-            grid[boxNewY][boxNewX] = BOX;
-
-        /* Update player's current position */
-        if(grid[playerY][playerX] == PLAYER_ON_TARGET)
-            grid[playerY][playerX] = TARGET;
-        else
-            grid[playerY][playerX] = EMPTY;
-
-        /* Update player's new position */
-        if(grid[newY][newX] == BOX_ON_TARGET)
-            grid[newY][newX] = PLAYER_ON_TARGET;
-        else
-            grid[newY][newX] = PLAYER;
-
-        playerX = newX;
-        playerY = newY;
+        /* Only the moved chip's socket is matched again */
+        if (matchReady) {
+            int k;
+
+            for (k = 0; k < numSockets; k++)
+                ASSIGN_COST(&socketMatch, k, boxIndex) = ChipCost(k, boxIndex);
+            AssignColumn(&socketMatch, &socketMatch, boxIndex);
+            UpdateWindowTitle(hwnd, currentLevel);
+        }
     }
 
     /* Redraw the window - FALSE means don't erase background first (prevents flicker) */
@@ -1060,6 +1006,17 @@ void UpdateWindowTitle(HWND hwnd, const char *levelName)
         sprintf(title, "RISCoban - %s", levelName);
     }
 
+    /* Strict mode says how far the chips are from their sockets */
+    if (StrictPending()) {
+        strcat(title, " - Strict, typing the sockets...");
+    } else if (strictMode && !matchReady) {
+        strcat(title, " - Strict");
+    } else if (strictMode && socketMatch.total >= ASSIGN_INFINITE) {
+        strcat(title, " - Strict, a chip can no longer reach its socket");
+    } else if (strictMode) {
+        sprintf(title + strlen(title), " - Strict, at least %ld pushes to go", socketMatch.total);
+    }
+
     /* Set the window title */
     SetWindowText(hwnd, title);
 }
@@ -1067,19 +1024,18 @@ void UpdateWindowTitle(HWND hwnd, const char *levelName)
 /* Check if the game is complete */
 BOOL CheckWin(void)
 {
-    int i, j;
-
-    for(i = 0; i < levelHeight; i++)
-    {
-        for(j = 0; j < levelWidth; j++)
-        {
-            /* If there's a target without a box, game is not complete */
-            if(grid[i][j] == TARGET || grid[i][j] == PLAYER_ON_TARGET)
-                return FALSE;
-        }
-    }
+    int k, c;
 
     /* All targets have boxes on them */
+    if (!BoardSolved(&board) || StrictPending())
+        return FALSE;
+
+    /* And in strict mode each the right type */
+    for (k = 0; k < numSockets && socketTypes != NULL; k++) {
+        c = socketCells[k];
+        if (!Seated(c / board.width, c % board.width))
+            return FALSE;
+    }
     return TRUE;
 }
 
@@ -1227,6 +1183,12 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                         InvalidateRect(hwnd, NULL, FALSE);
                     }
                     break;
+                case 'S': /* Strict mode, starts the level over */
+                    strictMode = !strictMode;
+                    LoadLevel(currentLevel);
+                    InvalidateRect(hwnd, NULL, FALSE);
+                    break;
+
                 case 'R': /* Reset current level */
                     /* Reset the current level */
                     LoadLevel(currentLevel);
@@ -1284,6 +1246,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             InvalidateRect(hwnd, NULL, FALSE);
             break;
             
+        case WM_STRICT:
+            FinishStrict(hwnd);
+            break;
+
         case WM_TIMER:
             if (wParam == 1) {
                 /* Timer for level completion */
@@ -1304,6 +1270,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     WNDCLASSEX wc;
     HWND hwnd;
     MSG Msg;
+    int i;
     
     /* Check processor type */
     CheckProcessorType();
@@ -1319,6 +1286,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     hSocketAxpBitmap = LoadBitmap(hInstance, MAKEINTRESOURCE(IDB_SOCKET_AXP));
     hSocketPpcBitmap = LoadBitmap(hInstance, MAKEINTRESOURCE(IDB_SOCKET_PPC));
     hSocketArmBitmap = LoadBitmap(hInstance, MAKEINTRESOURCE(IDB_SOCKET_ARM));
+    BuildAtlas();
 
     /* Scan for level files and sort them */
     ScanLevelFiles();
@@ -1332,8 +1300,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         MessageBox(NULL, "No level files found in 'levels' directory!", "RISCoban Warning", MB_ICONWARNING | MB_OK);
         /* Create a dummy level in memory */
         strcpy(currentLevel, "No Levels");
-        levelWidth = 5;
-        levelHeight = 5;
+        BoardInit(&board, 5, 5);
     }
 
     /* Register the Window Class */
@@ -1367,8 +1334,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
             windowHeight = 480;
         } else {
             /* Normal game window for RISC processors */
-            windowWidth = CELL_SIZE * levelWidth + 20;  /* Client area width with margin */
-            windowHeight = CELL_SIZE * levelHeight + 20; /* Client area height with margin */
+            windowWidth = CELL_SIZE * board.width + 20;  /* Client area width with margin */
+            windowHeight = CELL_SIZE * board.height + 20; /* Client area height with margin */
         }
 
         /* Set desired client area size */
@@ -1414,7 +1381,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         DispatchMessage(&Msg);
     }
 
-    /* Clean up resources */
+    /* Clean up resources, once a solve under way has finished */
+    if (strictBusy) {
+        JoinThread(&strictThread);
+        BoardFree(&strictBoard);
+        free(strictResult);
+    }
+    for (i = 0; i < NUM_LEVELS; i++)
+        free(levelSocketTypes[i]);
+    FreeStrict();
+    BoardFree(&levelStart);
+    ChipsFree(&chips);
+    AtlasFree(&atlas);
     if (hRoboArmBitmap != NULL) {
         DeleteObject(hRoboArmBitmap);
     }
@@ -0,0 +1,248 @@
+/* RISCoban chip lookup bench
+   Builds warehouse levels with hundreds of chips, moves them about at
+   random and times finding the pushed chip and drawing every chip a
+   frame with the per-cell chip map against scanning the chip list the
+   way the game used to. Both must name the same chip every time
+   Usage: chipbench [-b boxes,...] [-p pushes] [-f frames] [-s seed]
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chips.h"
+
+#define NUM_CHIP_TYPES 4
+
+/* LURD */
+static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+
+/* The chip list as it was, scanned for the chip at a cell */
+typedef struct {
+    int count;
+    int *cell;
+    unsigned char *type;
+} ChipList;
+
+static int FindChip(const ChipList *l, int cell)
+{
+    int i;
+
+    for (i = 0; i < l->count; i++) {
+        if (l->cell[i] == cell)
+            return i;
+    }
+    return NO_CHIP;
+}
+
+/* A walled room with a chip and a socket on about one cell in four */
+static int MakeWarehouse(Board *b, int boxes, unsigned long *seed)
+{
+    int side = 2, x, y, c, placed;
+
+    while ((side - 2) * (side - 2) < boxes * 4)
+        side++;
+    if (!BoardInit(b, side, side))
+        return 0;
+    for (y = 0; y < side; y++) {
+        for (x = 0; x < side; x++) {
+            if (x == 0 || y == 0 || x == side - 1 || y == side - 1)
+                SET_BIT(b->walls, CELL_INDEX(b, x, y));
+        }
+    }
+    b->playerX = 1;
+    b->playerY = 1;
+    for (placed = 0; placed < boxes; ) {
+        c = CELL_INDEX(b, 1 + (int)(NextRandom(seed) % (side - 2)),
+                       1 + (int)(NextRandom(seed) % (side - 2)));
+        if (TEST_BIT(b->boxes, c) || c == CELL_INDEX(b, 1, 1))
+            continue;
+        SET_BIT(b->boxes, c);
+        placed++;
+    }
+    for (placed = 0; placed < boxes; ) {
+        c = CELL_INDEX(b, 1 + (int)(NextRandom(seed) % (side - 2)),
+                       1 + (int)(NextRandom(seed) % (side - 2)));
+        if (TEST_BIT(b->targets, c))
+            continue;
+        SET_BIT(b->targets, c);
+        placed++;
+    }
+    return 1;
+}
+
+static double Elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Push chips about until pushes have been made, noting each push, then find
+   and move the pushed chip along the same pushes with the map and with
+   the list. Returns pushes where they name different chips */
+static long Pushes(Board *b, ChipMap *map, ChipList *list, long pushes, unsigned long *seed,
+                 double *mapTime, double *scanTime)
+{
+    long done = 0, mismatches = 0, i;
+    int d, x, y, c, *from, *to, *byMap, *byScan;
+    clock_t start;
+
+    from = (int *)malloc(pushes * sizeof(int));
+    to = (int *)malloc(pushes * sizeof(int));
+    byMap = (int *)malloc(pushes * sizeof(int));
+    byScan = (int *)malloc(pushes * sizeof(int));
+    if (!from || !to || !byMap || !byScan) {
+        free(from);
+        free(to);
+        free(byMap);
+        free(byScan);
+        return pushes;
+    }
+    /* Random pushes soon shut the arm in and freeze the chips against the
+       walls, so move a random chip a step wherever there is room, pulls
+       included. Only the lookups are timed, not the moves */
+    while (done < pushes) {
+        x = 1 + (int)(NextRandom(seed) % (b->width - 2));
+        y = 1 + (int)(NextRandom(seed) % (b->height - 2));
+        d = (int)(NextRandom(seed) % 4);
+        c = CELL_INDEX(b, x + dx[d], y + dy[d]);
+        if (!TEST_BIT(b->boxes, CELL_INDEX(b, x, y)) || TEST_BIT(b->walls, c) ||
+            TEST_BIT(b->boxes, c))
+            continue;
+        from[done] = CELL_INDEX(b, x, y);
+        to[done] = c;
+        CLEAR_BIT(b->boxes, from[done]);
+        SET_BIT(b->boxes, c);
+        done++;
+    }
+
+    start = clock();
+    for (i = 0; i < done; i++) {
+        byMap[i] = CHIP_AT(map, from[i]);
+        ChipsMove(map, from[i], to[i]);
+    }
+    *mapTime = Elapsed(start);
+
+    start = clock();
+    for (i = 0; i < done; i++) {
+        byScan[i] = FindChip(list, from[i]);
+        if (byScan[i] != NO_CHIP)
+            list->cell[byScan[i]] = to[i];
+    }
+    *scanTime = Elapsed(start);
+
+    for (i = 0; i < done; i++) {
+        if (byMap[i] != byScan[i] || byMap[i] == NO_CHIP)
+            mismatches++;
+    }
+    free(from);
+    free(to);
+    free(byMap);
+    free(byScan);
+    return mismatches;
+}
+
+/* Look up the type of every chip as a frame of DrawGrid does, in reading
+   order over the board */
+static long Frames(const Board *b, const ChipMap *map, const ChipList *list, int frames,
+                   double *mapTime, double *scanTime)
+{
+    int cells = b->width * b->height, f, c, id;
+    long mapSum = 0, scanSum = 0;
+    clock_t start;
+
+    start = clock();
+    for (f = 0; f < frames; f++) {
+        for (c = 0; c < cells; c++) {
+            if (TEST_BIT(b->boxes, c))
+                mapSum += map->type[CHIP_AT(map, c)];
+        }
+    }
+    *mapTime = Elapsed(start);
+
+    start = clock();
+    for (f = 0; f < frames; f++) {
+        for (c = 0; c < cells; c++) {
+            if (TEST_BIT(b->boxes, c)) {
+                id = FindChip(list, c);
+                scanSum += id == NO_CHIP ? 0 : list->type[id];
+            }
+        }
+    }
+    *scanTime = Elapsed(start);
+    return mapSum != scanSum;
+}
+
+static double Rate(double count, double seconds)
+{
+    return seconds > 0 ? count / seconds : 0.0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *sizes = "25,100,400";
+    long pushes = 1000000, mismatches, failed = 0;
+    int frames = 2000, boxes, i;
+    unsigned long seed = 1, state;
+    double walkMap = 0.0, walkScan = 0.0, drawMap = 0.0, drawScan = 0.0;
+    const char *p;
+    ChipMap map;
+    ChipList list;
+    Board board;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            sizes = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            pushes = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else {
+            break;
+        }
+    }
+    if (i < argc || pushes <= 0 || frames <= 0) {
+        printf("Usage: chipbench [-b boxes,...] [-p pushes] [-f frames] [-s seed]\n");
+        return 1;
+    }
+
+    for (p = sizes; *p; p = strchr(p, ',') ? strchr(p, ',') + 1 : p + strlen(p)) {
+        boxes = atoi(p);
+        if (boxes <= 0)
+            continue;
+        state = seed ? seed : 1;
+        if (!MakeWarehouse(&board, boxes, &state) || !ChipsInit(&map, &board, NUM_CHIP_TYPES)) {
+            printf("%d boxes: out of memory\n", boxes);
+            return 2;
+        }
+
+        /* The list starts out the same as the map */
+        list.count = map.count;
+        list.cell = (int *)malloc(map.count * sizeof(int));
+        list.type = (unsigned char *)malloc(map.count);
+        if (!list.cell || !list.type) {
+            printf("%d boxes: out of memory\n", boxes);
+            return 2;
+        }
+        memcpy(list.cell, map.cellOf, map.count * sizeof(int));
+        memcpy(list.type, map.type, map.count);
+
+        mismatches = Pushes(&board, &map, &list, pushes, &state, &walkMap, &walkScan);
+        mismatches += Frames(&board, &map, &list, frames, &drawMap, &drawScan);
+
+        printf("%d boxes %dx%d: pushes/sec map=%.0f scan=%.0f  frames/sec map=%.0f scan=%.0f  speedup push=%.1fx frame=%.1fx%s\n",
+               boxes, board.width, board.height,
+               Rate((double)pushes, walkMap), Rate((double)pushes, walkScan),
+               Rate(frames, drawMap), Rate(frames, drawScan),
+               walkMap > 0 ? walkScan / walkMap : 0.0, drawMap > 0 ? drawScan / drawMap : 0.0,
+               mismatches ? "  MISMATCH" : "");
+        if (mismatches)
+            failed++;
+
+        free(list.cell);
+        free(list.type);
+        ChipsFree(&map);
+        BoardFree(&board);
+    }
+    return failed ? 1 : 0;
+}
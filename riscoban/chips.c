@@ -0,0 +1,51 @@
+/* RISCoban chips
+   Which chip sits in each cell and which processor it is, kept up to
+   date on every push so moving or drawing a chip is one lookup
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include "chips.h"
+
+void ChipsFree(ChipMap *m)
+{
+    free(m->idAt);
+    free(m->cellOf);
+    free(m->type);
+    memset(m, 0, sizeof(ChipMap));
+}
+
+/* Number the chips in reading order */
+int ChipsInit(ChipMap *m, const Board *b, int numTypes)
+{
+    int cells = b->width * b->height, c;
+
+    memset(m, 0, sizeof(ChipMap));
+    m->idAt = (int *)malloc(cells * sizeof(int));
+    m->cellOf = (int *)malloc((cells + 1) * sizeof(int));
+    m->type = (unsigned char *)malloc(cells + 1);
+    if (!m->idAt || !m->cellOf || !m->type) {
+        ChipsFree(m);
+        return 0;
+    }
+    for (c = 0; c < cells; c++) {
+        if (TEST_BIT(b->boxes, c)) {
+            m->idAt[c] = m->count;
+            m->cellOf[m->count] = c;
+            m->type[m->count] = (unsigned char)(m->count % numTypes);
+            m->count++;
+        } else {
+            m->idAt[c] = NO_CHIP;
+        }
+    }
+    return 1;
+}
+
+void ChipsMove(ChipMap *m, int from, int to)
+{
+    int id = m->idAt[from];
+
+    m->idAt[from] = NO_CHIP;
+    m->idAt[to] = id;
+    if (id != NO_CHIP)
+        m->cellOf[id] = to;
+}
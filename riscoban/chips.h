@@ -0,0 +1,29 @@
+/* RISCoban chips
+   Which chip sits in each cell and which processor it is, kept up to
+   date on every push so moving or drawing a chip is one lookup
+   Public Domain          */
+#ifndef CHIPS_H
+#define CHIPS_H
+
+#include "../sokoban/board.h"
+
+#define NO_CHIP (-1)
+
+typedef struct {
+    int count;                /* Chips on the board */
+    int *idAt;                /* Per cell, the chip there or NO_CHIP */
+    int *cellOf;              /* Per chip, its cell */
+    unsigned char *type;      /* Per chip, 0=MIPS, 1=AXP, 2=PPC, 3=ARM */
+} ChipMap;
+
+#define CHIP_AT(m, cell) ((m)->idAt[cell])
+
+/* Number the chips of a level in reading order and deal them numTypes
+   types in turn, as DealTypes does. Returns 0 if out of memory */
+int ChipsInit(ChipMap *m, const Board *b, int numTypes);
+void ChipsFree(ChipMap *m);
+
+/* The chip at from was pushed to to */
+void ChipsMove(ChipMap *m, int from, int to);
+
+#endif /* CHIPS_H */
@@ -0,0 +1,209 @@
+/* Sokoban box assignment
+   Cheapest way to give every target its own box, the Hungarian method
+   with the potentials kept so a pushed box is matched again in one pass
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include "assign.h"
+
+/* Bigger than any reduced cost */
+#define NO_DELTA 0x7FFFFFFFL
+
+void AssignFree(Assignment *a)
+{
+    free(a->cost);
+    free(a->u);
+    free(a->v);
+    free(a->rowOf);
+    free(a->minv);
+    free(a->way);
+    free(a->used);
+    memset(a, 0, sizeof(Assignment));
+}
+
+/* Allocate an assignment for rows targets and cols boxes, costs zeroed */
+int AssignInit(Assignment *a, int rows, int cols)
+{
+    memset(a, 0, sizeof(Assignment));
+    if (rows < 0 || rows > cols)
+        return 0;
+    a->rows = rows;
+    a->cols = cols;
+    a->cost = (long *)calloc((size_t)rows * cols + 1, sizeof(long));
+    a->u = (long *)calloc(rows + 1, sizeof(long));
+    a->v = (long *)calloc(cols + 1, sizeof(long));
+    a->rowOf = (int *)calloc(cols + 1, sizeof(int));
+    a->minv = (long *)malloc((cols + 1) * sizeof(long));
+    a->way = (int *)malloc((cols + 1) * sizeof(int));
+    a->used = (unsigned char *)malloc(cols + 1);
+    if (!a->cost || !a->u || !a->v || !a->rowOf || !a->minv || !a->way || !a->used) {
+        AssignFree(a);
+        return 0;
+    }
+    return 1;
+}
+
+/* Give row i, 1-based, a box along the cheapest augmenting path. The
+   potentials stay feasible and tight on every matched pair */
+static void AddRow(Assignment *a, int i)
+{
+    long *u = a->u, *v = a->v, *minv = a->minv, cur, delta;
+    int *p = a->rowOf, *way = a->way;
+    int j, j0 = 0, j1 = 0, i0;
+
+    p[0] = i;
+    for (j = 0; j <= a->cols; j++) {
+        minv[j] = NO_DELTA;
+        a->used[j] = 0;
+    }
+    do {
+        a->used[j0] = 1;
+        i0 = p[j0];
+        delta = NO_DELTA;
+        for (j = 1; j <= a->cols; j++) {
+            if (a->used[j])
+                continue;
+            cur = ASSIGN_COST(a, i0 - 1, j - 1) - u[i0] - v[j];
+            if (cur < minv[j]) {
+                minv[j] = cur;
+                way[j] = j0;
+            }
+            if (minv[j] < delta) {
+                delta = minv[j];
+                j1 = j;
+            }
+        }
+        for (j = 0; j <= a->cols; j++) {
+            if (a->used[j]) {
+                u[p[j]] += delta;
+                v[j] -= delta;
+            } else {
+                minv[j] -= delta;
+            }
+        }
+        j0 = j1;
+    } while (p[j0] != 0);
+
+    /* Flip the path back to the spare column */
+    do {
+        j1 = way[j0];
+        p[j0] = p[j1];
+        j0 = j1;
+    } while (j0);
+}
+
+/* Sum of the matched costs */
+static long Total(Assignment *a)
+{
+    long total = 0, c;
+    int j;
+
+    for (j = 1; j <= a->cols; j++) {
+        if (a->rowOf[j] == 0)
+            continue;
+        c = ASSIGN_COST(a, a->rowOf[j] - 1, j - 1);
+        if (c >= ASSIGN_INFINITE)
+            return a->total = ASSIGN_INFINITE;
+        total += c;
+    }
+    return a->total = total;
+}
+
+/* Match from nothing */
+long AssignSolve(Assignment *a)
+{
+    int i;
+
+    memset(a->u, 0, (a->rows + 1) * sizeof(long));
+    memset(a->v, 0, (a->cols + 1) * sizeof(long));
+    memset(a->rowOf, 0, (a->cols + 1) * sizeof(int));
+    for (i = 1; i <= a->rows; i++)
+        AddRow(a, i);
+    return Total(a);
+}
+
+/* The box in column col moved, match its target again from the
+   matching of from */
+long AssignColumn(Assignment *a, const Assignment *from, int col)
+{
+    long best, c;
+    int j = col + 1, i, r;
+
+    /* A spare box could take over without losing its own target, which
+       one pass does not see */
+    if (a->rows != a->cols)
+        return AssignSolve(a);
+
+    if (from != a) {
+        memcpy(a->u, from->u, (a->rows + 1) * sizeof(long));
+        memcpy(a->v, from->v, (a->cols + 1) * sizeof(long));
+        memcpy(a->rowOf, from->rowOf, (a->cols + 1) * sizeof(int));
+    }
+
+    /* Free the target of the moved box and lower the column's potential
+       until its new costs are feasible, the rest stay optimal */
+    i = a->rowOf[j];
+    a->rowOf[j] = 0;
+    best = NO_DELTA;
+    for (r = 1; r <= a->rows; r++) {
+        c = ASSIGN_COST(a, r - 1, col) - a->u[r];
+        if (c < best)
+            best = c;
+    }
+    a->v[j] = best;
+    AddRow(a, i);
+    return Total(a);
+}
+
+/* Pushes to bring a box from each cell onto goal, by pulling it back
+   from the goal with the player behind it */
+void PushDistance(const Board *b, int goal, unsigned short *dist)
+{
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    int cells = b->width * b->height;
+    int *queue;
+    int head = 0, tail = 0, c, d, x, y, px, py;
+
+    for (c = 0; c < cells; c++)
+        dist[c] = NO_PUSH_DISTANCE;
+    queue = (int *)malloc(cells * sizeof(int));
+    if (!queue)
+        return;
+
+    dist[goal] = 0;
+    queue[tail++] = goal;
+    while (head < tail) {
+        c = queue[head++];
+        for (d = 0; d < 4; d++) {
+            /* Box pulled to x, y with the player a step further on */
+            x = c % b->width + dx[d];
+            y = c / b->width + dy[d];
+            px = x + dx[d];
+            py = y + dy[d];
+            if (px < 0 || py < 0 || px >= b->width || py >= b->height ||
+                TEST_BIT(b->walls, CELL_INDEX(b, x, y)) ||
+                TEST_BIT(b->walls, CELL_INDEX(b, px, py)) ||
+                dist[CELL_INDEX(b, x, y)] != NO_PUSH_DISTANCE)
+                continue;
+            dist[CELL_INDEX(b, x, y)] = (unsigned short)(dist[c] + 1);
+            queue[tail++] = CELL_INDEX(b, x, y);
+        }
+    }
+    free(queue);
+}
+
+/* Deal the types in turn to boxes and targets in reading order */
+void DealTypes(const Board *b, int numTypes, unsigned char *boxTypes,
+               unsigned char *goalTypes)
+{
+    int cells = b->width * b->height, c, boxes = 0, goals = 0;
+
+    memset(boxTypes, 0, cells);
+    memset(goalTypes, 0, cells);
+    for (c = 0; c < cells; c++) {
+        if (TEST_BIT(b->boxes, c))
+            boxTypes[c] = (unsigned char)(boxes++ % numTypes);
+        if (TEST_BIT(b->targets, c))
+            goalTypes[c] = (unsigned char)(goals++ % numTypes);
+    }
+}
@@ -0,0 +1,54 @@
+/* Sokoban box assignment
+   Cheapest way to give every target its own box, the Hungarian method
+   with the potentials kept so a pushed box is matched again in one pass
+   Public Domain          */
+#ifndef ASSIGN_H
+#define ASSIGN_H
+
+#include "board.h"
+
+/* Cost of a box that can never reach a target, and of a matching that
+   needs one. Large enough to stand out, small enough that potentials
+   for a thousand boxes still fit a 32-bit long */
+#define ASSIGN_INFINITE 0x100000L
+#define NO_PUSH_DISTANCE 0xFFFF
+
+/* Rows are targets, columns boxes, at least as many boxes as targets */
+typedef struct {
+    int rows, cols;
+    long *cost;               /* cost[row * cols + col] */
+    long *u, *v;              /* Row and column potentials, 1-based, v[0] for the spare column */
+    int *rowOf;               /* 1-based, rowOf[j] is row + 1 matched to column j - 1, 0 for none */
+    long total;               /* Cost of the matching, ASSIGN_INFINITE if none will do */
+    long *minv;               /* Scratch */
+    int *way;
+    unsigned char *used;
+} Assignment;
+
+#define ASSIGN_COST(a, row, col) ((a)->cost[(long)(row) * (a)->cols + (col)])
+
+/* Allocate an assignment for rows targets and cols boxes, costs zeroed.
+   Returns 0 on failure or with more targets than boxes */
+int AssignInit(Assignment *a, int rows, int cols);
+void AssignFree(Assignment *a);
+
+/* Match from nothing, O(rows * rows * cols) */
+long AssignSolve(Assignment *a);
+
+/* The box in column col moved and its costs in a are new, every other
+   cost is as in from. a takes the matching of from and matches the one
+   target that lost its box again, O(rows * cols). from may be a itself.
+   Boards with spare boxes are matched from nothing */
+long AssignColumn(Assignment *a, const Assignment *from, int col);
+
+/* Pushes to bring a box from each cell onto goal with nothing else in
+   the way, NO_PUSH_DISTANCE where it cannot */
+void PushDistance(const Board *b, int goal, unsigned short *dist);
+
+/* RISCoban chip types: boxes and targets are each dealt the types in
+   turn in reading order, so a level with a box per target has as many
+   of each type as it has sockets for it. Both arrays are per cell */
+void DealTypes(const Board *b, int numTypes, unsigned char *boxTypes,
+               unsigned char *goalTypes);
+
+#endif /* ASSIGN_H */
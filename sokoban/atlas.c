@@ -0,0 +1,45 @@
+/* Sokoban sprite atlas
+   Every tile drawn once at startup into one bitmap, selected into a
+   memory DC that lives as long as the game
+   Public Domain          */
+#include <windows.h>
+#include "atlas.h"
+
+/* Room for numTiles square tiles, returns FALSE if GDI is out of room */
+BOOL AtlasInit(SpriteAtlas *a, int tileSize, int numTiles)
+{
+    HDC screen = GetDC(NULL);
+
+    a->tileSize = tileSize;
+    a->numTiles = numTiles;
+    a->dc = CreateCompatibleDC(screen);
+    a->bitmap = CreateCompatibleBitmap(screen, tileSize * numTiles, tileSize);
+    ReleaseDC(NULL, screen);
+    if (a->dc == NULL || a->bitmap == NULL) {
+        if (a->dc != NULL)
+            DeleteDC(a->dc);
+        if (a->bitmap != NULL)
+            DeleteObject(a->bitmap);
+        a->dc = NULL;
+        a->bitmap = NULL;
+        return FALSE;
+    }
+    a->oldBitmap = (HBITMAP)SelectObject(a->dc, a->bitmap);
+    return TRUE;
+}
+
+void AtlasFree(SpriteAtlas *a)
+{
+    if (a->dc != NULL) {
+        SelectObject(a->dc, a->oldBitmap);
+        DeleteObject(a->bitmap);
+        DeleteDC(a->dc);
+        a->dc = NULL;
+    }
+}
+
+/* Copy a tile to x, y */
+void AtlasDraw(const SpriteAtlas *a, HDC hdc, int x, int y, int tile)
+{
+    BitBlt(hdc, x, y, a->tileSize, a->tileSize, a->dc, ATLAS_X(a, tile), 0, SRCCOPY);
+}
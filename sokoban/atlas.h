@@ -0,0 +1,26 @@
+/* Sokoban sprite atlas
+   Every tile drawn once at startup into one bitmap, selected into a
+   memory DC that lives as long as the game
+   Public Domain          */
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <windows.h>
+
+typedef struct {
+    HDC dc;                   /* Tiles side by side, draw into it to make them */
+    HBITMAP bitmap, oldBitmap;
+    int tileSize, numTiles;
+} SpriteAtlas;
+
+/* Room for numTiles square tiles, returns FALSE if GDI is out of room */
+BOOL AtlasInit(SpriteAtlas *a, int tileSize, int numTiles);
+void AtlasFree(SpriteAtlas *a);
+
+/* Left edge of a tile in a->dc */
+#define ATLAS_X(a, tile) ((tile) * (a)->tileSize)
+
+/* Copy a tile to x, y */
+void AtlasDraw(const SpriteAtlas *a, HDC hdc, int x, int y, int tile);
+
+#endif /* ATLAS_H */
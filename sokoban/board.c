@@ -0,0 +1,144 @@
+/* Sokoban board
+   Walls, boxes and targets as packed bitplanes, one bit per cell
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include "board.h"
+
+/* Allocate cleared planes for a width x height level, returns 0 on failure */
+int BoardInit(Board *b, int width, int height)
+{
+    memset(b, 0, sizeof(Board));
+    b->width = width;
+    b->height = height;
+    b->numWords = (width * height + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS;
+    if (b->numWords == 0) {
+        b->numWords = 1;
+    }
+
+    /* All four planes share one block */
+    b->storage = (BoardWord *)calloc(b->numWords * 4, sizeof(BoardWord));
+    if (!b->storage) {
+        return 0;
+    }
+    b->walls = b->storage;
+    b->boxes = b->walls + b->numWords;
+    b->targets = b->boxes + b->numWords;
+    b->dead = b->targets + b->numWords;
+    return 1;
+}
+
+void BoardFree(Board *b)
+{
+    free(b->storage);
+    memset(b, 0, sizeof(Board));
+}
+
+/* Deep copy, dst must be freed or zeroed */
+int BoardCopy(Board *dst, const Board *src)
+{
+    free(dst->storage);
+    if (!BoardInit(dst, src->width, src->height)) {
+        return 0;
+    }
+
+    /* The source planes need not be one block */
+    memcpy(dst->walls, src->walls, src->numWords * sizeof(BoardWord));
+    memcpy(dst->boxes, src->boxes, src->numWords * sizeof(BoardWord));
+    memcpy(dst->targets, src->targets, src->numWords * sizeof(BoardWord));
+    memcpy(dst->dead, src->dead, src->numWords * sizeof(BoardWord));
+    dst->playerX = src->playerX;
+    dst->playerY = src->playerY;
+    return 1;
+}
+
+/* Cell contents as the classic game element */
+int BoardCell(const Board *b, int x, int y)
+{
+    int i = CELL_INDEX(b, x, y);
+    int target = (int)TEST_BIT(b->targets, i);
+
+    if (TEST_BIT(b->walls, i))
+        return WALL;
+    if (TEST_BIT(b->boxes, i))
+        return target ? BOX_ON_TARGET : BOX;
+    if (x == b->playerX && y == b->playerY)
+        return target ? PLAYER_ON_TARGET : PLAYER;
+    return target ? TARGET : EMPTY;
+}
+
+/* Move the player one step, pushing a box if there is one */
+int BoardMove(Board *b, int dx, int dy)
+{
+    int newX = b->playerX + dx;
+    int newY = b->playerY + dy;
+    int boxNewX, boxNewY, from, to;
+
+    /* Check if the move is valid */
+    if (newX < 0 || newY < 0 || newX >= b->width || newY >= b->height)
+        return MOVE_NONE;
+
+    from = CELL_INDEX(b, newX, newY);
+    if (TEST_BIT(b->walls, from))
+        return MOVE_NONE;
+
+    /* Moving to an empty space or target */
+    if (!TEST_BIT(b->boxes, from)) {
+        b->playerX = newX;
+        b->playerY = newY;
+        return MOVE_STEP;
+    }
+
+    /* Moving a box */
+    boxNewX = newX + dx;
+    boxNewY = newY + dy;
+    if (boxNewX < 0 || boxNewY < 0 || boxNewX >= b->width || boxNewY >= b->height)
+        return MOVE_NONE;
+
+    to = CELL_INDEX(b, boxNewX, boxNewY);
+    if (TEST_BIT(b->walls, to) || TEST_BIT(b->boxes, to))
+        return MOVE_NONE;
+
+    CLEAR_BIT(b->boxes, from);
+    SET_BIT(b->boxes, to);
+    b->playerX = newX;
+    b->playerY = newY;
+    return MOVE_PUSH;
+}
+
+/* Every target holds a box */
+int BoardSolved(const Board *b)
+{
+    int i;
+
+    for (i = 0; i < b->numWords; i++) {
+        if (b->targets[i] & ~b->boxes[i])
+            return 0;
+    }
+    return 1;
+}
+
+int BoardCountBoxes(const Board *b)
+{
+    BoardWord w;
+    int i, count = 0;
+
+    for (i = 0; i < b->numWords; i++) {
+        /* Clear the lowest set bit until none are left */
+        for (w = b->boxes[i]; w; w &= w - 1) {
+            count++;
+        }
+    }
+    return count;
+}
+
+unsigned long NextRandom(unsigned long *state)
+{
+    unsigned long x = *state;
+
+    x ^= (x << 13) & 0xFFFFFFFFUL;
+    x ^= x >> 17;
+    x ^= (x << 5) & 0xFFFFFFFFUL;
+    *state = x;
+    return x;
+}
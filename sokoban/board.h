@@ -0,0 +1,63 @@
+/* Sokoban board
+   Walls, boxes and targets as packed bitplanes, one bit per cell
+   Public Domain          */
+#ifndef BOARD_H
+#define BOARD_H
+
+/* Game elements, as reported by BoardCell */
+#define EMPTY   0
+#define WALL    1
+#define BOX     2
+#define TARGET  3
+#define PLAYER  4
+#define BOX_ON_TARGET 5
+#define PLAYER_ON_TARGET 6
+
+/* Result of BoardMove */
+#define MOVE_NONE 0
+#define MOVE_STEP 1
+#define MOVE_PUSH 2
+
+/* 32 bits with every NT and Unix compiler, level packs store the same words */
+typedef unsigned int BoardWord;
+#define BOARD_WORD_BITS 32
+
+typedef struct {
+    int width, height;
+    int numWords;             /* Words per plane */
+    BoardWord *walls;         /* Bit y * width + x set for a wall */
+    BoardWord *boxes;
+    BoardWord *targets;
+    BoardWord *dead;          /* Squares a box can never leave toward a target */
+    int playerX, playerY;
+    BoardWord *storage;       /* Owned planes, walls may point into a level pack */
+} Board;
+
+#define CELL_INDEX(b, x, y) ((y) * (b)->width + (x))
+#define TEST_BIT(plane, i)  (((plane)[(i) / BOARD_WORD_BITS] >> ((i) % BOARD_WORD_BITS)) & 1)
+#define SET_BIT(plane, i)   ((plane)[(i) / BOARD_WORD_BITS] |= (BoardWord)1 << ((i) % BOARD_WORD_BITS))
+#define CLEAR_BIT(plane, i) ((plane)[(i) / BOARD_WORD_BITS] &= ~((BoardWord)1 << ((i) % BOARD_WORD_BITS)))
+
+/* Allocate cleared planes for a width x height level, returns 0 on failure */
+int BoardInit(Board *b, int width, int height);
+void BoardFree(Board *b);
+
+/* Deep copy, dst must be freed or zeroed */
+int BoardCopy(Board *dst, const Board *src);
+
+/* Cell contents as the classic game element */
+int BoardCell(const Board *b, int x, int y);
+
+/* Move the player one step, pushing a box if there is one */
+int BoardMove(Board *b, int dx, int dy);
+
+/* Every target holds a box */
+int BoardSolved(const Board *b);
+
+int BoardCountBoxes(const Board *b);
+
+/* xorshift32, state must not be 0. The Zobrist keys and the tools each
+   draw from their own state, so a seed gives the same run every time */
+unsigned long NextRandom(unsigned long *state);
+
+#endif /* BOARD_H */
@@ -0,0 +1,330 @@
+/* Sokoban board equivalence check
+   Replays move sequences on the bitboard and on the classic cell grid
+   and reports the first cell where they disagree
+   Usage: boardcheck [-w walks] [-l length] [-s seed] level.sok ...
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "level.h"
+#include "solver.h"
+
+/* The classic game state: one element per cell */
+typedef struct {
+    int width, height;
+    int *cells;
+    int playerX, playerY;
+} Grid;
+
+#define GRID_AT(g, x, y) ((g)->cells[(y) * (g)->width + (x)])
+
+/* The parser the game used before the bitboard, lines split with strpbrk */
+static int ParseGrid(const char *data, long size, Grid *g)
+{
+    char *text, *line, *nextLine;
+    int row, col, i;
+
+    text = (char *)malloc(size + 1);
+    if (!text) {
+        return 0;
+    }
+
+    /* First pass: determine level dimensions */
+    memcpy(text, data, size);
+    text[size] = '\0';
+    g->width = 0;
+    g->height = 0;
+    line = text;
+    while (line && *line) {
+        nextLine = strpbrk(line, "\r\n");
+        if (nextLine) {
+            char *endLine = nextLine;
+            while (*nextLine == '\r' || *nextLine == '\n') {
+                nextLine++;
+            }
+            *endLine = '\0';
+        }
+        col = (int)strlen(line);
+        if (col > 0) {
+            if (col > g->width) {
+                g->width = col;
+            }
+            g->height++;
+        }
+        if (!nextLine || !*nextLine) {
+            break;
+        }
+        line = nextLine;
+    }
+
+    g->cells = (int *)calloc(g->width * g->height + 1, sizeof(int));
+    if (!g->cells) {
+        free(text);
+        return 0;
+    }
+
+    /* Second pass: actually load the level */
+    memcpy(text, data, size);
+    text[size] = '\0';
+    row = 0;
+    line = text;
+    while (line && *line && row < g->height) {
+        nextLine = strpbrk(line, "\r\n");
+        if (nextLine) {
+            char *endLine = nextLine;
+            while (*nextLine == '\r' || *nextLine == '\n') {
+                nextLine++;
+            }
+            *endLine = '\0';
+        }
+
+        col = 0;
+        for (i = 0; line[i] != '\0' && col < g->width; i++) {
+            switch (line[i]) {
+                case '#': GRID_AT(g, col, row) = WALL; col++; break;
+                case '@': GRID_AT(g, col, row) = PLAYER;
+                          g->playerX = col; g->playerY = row; col++; break;
+                case '+': GRID_AT(g, col, row) = PLAYER_ON_TARGET;
+                          g->playerX = col; g->playerY = row; col++; break;
+                case '$': GRID_AT(g, col, row) = BOX; col++; break;
+                case '*': GRID_AT(g, col, row) = BOX_ON_TARGET; col++; break;
+                case '.': GRID_AT(g, col, row) = TARGET; col++; break;
+                case ' ': GRID_AT(g, col, row) = EMPTY; col++; break;
+                default: break;
+            }
+        }
+
+        row++;
+        if (!nextLine || !*nextLine) {
+            break;
+        }
+        line = nextLine;
+    }
+
+    free(text);
+    return 1;
+}
+
+/* The game's MovePlayer before the bitboard */
+static void MoveGrid(Grid *g, int dx, int dy)
+{
+    int newX = g->playerX + dx;
+    int newY = g->playerY + dy;
+    int *here, *next, *beyond;
+
+    if (newX < 0 || newY < 0 || newX >= g->width || newY >= g->height)
+        return;
+
+    here = &GRID_AT(g, g->playerX, g->playerY);
+    next = &GRID_AT(g, newX, newY);
+    if (*next == WALL)
+        return;
+
+    if (*next == BOX || *next == BOX_ON_TARGET) {
+        int boxNewX = newX + dx;
+        int boxNewY = newY + dy;
+
+        if (boxNewX < 0 || boxNewY < 0 || boxNewX >= g->width || boxNewY >= g->height)
+            return;
+        beyond = &GRID_AT(g, boxNewX, boxNewY);
+        if (*beyond == WALL || *beyond == BOX || *beyond == BOX_ON_TARGET)
+            return;
+
+        *beyond = (*beyond == TARGET) ? BOX_ON_TARGET : BOX;
+        *next = (*next == BOX_ON_TARGET) ? TARGET : EMPTY;
+    }
+
+    *here = (*here == PLAYER_ON_TARGET) ? TARGET : EMPTY;
+    *next = (*next == TARGET) ? PLAYER_ON_TARGET : PLAYER;
+    g->playerX = newX;
+    g->playerY = newY;
+}
+
+static int GridSolved(const Grid *g)
+{
+    int i;
+
+    for (i = 0; i < g->width * g->height; i++) {
+        if (g->cells[i] == TARGET || g->cells[i] == PLAYER_ON_TARGET)
+            return 0;
+    }
+    return 1;
+}
+
+/* First differing cell as y * width + x, -1 if the states are identical */
+static int Compare(const Grid *g, const Board *b)
+{
+    int x, y;
+
+    if (g->width != b->width || g->height != b->height)
+        return 0;
+    if (g->playerX != b->playerX || g->playerY != b->playerY)
+        return g->playerY * g->width + g->playerX;
+    for (y = 0; y < g->height; y++) {
+        for (x = 0; x < g->width; x++) {
+            if (GRID_AT(g, x, y) != BoardCell(b, x, y))
+                return y * g->width + x;
+        }
+    }
+    if (GridSolved(g) != BoardSolved(b))
+        return 0;
+    return -1;
+}
+
+static void Direction(char c, int *dx, int *dy)
+{
+    *dx = *dy = 0;
+    switch (c) {
+        case 'l': case 'L': *dx = -1; break;
+        case 'r': case 'R': *dx = 1; break;
+        case 'u': case 'U': *dy = -1; break;
+        case 'd': case 'D': *dy = 1; break;
+    }
+}
+
+/* Replay moves on both, returns the index of the first bad move or -1 */
+static long Replay(const char *data, long size, const char *moves, long count,
+                   double *gridSeconds, double *boardSeconds)
+{
+    Grid g;
+    Board b;
+    clock_t start;
+    long i;
+    int dx, dy;
+
+    memset(&g, 0, sizeof(g));
+    memset(&b, 0, sizeof(b));
+    if (!ParseGrid(data, size, &g) || !ParseLevel(data, size, &b)) {
+        free(g.cells);
+        BoardFree(&b);
+        return 0;
+    }
+
+    if (Compare(&g, &b) >= 0) {
+        free(g.cells);
+        BoardFree(&b);
+        return 0;
+    }
+
+    for (i = 0; i < count; i++) {
+        Direction(moves[i], &dx, &dy);
+        MoveGrid(&g, dx, dy);
+        BoardMove(&b, dx, dy);
+        if (Compare(&g, &b) >= 0) {
+            free(g.cells);
+            BoardFree(&b);
+            return i + 1;
+        }
+    }
+
+    /* Time each representation on its own, without the comparison */
+    free(g.cells);
+    BoardFree(&b);
+    ParseGrid(data, size, &g);
+    start = clock();
+    for (i = 0; i < count; i++) {
+        Direction(moves[i], &dx, &dy);
+        MoveGrid(&g, dx, dy);
+    }
+    *gridSeconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+    ParseLevel(data, size, &b);
+    start = clock();
+    for (i = 0; i < count; i++) {
+        Direction(moves[i], &dx, &dy);
+        BoardMove(&b, dx, dy);
+    }
+    *boardSeconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    free(g.cells);
+    BoardFree(&b);
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char dirs[] = "lrud";
+    SolveOptions options;
+    SolveResult result;
+    Board board;
+    char *data, *walk;
+    long size, length = 10000, bad, totalMoves = 0;
+    unsigned long seed = 1;
+    int walks = 20, failed = 0, checked = 0, i, w;
+    double gridSeconds = 0.0, boardSeconds = 0.0;
+
+    InitSolveOptions(&options);
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            walks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            length = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else {
+            break;
+        }
+    }
+
+    if (i >= argc) {
+        printf("Usage: boardcheck [-w walks] [-l length] [-s seed] level.sok ...\n");
+        return 1;
+    }
+
+    walk = (char *)malloc(length + 1);
+    if (!walk) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    for (; i < argc; i++) {
+        data = ReadTextFile(argv[i], &size);
+        if (!data) {
+            printf("%s: cannot read\n", argv[i]);
+            failed++;
+            continue;
+        }
+        checked++;
+
+        /* The solver's solution is a recorded game that ends solved */
+        if (ParseLevel(data, size, &board)) {
+            SolveLevel(&board, &options, &result);
+            BoardFree(&board);
+            if (result.solution) {
+                bad = Replay(data, size, result.solution, (long)strlen(result.solution),
+                             &gridSeconds, &boardSeconds);
+                if (bad >= 0) {
+                    printf("%s: solution differs after move %ld\n", argv[i], bad);
+                    failed++;
+                }
+                totalMoves += (long)strlen(result.solution);
+            }
+            FreeSolveResult(&result);
+        }
+
+        /* Seeded random walks bump into walls and push boxes into corners */
+        for (w = 0; w < walks; w++) {
+            long m;
+
+            srand((unsigned)(seed + w));
+            for (m = 0; m < length; m++) {
+                walk[m] = dirs[rand() % 4];
+            }
+            bad = Replay(data, size, walk, length, &gridSeconds, &boardSeconds);
+            if (bad >= 0) {
+                printf("%s: walk %d differs after move %ld\n", argv[i], w, bad);
+                failed++;
+                break;
+            }
+            totalMoves += length;
+        }
+
+        free(data);
+    }
+
+    free(walk);
+    printf("total: levels=%d mismatches=%d moves=%ld grid=%.3fs board=%.3fs\n",
+           checked, failed, totalMoves, gridSeconds, boardSeconds);
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,284 @@
+/* Sokoban level collection
+   Multi-level .sok/XSB files, memory-mapped and indexed on demand
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "collection.h"
+#include "level.h"
+
+/* Map a collection file, nothing is read until a level is asked for */
+int OpenCollection(LevelCollection *c, const char *path)
+{
+#ifdef _WIN32
+    HANDLE file, mapping;
+    DWORD size;
+#else
+    struct stat st;
+    void *view;
+    int fd;
+#endif
+
+    memset(c, 0, sizeof(LevelCollection));
+    c->tailTitle = -1;
+
+#ifdef _WIN32
+    file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+    size = GetFileSize(file, NULL);
+    c->file = file;
+    c->size = (long)size;
+
+    /* An empty file cannot be mapped, it just has no levels */
+    if (size == 0)
+        return 1;
+
+    mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        c->file = NULL;
+        return 0;
+    }
+    c->mapping = mapping;
+    c->data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!c->data) {
+        CloseCollection(c);
+        return 0;
+    }
+#else
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return 0;
+    }
+    c->size = (long)st.st_size;
+    if (c->size > 0) {
+        view = mmap(NULL, c->size, PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+        c->data = (const char *)view;
+    }
+
+    /* The mapping stays valid after the descriptor is closed */
+    close(fd);
+#endif
+    return 1;
+}
+
+void CloseCollection(LevelCollection *c)
+{
+#ifdef _WIN32
+    if (c->data)
+        UnmapViewOfFile((LPVOID)c->data);
+    if (c->mapping)
+        CloseHandle((HANDLE)c->mapping);
+    if (c->file)
+        CloseHandle((HANDLE)c->file);
+#else
+    if (c->data)
+        munmap((void *)c->data, c->size);
+#endif
+    free(c->levels);
+    memset(c, 0, sizeof(LevelCollection));
+}
+
+/* Find the end of the line starting at pos */
+static long LineEnd(const char *data, long size, long pos)
+{
+    while (pos < size && data[pos] != '\r' && data[pos] != '\n')
+        pos++;
+    return pos;
+}
+
+/* Step over exactly one line break, blank lines separate levels */
+static long NextLine(const char *data, long size, long pos)
+{
+    if (pos < size && data[pos] == '\r')
+        pos++;
+    if (pos < size && data[pos] == '\n')
+        pos++;
+    return pos;
+}
+
+/* Only board characters and at least one wall */
+static int IsBoardLine(const char *line, long len)
+{
+    int wall = 0;
+    long i;
+
+    for (i = 0; i < len; i++) {
+        if (line[i] == '#')
+            wall = 1;
+        else if (!strchr(" @+$*.-_", line[i]))
+            return 0;
+    }
+    return wall;
+}
+
+/* "Title:" lines win, then comments and bare names; other "Key: value"
+   metadata such as "Author:" is never a title */
+static int TitleRank(const char *line, long len)
+{
+    long i;
+    int text = 0;
+
+    if (len >= 6 && strncmp(line, "Title:", 6) == 0)
+        return 2;
+    for (i = 0; i < len; i++) {
+        if (line[i] == ':' && line[0] != ';')
+            return 0;
+        if (line[i] != ' ' && line[i] != '\t' && line[i] != ';')
+            text = 1;
+    }
+    return text;
+}
+
+/* Index one more level, returns 0 at the end of the file */
+static int IndexNext(LevelCollection *c)
+{
+    long pos = c->scanned, end, start = -1, last = -1;
+    long title = -1, titleEnd = -1;
+    int rank = 0, r;
+    LevelSpan *span;
+
+    if (c->complete)
+        return 0;
+
+    while (pos < c->size) {
+        end = LineEnd(c->data, c->size, pos);
+        if (IsBoardLine(c->data + pos, end - pos)) {
+            if (start < 0)
+                start = pos;
+            last = end;
+        } else if (start >= 0) {
+            /* The board is over, this line belongs to the next gap */
+            break;
+        } else {
+            r = TitleRank(c->data + pos, end - pos);
+            if (r > 0 && r >= rank) {
+                title = pos;
+                titleEnd = end;
+                rank = r;
+            }
+        }
+        pos = NextLine(c->data, c->size, end);
+    }
+    c->scanned = pos;
+
+    if (start < 0) {
+        c->complete = 1;
+        c->tailTitle = title;
+        c->tailTitleEnd = titleEnd;
+        c->tailTitleRank = rank;
+        return 0;
+    }
+
+    if (c->numLevels == c->capacity) {
+        long cap = c->capacity ? c->capacity * 2 : 256;
+        LevelSpan *levels = (LevelSpan *)realloc(c->levels, cap * sizeof(LevelSpan));
+        if (!levels) {
+            c->complete = 1;
+            return 0;
+        }
+        c->levels = levels;
+        c->capacity = cap;
+    }
+
+    span = &c->levels[c->numLevels++];
+    span->start = start;
+    span->end = last;
+    span->title = title;
+    span->titleEnd = titleEnd;
+    span->titleRank = rank;
+    return 1;
+}
+
+/* Index just far enough to tell whether level n exists */
+int CollectionHasLevel(LevelCollection *c, long n)
+{
+    if (n < 0)
+        return 0;
+    while (c->numLevels <= n) {
+        if (!IndexNext(c))
+            return 0;
+    }
+    return 1;
+}
+
+/* Index the whole file, returns the number of levels */
+long CollectionCount(LevelCollection *c)
+{
+    while (IndexNext(c))
+        ;
+    return c->numLevels;
+}
+
+/* Parse level n into a new board, returns 0 if there is no such level */
+int CollectionLevel(LevelCollection *c, long n, Board *board)
+{
+    if (!CollectionHasLevel(c, n))
+        return 0;
+    return ParseXsbLevel(c->data + c->levels[n].start,
+                         c->levels[n].end - c->levels[n].start, board);
+}
+
+/* Files name their levels either before the board or with a "Title:"
+   line after it, the first two levels tell which */
+static int TitlesAfter(LevelCollection *c)
+{
+    if (c->levels[0].titleRank == 2)
+        return 0;
+    if (CollectionHasLevel(c, 1))
+        return c->levels[1].titleRank == 2;
+    return c->tailTitleRank == 2;
+}
+
+/* Copy the title of level n, empty if it has none */
+void CollectionTitle(LevelCollection *c, long n, char *title, int size)
+{
+    long from = -1, to = -1, len;
+
+    title[0] = '\0';
+    if (!CollectionHasLevel(c, n))
+        return;
+
+    if (!TitlesAfter(c)) {
+        from = c->levels[n].title;
+        to = c->levels[n].titleEnd;
+    } else if (CollectionHasLevel(c, n + 1)) {
+        from = c->levels[n + 1].title;
+        to = c->levels[n + 1].titleEnd;
+    } else {
+        from = c->tailTitle;
+        to = c->tailTitleEnd;
+    }
+    if (from < 0)
+        return;
+
+    /* Drop the comment marker, the key and surrounding blanks */
+    if (to - from >= 6 && strncmp(c->data + from, "Title:", 6) == 0)
+        from += 6;
+    while (from < to && (c->data[from] == ';' || c->data[from] == ' ' || c->data[from] == '\t'))
+        from++;
+    while (to > from && (c->data[to - 1] == ' ' || c->data[to - 1] == '\t'))
+        to--;
+
+    len = to - from;
+    if (len > size - 1)
+        len = size - 1;
+    memcpy(title, c->data + from, len);
+    title[len] = '\0';
+}
@@ -0,0 +1,44 @@
+/* Sokoban level collection
+   Multi-level .sok/XSB files, memory-mapped and indexed on demand
+   Public Domain          */
+#ifndef COLLECTION_H
+#define COLLECTION_H
+
+#include "board.h"
+
+/* Where one level lives in the file */
+typedef struct {
+    long start, end;          /* Board lines */
+    long title, titleEnd;     /* Best title line in the gap before it, title < 0 if none */
+    int titleRank;            /* 2 for a "Title:" line, 1 for a comment or name */
+} LevelSpan;
+
+typedef struct {
+    const char *data;         /* The mapped file */
+    long size;
+    LevelSpan *levels;        /* Index, filled in as far as anyone has asked */
+    long numLevels, capacity;
+    long scanned;             /* Bytes indexed so far */
+    int complete;             /* Reached the end of the file */
+    long tailTitle, tailTitleEnd; /* Title line after the last level */
+    int tailTitleRank;
+    void *file, *mapping;     /* Handles for the OS mapping */
+} LevelCollection;
+
+/* Map a collection file, nothing is read until a level is asked for */
+int OpenCollection(LevelCollection *c, const char *path);
+void CloseCollection(LevelCollection *c);
+
+/* Index just far enough to tell whether level n exists */
+int CollectionHasLevel(LevelCollection *c, long n);
+
+/* Index the whole file, returns the number of levels */
+long CollectionCount(LevelCollection *c);
+
+/* Parse level n into a new board, returns 0 if there is no such level */
+int CollectionLevel(LevelCollection *c, long n, Board *board);
+
+/* Copy the title of level n, empty if it has none */
+void CollectionTitle(LevelCollection *c, long n, char *title, int size);
+
+#endif /* COLLECTION_H */
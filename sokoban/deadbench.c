@@ -0,0 +1,101 @@
+/* Sokoban deadlock analysis benchmark
+   Times the dead square pass done at level load and the freeze check
+   done after every push
+   Usage: deadbench [-r repeat] [-l length] level.sok ...
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "level.h"
+#include "deadlock.h"
+
+int main(int argc, char *argv[])
+{
+    static const int dirX[4] = {-1, 0, 1, 0};
+    static const int dirY[4] = {0, -1, 0, 1};
+    Board board, start;
+    char *data;
+    long size, length = 100000, repeat = 1000, r, m, pushes, stuck;
+    long totalPushes = 0, totalStuck = 0;
+    int i, c, d, dead, floor, levels = 0, failed = 0;
+    double loadSeconds, checkSeconds, totalLoad = 0.0, totalCheck = 0.0;
+    clock_t t;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeat = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            length = atol(argv[++i]);
+        } else {
+            break;
+        }
+    }
+
+    if (i >= argc || repeat < 1) {
+        printf("Usage: deadbench [-r repeat] [-l length] level.sok ...\n");
+        return 1;
+    }
+
+    memset(&start, 0, sizeof(start));
+    for (; i < argc; i++) {
+        data = ReadTextFile(argv[i], &size);
+        if (!data || !ParseLevel(data, size, &board)) {
+            printf("%s: cannot read\n", argv[i]);
+            free(data);
+            failed++;
+            continue;
+        }
+        free(data);
+        levels++;
+
+        /* Dead squares, as LoadLevel does once per level */
+        t = clock();
+        for (r = 0; r < repeat; r++) {
+            dead = FindDeadSquares(&board);
+        }
+        loadSeconds = (double)(clock() - t) / CLOCKS_PER_SEC / repeat;
+
+        floor = 0;
+        for (c = 0; c < board.width * board.height; c++) {
+            if (!TEST_BIT(board.walls, c)) {
+                floor++;
+            }
+        }
+
+        /* A random walk checking every push like MovePlayer, restarting
+           whenever it gets stuck; the time includes the moves */
+        BoardCopy(&start, &board);
+        srand(1);
+        pushes = stuck = 0;
+        t = clock();
+        for (m = 0; m < length; m++) {
+            d = rand() % 4;
+            if (BoardMove(&board, dirX[d], dirY[d]) != MOVE_PUSH) {
+                continue;
+            }
+            c = CELL_INDEX(&board, board.playerX + dirX[d], board.playerY + dirY[d]);
+            if (IS_DEADLOCK(&board, c)) {
+                stuck++;
+                BoardCopy(&board, &start);
+            }
+            pushes++;
+        }
+        checkSeconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+        printf("%s: floor=%d dead=%d load=%.2fus pushes=%ld stuck=%ld walk=%.3fs\n",
+               argv[i], floor, dead, loadSeconds * 1e6, pushes, stuck, checkSeconds);
+
+        totalLoad += loadSeconds;
+        totalCheck += checkSeconds;
+        totalPushes += pushes;
+        totalStuck += stuck;
+        BoardFree(&board);
+    }
+    BoardFree(&start);
+
+    printf("total: levels=%d load=%.2fus/level pushes=%ld stuck=%ld checked pushes/sec=%.0f\n",
+           levels, levels ? totalLoad * 1e6 / levels : 0.0, totalPushes, totalStuck,
+           totalCheck > 0 ? totalPushes / totalCheck : 0.0);
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,162 @@
+/* Sokoban deadlock detection
+   Dead squares found once per level, freeze deadlocks checked per push
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include "deadlock.h"
+
+/* Neighbour of cell in direction 0=left 1=up 2=right 3=down, -1 if off the board */
+static int Neighbour(const Board *b, int cell, int d)
+{
+    int x = cell % b->width;
+
+    switch (d) {
+        case 0: return x > 0 ? cell - 1 : -1;
+        case 1: return cell >= b->width ? cell - b->width : -1;
+        case 2: return x < b->width - 1 ? cell + 1 : -1;
+        default: return cell + b->width < b->width * b->height ? cell + b->width : -1;
+    }
+}
+
+/* Floor neighbour, -1 for walls and the outside */
+static int Floor(const Board *b, int cell, int d)
+{
+    int n = Neighbour(b, cell, d);
+
+    if (n >= 0 && TEST_BIT(b->walls, n))
+        return -1;
+    return n;
+}
+
+/* Fill b->dead with the floor squares from which no box can be pushed
+   onto any target, returns how many there are */
+int FindDeadSquares(Board *b)
+{
+    int cells = b->width * b->height;
+    int *queue;
+    int head = 0, tail = 0, c, d, p, count = 0;
+
+    memset(b->dead, 0, b->numWords * sizeof(BoardWord));
+
+    queue = (int *)malloc(cells * sizeof(int));
+    if (!queue) {
+        /* Nothing marked dead is always safe */
+        return 0;
+    }
+
+    /* Start with every floor square dead, then pull boxes back from the
+       targets; anything a box can be pulled to is alive */
+    for (c = 0; c < cells; c++) {
+        if (!TEST_BIT(b->walls, c)) {
+            SET_BIT(b->dead, c);
+        }
+    }
+    for (c = 0; c < cells; c++) {
+        if (TEST_BIT(b->targets, c)) {
+            CLEAR_BIT(b->dead, c);
+            queue[tail++] = c;
+        }
+    }
+
+    while (head < tail) {
+        c = queue[head++];
+        for (d = 0; d < 4; d++) {
+            /* Box at p, player behind it at the next square on */
+            p = Floor(b, c, d);
+            if (p < 0 || !TEST_BIT(b->dead, p) || Floor(b, p, d) < 0) {
+                continue;
+            }
+            CLEAR_BIT(b->dead, p);
+            queue[tail++] = p;
+        }
+    }
+
+    free(queue);
+
+    for (c = 0; c < cells; c++) {
+        if (TEST_BIT(b->dead, c)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* Boxes on the current chain of checks count as walls, deeper chains
+   than this give up and report no deadlock */
+#define MAX_FREEZE_DEPTH 64
+
+typedef struct {
+    const Board *b;
+    int path[MAX_FREEZE_DEPTH];
+    int depth;
+} FreezeCheck;
+
+static int Frozen(FreezeCheck *f, int cell, int *offTarget);
+
+static int IsWallFor(const FreezeCheck *f, int cell)
+{
+    int i;
+
+    if (cell < 0 || TEST_BIT(f->b->walls, cell))
+        return 1;
+    for (i = 0; i < f->depth; i++) {
+        if (f->path[i] == cell)
+            return 1;
+    }
+    return 0;
+}
+
+/* Can the box at cell not move along the axis through directions d and d + 2? */
+static int Blocked(FreezeCheck *f, int cell, int d, int *offTarget)
+{
+    const Board *b = f->b;
+    int n1 = Neighbour(b, cell, d);
+    int n2 = Neighbour(b, cell, d + 2);
+
+    /* A wall or the edge on either side */
+    if (IsWallFor(f, n1) || IsWallFor(f, n2))
+        return 1;
+
+    /* Dead squares on both sides, moving would lose anyway */
+    if (TEST_BIT(b->dead, n1) && TEST_BIT(b->dead, n2))
+        return 1;
+
+    /* A frozen box on either side */
+    if (TEST_BIT(b->boxes, n1) && Frozen(f, n1, offTarget))
+        return 1;
+    if (TEST_BIT(b->boxes, n2) && Frozen(f, n2, offTarget))
+        return 1;
+
+    return 0;
+}
+
+/* Box at cell blocked on both axes, counting frozen boxes off target */
+static int Frozen(FreezeCheck *f, int cell, int *offTarget)
+{
+    int off = 0, frozen;
+
+    if (f->depth == MAX_FREEZE_DEPTH)
+        return 0;
+
+    /* Treat this box as a wall while its neighbours are checked */
+    f->path[f->depth++] = cell;
+    frozen = Blocked(f, cell, 0, &off) && Blocked(f, cell, 1, &off);
+    f->depth--;
+
+    /* Neighbours only count if they really are held by this box */
+    if (!frozen)
+        return 0;
+    *offTarget += off + !TEST_BIT(f->b->targets, cell);
+    return 1;
+}
+
+/* Is the box at cell stuck for good off a target? */
+int IsFreezeDeadlock(const Board *b, int cell)
+{
+    FreezeCheck f;
+    int offTarget = 0;
+
+    f.b = b;
+    f.depth = 0;
+    return Frozen(&f, cell, &offTarget) && offTarget > 0;
+}
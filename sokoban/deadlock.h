@@ -0,0 +1,19 @@
+/* Sokoban deadlock detection
+   Dead squares found once per level, freeze deadlocks checked per push
+   Public Domain          */
+#ifndef DEADLOCK_H
+#define DEADLOCK_H
+
+#include "board.h"
+
+/* Fill b->dead with the floor squares from which no box can be pushed
+   onto any target, returns how many there are */
+int FindDeadSquares(Board *b);
+
+/* Is the box at cell stuck for good off a target? */
+int IsFreezeDeadlock(const Board *b, int cell);
+
+/* A push onto cell lost the level */
+#define IS_DEADLOCK(b, cell) (TEST_BIT((b)->dead, cell) || IsFreezeDeadlock(b, cell))
+
+#endif /* DEADLOCK_H */
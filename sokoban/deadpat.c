@@ -0,0 +1,238 @@
+/* Sokoban deadlock patterns
+   Small windows of walls and boxes that can never be cleared, found
+   offline by patgen and mapped straight from a file
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "deadpat.h"
+
+/* Patterns in a window, 0 if it is too small or too big for a table */
+long CountPatterns(int width, int height)
+{
+    long count = 1;
+    int i;
+
+    if (width < 3 || height < 3 || width * height > MAX_PATTERN_CELLS)
+        return 0;
+    for (i = 1; i < width * height; i++)
+        count *= 3;
+    return count;
+}
+
+/* Check the header and point the table at the bits */
+static int ReadHeader(PatternTable *t, const BoardWord *words, long size)
+{
+    long count;
+
+    if (size < PATTERN_HEADER_WORDS * (long)sizeof(BoardWord))
+        return 0;
+    if (words[0] != PATTERN_MAGIC || words[1] != PATTERN_VERSION)
+        return 0;
+    count = CountPatterns((int)words[2], (int)words[3]);
+    if (count == 0 || (long)words[4] != count ||
+        size < (PATTERN_HEADER_WORDS + (count + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS) *
+               (long)sizeof(BoardWord))
+        return 0;
+
+    t->width = (int)words[2];
+    t->height = (int)words[3];
+    t->count = count;
+    t->dead = (long)words[5];
+    t->bits = words + PATTERN_HEADER_WORDS;
+    return 1;
+}
+
+/* Map a pattern file, startup is the one mapping call */
+int OpenPatterns(PatternTable *t, const char *path)
+{
+#ifdef _WIN32
+    HANDLE file, mapping;
+    DWORD size;
+#else
+    struct stat st;
+    void *view;
+    int fd;
+#endif
+
+    memset(t, 0, sizeof(PatternTable));
+
+#ifdef _WIN32
+    file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+    t->file = file;
+    size = GetFileSize(file, NULL);
+    t->size = (long)size;
+    if (size == 0) {
+        ClosePatterns(t);
+        return 0;
+    }
+    mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        ClosePatterns(t);
+        return 0;
+    }
+    t->mapping = mapping;
+    t->view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    t->size = (long)st.st_size;
+    view = mmap(NULL, t->size, PROT_READ, MAP_SHARED, fd, 0);
+    t->view = view == MAP_FAILED ? NULL : view;
+
+    /* The mapping stays valid after the descriptor is closed */
+    close(fd);
+#endif
+    if (!t->view || !ReadHeader(t, (const BoardWord *)t->view, t->size)) {
+        ClosePatterns(t);
+        return 0;
+    }
+    return 1;
+}
+
+void ClosePatterns(PatternTable *t)
+{
+#ifdef _WIN32
+    if (t->view)
+        UnmapViewOfFile(t->view);
+    if (t->mapping)
+        CloseHandle((HANDLE)t->mapping);
+    if (t->file)
+        CloseHandle((HANDLE)t->file);
+#else
+    if (t->view)
+        munmap(t->view, t->size);
+#endif
+    memset(t, 0, sizeof(PatternTable));
+}
+
+/* Cells as far from the pushed box as any window reaches, 3 by 5 at most */
+#define MAX_REACH 3
+#define TARGET_DIGIT 3
+
+/* Pattern index of the window with the box in the middle of around,
+   read left to right or mirrored as stepX and stepY say. -1 if a target
+   is inside */
+static long WindowIndex(const PatternTable *t, unsigned char around[][2 * MAX_REACH + 1],
+                        int stepX, int stepY)
+{
+    long index = 0, digit = 1;
+    int i, j, v;
+
+    for (j = 0; j < t->height; j++) {
+        for (i = 0; i < t->width; i++) {
+            if (i == 1 && j == 1)
+                continue;
+            v = around[MAX_REACH + (j - 1) * stepY][MAX_REACH + (i - 1) * stepX];
+            if (v == TARGET_DIGIT)
+                return -1;
+            index += v * digit;
+            digit *= 3;
+        }
+    }
+    return index;
+}
+
+/* No wall, box or board edge on the eight cells round x, y */
+static int FloorAllRound(const Board *b, int x, int y)
+{
+    int dx, dy, c;
+
+    if (x < 1 || y < 1 || x >= b->width - 1 || y >= b->height - 1)
+        return 0;
+    for (dy = -1; dy <= 1; dy++) {
+        for (dx = -1; dx <= 1; dx++) {
+            c = CELL_INDEX(b, x + dx, y + dy);
+            if ((dx != 0 || dy != 0) && (TEST_BIT(b->walls, c) || TEST_BIT(b->boxes, c)))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* Did pushing a box onto cell leave it in a deadlocked window? Windows
+   are tried with the box at each of their inner corners, one probe each.
+   Always 0 with no table open */
+int PatternDeadlock(const PatternTable *t, const Board *b, int cell)
+{
+    unsigned char around[2 * MAX_REACH + 1][2 * MAX_REACH + 1];
+    int x, y, dx, dy, cx, cy, c, reachX, reachY, stepX, stepY;
+    long index;
+
+    if (!t->bits || TEST_BIT(b->targets, cell))
+        return 0;
+    x = cell % b->width;
+    y = cell / b->width;
+
+    /* With floor all round, the box goes out of any window first: two
+       pushes off its nearest edge, the player coming round through the
+       edge row. A window holding it is then only dead if it was without
+       it, which this push did not cause */
+    if (FloorAllRound(b, x, y))
+        return 0;
+
+    /* Every probe reads the same few cells, look each up once */
+    reachX = t->width - 2;
+    reachY = t->height - 2;
+    for (dy = -reachY; dy <= reachY; dy++) {
+        cy = y + dy;
+        for (dx = -reachX; dx <= reachX; dx++) {
+            cx = x + dx;
+            c = CELL_INDEX(b, cx, cy);
+            around[MAX_REACH + dy][MAX_REACH + dx] = (unsigned char)
+                (cx < 0 || cy < 0 || cx >= b->width || cy >= b->height || TEST_BIT(b->walls, c) ? 1 :
+                 TEST_BIT(b->targets, c) ? TARGET_DIGIT : TEST_BIT(b->boxes, c) ? 2 : 0);
+        }
+    }
+
+    /* Three wide windows look the same mirrored, wider ones need both ways */
+    for (stepY = 1; stepY >= (t->height > 3 ? -1 : 1); stepY -= 2) {
+        for (stepX = 1; stepX >= (t->width > 3 ? -1 : 1); stepX -= 2) {
+            index = WindowIndex(t, around, stepX, stepY);
+            if (index >= 0 && TEST_BIT(t->bits, index))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static int WriteWord(FILE *f, unsigned long value)
+{
+    BoardWord w = (BoardWord)value;
+
+    return fwrite(&w, sizeof(w), 1, f) == 1;
+}
+
+/* Write bits for count patterns as a table file */
+int WritePatterns(FILE *f, int width, int height, const BoardWord *bits, long count)
+{
+    long words = (count + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS, dead = 0, i;
+
+    if (count != CountPatterns(width, height))
+        return 0;
+    for (i = 0; i < count; i++) {
+        if (TEST_BIT(bits, i))
+            dead++;
+    }
+    if (!WriteWord(f, PATTERN_MAGIC) || !WriteWord(f, PATTERN_VERSION) ||
+        !WriteWord(f, width) || !WriteWord(f, height) || !WriteWord(f, count) ||
+        !WriteWord(f, dead))
+        return 0;
+    return fwrite(bits, sizeof(BoardWord), words, f) == (size_t)words;
+}
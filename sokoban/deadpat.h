@@ -0,0 +1,59 @@
+/* Sokoban deadlock patterns
+   Small windows of walls and boxes that can never be cleared, found
+   offline by patgen and mapped straight from a file
+   Public Domain          */
+#ifndef DEADPAT_H
+#define DEADPAT_H
+
+#include <stdio.h>
+#include "board.h"
+
+/* Layout, all fields are 32-bit words in the byte order of the machine
+   that wrote them (little-endian on every NT platform):
+
+     'SOKD' version width height count dead
+     bits[(count + 31) / 32]  one per pattern, set for a deadlock
+
+   A pattern is a width by height window with the pushed box at (1, 1).
+   The other cells, row by row, are base 3 digits: 0 floor, 1 wall or off
+   the board, 2 box. That number is the pattern's index, a perfect hash,
+   so a window is one bit test.
+
+   A deadlock is a window whose boxes can never all be pushed out of it,
+   even with the player free to go anywhere and nothing but floor all
+   round. That only holds for windows without targets, lookups on any
+   others say no. */
+#define PATTERN_MAGIC   0x444B4F53UL /* "SOKD" */
+#define PATTERN_VERSION 1
+#define PATTERN_HEADER_WORDS 6
+#define MAX_PATTERN_CELLS 16
+
+typedef struct {
+    const BoardWord *bits;    /* NULL when no table is open */
+    int width, height;
+    long count;               /* Patterns, 3 to the power of cells less one */
+    long dead;
+    long size;
+    void *file, *mapping, *view;  /* Handles for the OS mapping */
+} PatternTable;
+
+/* Patterns in a window, 0 if it is too small or too big for a table */
+long CountPatterns(int width, int height);
+
+/* Map a pattern file, startup is the one mapping call */
+int OpenPatterns(PatternTable *t, const char *path);
+void ClosePatterns(PatternTable *t);
+
+/* Did pushing a box onto cell leave it in a deadlocked window? Windows
+   are tried with the box at each of their inner corners, one probe each:
+   one for 3x3, up to four mirrored ones for 4x4 after reading the 5x5
+   cells round the box. That is not one probe per push, a 4x4 lookup
+   costs four to five freeze checks (patbench), so callers ask only when
+   the freeze check misses. A box with floor all round is answered
+   without a probe. Always 0 with no table open */
+int PatternDeadlock(const PatternTable *t, const Board *b, int cell);
+
+/* Write bits for count patterns as a table file */
+int WritePatterns(FILE *f, int width, int height, const BoardWord *bits, long count);
+
+#endif /* DEADPAT_H */
@@ -3,8 +3,11 @@
 #include <io.h>      /* For _findfirst, _findnext */
 #include <stdlib.h>  /* For qsort */
 #include <search.h>  /* For _findfirst on some compilers */
+#include "level.h"
+#include "deadlock.h"
+#include "collection.h"
+#include "pack.h"
 
-#define MAX_LEVELS 100
 #define MAX_PATH 260
 
 /* String comparison function for qsort */
@@ -16,11 +19,12 @@ int main() {
     struct _finddata_t findData;
     long hFind; /* Changed from intptr_t to long for old Visual Studio */
     char searchPath[MAX_PATH];
-    char levelFiles[MAX_LEVELS][MAX_PATH];
-    char *levelFilePointers[MAX_LEVELS];
-    int numLevels = 0;
-    int i;
-    FILE *rcFile, *headerFile;
+    char **levelFilePointers = NULL;
+    Board **boardPointers = NULL;
+    long numFiles = 0, numLevels = 0, capacity = 0, count, n, i;
+    int ok;
+    LevelCollection collection;
+    FILE *rcFile, *headerFile, *packFile;
 
     printf("Generating level resources...\n");
 
@@ -36,17 +40,78 @@ int main() {
 
     /* Collect all level files */
     do {
-        if (numLevels < MAX_LEVELS) {
-            sprintf(levelFiles[numLevels], "levels\\%s", findData.name);
-            levelFilePointers[numLevels] = levelFiles[numLevels];
-            numLevels++;
+        char **files = (char **)realloc(levelFilePointers, (numFiles + 1) * sizeof(char *));
+        if (!files) {
+            printf("Out of memory!\n");
+            return 1;
+        }
+        levelFilePointers = files;
+        levelFilePointers[numFiles] = (char *)malloc(MAX_PATH);
+        if (!levelFilePointers[numFiles]) {
+            printf("Out of memory!\n");
+            return 1;
         }
-    } while (_findnext(hFind, &findData) == 0 && numLevels < MAX_LEVELS);
+        sprintf(levelFilePointers[numFiles], "levels\\%s", findData.name);
+        numFiles++;
+    } while (_findnext(hFind, &findData) == 0);
 
     _findclose(hFind);
 
     /* Sort the level filenames alphabetically */
-    qsort(levelFilePointers, numLevels, sizeof(char *), CompareStrings);
+    qsort(levelFilePointers, numFiles, sizeof(char *), CompareStrings);
+
+    /* Parse every level now so the game only points into the pack, a
+       file may be a whole collection */
+    for (i = 0; i < numFiles; i++) {
+        if (!OpenCollection(&collection, levelFilePointers[i])) {
+            printf("Failed to read %s!\n", levelFilePointers[i]);
+            return 1;
+        }
+        count = CollectionCount(&collection);
+        for (n = 0; n < count; n++) {
+            if (numLevels == capacity) {
+                Board **boards;
+
+                capacity = capacity ? capacity * 2 : 256;
+                boards = (Board **)realloc(boardPointers, capacity * sizeof(Board *));
+                if (!boards) {
+                    printf("Out of memory!\n");
+                    return 1;
+                }
+                boardPointers = boards;
+            }
+            boardPointers[numLevels] = (Board *)malloc(sizeof(Board));
+            if (!boardPointers[numLevels]) {
+                printf("Out of memory!\n");
+                return 1;
+            }
+
+            /* A single level file keeps its blank padding rows as drawn */
+            if (count == 1)
+                ok = ParseLevel(collection.data, collection.size, boardPointers[numLevels]);
+            else
+                ok = CollectionLevel(&collection, n, boardPointers[numLevels]);
+            if (!ok) {
+                printf("Failed to parse %s!\n", levelFilePointers[i]);
+                return 1;
+            }
+            FindDeadSquares(boardPointers[numLevels]);
+            numLevels++;
+        }
+        CloseCollection(&collection);
+    }
+
+    packFile = fopen("levels.pak", "wb");
+    if (!packFile) {
+        printf("Failed to create levels.pak!\n");
+        return 1;
+    }
+    if (!WritePack(packFile, boardPointers, numLevels)) {
+        fclose(packFile);
+        printf("Failed to write levels.pak!\n");
+        return 1;
+    }
+    fclose(packFile);
 
     /* Create RC file for levels */
     rcFile = fopen("levels.rc", "w");
@@ -67,41 +132,27 @@ int main() {
     fprintf(headerFile, "/* Auto-generated level resource IDs */\n");
     fprintf(headerFile, "#ifndef LEVELS_H\n");
     fprintf(headerFile, "#define LEVELS_H\n\n");
-    fprintf(headerFile, "#define IDR_LEVEL_BASE 3000\n");
-    fprintf(headerFile, "#define NUM_LEVELS %d\n\n", numLevels);
+    fprintf(headerFile, "#define IDR_LEVEL_PACK 3000\n");
 
-    /* Write RC file content */
+    /* Write RC file content, one resource holds the whole pack */
     fprintf(rcFile, "/* Auto-generated level resources */\n");
-
-    /* Generate resource definitions for each level */
-    for (i = 0; i < numLevels; i++) {
-        /* For .h file, define both the individual resource IDs and the calculation method */
-        fprintf(headerFile, "#define IDR_LEVEL_%d %d\n", i, 3000 + i);
-
-        /* For .rc file, use the same resource identifiers - make sure full path uses backslashes */
-        {
-            char correctedPath[MAX_PATH];
-            char *p;
-
-            /* Copy the path */
-            strcpy(correctedPath, levelFilePointers[i]);
-
-            /* Convert any forward slashes to backslashes */
-            for (p = correctedPath; *p; p++) {
-                if (*p == '/') {
-                    *p = '\\';
-                }
-            }
-
-            fprintf(rcFile, "%d RCDATA \"%s\"\n", 3000 + i, correctedPath);
-        }
-    }
+    fprintf(rcFile, "3000 RCDATA \"levels.pak\"\n");
 
     fprintf(headerFile, "\n#endif /* LEVELS_H */\n");
 
     fclose(rcFile);
     fclose(headerFile);
 
-    printf("Generated resources for %d level files\n", numLevels);
+    for (i = 0; i < numLevels; i++) {
+        BoardFree(boardPointers[i]);
+        free(boardPointers[i]);
+    }
+    for (i = 0; i < numFiles; i++) {
+        free(levelFilePointers[i]);
+    }
+    free(boardPointers);
+    free(levelFilePointers);
+
+    printf("Generated level pack for %ld levels from %ld files\n", numLevels, numFiles);
     return 0;
 }
\ No newline at end of file
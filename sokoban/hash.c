@@ -0,0 +1,131 @@
+/* Sokoban state hashing
+   Zobrist keys and a fixed-memory transposition table
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include "hash.h"
+
+ZobristKey zobristBox[ZOBRIST_CELLS];
+ZobristKey zobristPlayer[ZOBRIST_CELLS];
+
+static ZobristKey RandomKey(unsigned long *state)
+{
+    ZobristKey hi = NextRandom(state);
+    return (hi << 32) | NextRandom(state);
+}
+
+/* Fill the key tables, safe to call more than once. Threads only read
+   them once filled, so call it before starting any */
+void InitZobrist(void)
+{
+    static int ready = 0;
+    unsigned long state = 2463534242UL;     /* Fixed, so keys are the same on every run */
+    int i;
+
+    if (ready)
+        return;
+    for (i = 0; i < ZOBRIST_CELLS; i++) {
+        zobristBox[i] = RandomKey(&state);
+        zobristPlayer[i] = RandomKey(&state);
+    }
+    ready = 1;
+}
+
+/* Full hash of the boxes on a board, MovePlayer keeps it up to date after */
+ZobristKey HashBoxes(const Board *b)
+{
+    ZobristKey key = 0;
+    int i, cells = b->width * b->height;
+
+    for (i = 0; i < cells; i++) {
+        if (TEST_BIT(b->boxes, i)) {
+            key ^= ZOBRIST_BOX(i);
+        }
+    }
+    return key;
+}
+
+/* Allocate a table of the given size in megabytes, returns 0 on failure */
+int TTInit(TransTable *tt, int megabytes)
+{
+    unsigned long bytes, buckets = 1;
+
+    memset(tt, 0, sizeof(TransTable));
+    if (megabytes < 1) {
+        megabytes = 1;
+    }
+    bytes = (unsigned long)megabytes << 20;
+
+    /* Largest power of two bucket count that fits */
+    while (buckets * 2 * TT_BUCKET * sizeof(TTEntry) <= bytes) {
+        buckets *= 2;
+    }
+
+    tt->entries = (TTEntry *)calloc(buckets * TT_BUCKET, sizeof(TTEntry));
+    if (!tt->entries) {
+        return 0;
+    }
+    tt->numBuckets = buckets;
+    return 1;
+}
+
+void TTFree(TransTable *tt)
+{
+    free(tt->entries);
+    tt->entries = NULL;
+    tt->numBuckets = 0;
+}
+
+void TTClear(TransTable *tt)
+{
+    memset(tt->entries, 0, tt->numBuckets * TT_BUCKET * sizeof(TTEntry));
+    tt->hits = tt->misses = tt->collisions = tt->stores = tt->replaced = 0;
+}
+
+static TTEntry *Bucket(TransTable *tt, ZobristKey key)
+{
+    return tt->entries + (unsigned long)(key & (tt->numBuckets - 1)) * TT_BUCKET;
+}
+
+/* Find the entry for key, NULL if it is not stored */
+TTEntry *TTProbe(TransTable *tt, ZobristKey key)
+{
+    TTEntry *e = Bucket(tt, key);
+    int i;
+
+    for (i = 0; i < TT_BUCKET; i++) {
+        if (e[i].used && e[i].key == key) {
+            tt->hits++;
+            return &e[i];
+        }
+    }
+    tt->misses++;
+    return NULL;
+}
+
+/* Store or update key */
+void TTStore(TransTable *tt, ZobristKey key, long value, unsigned short priority)
+{
+    TTEntry *e = Bucket(tt, key);
+    TTEntry *victim = NULL;
+    int i;
+
+    for (i = 0; i < TT_BUCKET; i++) {
+        if (!e[i].used || e[i].key == key) {
+            victim = &e[i];
+            break;
+        }
+        if (!victim || e[i].priority < victim->priority) {
+            victim = &e[i];
+        }
+    }
+
+    if (victim->used && victim->key != key) {
+        tt->replaced++;
+    }
+    victim->key = key;
+    victim->value = value;
+    victim->priority = priority;
+    victim->used = 1;
+    tt->stores++;
+}
@@ -0,0 +1,64 @@
+/* Sokoban state hashing
+   Zobrist keys and a fixed-memory transposition table
+   Public Domain          */
+#ifndef HASH_H
+#define HASH_H
+
+#include "board.h"
+
+#ifdef _MSC_VER
+typedef unsigned __int64 ZobristKey;
+#else
+typedef unsigned long long ZobristKey;
+#endif
+
+/* Random keys per cell, a state key is the XOR of its boxes and the
+   normalized (lowest reachable) player cell. Boards with more cells
+   than ZOBRIST_CELLS wrap around and share keys. */
+#define ZOBRIST_CELLS 4096
+#define ZOBRIST_BOX(c)    zobristBox[(c) & (ZOBRIST_CELLS - 1)]
+#define ZOBRIST_PLAYER(c) zobristPlayer[(c) & (ZOBRIST_CELLS - 1)]
+
+extern ZobristKey zobristBox[ZOBRIST_CELLS];
+extern ZobristKey zobristPlayer[ZOBRIST_CELLS];
+
+/* Fill the key tables, safe to call more than once. Threads only read
+   them once filled, so call it before starting any */
+void InitZobrist(void);
+
+/* Full hash of the boxes on a board, MovePlayer keeps it up to date after */
+ZobristKey HashBoxes(const Board *b);
+
+/* Transposition table: buckets of TT_BUCKET entries, on a full bucket the
+   entry with the lowest priority is replaced */
+#define TT_BUCKET 4
+
+typedef struct {
+    ZobristKey key;
+    long value;               /* Caller data, e.g. a node index */
+    unsigned short priority;  /* Higher survives replacement */
+    unsigned short used;
+} TTEntry;
+
+typedef struct {
+    TTEntry *entries;
+    unsigned long numBuckets;
+    unsigned long hits;       /* Probes that found the key */
+    unsigned long misses;     /* Probes that did not */
+    unsigned long collisions; /* Key matched but the state did not, set by the caller */
+    unsigned long stores;
+    unsigned long replaced;   /* Live entries evicted by a store */
+} TransTable;
+
+/* Allocate a table of the given size in megabytes, returns 0 on failure */
+int TTInit(TransTable *tt, int megabytes);
+void TTFree(TransTable *tt);
+void TTClear(TransTable *tt);
+
+/* Find the entry for key, NULL if it is not stored */
+TTEntry *TTProbe(TransTable *tt, ZobristKey key);
+
+/* Store or update key */
+void TTStore(TransTable *tt, ZobristKey key, long value, unsigned short priority);
+
+#endif /* HASH_H */
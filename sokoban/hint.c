@@ -0,0 +1,98 @@
+/* Sokoban hints
+   The next push within a time budget, reusing earlier searches
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include "hint.h"
+#include "thread.h"
+
+/* Hints are asked for while playing, keep the solver small */
+#define HINT_MAX_NODES 2000000L
+#define HINT_TABLE_MB 16
+
+/* Share of the budget kept for finishing the expansion under way */
+#define HINT_HEADROOM 0.1
+
+/* LURD, as the solver numbers directions */
+static const int hintDX[4] = {-1, 0, 1, 0};
+static const int hintDY[4] = {0, -1, 0, 1};
+
+/* Set up for a level, returns 0 if the solver cannot take it */
+int HintInit(HintEngine *h, const Board *level)
+{
+    SolveOptions options;
+
+    memset(h, 0, sizeof(HintEngine));
+    InitSolveOptions(&options);
+    options.maxNodes = HINT_MAX_NODES;
+    options.tableMegabytes = HINT_TABLE_MB;
+    h->solver = CreateSolver(level, &options);
+    return h->solver != NULL;
+}
+
+void HintFree(HintEngine *h)
+{
+    FreeSolver(h->solver);
+    memset(h, 0, sizeof(HintEngine));
+}
+
+/* Positions are told apart by their Zobrist key, 64 bits leave a clash
+   between two box sets of one level out of reach */
+static int SamePosition(const HintEngine *h, const Board *board, ZobristKey boxKey)
+{
+    return h->boxKey == boxKey && h->playerX == board->playerX && h->playerY == board->playerY;
+}
+
+static int HintStop(void *arg)
+{
+    HintEngine *h = (HintEngine *)arg;
+
+    return h->cancel || WallSeconds() > h->deadline;
+}
+
+/* Find the next push from the position on board, searching for at most
+   budget seconds, or failing that the best guess the search has */
+int HintNext(HintEngine *h, const Board *board, ZobristKey boxKey, double budget, Hint *hint)
+{
+    long nodes = h->counters.nodes;
+    int status, outcome, cell, dir;
+
+    memset(hint, 0, sizeof(Hint));
+    if (!h->solver)
+        return HINT_NONE;
+    h->deadline = WallSeconds() + budget * (1.0 - HINT_HEADROOM);
+
+    if (!h->searching || !SamePosition(h, board, boxKey)) {
+        h->boxKey = boxKey;
+        h->playerX = board->playerX;
+        h->playerY = board->playerY;
+        h->searching = 1;
+        SolverStart(h->solver, board);
+    }
+    status = SolverRun(h->solver, HintStop, h, &h->counters);
+    hint->nodes = h->counters.nodes - nodes;
+
+    if (status == SOLVE_RUNNING) {
+        if (h->cancel)
+            return HINT_CANCELLED;
+        if (!SolverBestPush(h->solver, &cell, &dir, &hint->pushesLeft))
+            return HINT_TIMEOUT;
+        outcome = HINT_GUESS;
+    } else {
+        if (status != SOLVE_FOUND || !SolverFirstPush(h->solver, &cell, &dir, &hint->pushesLeft))
+            return HINT_NONE;
+        outcome = HINT_FOUND;
+    }
+
+    hint->boxX = cell % board->width;
+    hint->boxY = cell / board->width;
+    hint->dx = hintDX[dir];
+    hint->dy = hintDY[dir];
+    return outcome;
+}
+
+/* Stop a HintNext running on another thread */
+void HintCancel(HintEngine *h)
+{
+    h->cancel = 1;
+}
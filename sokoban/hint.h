@@ -0,0 +1,48 @@
+/* Sokoban hints
+   The next push within a time budget, reusing earlier searches
+   Public Domain          */
+#ifndef HINT_H
+#define HINT_H
+
+#include "board.h"
+#include "solver.h"
+#include "hash.h"
+
+/* HintNext outcome */
+#define HINT_FOUND     0
+#define HINT_TIMEOUT   1  /* Out of time, asking again carries on */
+#define HINT_CANCELLED 2  /* HintCancel was called, asking again carries on */
+#define HINT_NONE      3  /* No solution from here */
+#define HINT_GUESS     4  /* Out of time, the push looks best so far, asking again carries on */
+
+typedef struct {
+    int boxX, boxY;           /* Box to push */
+    int dx, dy;               /* Which way */
+    int pushesLeft;           /* Optimal pushes to solve from here, at least that many for a guess */
+    long nodes;               /* Expanded for this answer, 0 if it was known */
+} Hint;
+
+typedef struct {
+    Solver *solver;
+    ZobristKey boxKey;        /* Boxes of the search under way */
+    int playerX, playerY;     /* And where the player stood */
+    int searching;
+    SolveResult counters;
+    volatile long cancel;
+    double deadline;
+} HintEngine;
+
+/* Set up for a level, returns 0 if the solver cannot take it */
+int HintInit(HintEngine *h, const Board *level);
+void HintFree(HintEngine *h);
+
+/* Find the next push from the position on board, searching for at most
+   budget seconds, or failing that the best guess the search has. boxKey is HashBoxes of the board, which the caller
+   keeps up to date push by push. A search cut short resumes when asked
+   again from the same position. Clear h->cancel before asking */
+int HintNext(HintEngine *h, const Board *board, ZobristKey boxKey, double budget, Hint *hint);
+
+/* Stop a HintNext running on another thread */
+void HintCancel(HintEngine *h);
+
+#endif /* HINT_H */
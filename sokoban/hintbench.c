@@ -0,0 +1,242 @@
+/* Sokoban hint benchmark
+   Plays every level by asking for a hint before each push, now and then
+   making a push of its own instead and taking it back if that loses the
+   level, and reports hint latency percentiles
+   Usage: hintbench [-b budget ms] [-d deviate %] [-s seed] [-c] level.sok ...
+   -c starts a fresh engine for every new position, as if nothing was kept
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "level.h"
+#include "hint.h"
+#include "thread.h"
+
+#define MAX_ASKS 2000         /* Per level, gives up after that many */
+
+static double *latency;
+static long numLatency, latencyCapacity;
+
+static void AddLatency(double seconds)
+{
+    if (numLatency == latencyCapacity) {
+        long cap = latencyCapacity ? latencyCapacity * 2 : 4096;
+        double *grown = (double *)realloc(latency, cap * sizeof(double));
+        if (!grown)
+            return;
+        latency = grown;
+        latencyCapacity = cap;
+    }
+    latency[numLatency++] = seconds;
+}
+
+static int CompareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double Percentile(double p)
+{
+    long i = (long)(p / 100.0 * (numLatency - 1) + 0.5);
+    return numLatency ? latency[i] : 0.0;
+}
+
+/* Can the player walk to x, y without pushing anything */
+static int CanReach(const Board *b, int x, int y)
+{
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    unsigned char *seen;
+    int *stack, top = 0, c, d, nx, ny, cells = b->width * b->height, found = 0;
+
+    if (x < 0 || y < 0 || x >= b->width || y >= b->height)
+        return 0;
+    seen = (unsigned char *)calloc(cells, 1);
+    stack = (int *)malloc(cells * sizeof(int));
+    if (!seen || !stack) {
+        free(seen);
+        free(stack);
+        return 0;
+    }
+    c = CELL_INDEX(b, b->playerX, b->playerY);
+    seen[c] = 1;
+    stack[top++] = c;
+    while (top > 0 && !found) {
+        c = stack[--top];
+        found = c == CELL_INDEX(b, x, y);
+        for (d = 0; d < 4; d++) {
+            nx = c % b->width + dx[d];
+            ny = c / b->width + dy[d];
+            if (nx < 0 || ny < 0 || nx >= b->width || ny >= b->height)
+                continue;
+            if (seen[CELL_INDEX(b, nx, ny)] || TEST_BIT(b->walls, CELL_INDEX(b, nx, ny)) ||
+                TEST_BIT(b->boxes, CELL_INDEX(b, nx, ny)))
+                continue;
+            seen[CELL_INDEX(b, nx, ny)] = 1;
+            stack[top++] = CELL_INDEX(b, nx, ny);
+        }
+    }
+    free(seen);
+    free(stack);
+    return found;
+}
+
+/* Walk behind the box and push it, returns 0 if that is not possible */
+static int Push(Board *b, int boxX, int boxY, int dx, int dy)
+{
+    int oldX = b->playerX, oldY = b->playerY;
+
+    if (!CanReach(b, boxX - dx, boxY - dy))
+        return 0;
+    b->playerX = boxX - dx;
+    b->playerY = boxY - dy;
+    if (BoardMove(b, dx, dy) != MOVE_PUSH) {
+        b->playerX = oldX;
+        b->playerY = oldY;
+        return 0;
+    }
+    return 1;
+}
+
+/* Any legal push, picked at random */
+static int RandomPush(Board *b, unsigned long *rng)
+{
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    int cells = b->width * b->height, start, i, c, d;
+
+    start = (int)(NextRandom(rng) % (unsigned long)cells);
+    for (i = 0; i < cells; i++) {
+        c = (start + i) % cells;
+        if (!TEST_BIT(b->boxes, c))
+            continue;
+        for (d = 0; d < 4; d++) {
+            if (Push(b, c % b->width, c / b->width, dx[d], dy[d]))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    HintEngine engine;
+    Hint hint;
+    Board level, board, undo;
+    char *data;
+    long size, asks, found = 0, timeouts = 0, guesses = 0, none = 0, known = 0, deviations = 0;
+    long undone = 0, nodes = 0, overBudget = 0;
+    double budget = 0.05, start, spent, total = 0.0;
+    int deviate = 10, cold = 0, solved = 0, failed = 0, status, i, first;
+    unsigned long rng = 12345;
+
+    for (first = 1; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "-b") == 0 && first + 1 < argc) {
+            budget = atof(argv[++first]) / 1000.0;
+        } else if (strcmp(argv[first], "-d") == 0 && first + 1 < argc) {
+            deviate = atoi(argv[++first]);
+        } else if (strcmp(argv[first], "-s") == 0 && first + 1 < argc) {
+            rng = strtoul(argv[++first], NULL, 10);
+        } else if (strcmp(argv[first], "-c") == 0) {
+            cold = 1;
+        } else {
+            break;
+        }
+    }
+    if (first >= argc || budget <= 0) {
+        printf("Usage: hintbench [-b budget ms] [-d deviate %%] [-s seed] [-c] level.sok ...\n");
+        return 1;
+    }
+    if (rng == 0)
+        rng = 1;
+
+    for (i = first; i < argc; i++) {
+        data = ReadTextFile(argv[i], &size);
+        if (!data || !ParseLevel(data, size, &level)) {
+            printf("%s: cannot read\n", argv[i]);
+            free(data);
+            failed++;
+            continue;
+        }
+        free(data);
+        memset(&board, 0, sizeof(Board));
+        memset(&undo, 0, sizeof(Board));
+        BoardCopy(&board, &level);
+        BoardCopy(&undo, &level);
+        if (!HintInit(&engine, &level)) {
+            printf("%s: too big for the solver\n", argv[i]);
+            BoardFree(&level);
+            BoardFree(&board);
+            BoardFree(&undo);
+            failed++;
+            continue;
+        }
+
+        status = HINT_NONE;
+        for (asks = 0; asks < MAX_ASKS && !BoardSolved(&board); asks++) {
+            if (cold && status != HINT_TIMEOUT && status != HINT_GUESS) {
+                HintFree(&engine);
+                HintInit(&engine, &level);
+            }
+
+            engine.cancel = 0;
+            start = WallSeconds();
+            status = HintNext(&engine, &board, HashBoxes(&board), budget, &hint);
+            spent = WallSeconds() - start;
+            AddLatency(spent);
+            total += spent;
+            nodes += hint.nodes;
+            if (spent > budget)
+                overBudget++;
+
+            if (status == HINT_TIMEOUT || status == HINT_GUESS) {
+                /* Ask again for the proven push, as a player pressing the
+                   key again would */
+                if (status == HINT_GUESS)
+                    guesses++;
+                else
+                    timeouts++;
+                continue;
+            }
+            if (status == HINT_NONE) {
+                /* The last deviation lost the level, take it back */
+                none++;
+                undone++;
+                BoardCopy(&board, &undo);
+                continue;
+            }
+
+            found++;
+            if (hint.nodes == 0)
+                known++;
+            BoardCopy(&undo, &board);
+            if ((long)(NextRandom(&rng) % 100) < deviate && RandomPush(&board, &rng)) {
+                deviations++;
+                continue;
+            }
+            Push(&board, hint.boxX, hint.boxY, hint.dx, hint.dy);
+        }
+
+        if (BoardSolved(&board)) {
+            solved++;
+        } else {
+            printf("%s: not solved after %d hints\n", argv[i], MAX_ASKS);
+            failed++;
+        }
+        HintFree(&engine);
+        BoardFree(&level);
+        BoardFree(&board);
+        BoardFree(&undo);
+    }
+
+    qsort(latency, numLatency, sizeof(double), CompareDoubles);
+    printf("levels: solved=%d failed=%d undone=%ld budget=%.0fms%s\n",
+           solved, failed, undone, budget * 1000.0, cold ? " cold" : "");
+    printf("hints: asked=%ld found=%ld already known=%ld guesses=%ld timeouts=%ld none=%ld deviations=%ld\n",
+           numLatency, found, known, guesses, timeouts, none, deviations);
+    printf("latency ms: p50=%.3f p90=%.3f p99=%.3f max=%.3f mean=%.3f over budget=%ld\n",
+           Percentile(50) * 1e3, Percentile(90) * 1e3, Percentile(99) * 1e3,
+           Percentile(100) * 1e3, numLatency ? total / numLatency * 1e3 : 0.0, overBudget);
+    printf("nodes expanded=%ld\n", nodes);
+    free(latency);
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,249 @@
+/* Sokoban move journal
+   Every step and push in four bits, for undo, redo and saved games
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "journal.h"
+#include "level.h"
+
+#define JOURNAL_PUSH 4        /* Set in a move nibble for a push */
+
+/* LURD, as the solver numbers directions */
+static const int journalDX[4] = {-1, 0, 1, 0};
+static const int journalDY[4] = {0, -1, 0, 1};
+static const char journalSteps[] = "lurd";
+static const char journalPushes[] = "LURD";
+
+void JournalInit(Journal *j)
+{
+    memset(j, 0, sizeof(Journal));
+}
+
+void JournalFree(Journal *j)
+{
+    free(j->moves);
+    memset(j, 0, sizeof(Journal));
+}
+
+static int GetMove(const Journal *j, long n)
+{
+    return (j->moves[n / 2] >> ((n & 1) * 4)) & 0x0F;
+}
+
+static void SetMove(Journal *j, long n, int move)
+{
+    int shift = (int)(n & 1) * 4;
+
+    j->moves[n / 2] = (unsigned char)((j->moves[n / 2] & ~(0x0F << shift)) | (move << shift));
+}
+
+static int DirectionOf(int dx, int dy)
+{
+    return dx < 0 ? 0 : dy < 0 ? 1 : dx > 0 ? 2 : 3;
+}
+
+/* Room for one more move, returns 0 out of memory */
+int JournalReserve(Journal *j)
+{
+    if (j->position == j->capacity) {
+        long cap = j->capacity ? j->capacity * 2 : 1024;
+        unsigned char *moves = (unsigned char *)realloc(j->moves, cap / 2);
+
+        if (!moves)
+            return 0;
+        j->moves = moves;
+        j->capacity = cap;
+    }
+    return 1;
+}
+
+/* Record a move just made on the board, dropping anything undone */
+int JournalRecord(Journal *j, int dx, int dy, int push)
+{
+    if (!JournalReserve(j))
+        return 0;
+    SetMove(j, j->position, DirectionOf(dx, dy) | (push ? JOURNAL_PUSH : 0));
+    j->length = ++j->position;
+    return 1;
+}
+
+/* Step back, pulling the box along if the move was a push */
+int JournalUndo(Journal *j, Board *b)
+{
+    int move, d, box;
+
+    if (j->position == 0)
+        return 0;
+    move = GetMove(j, --j->position);
+    d = move & 3;
+    if (move & JOURNAL_PUSH) {
+        box = CELL_INDEX(b, b->playerX + journalDX[d], b->playerY + journalDY[d]);
+        CLEAR_BIT(b->boxes, box);
+        SET_BIT(b->boxes, CELL_INDEX(b, b->playerX, b->playerY));
+    }
+    b->playerX -= journalDX[d];
+    b->playerY -= journalDY[d];
+    return 1;
+}
+
+int JournalRedo(Journal *j, Board *b)
+{
+    int move;
+
+    if (j->position == j->length)
+        return 0;
+    move = GetMove(j, j->position);
+    if (BoardMove(b, journalDX[move & 3], journalDY[move & 3]) == MOVE_NONE)
+        return 0;
+    j->position++;
+    return 1;
+}
+
+/* Undo or redo until move n is the last one played */
+long JournalSeek(Journal *j, Board *b, long n)
+{
+    if (n < 0)
+        n = 0;
+    if (n > j->length)
+        n = j->length;
+    while (j->position > n)
+        JournalUndo(j, b);
+    while (j->position < n && JournalRedo(j, b))
+        ;
+    return j->position;
+}
+
+/* The caller put the board back at the start, keep the moves for redo */
+void JournalRestart(Journal *j)
+{
+    j->position = 0;
+}
+
+int JournalIsPush(const Journal *j, long n)
+{
+    return n >= 0 && n < j->length && (GetMove(j, n) & JOURNAL_PUSH) != 0;
+}
+
+/* Moves in LURD notation, caller frees */
+char *JournalToLurd(const Journal *j)
+{
+    char *lurd = (char *)malloc(j->length + 1);
+    long n;
+    int move;
+
+    if (!lurd)
+        return NULL;
+    for (n = 0; n < j->length; n++) {
+        move = GetMove(j, n);
+        lurd[n] = (move & JOURNAL_PUSH) ? journalPushes[move & 3] : journalSteps[move & 3];
+    }
+    lurd[n] = '\0';
+    return lurd;
+}
+
+/* Play LURD moves from the board's position, recording them */
+long JournalPlayLurd(Journal *j, Board *b, const char *lurd)
+{
+    const char *p;
+    long played = 0;
+    int d, result;
+
+    for (; *lurd; lurd++) {
+        p = strchr(journalSteps, *lurd);
+        if (!p) {
+            p = strchr(journalPushes, *lurd);
+            if (!p)
+                break;
+            d = (int)(p - journalPushes);
+        } else {
+            d = (int)(p - journalSteps);
+        }
+
+        /* The case only says what happened, the board decides. Room
+           first, the board must not move without its journal entry */
+        if (!JournalReserve(j))
+            break;
+        result = BoardMove(b, journalDX[d], journalDY[d]);
+        if (result == MOVE_NONE)
+            break;
+        JournalRecord(j, journalDX[d], journalDY[d], result == MOVE_PUSH);
+        played++;
+    }
+    return played;
+}
+
+int JournalSave(const Journal *j, const char *path)
+{
+    FILE *f;
+    char *lurd = JournalToLurd(j);
+    int ok;
+
+    if (!lurd)
+        return 0;
+    f = fopen(path, "w");
+    if (!f) {
+        free(lurd);
+        return 0;
+    }
+    ok = fprintf(f, "%s\n%ld\n", lurd, j->position) > 0;
+    if (fclose(f) != 0)
+        ok = 0;
+    free(lurd);
+    return ok;
+}
+
+/* Replay a saved game onto a board at the level's start */
+int JournalLoad(Journal *j, Board *b, const char *path)
+{
+    char *data, *line;
+    long size, length, position;
+
+    data = ReadTextFile(path, &size);
+    if (!data)
+        return 0;
+
+    /* First line the moves, then how many of them were played */
+    line = strchr(data, '\n');
+    if (line)
+        *line++ = '\0';
+    length = (long)strlen(data);
+    if (length > 0 && data[length - 1] == '\r')
+        data[--length] = '\0';
+    position = line ? atol(line) : length;
+
+    j->length = j->position = 0;
+    if (JournalPlayLurd(j, b, data) != length) {
+        JournalSeek(j, b, 0);
+        j->length = 0;
+        free(data);
+        return 0;
+    }
+    JournalSeek(j, b, position);
+    free(data);
+    return 1;
+}
+
+static unsigned long Fnv(unsigned long hash, unsigned long value)
+{
+    return ((hash ^ value) * 16777619UL) & 0xFFFFFFFFUL;
+}
+
+/* File name for a level's saved game, FNV-1a over its start position */
+void JournalName(const Board *b, char *name, int size)
+{
+    unsigned long hash = 2166136261UL;
+    char buf[16];
+    int c, cells = b->width * b->height;
+
+    hash = Fnv(hash, (unsigned long)b->width);
+    hash = Fnv(hash, (unsigned long)b->height);
+    for (c = 0; c < cells; c++)
+        hash = Fnv(hash, (unsigned long)(TEST_BIT(b->walls, c) | TEST_BIT(b->boxes, c) << 1 |
+                                         TEST_BIT(b->targets, c) << 2));
+    hash = Fnv(hash, (unsigned long)CELL_INDEX(b, b->playerX, b->playerY));
+
+    sprintf(buf, "%08lx.lurd", hash);
+    strncpy(name, buf, size - 1);
+    name[size - 1] = '\0';
+}
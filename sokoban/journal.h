@@ -0,0 +1,61 @@
+/* Sokoban move journal
+   Every step and push in four bits, for undo, redo and saved games
+   Public Domain          */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "board.h"
+
+/* A move is its direction in LURD order plus a push flag. Moves past
+   position are undone ones that redo can bring back */
+typedef struct {
+    unsigned char *moves;     /* Two moves per byte, low nibble first */
+    long length;              /* Moves recorded, including undone ones */
+    long position;            /* Moves currently played */
+    long capacity;            /* Moves that fit in the buffer */
+} Journal;
+
+void JournalInit(Journal *j);
+void JournalFree(Journal *j);
+
+/* Make room for one more move before making it on the board, so the
+   board never gets ahead of the journal. Returns 0 out of memory */
+int JournalReserve(Journal *j);
+
+/* Record a move just made on the board, dropping anything undone.
+   Returns 0 out of memory, never after JournalReserve */
+int JournalRecord(Journal *j, int dx, int dy, int push);
+
+/* Take back or replay one move, return 0 if there is none */
+int JournalUndo(Journal *j, Board *b);
+int JournalRedo(Journal *j, Board *b);
+
+/* Undo or redo until move n is the last one played, clamped to what
+   was recorded. Costs one step per move between here and n */
+long JournalSeek(Journal *j, Board *b, long n);
+
+/* The caller put the board back at the level's start itself, keep
+   every move for redo */
+void JournalRestart(Journal *j);
+
+/* Was move n a push */
+int JournalIsPush(const Journal *j, long n);
+
+/* Moves in LURD notation, lowercase steps and uppercase pushes, the
+   same as the solver writes. Caller frees */
+char *JournalToLurd(const Journal *j);
+
+/* Play LURD moves from the board's position, recording them. Stops at
+   the first one that cannot be made and returns how many were played */
+long JournalPlayLurd(Journal *j, Board *b, const char *lurd);
+
+/* Saved games are the LURD line of every recorded move, then the
+   number played. Load replays onto a board at the level's start and
+   returns 0 if the file is missing or does not fit the level */
+int JournalSave(const Journal *j, const char *path);
+int JournalLoad(Journal *j, Board *b, const char *path);
+
+/* File name for a level's saved game, from a hash of its layout */
+void JournalName(const Board *b, char *name, int size);
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,152 @@
+/* Sokoban level parser
+   Shared by the game and the headless tools
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "level.h"
+
+/* Find the end of the line starting at pos */
+static long LineEnd(const char *data, long size, long pos)
+{
+    while (pos < size && data[pos] != '\r' && data[pos] != '\n' && data[pos] != '\0')
+        pos++;
+    return pos;
+}
+
+/* Skip all newline characters */
+static long SkipNewlines(const char *data, long size, long pos)
+{
+    while (pos < size && (data[pos] == '\r' || data[pos] == '\n'))
+        pos++;
+    return pos;
+}
+
+/* Parse .sok text into a freshly allocated board, returns 0 on failure.
+   xsb also takes '-' and '_' as floor, the game's own files skip them */
+static int ParseBoard(const char *data, long size, Board *board, int xsb)
+{
+    long pos, end;
+    int row, col, width, height, cell;
+
+    /* First pass: determine level dimensions */
+    width = 0;
+    height = 0;
+
+    pos = SkipNewlines(data, size, 0);
+    while (pos < size && data[pos] != '\0') {
+        end = LineEnd(data, size, pos);
+
+        /* Count only lines with content */
+        if (end - pos > width) {
+            width = (int)(end - pos);
+        }
+        height++;
+
+        pos = SkipNewlines(data, size, end);
+    }
+
+    if (!BoardInit(board, width, height)) {
+        return 0;
+    }
+
+    /* Second pass: actually load the level */
+    row = 0;
+    pos = SkipNewlines(data, size, 0);
+    while (pos < size && data[pos] != '\0' && row < height) {
+        end = LineEnd(data, size, pos);
+
+        col = 0;
+        for (; pos < end && col < width; pos++) {
+            cell = CELL_INDEX(board, col, row);
+            switch (data[pos]) {
+                case '#': /* Wall */
+                    SET_BIT(board->walls, cell);
+                    col++;
+                    break;
+
+                case '+': /* Player on target */
+                    SET_BIT(board->targets, cell);
+                    /* fall through */
+                case '@': /* Player */
+                    board->playerX = col;
+                    board->playerY = row;
+                    col++;
+                    break;
+
+                case '*': /* Box on target */
+                    SET_BIT(board->targets, cell);
+                    /* fall through */
+                case '$': /* Box */
+                    SET_BIT(board->boxes, cell);
+                    col++;
+                    break;
+
+                case '.': /* Target */
+                    SET_BIT(board->targets, cell);
+                    col++;
+                    break;
+
+                case '-': /* Empty space in XSB collections */
+                case '_':
+                    if (!xsb)
+                        break;
+                    /* fall through */
+                case ' ': /* Empty space */
+                    col++;
+                    break;
+
+                default:
+                    /* Skip unknown characters */
+                    break;
+            }
+        }
+
+        row++;
+        pos = SkipNewlines(data, size, end);
+    }
+
+    return 1;
+}
+
+int ParseLevel(const char *data, long size, Board *board)
+{
+    return ParseBoard(data, size, board, 0);
+}
+
+int ParseXsbLevel(const char *data, long size, Board *board)
+{
+    return ParseBoard(data, size, board, 1);
+}
+
+/* Read a whole file into a null-terminated buffer, caller frees */
+char *ReadTextFile(const char *path, long *size)
+{
+    FILE *f;
+    char *data;
+    long len;
+
+    f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data = (char *)malloc(len + 1);
+    if (!data) {
+        fclose(f);
+        return NULL;
+    }
+
+    len = (long)fread(data, 1, len, f);
+    data[len] = '\0';
+    fclose(f);
+
+    if (size) {
+        *size = len;
+    }
+    return data;
+}
@@ -0,0 +1,19 @@
+/* Sokoban level parser
+   Shared by the game and the headless tools
+   Public Domain          */
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "board.h"
+
+/* Parse .sok text into a freshly allocated board, returns 0 on failure */
+int ParseLevel(const char *data, long size, Board *board);
+
+/* The same for a level out of a collection, where '-' and '_' are floor
+   too. The game's single level files skip them, l84.sok has '_' */
+int ParseXsbLevel(const char *data, long size, Board *board);
+
+/* Read a whole file into a null-terminated buffer, caller frees */
+char *ReadTextFile(const char *path, long *size);
+
+#endif /* LEVEL_H */
@@ -0,0 +1,172 @@
+/* Sokoban level sets
+   Every level of a directory, collection, pack or single level file, in
+   the order the game plays them, for the batch tools
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+#include "levelset.h"
+#include "level.h"
+#include "collection.h"
+#include "pack.h"
+
+static SetLevel *NewLevel(LevelSet *set, const char *name, const char *title)
+{
+    SetLevel *level;
+
+    if (set->numLevels == set->capacity) {
+        long cap = set->capacity ? set->capacity * 2 : 128;
+        SetLevel *levels = (SetLevel *)realloc(set->levels, cap * sizeof(SetLevel));
+        if (!levels)
+            return NULL;
+        set->levels = levels;
+        set->capacity = cap;
+    }
+    level = &set->levels[set->numLevels++];
+    memset(level, 0, sizeof(SetLevel));
+    strncpy(level->name, name, SET_NAME - 1);
+    strncpy(level->title, title, SET_TITLE - 1);
+    return level;
+}
+
+/* A pack from genlevels, a collection, or a single level file */
+static int AddFile(LevelSet *set, const char *path)
+{
+    LevelCollection c;
+    LevelPack pack;
+    SetLevel *level;
+    Board board;
+    char name[SET_NAME], title[SET_TITLE];
+    char *data;
+    long size, count, n;
+
+    data = ReadTextFile(path, &size);
+    if (!data)
+        return 0;
+    if (OpenPack(&pack, data, size)) {
+        for (n = 0; n < pack.numLevels; n++) {
+            sprintf(name, "%.270s#%ld", path, n + 1);
+            level = NewLevel(set, name, "");
+            if (!level || !PackLevel(&pack, n, &board))
+                return 0;
+            BoardCopy(&level->board, &board);
+            BoardFree(&board);
+        }
+        free(data);
+        return 1;
+    }
+    free(data);
+
+    if (!OpenCollection(&c, path))
+        return 0;
+    count = CollectionCount(&c);
+    for (n = 0; n < count; n++) {
+        CollectionTitle(&c, n, title, SET_TITLE);
+        if (count == 1) {
+            /* Keep blank padding rows the way the game parses it */
+            level = NewLevel(set, path, title);
+            if (!level || !ParseLevel(c.data, c.size, &level->board))
+                return 0;
+        } else {
+            sprintf(name, "%.270s#%ld", path, n + 1);
+            level = NewLevel(set, name, title);
+            if (!level || !CollectionLevel(&c, n, &level->board))
+                return 0;
+        }
+    }
+    CloseCollection(&c);
+    return 1;
+}
+
+static int CompareStrings(const void *a, const void *b)
+{
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+/* Remember one file name found in a directory */
+static int AddName(char ***names, long *numNames, const char *dir, const char *entry)
+{
+    char **grown = (char **)realloc(*names, (*numNames + 1) * sizeof(char *));
+
+    if (!grown)
+        return 0;
+    *names = grown;
+    grown[*numNames] = (char *)malloc(SET_NAME);
+    if (!grown[*numNames])
+        return 0;
+    sprintf(grown[(*numNames)++], "%.200s/%.90s", dir, entry);
+    return 1;
+}
+
+/* Every .sok file in a directory, in name order like genlevels */
+static int AddDirectory(LevelSet *set, const char *path)
+{
+    char **names = NULL;
+    long numNames = 0, i;
+    int ok = 1;
+#ifdef _WIN32
+    struct _finddata_t findData;
+    long hFind;
+    char pattern[SET_NAME];
+
+    sprintf(pattern, "%.280s\\*.sok", path);
+    hFind = _findfirst(pattern, &findData);
+    if (hFind != -1) {
+        do {
+            ok = AddName(&names, &numNames, path, findData.name);
+        } while (ok && _findnext(hFind, &findData) == 0);
+        _findclose(hFind);
+    }
+#else
+    DIR *dir;
+    struct dirent *entry;
+    size_t len;
+
+    dir = opendir(path);
+    if (!dir)
+        return 0;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        len = strlen(entry->d_name);
+        if (len > 4 && strcmp(entry->d_name + len - 4, ".sok") == 0)
+            ok = AddName(&names, &numNames, path, entry->d_name);
+    }
+    closedir(dir);
+#endif
+
+    qsort(names, numNames, sizeof(char *), CompareStrings);
+    for (i = 0; i < numNames; i++) {
+        if (ok && !AddFile(set, names[i])) {
+            printf("%s: cannot read\n", names[i]);
+            ok = 0;
+        }
+        free(names[i]);
+    }
+    free(names);
+    return ok;
+}
+
+int AddLevels(LevelSet *set, const char *path)
+{
+    struct stat st;
+
+    if (stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR)
+        return AddDirectory(set, path);
+    return AddFile(set, path);
+}
+
+void FreeLevelSet(LevelSet *set)
+{
+    long n;
+
+    for (n = 0; n < set->numLevels; n++)
+        BoardFree(&set->levels[n].board);
+    free(set->levels);
+    memset(set, 0, sizeof(LevelSet));
+}
@@ -0,0 +1,29 @@
+/* Sokoban level sets
+   Every level of a directory, collection, pack or single level file, in
+   the order the game plays them, for the batch tools
+   Public Domain          */
+#ifndef LEVELSET_H
+#define LEVELSET_H
+
+#include "board.h"
+
+#define SET_NAME  300
+#define SET_TITLE 80
+
+typedef struct {
+    char name[SET_NAME];      /* File, with #n after it for a collection */
+    char title[SET_TITLE];
+    Board board;              /* Owned, even for a pack */
+} SetLevel;
+
+typedef struct {
+    SetLevel *levels;
+    long numLevels, capacity;
+} LevelSet;
+
+/* Add the levels under path. .sok files of a directory go in name order
+   like genlevels. Returns 0 if something could not be read */
+int AddLevels(LevelSet *set, const char *path);
+void FreeLevelSet(LevelSet *set);
+
+#endif /* LEVELSET_H */
@@ -0,0 +1,376 @@
+/* Sokoban macro moves
+   Level analysis for runs of pushes a search can make as one move: a box
+   pushed into a one-wide tunnel goes on to the end of it, and a box
+   pushed through the door of a goal room, targets behind a single
+   entrance, goes straight to the next target in a fixed fill order
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include "macro.h"
+
+/* LURD */
+static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+
+/* The room's cells numbered from 0: the cell outside the door where the
+   player stands to push in, the door, then the room */
+#define ROOM_LOCALS (MAX_ROOM_CELLS + 2)
+#define ROOM_STATES (ROOM_LOCALS * ROOM_LOCALS)
+#define OUTSIDE 0
+#define DOOR 1
+
+/* Fewest pushes from the door to anywhere in one room, box cell by
+   normalized player cell */
+typedef struct {
+    int n;
+    int cell[ROOM_LOCALS];
+    int next[ROOM_LOCALS][4];
+    unsigned char blocked[ROOM_LOCALS];   /* Targets filled already */
+    short parent[ROOM_STATES];            /* -1 for the start, -2 unseen */
+    unsigned char dir[ROOM_STATES];
+    short queue[ROOM_STATES];
+    short reached[ROOM_LOCALS];           /* First state with the box on each cell, -1 if none */
+    unsigned long reach[ROOM_LOCALS];
+    unsigned long stamp;
+    unsigned char stand[ROOM_LOCALS];     /* Player cells of the state being expanded */
+    short floodQueue[ROOM_LOCALS];
+} RoomSearch;
+
+/* Neighbour of a cell, -1 for a wall or off the board */
+static int Neighbour(const Board *b, int c, int d)
+{
+    int x = c % b->width + dx[d], y = c / b->width + dy[d];
+
+    if (x < 0 || y < 0 || x >= b->width || y >= b->height || TEST_BIT(b->walls, CELL_INDEX(b, x, y)))
+        return -1;
+    return CELL_INDEX(b, x, y);
+}
+
+void FreeMacros(LevelMacros *m)
+{
+    free(m->tunnel);
+    free(m->room);
+    free(m->door);
+    free(m->fill);
+    free(m->pathFrom);
+    free(m->pathDir);
+    memset(m, 0, sizeof(LevelMacros));
+}
+
+/* One-wide cells and the runs of them */
+static void FindTunnels(const Board *b, LevelMacros *m)
+{
+    int c, d;
+
+    for (c = 0; c < m->numCells; c++) {
+        if (TEST_BIT(b->walls, c))
+            continue;
+        for (d = 0; d < 2; d++) {
+            /* Across a push along direction d lie directions d + 1 and d + 3 */
+            if (Neighbour(b, c, d + 1) < 0 && Neighbour(b, c, (d + 3) & 3) < 0)
+                m->tunnel[c] |= (unsigned char)(1 << d);
+        }
+        if (m->tunnel[c])
+            m->tunnelCells++;
+    }
+    for (c = 0; c < m->numCells; c++) {
+        for (d = 0; d < 2; d++) {
+            if (IN_TUNNEL(m, c, d) &&
+                (Neighbour(b, c, d) < 0 || !IN_TUNNEL(m, Neighbour(b, c, d), d)))
+                m->corridors++;
+        }
+    }
+}
+
+/* Player cells reachable from start with the box on box, returns the
+   lowest */
+static int RoomFlood(RoomSearch *r, int box, int start)
+{
+    int head = 0, tail = 0, lowest = start, c, d, n;
+
+    r->stamp++;
+    r->reach[start] = r->stamp;
+    r->floodQueue[tail++] = (short)start;
+    while (head < tail) {
+        c = r->floodQueue[head++];
+        if (c < lowest)
+            lowest = c;
+        for (d = 0; d < 4; d++) {
+            n = r->next[c][d];
+            if (n >= 0 && n != box && !r->blocked[n] && r->reach[n] != r->stamp) {
+                r->reach[n] = r->stamp;
+                r->floodQueue[tail++] = (short)n;
+            }
+        }
+    }
+    return lowest;
+}
+
+/* Breadth first over pushes from the box on the door and the player
+   outside it, noting the first state with the box on each cell */
+static void RoomBreadthFirst(RoomSearch *r)
+{
+    int head = 0, tail = 0, state, box, d, behind, to, player;
+
+    for (state = 0; state < r->n * r->n; state++)
+        r->parent[state] = -2;
+    for (box = 0; box < r->n; box++)
+        r->reached[box] = -1;
+
+    state = DOOR * r->n + RoomFlood(r, DOOR, OUTSIDE);
+    r->parent[state] = -1;
+    r->reached[DOOR] = (short)state;
+    r->queue[tail++] = (short)state;
+    while (head < tail) {
+        state = r->queue[head++];
+        box = state / r->n;
+        RoomFlood(r, box, state % r->n);
+        for (to = 0; to < r->n; to++)
+            r->stand[to] = (unsigned char)(r->reach[to] == r->stamp);
+        for (d = 0; d < 4; d++) {
+            behind = r->next[box][(d + 2) & 3];
+            to = r->next[box][d];
+            if (behind < 0 || to <= OUTSIDE || r->blocked[to] || !r->stand[behind])
+                continue;
+            player = RoomFlood(r, to, box);
+            if (r->parent[to * r->n + player] != -2)
+                continue;
+            r->parent[to * r->n + player] = (short)state;
+            r->dir[to * r->n + player] = (unsigned char)d;
+            if (r->reached[to] < 0)
+                r->reached[to] = (short)(to * r->n + player);
+            r->queue[tail++] = (short)(to * r->n + player);
+        }
+    }
+}
+
+/* Pushes to get the box to a state, 0 for the start */
+static int RoomPushes(const RoomSearch *r, int state)
+{
+    int pushes = 0;
+
+    for (; r->parent[state] >= 0; state = r->parent[state])
+        pushes++;
+    return pushes;
+}
+
+/* Append the pushes that lead to state to the room paths, in order */
+static int AddRoomPath(LevelMacros *m, const RoomSearch *r, int state, GoalRoom *room, int k,
+                       int *capacity)
+{
+    int pushes = RoomPushes(r, state), i, parent;
+    unsigned short *from;
+    unsigned char *dir;
+
+    if (m->pathPushes + pushes > *capacity) {
+        *capacity = (m->pathPushes + pushes) * 2 + 64;
+        from = (unsigned short *)realloc(m->pathFrom, *capacity * sizeof(unsigned short));
+        if (!from)
+            return 0;
+        m->pathFrom = from;
+        dir = (unsigned char *)realloc(m->pathDir, *capacity);
+        if (!dir)
+            return 0;
+        m->pathDir = dir;
+    }
+    room->pathStart[k] = m->pathPushes;
+    room->pathLength[k] = pushes;
+    for (i = pushes - 1; i >= 0; i--) {
+        parent = r->parent[state];
+        m->pathFrom[m->pathPushes + i] = (unsigned short)r->cell[parent / r->n];
+        m->pathDir[m->pathPushes + i] = r->dir[state];
+        state = parent;
+    }
+    m->pathPushes += pushes;
+    return 1;
+}
+
+/* Fill the room from the door, farthest target first among those that
+   leave every other one reachable. Returns 0 if there is no such order */
+static int OrderRoom(const Board *b, LevelMacros *m, RoomSearch *r, GoalRoom *room, int *capacity)
+{
+    int goal[MAX_ROOM_GOALS], pushes[MAX_ROOM_GOALS], numGoals = 0;
+    int k, t, i, best, ok;
+
+    for (i = DOOR + 1; i < r->n; i++) {
+        r->blocked[i] = 0;
+        if (TEST_BIT(b->targets, r->cell[i]))
+            goal[numGoals++] = i;
+    }
+    room->numGoals = numGoals;
+
+    for (k = 0; k < numGoals; k++) {
+        RoomBreadthFirst(r);
+        for (t = 0; t < numGoals; t++) {
+            pushes[t] = r->blocked[goal[t]] || r->reached[goal[t]] < 0 ? -1 :
+                        RoomPushes(r, r->reached[goal[t]]);
+        }
+
+        /* Farthest first, filling it must not shut any other target off */
+        for (best = -1; ; pushes[best] = -1) {
+            for (t = 0, best = -1; t < numGoals; t++) {
+                if (pushes[t] >= 0 && (best < 0 || pushes[t] > pushes[best]))
+                    best = t;
+            }
+            if (best < 0)
+                return 0;
+            r->blocked[goal[best]] = 1;
+            RoomBreadthFirst(r);
+            for (i = 0, ok = 1; i < numGoals; i++) {
+                if (!r->blocked[goal[i]] && r->reached[goal[i]] < 0)
+                    ok = 0;
+            }
+            r->blocked[goal[best]] = 0;
+            if (ok)
+                break;
+        }
+
+        RoomBreadthFirst(r);
+        if (!AddRoomPath(m, r, r->reached[goal[best]], room, k, capacity))
+            return 0;
+        room->goals[k] = r->cell[goal[best]];
+        r->blocked[goal[best]] = 1;
+    }
+    return 1;
+}
+
+/* Cells behind door seen from its outside, 0 if they are not a room:
+   more than MAX_ROOM_CELLS, a way back out, a box, the player or no
+   target */
+static int FloodRoom(const Board *b, int door, int d, int *cells, unsigned char *seen)
+{
+    int head = 0, tail = 0, c, e, n, goals = 0, ok = 1, i;
+    int outside = Neighbour(b, door, (d + 2) & 3);
+    int player = CELL_INDEX(b, b->playerX, b->playerY);
+
+    cells[tail++] = Neighbour(b, door, d);
+    seen[cells[0]] = 1;
+    while (head < tail && ok) {
+        c = cells[head++];
+        if (c == outside || c == player || TEST_BIT(b->boxes, c))
+            ok = 0;
+        if (TEST_BIT(b->targets, c))
+            goals++;
+        for (e = 0; e < 4 && ok; e++) {
+            n = Neighbour(b, c, e);
+            if (n < 0 || n == door || seen[n])
+                continue;
+            if (tail == MAX_ROOM_CELLS) {
+                ok = 0;
+                break;
+            }
+            seen[n] = 1;
+            cells[tail++] = n;
+        }
+    }
+    for (i = 0; i < tail; i++)
+        seen[cells[i]] = 0;
+    return ok && goals > 0 && goals <= MAX_ROOM_GOALS ? tail : 0;
+}
+
+/* Doors, and the rooms behind them that have a fill order */
+static int FindRooms(const Board *b, LevelMacros *m, unsigned char *seen)
+{
+    int doors[MAX_ROOMS * 4], dirs[MAX_ROOMS * 4], numDoors = 0;
+    int cells[MAX_ROOM_CELLS], size, c, d, in, i, j, inner, used, capacity = 0;
+    RoomSearch *r;
+    GoalRoom *room;
+
+    /* A door is one wide across the way in, with a floor cell on each
+       side, and the cell after it is not one as well */
+    for (c = 0; c < m->numCells && numDoors < MAX_ROOMS * 4; c++) {
+        if (TEST_BIT(b->walls, c) || TEST_BIT(b->targets, c) || TEST_BIT(b->boxes, c))
+            continue;
+        for (d = 0; d < 4; d++) {
+            in = Neighbour(b, c, d);
+            if (!IN_TUNNEL(m, c, d) || in < 0 || Neighbour(b, c, (d + 2) & 3) < 0)
+                continue;
+            if (IN_TUNNEL(m, in, d) && !TEST_BIT(b->targets, in) && Neighbour(b, in, d) >= 0)
+                continue;
+            if (FloodRoom(b, c, d, cells, seen) && numDoors < MAX_ROOMS * 4) {
+                doors[numDoors] = c;
+                dirs[numDoors++] = d;
+            }
+        }
+    }
+
+    r = (RoomSearch *)malloc(sizeof(RoomSearch));
+    if (!r)
+        return 0;
+    for (i = 0; i < numDoors && m->numRooms < MAX_ROOMS; i++) {
+        size = FloodRoom(b, doors[i], dirs[i], cells, seen);
+
+        /* Take the innermost of rooms inside rooms */
+        for (j = 0, inner = 1; j < numDoors; j++) {
+            for (c = 0; c < size && j != i; c++) {
+                if (cells[c] == doors[j])
+                    inner = 0;
+            }
+        }
+        if (!inner)
+            continue;
+
+        r->n = size + 2;
+        r->cell[OUTSIDE] = Neighbour(b, doors[i], (dirs[i] + 2) & 3);
+        r->cell[DOOR] = doors[i];
+        memcpy(r->cell + DOOR + 1, cells, size * sizeof(int));
+        for (j = 0; j < r->n; j++) {
+            r->blocked[j] = 0;
+            for (d = 0; d < 4; d++) {
+                r->next[j][d] = -1;
+                in = Neighbour(b, r->cell[j], d);
+                for (c = 0; c < r->n && in >= 0; c++) {
+                    if (r->cell[c] == in)
+                        r->next[j][d] = c;
+                }
+            }
+        }
+        r->stamp = 0;
+        memset(r->reach, 0, sizeof(r->reach));
+
+        room = &m->rooms[m->numRooms];
+        room->door = doors[i];
+        room->dir = dirs[i];
+        room->numCells = size;
+        memcpy(room->cells, cells, size * sizeof(int));
+        used = m->pathPushes;
+        if (!OrderRoom(b, m, r, room, &capacity)) {
+            m->pathPushes = used;
+            continue;
+        }
+        for (j = 0; j < size; j++)
+            m->room[cells[j]] = (unsigned char)(m->numRooms + 1);
+        for (j = 0; j < room->numGoals; j++)
+            m->fill[room->goals[j]] = (unsigned char)j;
+        m->door[doors[i]] = (unsigned char)(m->numRooms + 1);
+        m->numRooms++;
+    }
+    free(r);
+    return 1;
+}
+
+int FindMacros(const Board *b, LevelMacros *m)
+{
+    unsigned char *seen;
+    int ok;
+
+    memset(m, 0, sizeof(LevelMacros));
+    m->numCells = b->width * b->height;
+    m->tunnel = (unsigned char *)calloc(m->numCells, 1);
+    m->room = (unsigned char *)calloc(m->numCells, 1);
+    m->door = (unsigned char *)calloc(m->numCells, 1);
+    m->fill = (unsigned char *)malloc(m->numCells);
+    seen = (unsigned char *)calloc(m->numCells, 1);
+    if (!m->tunnel || !m->room || !m->door || !m->fill || !seen) {
+        free(seen);
+        FreeMacros(m);
+        return 0;
+    }
+    memset(m->fill, NOT_FILLED, m->numCells);
+
+    FindTunnels(b, m);
+    ok = FindRooms(b, m, seen);
+    free(seen);
+    if (!ok)
+        FreeMacros(m);
+    return ok;
+}
@@ -0,0 +1,57 @@
+/* Sokoban macro moves
+   Level analysis for runs of pushes a search can make as one move: a box
+   pushed into a one-wide tunnel goes on to the end of it, and a box
+   pushed through the door of a goal room, targets behind a single
+   entrance, goes straight to the next target in a fixed fill order
+   Public Domain          */
+#ifndef MACRO_H
+#define MACRO_H
+
+#include "board.h"
+
+#define MAX_ROOMS 16
+#define MAX_ROOM_CELLS 64       /* Room cells, not counting the door */
+#define MAX_ROOM_GOALS 32
+#define NOT_FILLED 0xFF
+
+/* Longest run of pushes one macro move can make: the length of a tunnel
+   and then a way through a room */
+#define MAX_MACRO_PUSHES (4096 + (MAX_ROOM_CELLS + 2) * (MAX_ROOM_CELLS + 2))
+
+typedef struct {
+    int door;                 /* Cell a box is pushed onto to come in */
+    int dir;                  /* Direction into the room, LURD */
+    int numCells;
+    int cells[MAX_ROOM_CELLS];
+    int numGoals;
+    int goals[MAX_ROOM_GOALS];      /* Targets in the order they are filled */
+    int pathStart[MAX_ROOM_GOALS];  /* Pushes from the door to each goal, the ones before it filled */
+    int pathLength[MAX_ROOM_GOALS];
+} GoalRoom;
+
+typedef struct {
+    int numCells;
+    unsigned char *tunnel;    /* Per cell, bit 0 walls above and below, bit 1 walls left and right */
+    unsigned char *room;      /* Per cell, room plus one inside a room, 0 elsewhere */
+    unsigned char *door;      /* Per cell, room plus one on a door */
+    unsigned char *fill;      /* Per cell, place of a room target in its fill order, NOT_FILLED elsewhere */
+    int numRooms;
+    GoalRoom rooms[MAX_ROOMS];
+    unsigned short *pathFrom; /* Room paths: box cell before each push and its direction */
+    unsigned char *pathDir;
+    int pathPushes;
+    int tunnelCells;          /* One-wide cells a box can be pushed along */
+    int corridors;            /* Runs of them */
+} LevelMacros;
+
+/* Is cell one wide across a push in direction d, LURD */
+#define IN_TUNNEL(m, c, d) (((m)->tunnel[c] >> ((d) & 1)) & 1)
+
+/* Find the tunnels and goal rooms of the level as it starts. Rooms must
+   start empty, with the player outside, and have a fill order where
+   every target can still be reached when the ones before it are filled.
+   Returns 0 if out of memory */
+int FindMacros(const Board *b, LevelMacros *m);
+void FreeMacros(LevelMacros *m);
+
+#endif /* MACRO_H */
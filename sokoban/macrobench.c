@@ -0,0 +1,149 @@
+/* Sokoban macro move bench
+   Reports the tunnels, corridors and goal rooms found in each level,
+   solves it with and without macro moves and compares the effective
+   branching factor of the two searches: b for which the states created
+   fill a uniform tree of b children per push down to the solution, and
+   per move, where a macro move is one however many pushes it makes.
+   Every solution is played back and must solve its level
+   Usage: macrobench [-n maxnodes] [-m tablemb] level.sok ...
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "level.h"
+#include "solver.h"
+#include "macro.h"
+
+/* b with b + b^2 + ... + b^depth = states, 0 if there is no depth */
+static double Branching(long states, int depth)
+{
+    double lo = 1.0, hi = (double)states + 1.0, b, sum, term;
+    int i, round;
+
+    if (depth <= 0 || states <= 0)
+        return 0.0;
+    for (round = 0; round < 100; round++) {
+        b = (lo + hi) / 2;
+        for (i = 0, sum = 0.0, term = 1.0; i < depth && sum <= states; i++) {
+            term *= b;
+            sum += term;
+        }
+        if (sum > states)
+            hi = b;
+        else
+            lo = b;
+    }
+    return lo;
+}
+
+/* Play a LURD solution, 1 if it solves the level */
+static int Plays(const Board *level, const char *solution)
+{
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    Board board;
+    const char *m, *d;
+    int ok;
+
+    memset(&board, 0, sizeof(Board));
+    if (!solution || !BoardCopy(&board, level))
+        return 0;
+    for (m = solution; *m; m++) {
+        d = strchr("lurd", *m >= 'a' ? *m : *m - 'A' + 'a');
+        if (!d || BoardMove(&board, dx[d - "lurd"], dy[d - "lurd"]) == MOVE_NONE)
+            break;
+    }
+    ok = !*m && BoardSolved(&board);
+    BoardFree(&board);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    SolveOptions options;
+    SolveResult plain, macro;
+    LevelMacros found;
+    Board board;
+    char *data;
+    long size, plainStates = 0, macroStates = 0, plainNodes = 0, macroNodes = 0;
+    int i, r, goals, levels = 0, compared = 0, longer = 0, failed = 0;
+    double plainB, macroB, moveB, sumPlain = 0.0, sumMacro = 0.0, sumMove = 0.0, sumCut = 0.0;
+
+    InitSolveOptions(&options);
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            options.maxNodes = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            options.tableMegabytes = atoi(argv[++i]);
+        } else {
+            break;
+        }
+    }
+    if (i >= argc) {
+        printf("Usage: macrobench [-n maxnodes] [-m tablemb] level.sok ...\n");
+        return 1;
+    }
+
+    for (; i < argc; i++) {
+        data = ReadTextFile(argv[i], &size);
+        if (!data || !ParseLevel(data, size, &board)) {
+            printf("%s: cannot read\n", argv[i]);
+            free(data);
+            failed++;
+            continue;
+        }
+        free(data);
+        levels++;
+
+        if (!FindMacros(&board, &found)) {
+            printf("%s: out of memory\n", argv[i]);
+            return 2;
+        }
+        for (r = 0, goals = 0; r < found.numRooms; r++)
+            goals += found.rooms[r].numGoals;
+        printf("%s: tunnel cells=%d corridors=%d goal rooms=%d room targets=%d\n",
+               argv[i], found.tunnelCells, found.corridors, found.numRooms, goals);
+        FreeMacros(&found);
+
+        options.macros = 0;
+        SolveLevel(&board, &options, &plain);
+        options.macros = 1;
+        SolveLevel(&board, &options, &macro);
+
+        plainB = Branching(plain.generated, plain.pushes);
+        macroB = Branching(macro.generated, macro.pushes);
+        moveB = Branching(macro.generated, macro.steps);
+        printf("  plain: %s pushes=%d nodes=%ld states=%ld b=%.3f  macro: %s pushes=%d steps=%d nodes=%ld states=%ld macros=%ld b=%.3f per move=%.3f\n",
+               plain.status == SOLVE_FOUND ? "solved" : plain.status == SOLVE_LIMIT ? "limit" : "unsolvable",
+               plain.pushes, plain.nodes, plain.generated, plainB,
+               macro.status == SOLVE_FOUND ? "solved" : macro.status == SOLVE_LIMIT ? "limit" : "unsolvable",
+               macro.pushes, macro.steps, macro.nodes, macro.generated, macro.macros, macroB, moveB);
+
+        if ((plain.status == SOLVE_FOUND && !Plays(&board, plain.solution)) ||
+            (macro.status == SOLVE_FOUND && !Plays(&board, macro.solution))) {
+            printf("  solution does not solve the level\n");
+            failed++;
+        }
+        if (plain.status == SOLVE_FOUND && macro.status == SOLVE_FOUND) {
+            compared++;
+            sumPlain += plainB;
+            sumMacro += macroB;
+            sumMove += moveB;
+            sumCut += plainB > 0 ? (plainB - macroB) / plainB : 0.0;
+            plainNodes += plain.nodes;
+            macroNodes += macro.nodes;
+            plainStates += plain.generated;
+            macroStates += macro.generated;
+            if (macro.pushes > plain.pushes)
+                longer++;
+        }
+        FreeSolveResult(&plain);
+        FreeSolveResult(&macro);
+        BoardFree(&board);
+    }
+
+    printf("total: levels=%d solved both ways=%d branching plain=%.3f macro=%.3f reduction=%.1f%% macro per move=%.3f nodes plain=%ld macro=%ld states plain=%ld macro=%ld more pushes=%d failed=%d\n",
+           levels, compared, compared ? sumPlain / compared : 0.0, compared ? sumMacro / compared : 0.0,
+           compared ? 100.0 * sumCut / compared : 0.0, compared ? sumMove / compared : 0.0, plainNodes, macroNodes, plainStates,
+           macroStates, longer, failed);
+    return failed ? 2 : 0;
+}
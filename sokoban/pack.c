@@ -0,0 +1,111 @@
+/* Sokoban level pack
+   Pre-parsed levels written by genlevels and read in place
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pack.h"
+
+/* Check the header of a pack held in memory, returns 0 if it is not one */
+int OpenPack(LevelPack *pack, const void *data, long size)
+{
+    const BoardWord *words = (const BoardWord *)data;
+
+    memset(pack, 0, sizeof(LevelPack));
+    if (size < PACK_HEADER_WORDS * (long)sizeof(BoardWord))
+        return 0;
+    if (words[0] != PACK_MAGIC || words[1] != PACK_VERSION)
+        return 0;
+
+    pack->data = words;
+    pack->words = size / (long)sizeof(BoardWord);
+    pack->numLevels = (long)words[2];
+    pack->offset = words + PACK_HEADER_WORDS;
+    if (pack->numLevels > pack->words - PACK_HEADER_WORDS) {
+        pack->numLevels = 0;
+        return 0;
+    }
+    return 1;
+}
+
+/* Point board at level n of the pack, returns 0 on a bad level */
+int PackLevel(const LevelPack *pack, long n, Board *board)
+{
+    const BoardWord *level;
+    long at;
+    int numWords;
+
+    memset(board, 0, sizeof(Board));
+    if (n < 0 || n >= pack->numLevels)
+        return 0;
+
+    at = (long)(pack->offset[n] / sizeof(BoardWord));
+    if (at < 0 || at + PACK_LEVEL_WORDS > pack->words)
+        return 0;
+    level = pack->data + at;
+    numWords = (int)level[4];
+    if (numWords < 1 || at + PACK_LEVEL_WORDS + 4L * numWords > pack->words)
+        return 0;
+
+    /* Only the boxes change during play */
+    board->storage = (BoardWord *)malloc(numWords * sizeof(BoardWord));
+    if (!board->storage)
+        return 0;
+
+    board->width = (int)level[0];
+    board->height = (int)level[1];
+    board->playerX = (int)level[2];
+    board->playerY = (int)level[3];
+    board->numWords = numWords;
+
+    /* The pack is read-only, nothing writes through these */
+    board->walls = (BoardWord *)(level + PACK_LEVEL_WORDS);
+    board->targets = board->walls + 2 * numWords;
+    board->dead = board->walls + 3 * numWords;
+    board->boxes = board->storage;
+    memcpy(board->boxes, board->walls + numWords, numWords * sizeof(BoardWord));
+    return 1;
+}
+
+static int WriteWord(FILE *f, unsigned long value)
+{
+    BoardWord w = (BoardWord)value;
+
+    return fwrite(&w, sizeof(w), 1, f) == 1;
+}
+
+static int WritePlane(FILE *f, const BoardWord *plane, int numWords)
+{
+    return fwrite(plane, sizeof(BoardWord), numWords, f) == (size_t)numWords;
+}
+
+/* Write the boards as a pack, dead squares must be filled in */
+int WritePack(FILE *f, Board **levels, long count)
+{
+    unsigned long offset;
+    long i;
+    Board *b;
+
+    if (!WriteWord(f, PACK_MAGIC) || !WriteWord(f, PACK_VERSION) || !WriteWord(f, count))
+        return 0;
+
+    /* Index first, levels follow in order */
+    offset = (PACK_HEADER_WORDS + count) * sizeof(BoardWord);
+    for (i = 0; i < count; i++) {
+        if (!WriteWord(f, offset))
+            return 0;
+        offset += (PACK_LEVEL_WORDS + 4 * levels[i]->numWords) * sizeof(BoardWord);
+    }
+
+    for (i = 0; i < count; i++) {
+        b = levels[i];
+        if (!WriteWord(f, b->width) || !WriteWord(f, b->height) ||
+            !WriteWord(f, b->playerX) || !WriteWord(f, b->playerY) ||
+            !WriteWord(f, b->numWords))
+            return 0;
+        if (!WritePlane(f, b->walls, b->numWords) || !WritePlane(f, b->boxes, b->numWords) ||
+            !WritePlane(f, b->targets, b->numWords) || !WritePlane(f, b->dead, b->numWords))
+            return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,42 @@
+/* Sokoban level pack
+   Pre-parsed levels written by genlevels and read in place
+   Public Domain          */
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdio.h>
+#include "board.h"
+
+/* Layout, all fields are 32-bit words in the byte order of the machine
+   that wrote them (little-endian on every NT platform):
+
+     'SOKP' version count
+     offset[count]            byte offset of each level from the start
+     per level:
+       width height playerX playerY numWords
+       walls[numWords] boxes[numWords] targets[numWords] dead[numWords]
+
+   Walls, targets and dead squares are used straight from the pack, only
+   the boxes are copied since play moves them. */
+#define PACK_MAGIC   0x504B4F53UL /* "SOKP" */
+#define PACK_VERSION 1
+#define PACK_HEADER_WORDS 3
+#define PACK_LEVEL_WORDS  5
+
+typedef struct {
+    const BoardWord *data;
+    long words;               /* Size of the pack in words */
+    long numLevels;
+    const BoardWord *offset;  /* Index, one entry per level */
+} LevelPack;
+
+/* Check the header of a pack held in memory, returns 0 if it is not one */
+int OpenPack(LevelPack *pack, const void *data, long size);
+
+/* Point board at level n of the pack, returns 0 on a bad level */
+int PackLevel(const LevelPack *pack, long n, Board *board);
+
+/* Write the boards as a pack, dead squares must be filled in */
+int WritePack(FILE *f, Board **levels, long count);
+
+#endif /* PACK_H */
@@ -0,0 +1,141 @@
+/* Sokoban level pack benchmark
+   Builds a pack from .sok files, repeating them up to the requested
+   count, and compares loading from it against parsing the text
+   Usage: packbench [-n levels] [-o pack] level.sok ...
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "level.h"
+#include "deadlock.h"
+#include "pack.h"
+
+int main(int argc, char *argv[])
+{
+    const char *packPath = "levels.pak";
+    char **texts;
+    long *sizes;
+    Board *boards, **order, board;
+    LevelPack pack;
+    FILE *f;
+    char *packData;
+    long count = 10000, packSize, n, boxes;
+    int numFiles, first, j;
+    double textSeconds, packSeconds;
+    clock_t t;
+
+    for (first = 1; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "-n") == 0 && first + 1 < argc) {
+            count = atol(argv[++first]);
+        } else if (strcmp(argv[first], "-o") == 0 && first + 1 < argc) {
+            packPath = argv[++first];
+        } else {
+            break;
+        }
+    }
+
+    numFiles = argc - first;
+    if (numFiles < 1 || count < 1) {
+        printf("Usage: packbench [-n levels] [-o pack] level.sok ...\n");
+        return 1;
+    }
+
+    texts = (char **)calloc(numFiles, sizeof(char *));
+    sizes = (long *)calloc(numFiles, sizeof(long));
+    boards = (Board *)calloc(numFiles, sizeof(Board));
+    order = (Board **)malloc(count * sizeof(Board *));
+    if (!texts || !sizes || !boards || !order) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    for (j = 0; j < numFiles; j++) {
+        texts[j] = ReadTextFile(argv[first + j], &sizes[j]);
+        if (!texts[j] || !ParseLevel(texts[j], sizes[j], &boards[j])) {
+            printf("%s: cannot read\n", argv[first + j]);
+            return 1;
+        }
+        FindDeadSquares(&boards[j]);
+    }
+
+    /* Same levels over and over to reach the pack size */
+    for (n = 0; n < count; n++) {
+        order[n] = &boards[n % numFiles];
+    }
+    f = fopen(packPath, "wb");
+    if (!f || !WritePack(f, order, count)) {
+        printf("%s: cannot write\n", packPath);
+        return 1;
+    }
+    fclose(f);
+
+    packData = ReadTextFile(packPath, &packSize);
+    if (!packData || !OpenPack(&pack, packData, packSize)) {
+        printf("%s: not a level pack\n", packPath);
+        return 1;
+    }
+
+    /* Text: parse and find dead squares, what the game did per level.
+       boxes is a checksum both loops touch so neither is optimized away */
+    boxes = 0;
+    t = clock();
+    for (n = 0; n < count; n++) {
+        j = (int)(n % numFiles);
+        ParseLevel(texts[j], sizes[j], &board);
+        FindDeadSquares(&board);
+        boxes += board.boxes[0] & 1;
+        BoardFree(&board);
+    }
+    textSeconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+    /* Pack: point into the loaded pack, copy the boxes */
+    t = clock();
+    for (n = 0; n < count; n++) {
+        if (!PackLevel(&pack, n, &board)) {
+            printf("%s: level %ld is damaged\n", packPath, n);
+            return 1;
+        }
+        boxes -= board.boxes[0] & 1;
+        BoardFree(&board);
+    }
+    packSeconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+    /* Every level must come back exactly as parsed */
+    for (n = 0; n < count; n++) {
+        Board *b = order[n];
+
+        PackLevel(&pack, n, &board);
+        if (board.width != b->width || board.height != b->height ||
+            board.playerX != b->playerX || board.playerY != b->playerY ||
+            memcmp(board.walls, b->walls, b->numWords * sizeof(BoardWord)) ||
+            memcmp(board.boxes, b->boxes, b->numWords * sizeof(BoardWord)) ||
+            memcmp(board.targets, b->targets, b->numWords * sizeof(BoardWord)) ||
+            memcmp(board.dead, b->dead, b->numWords * sizeof(BoardWord))) {
+            printf("%s: level %ld differs from its text\n", packPath, n);
+            return 2;
+        }
+        BoardFree(&board);
+    }
+
+    printf("file: %s levels=%ld bytes=%ld (%.1f per level)\n",
+           packPath, count, packSize, (double)packSize / count);
+    printf("text: %.3fs %.0f levels/sec\n", textSeconds,
+           textSeconds > 0 ? count / textSeconds : 0.0);
+    printf("pack: %.3fs %.0f levels/sec\n", packSeconds,
+           packSeconds > 0 ? count / packSeconds : 0.0);
+    if (packSeconds > 0 && textSeconds > 0) {
+        printf("speedup: %.1fx\n", textSeconds / packSeconds);
+    }
+
+    free(packData);
+    for (j = 0; j < numFiles; j++) {
+        free(texts[j]);
+        BoardFree(&boards[j]);
+    }
+    free(texts);
+    free(sizes);
+    free(boards);
+    free(order);
+    return boxes == 0 ? 0 : 2;
+}
@@ -0,0 +1,215 @@
+/* Sokoban deadlock pattern benchmark
+   Times mapping a patgen table and looking pushes up in it against the
+   freeze check, and the two as the game and solver run them, the table
+   only when the freeze check misses. Counts the deadlocks only the table finds, and replays
+   the solver's solutions to make sure the table never cuts one
+   Usage: patbench [-r repeat] [-l length] [-n maxnodes] patterns.pat level.sok ...
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "level.h"
+#include "deadlock.h"
+#include "deadpat.h"
+#include "solver.h"
+#include "thread.h"
+
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+
+/* Pushes of the walk, the boxes after each and the cell pushed onto */
+typedef struct {
+    BoardWord *boxes;
+    int *cell;
+    long count, capacity;
+    int numWords;
+} PushLog;
+
+static int LogPush(PushLog *log, const Board *b, int cell)
+{
+    if (log->count == log->capacity)
+        return 0;
+    memcpy(log->boxes + log->count * log->numWords, b->boxes, log->numWords * sizeof(BoardWord));
+    log->cell[log->count++] = cell;
+    return 1;
+}
+
+/* Pushes along the solver's solution the table says are lost */
+static long FalseDeadlocks(const PatternTable *patterns, const Board *level, long maxNodes,
+                           int *solved)
+{
+    SolveOptions options;
+    SolveResult result;
+    Board board;
+    const char *m;
+    long wrong = 0;
+    int d;
+
+    InitSolveOptions(&options);
+    options.maxNodes = maxNodes;
+    *solved = SolveLevel(level, &options, &result) == SOLVE_FOUND && result.solution;
+    if (!*solved) {
+        FreeSolveResult(&result);
+        return 0;
+    }
+
+    memset(&board, 0, sizeof(Board));
+    BoardCopy(&board, level);
+    for (m = result.solution; *m; m++) {
+        d = (int)(strchr("lurd", *m >= 'a' ? *m : *m - 'A' + 'a') - "lurd");
+        if (BoardMove(&board, dirX[d], dirY[d]) == MOVE_PUSH &&
+            PatternDeadlock(patterns, &board,
+                            CELL_INDEX(&board, board.playerX + dirX[d], board.playerY + dirY[d])))
+            wrong++;
+    }
+    BoardFree(&board);
+    FreeSolveResult(&result);
+    return wrong;
+}
+
+int main(int argc, char *argv[])
+{
+    PatternTable patterns;
+    PushLog log;
+    Board board, start, probe;
+    char *data;
+    long size, length = 100000, repeat = 20, maxNodes = 200000, r, m, n;
+    long pushes, stuck, extra, found, totalPushes = 0, totalStuck = 0, totalExtra = 0;
+    long lookups = 0, wrong = 0, totalWrong = 0, checked = 0;
+    int i, c, d, levels = 0, failed = 0, solved;
+    double openSeconds, patternSeconds = 0.0, freezeSeconds = 0.0, bothSeconds = 0.0, t;
+    BoardWord *saved;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeat = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            length = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            maxNodes = atol(argv[++i]);
+        } else {
+            break;
+        }
+    }
+    if (i + 1 >= argc || repeat < 1 || length < 1) {
+        printf("Usage: patbench [-r repeat] [-l length] [-n maxnodes] patterns.pat level.sok ...\n");
+        return 1;
+    }
+
+    /* Startup is one mapping, the first lookups fault the pages in */
+    t = WallSeconds();
+    if (!OpenPatterns(&patterns, argv[i])) {
+        printf("%s: not a pattern table\n", argv[i]);
+        return 1;
+    }
+    openSeconds = WallSeconds() - t;
+    printf("%s: %dx%d patterns=%ld dead=%ld bytes=%ld open=%.1fus\n", argv[i], patterns.width,
+           patterns.height, patterns.count, patterns.dead, patterns.size, openSeconds * 1e6);
+
+    memset(&start, 0, sizeof(start));
+    memset(&log, 0, sizeof(log));
+    for (i++; i < argc; i++) {
+        data = ReadTextFile(argv[i], &size);
+        if (!data || !ParseLevel(data, size, &board)) {
+            printf("%s: cannot read\n", argv[i]);
+            free(data);
+            failed++;
+            continue;
+        }
+        free(data);
+        FindDeadSquares(&board);
+        levels++;
+
+        log.numWords = board.numWords;
+        log.capacity = length;
+        log.count = 0;
+        log.boxes = (BoardWord *)malloc(length * board.numWords * sizeof(BoardWord));
+        log.cell = (int *)malloc(length * sizeof(int));
+        if (!log.boxes || !log.cell) {
+            printf("out of memory\n");
+            return 2;
+        }
+
+        /* A random walk like deadbench, restarting when either check
+           says the last push lost the level */
+        BoardCopy(&start, &board);
+        srand(1);
+        pushes = stuck = extra = 0;
+        for (m = 0; m < length; m++) {
+            d = rand() % 4;
+            if (BoardMove(&board, dirX[d], dirY[d]) != MOVE_PUSH)
+                continue;
+            c = CELL_INDEX(&board, board.playerX + dirX[d], board.playerY + dirY[d]);
+            LogPush(&log, &board, c);
+            pushes++;
+            if (IS_DEADLOCK(&board, c)) {
+                stuck++;
+                BoardCopy(&board, &start);
+            } else if (PatternDeadlock(&patterns, &board, c)) {
+                extra++;
+                BoardCopy(&board, &start);
+            }
+        }
+
+        /* The same pushes again, timing just the checks */
+        probe = board;
+        saved = board.boxes;
+        found = 0;
+        t = WallSeconds();
+        for (r = 0; r < repeat; r++) {
+            for (n = 0; n < log.count; n++) {
+                probe.boxes = log.boxes + n * log.numWords;
+                found += PatternDeadlock(&patterns, &probe, log.cell[n]);
+            }
+        }
+        patternSeconds += WallSeconds() - t;
+        t = WallSeconds();
+        for (r = 0; r < repeat; r++) {
+            for (n = 0; n < log.count; n++) {
+                probe.boxes = log.boxes + n * log.numWords;
+                found += IsFreezeDeadlock(&probe, log.cell[n]);
+            }
+        }
+        freezeSeconds += WallSeconds() - t;
+        t = WallSeconds();
+        for (r = 0; r < repeat; r++) {
+            for (n = 0; n < log.count; n++) {
+                probe.boxes = log.boxes + n * log.numWords;
+                found += IsFreezeDeadlock(&probe, log.cell[n]) ||
+                         PatternDeadlock(&patterns, &probe, log.cell[n]);
+            }
+        }
+        bothSeconds += WallSeconds() - t;
+        lookups += log.count * repeat;
+        board.boxes = saved;
+
+        /* Nothing on a real solution may look lost */
+        BoardCopy(&board, &start);
+        wrong = FalseDeadlocks(&patterns, &board, maxNodes, &solved);
+        checked += solved;
+
+        printf("%s: pushes=%ld stuck=%ld pattern only=%ld solution %s false=%ld\n",
+               argv[i], pushes, stuck, extra, solved ? "checked" : "not found", wrong);
+
+        totalPushes += pushes;
+        totalStuck += stuck;
+        totalExtra += extra;
+        totalWrong += wrong;
+        free(log.boxes);
+        free(log.cell);
+        BoardFree(&board);
+    }
+    BoardFree(&start);
+
+    printf("total: levels=%d pushes=%ld stuck=%ld pattern only=%ld solutions=%ld false=%ld\n",
+           levels, totalPushes, totalStuck, totalExtra, checked, totalWrong);
+    printf("lookups=%ld pattern=%.1fns freeze=%.1fns freeze then pattern=%.1fns pattern lookups/sec=%.0f\n",
+           lookups, lookups ? patternSeconds * 1e9 / lookups : 0.0,
+           lookups ? freezeSeconds * 1e9 / lookups : 0.0,
+           lookups ? bothSeconds * 1e9 / lookups : 0.0,
+           patternSeconds > 0 ? lookups / patternSeconds : 0.0);
+
+    ClosePatterns(&patterns);
+    return failed ? 2 : totalWrong ? 1 : 0;
+}
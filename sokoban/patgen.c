@@ -0,0 +1,337 @@
+/* Sokoban deadlock pattern generator
+   Works out every window of walls and boxes whose boxes can never all
+   be pushed out of it, on all cores, and writes them as a table
+   Usage: patgen [-w width] [-h height] [-j threads] [-o file]
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "deadpat.h"
+#include "thread.h"
+
+#define OUTSIDE MAX_PATTERN_CELLS   /* Region of the player out of the window */
+#define LAYOUT_CHUNK 16               /* Wall layouts handed out at a time */
+
+/* LURD, as the solver numbers directions */
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+
+typedef struct {
+    int width, height, cells, anchor;
+    int next[MAX_PATTERN_CELLS][4];   /* Neighbour in the window, -1 outside */
+    long digit[MAX_PATTERN_CELLS];    /* Place value in the pattern index */
+    long count;                       /* Patterns */
+    long numLayouts;                  /* Wall layouts that leave the anchor free */
+    volatile long nextLayout;
+} PatternGen;
+
+/* One thread's share, tables are ORed together at the end */
+typedef struct {
+    PatternGen *gen;
+    BoardWord *bits;
+    long states;              /* Box sets worked out */
+    unsigned char (*label)[MAX_PATTERN_CELLS];  /* Region of each free cell, per box set */
+    unsigned int *alive;      /* Regions the box set can be cleared from, per box set */
+    unsigned int *subset;     /* Box sets of the layout, fewest boxes first */
+    unsigned int *first;      /* Where each box count starts in subset */
+    unsigned char *ones;      /* Boxes in each subset number */
+} Worker;
+
+/* Player regions of the free cells: the lowest cell of each, or OUTSIDE
+   for any that reaches the edge, where the player can walk round */
+static void Regions(const PatternGen *gen, unsigned int walls, unsigned int boxes,
+                    unsigned char *label)
+{
+    int queue[MAX_PATTERN_CELLS];
+    unsigned int seen = walls | boxes;
+    int c, n, d, head, tail, edge;
+
+    for (c = 0; c < gen->cells; c++) {
+        if (seen & (1u << c))
+            continue;
+        seen |= 1u << c;
+        head = tail = edge = 0;
+        queue[tail++] = c;
+        while (head < tail) {
+            for (d = 0; d < 4; d++) {
+                n = gen->next[queue[head]][d];
+                if (n < 0) {
+                    edge = 1;
+                } else if (!(seen & (1u << n))) {
+                    seen |= 1u << n;
+                    queue[tail++] = n;
+                }
+            }
+            head++;
+        }
+        for (n = 0; n < tail; n++)
+            label[queue[n]] = (unsigned char)(edge ? OUTSIDE : c);
+    }
+}
+
+/* Regions the player can clear the boxes from, by one push into a box
+   set already known to be clearable */
+static unsigned int Clearable(const Worker *w, unsigned int walls, unsigned int boxes)
+{
+    const PatternGen *gen = w->gen;
+    unsigned int alive = w->alive[boxes], after, bit;
+    int c, d, from, to, region, then;
+
+    for (c = 0; c < gen->cells; c++) {
+        bit = 1u << c;
+        if (!(boxes & bit))
+            continue;
+        for (d = 0; d < 4; d++) {
+            from = gen->next[c][(d + 2) & 3];
+            if (from < 0) {
+                region = OUTSIDE;
+            } else if ((walls | boxes) & (1u << from)) {
+                continue;
+            } else {
+                region = w->label[boxes][from];
+            }
+            if (alive & (1u << region))
+                continue;
+
+            /* Pushed out, the player follows to the edge */
+            to = gen->next[c][d];
+            if (to < 0) {
+                after = boxes & ~bit;
+                then = OUTSIDE;
+            } else if ((walls | boxes) & (1u << to)) {
+                continue;
+            } else {
+                after = (boxes & ~bit) | (1u << to);
+                then = w->label[after][c];
+            }
+            if (w->alive[after] & (1u << then))
+                alive |= 1u << region;
+        }
+    }
+    return alive;
+}
+
+/* Every box set on one wall layout, marking the deadlocked patterns */
+static void Layout(Worker *w, unsigned int walls)
+{
+    const PatternGen *gen = w->gen;
+    int cells[MAX_PATTERN_CELLS];
+    unsigned int free = ((1u << gen->cells) - 1) & ~walls, boxes, m, alive;
+    long counts[MAX_PATTERN_CELLS + 1], base = 0, index, i;
+    int n = 0, c, k, changed;
+
+    for (c = 0; c < gen->cells; c++) {
+        if (free & (1u << c)) {
+            cells[n++] = c;
+        } else {
+            base += gen->digit[c];
+        }
+    }
+
+    /* Box sets by box count, so pushes out of the window land on sets
+       already worked out */
+    memset(counts, 0, sizeof(counts));
+    w->ones[0] = 0;
+    counts[0] = 1;
+    for (m = 1; m < (1u << n); m++) {
+        w->ones[m] = (unsigned char)(w->ones[m & (m - 1)] + 1);
+        counts[w->ones[m]]++;
+    }
+    w->first[0] = 0;
+    for (k = 0; k <= n; k++) {
+        w->first[k + 1] = w->first[k] + (unsigned int)counts[k];
+        counts[k] = w->first[k];
+    }
+    for (m = 0; m < (1u << n); m++) {
+        boxes = 0;
+        for (c = 0; c < n; c++) {
+            if (m & (1u << c))
+                boxes |= 1u << cells[c];
+        }
+        w->subset[counts[w->ones[m]]++] = boxes;
+        Regions(gen, walls, boxes, w->label[boxes]);
+        w->alive[boxes] = 0;
+    }
+    w->alive[0] = ~0u;
+    w->states += 1L << n;
+
+    /* Pushes inside the window keep the count, go round until none helps */
+    for (k = 1; k <= n; k++) {
+        do {
+            changed = 0;
+            for (i = w->first[k]; i < (long)w->first[k + 1]; i++) {
+                boxes = w->subset[i];
+                alive = Clearable(w, walls, boxes);
+                if (alive != w->alive[boxes]) {
+                    w->alive[boxes] = alive;
+                    changed = 1;
+                }
+            }
+        } while (changed);
+    }
+
+    /* A deadlock has the anchor box and no region that clears it */
+    for (i = 0; i < (long)w->first[n + 1]; i++) {
+        boxes = w->subset[i];
+        if (!(boxes & (1u << gen->anchor)) || w->alive[boxes] != 0)
+            continue;
+        index = base;
+        for (c = 0; c < gen->cells; c++) {
+            if (c != gen->anchor && (boxes & (1u << c)))
+                index += 2 * gen->digit[c];
+        }
+        SET_BIT(w->bits, index);
+    }
+}
+
+static void WorkerMain(void *arg)
+{
+    Worker *w = (Worker *)arg;
+    PatternGen *gen = w->gen;
+    unsigned int low = (1u << gen->anchor) - 1, walls;
+    long first, layout;
+
+    for (;;) {
+        first = AtomicAdd(&gen->nextLayout, LAYOUT_CHUNK);
+        if (first >= gen->numLayouts)
+            break;
+        for (layout = first; layout < first + LAYOUT_CHUNK && layout < gen->numLayouts; layout++) {
+            /* The anchor holds the pushed box, never a wall */
+            walls = ((unsigned int)layout & low) | (((unsigned int)layout & ~low) << 1);
+            Layout(w, walls);
+        }
+    }
+}
+
+static int InitWorker(Worker *w, PatternGen *gen)
+{
+    long sets = 1L << gen->cells;
+
+    memset(w, 0, sizeof(Worker));
+    w->gen = gen;
+    w->bits = (BoardWord *)calloc((gen->count + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS,
+                                  sizeof(BoardWord));
+    w->label = (unsigned char (*)[MAX_PATTERN_CELLS])malloc(sets * MAX_PATTERN_CELLS);
+    w->alive = (unsigned int *)malloc(sets * sizeof(unsigned int));
+    w->subset = (unsigned int *)malloc(sets * sizeof(unsigned int));
+    w->first = (unsigned int *)malloc((MAX_PATTERN_CELLS + 2) * sizeof(unsigned int));
+    w->ones = (unsigned char *)malloc(sets);
+    return w->bits && w->label && w->alive && w->subset && w->first && w->ones;
+}
+
+static void FreeWorker(Worker *w)
+{
+    free(w->bits);
+    free(w->label);
+    free(w->alive);
+    free(w->subset);
+    free(w->first);
+    free(w->ones);
+}
+
+int main(int argc, char *argv[])
+{
+    PatternGen gen;
+    Worker *workers;
+    Thread *threads;
+    const char *output = "deadlock.pat";
+    int width = 4, height = 4, numThreads = CountProcessors(), i, c, d, x, y;
+    long words, dead = 0, states = 0, n, digit;
+    double wall;
+    FILE *f;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            break;
+        }
+    }
+    if (i < argc || numThreads < 1 || CountPatterns(width, height) == 0) {
+        printf("Usage: patgen [-w width] [-h height] [-j threads] [-o file]\n");
+        printf("  width and height at least 3, at most %d cells, 4 by 4 by default\n",
+               MAX_PATTERN_CELLS);
+        return 2;
+    }
+
+    memset(&gen, 0, sizeof(PatternGen));
+    gen.width = width;
+    gen.height = height;
+    gen.cells = width * height;
+    gen.anchor = width + 1;
+    gen.count = CountPatterns(width, height);
+    gen.numLayouts = 1L << (gen.cells - 1);
+    for (c = 0, digit = 1; c < gen.cells; c++) {
+        x = c % width;
+        y = c / width;
+        for (d = 0; d < 4; d++) {
+            gen.next[c][d] = x + dirX[d] >= 0 && x + dirX[d] < width &&
+                             y + dirY[d] >= 0 && y + dirY[d] < height ?
+                             c + dirX[d] + dirY[d] * width : -1;
+        }
+        if (c != gen.anchor) {
+            gen.digit[c] = digit;
+            digit *= 3;
+        }
+    }
+
+    workers = (Worker *)calloc(numThreads, sizeof(Worker));
+    threads = (Thread *)calloc(numThreads, sizeof(Thread));
+    if (!workers || !threads) {
+        printf("out of memory\n");
+        return 2;
+    }
+    for (i = 0; i < numThreads; i++) {
+        if (!InitWorker(&workers[i], &gen)) {
+            printf("out of memory\n");
+            return 2;
+        }
+    }
+
+    wall = WallSeconds();
+    for (i = 0; i < numThreads; i++) {
+        if (!StartThread(&threads[i], WorkerMain, &workers[i]))
+            WorkerMain(&workers[i]);
+    }
+    for (i = 0; i < numThreads; i++)
+        JoinThread(&threads[i]);
+    wall = WallSeconds() - wall;
+
+    words = (gen.count + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS;
+    for (i = 0; i < numThreads; i++) {
+        states += workers[i].states;
+        if (i > 0) {
+            for (n = 0; n < words; n++)
+                workers[0].bits[n] |= workers[i].bits[n];
+        }
+    }
+    for (n = 0; n < gen.count; n++) {
+        if (TEST_BIT(workers[0].bits, n))
+            dead++;
+    }
+
+    f = fopen(output, "wb");
+    if (!f || !WritePatterns(f, width, height, workers[0].bits, gen.count) || fclose(f) != 0) {
+        printf("%s: cannot write\n", output);
+        return 2;
+    }
+
+    printf("%dx%d: patterns=%ld dead=%ld (%.1f%%) layouts=%ld box sets=%ld\n",
+           width, height, gen.count, dead, 100.0 * dead / gen.count, gen.numLayouts, states);
+    printf("threads=%d wall=%.3fs box sets/sec=%.0f\n", numThreads, wall,
+           wall > 0 ? states / wall : 0.0);
+    printf("%s: %ld bytes\n", output,
+           (long)((PATTERN_HEADER_WORDS + words) * sizeof(BoardWord)));
+
+    for (i = 0; i < numThreads; i++)
+        FreeWorker(&workers[i]);
+    free(workers);
+    free(threads);
+    return 0;
+}
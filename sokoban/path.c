@@ -0,0 +1,261 @@
+/* Sokoban paths
+   Where the player can walk, the shortest walk to a cell and the fewest
+   pushes that take a box to a cell, for playing with the mouse
+   Public Domain          */
+#include <stdlib.h>
+#include <string.h>
+#include "path.h"
+
+/* LURD, as the solver numbers directions */
+#define OPPOSITE(d) (((d) + 2) & 3)
+static const char pathSteps[] = "lurd";
+static const char pathPushes[] = "LURD";
+
+/* A LURD string being built */
+typedef struct {
+    char *s;
+    long length, capacity;
+} PathText;
+
+int PathInit(PathFinder *p, const Board *b)
+{
+    memset(p, 0, sizeof(PathFinder));
+    p->width = b->width;
+    p->cells = b->width * b->height;
+    p->numWords = b->numWords;
+    p->reach = (BoardWord *)malloc(p->numWords * sizeof(BoardWord));
+    p->reachBoxes = (BoardWord *)malloc(p->numWords * sizeof(BoardWord));
+    p->queue = (int *)malloc(p->cells * sizeof(int));
+    p->states = (int *)malloc(p->cells * 4 * sizeof(int));
+    p->seen = (unsigned int *)calloc(p->cells, sizeof(unsigned int));
+    p->via = (signed char *)malloc(p->cells);
+    p->from = (int *)malloc(p->cells * 4 * sizeof(int));
+    if (!p->reach || !p->reachBoxes || !p->queue || !p->states || !p->seen || !p->via || !p->from) {
+        PathFree(p);
+        return 0;
+    }
+    return 1;
+}
+
+void PathFree(PathFinder *p)
+{
+    free(p->reach);
+    free(p->reachBoxes);
+    free(p->queue);
+    free(p->states);
+    free(p->seen);
+    free(p->via);
+    free(p->from);
+    memset(p, 0, sizeof(PathFinder));
+}
+
+/* The cell next to c in direction d, -1 off the edge */
+static int Neighbour(const PathFinder *p, int c, int d)
+{
+    switch (d) {
+        case 0:
+            return c % p->width > 0 ? c - 1 : -1;
+        case 1:
+            return c >= p->width ? c - p->width : -1;
+        case 2:
+            return c % p->width < p->width - 1 ? c + 1 : -1;
+        default:
+            return c + p->width < p->cells ? c + p->width : -1;
+    }
+}
+
+/* Breadth first from start, every cell reached gets seen set to the new
+   stamp and via set to the way it was entered. The box at ignore is the
+   one being moved and stands at box instead. Stops early at target,
+   returns how many cells were queued */
+static int Flood(PathFinder *p, const Board *b, int start, int ignore, int box, int target)
+{
+    int head = 0, tail = 0, c, n, d;
+
+    if (++p->stamp == 0) {
+        memset(p->seen, 0, p->cells * sizeof(unsigned int));
+        p->stamp = 1;
+    }
+    p->seen[start] = p->stamp;
+    p->via[start] = -1;
+    p->queue[tail++] = start;
+    while (head < tail) {
+        c = p->queue[head++];
+        if (c == target)
+            break;
+        for (d = 0; d < 4; d++) {
+            n = Neighbour(p, c, d);
+            if (n < 0 || p->seen[n] == p->stamp || TEST_BIT(b->walls, n) || n == box ||
+                (n != ignore && TEST_BIT(b->boxes, n)))
+                continue;
+            p->seen[n] = p->stamp;
+            p->via[n] = (signed char)d;
+            p->queue[tail++] = n;
+        }
+    }
+    return tail;
+}
+
+/* Reach holds until a box moves or the player is put down outside it,
+   by an undo say */
+static void UpdateReach(PathFinder *p, const Board *b)
+{
+    int player = CELL_INDEX(b, b->playerX, b->playerY);
+    int i, n;
+
+    if (p->reachValid && TEST_BIT(p->reach, player) &&
+        memcmp(p->reachBoxes, b->boxes, p->numWords * sizeof(BoardWord)) == 0)
+        return;
+
+    n = Flood(p, b, player, -1, -1, -1);
+    memset(p->reach, 0, p->numWords * sizeof(BoardWord));
+    for (i = 0; i < n; i++)
+        SET_BIT(p->reach, p->queue[i]);
+    memcpy(p->reachBoxes, b->boxes, p->numWords * sizeof(BoardWord));
+    p->reachValid = 1;
+    p->floods++;
+}
+
+int PathCanReach(PathFinder *p, const Board *b, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= b->width || y >= b->height)
+        return 0;
+    UpdateReach(p, b);
+    return TEST_BIT(p->reach, CELL_INDEX(b, x, y));
+}
+
+static int Reserve(PathText *t, long more)
+{
+    if (t->length + more + 1 > t->capacity) {
+        long cap = t->capacity ? t->capacity * 2 : 64;
+        char *s;
+
+        while (cap < t->length + more + 1)
+            cap *= 2;
+        s = (char *)realloc(t->s, cap);
+        if (!s)
+            return 0;
+        t->s = s;
+        t->capacity = cap;
+    }
+    return 1;
+}
+
+/* Append the walk the last flood found to target */
+static int AppendWalk(PathFinder *p, PathText *t, int target)
+{
+    long steps = 0, i;
+    int c;
+
+    for (c = target; p->via[c] >= 0; c = Neighbour(p, c, OPPOSITE(p->via[c])))
+        steps++;
+    if (!Reserve(t, steps))
+        return 0;
+    i = t->length + steps;
+    for (c = target; p->via[c] >= 0; c = Neighbour(p, c, OPPOSITE(p->via[c])))
+        t->s[--i] = pathSteps[p->via[c]];
+    t->length += steps;
+    t->s[t->length] = '\0';
+    return 1;
+}
+
+char *PathWalk(PathFinder *p, const Board *b, int x, int y)
+{
+    PathText t;
+    int target;
+
+    if (!PathCanReach(p, b, x, y))
+        return NULL;
+    target = CELL_INDEX(b, x, y);
+    Flood(p, b, CELL_INDEX(b, b->playerX, b->playerY), -1, -1, target);
+
+    memset(&t, 0, sizeof(PathText));
+    if (!Reserve(&t, 0) || !AppendWalk(p, &t, target)) {
+        free(t.s);
+        return NULL;
+    }
+    return t.s;
+}
+
+/* Queue every push of the box at c that the player at pc can walk up
+   to. A state is the box cell times four plus the push that put it
+   there, the player stands where the box was. Returns the state that
+   lands on dest, -1 if none did */
+static int PushFrom(PathFinder *p, const Board *b, int origin, int c, int pc, int parent,
+                    int dest, int *tail)
+{
+    int e, side, next, state;
+
+    Flood(p, b, pc, origin, c, -1);
+    for (e = 0; e < 4; e++) {
+        side = Neighbour(p, c, OPPOSITE(e));
+        if (side < 0 || p->seen[side] != p->stamp)
+            continue;
+        next = Neighbour(p, c, e);
+        if (next < 0 || TEST_BIT(b->walls, next) || (next != origin && TEST_BIT(b->boxes, next)))
+            continue;
+        state = next * 4 + e;
+        if (p->from[state] != -2)
+            continue;
+        p->from[state] = parent;
+        p->states[(*tail)++] = state;
+        if (next == dest)
+            return state;
+    }
+    return -1;
+}
+
+char *PathPush(PathFinder *p, const Board *b, int boxX, int boxY, int x, int y)
+{
+    PathText t;
+    int origin, dest, found, head = 0, tail = 0, n, i, s, e, c, pc;
+
+    if (boxX < 0 || boxY < 0 || boxX >= b->width || boxY >= b->height ||
+        x < 0 || y < 0 || x >= b->width || y >= b->height)
+        return NULL;
+    origin = CELL_INDEX(b, boxX, boxY);
+    dest = CELL_INDEX(b, x, y);
+    if (!TEST_BIT(b->boxes, origin) || TEST_BIT(b->walls, dest) ||
+        (dest != origin && TEST_BIT(b->boxes, dest)))
+        return NULL;
+
+    memset(&t, 0, sizeof(PathText));
+    if (!Reserve(&t, 0))
+        return NULL;
+    t.s[0] = '\0';
+    if (dest == origin)
+        return t.s;
+
+    /* Breadth first over pushes, so the first to land has the fewest */
+    for (s = 0; s < p->cells * 4; s++)
+        p->from[s] = -2;
+    found = PushFrom(p, b, origin, origin, CELL_INDEX(b, b->playerX, b->playerY), -1, dest, &tail);
+    while (found < 0 && head < tail) {
+        s = p->states[head++];
+        c = s / 4;
+        found = PushFrom(p, b, origin, c, Neighbour(p, c, OPPOSITE(s & 3)), s, dest, &tail);
+    }
+    if (found < 0) {
+        free(t.s);
+        return NULL;
+    }
+
+    /* The pushes back to the start, then walk up to each in turn */
+    n = 0;
+    for (s = found; s >= 0; s = p->from[s])
+        p->states[n++] = s;
+    pc = CELL_INDEX(b, b->playerX, b->playerY);
+    for (i = n - 1; i >= 0; i--) {
+        e = p->states[i] & 3;
+        c = Neighbour(p, p->states[i] / 4, OPPOSITE(e));
+        Flood(p, b, pc, origin, c, Neighbour(p, c, OPPOSITE(e)));
+        if (!AppendWalk(p, &t, Neighbour(p, c, OPPOSITE(e))) || !Reserve(&t, 1)) {
+            free(t.s);
+            return NULL;
+        }
+        t.s[t.length++] = pathPushes[e];
+        t.s[t.length] = '\0';
+        pc = c;
+    }
+    return t.s;
+}
@@ -0,0 +1,42 @@
+/* Sokoban paths
+   Where the player can walk, the shortest walk to a cell and the fewest
+   pushes that take a box to a cell, for playing with the mouse
+   Public Domain          */
+#ifndef PATH_H
+#define PATH_H
+
+#include "board.h"
+
+typedef struct {
+    int width, cells, numWords;
+    BoardWord *reach;         /* Floor the player can walk to */
+    BoardWord *reachBoxes;    /* The boxes reach was flooded for */
+    int reachValid;
+    long floods;              /* Times reach was worked out */
+    int *queue;               /* Flood queue, cells in the order reached */
+    int *states;              /* Push search queue, then the pushes found */
+    unsigned int *seen;       /* Cells flooded this round equal stamp */
+    unsigned int stamp;
+    signed char *via;         /* Direction each flooded cell was entered by */
+    int *from;                /* Push search state each state came from */
+} PathFinder;
+
+/* Room for a level the size of b, returns 0 out of memory */
+int PathInit(PathFinder *p, const Board *b);
+void PathFree(PathFinder *p);
+
+/* Can the player walk to x, y without pushing. Reach is flooded again
+   only when the boxes have moved since, so steps and hovering cost a
+   bit test */
+int PathCanReach(PathFinder *p, const Board *b, int x, int y);
+
+/* The shortest walk to x, y in lowercase LURD, empty if the player is
+   there, NULL if it cannot be reached. Caller frees */
+char *PathWalk(PathFinder *p, const Board *b, int x, int y);
+
+/* Walks and pushes in LURD that take the box at boxX, boxY to x, y
+   leaving every other box where it is. Fewest pushes first, then each
+   walk between them is shortest. NULL if there is no way. Caller frees */
+char *PathPush(PathFinder *p, const Board *b, int boxX, int boxY, int x, int y);
+
+#endif /* PATH_H */
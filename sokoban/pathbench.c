@@ -0,0 +1,335 @@
+/* Sokoban path check
+   Plays every level's solution and, at positions along the way, checks
+   the mouse path engine against plain searches: reach, shortest walks
+   and fewest-push box moves played back on the board. Then times hover,
+   walk and push clicks with and without the reach map kept
+   Usage: pathbench [-n boxmoves] [-s seed] level.sok ...
+   -n is how many box moves to check at each position
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "level.h"
+#include "solver.h"
+#include "path.h"
+
+/* LURD */
+static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+static const char steps[] = "lurd";
+
+static int Open(const Board *b, int x, int y)
+{
+    return x >= 0 && y >= 0 && x < b->width && y < b->height &&
+           !TEST_BIT(b->walls, CELL_INDEX(b, x, y)) && !TEST_BIT(b->boxes, CELL_INDEX(b, x, y));
+}
+
+/* Steps from the player to every cell without pushing, -1 if none */
+static void WalkDistances(const Board *b, int *dist, int *queue)
+{
+    int cells = b->width * b->height, head = 0, tail = 0, c, d, x, y;
+
+    for (c = 0; c < cells; c++)
+        dist[c] = -1;
+    c = CELL_INDEX(b, b->playerX, b->playerY);
+    dist[c] = 0;
+    queue[tail++] = c;
+    while (head < tail) {
+        c = queue[head++];
+        for (d = 0; d < 4; d++) {
+            x = c % b->width + dx[d];
+            y = c / b->width + dy[d];
+            if (Open(b, x, y) && dist[CELL_INDEX(b, x, y)] < 0) {
+                dist[CELL_INDEX(b, x, y)] = dist[c] + 1;
+                queue[tail++] = CELL_INDEX(b, x, y);
+            }
+        }
+    }
+}
+
+/* Fewest pushes to take the box at origin to dest, by layers over every
+   box and player cell pair. -1 if it cannot be done */
+static int FewestPushes(Board *b, int origin, int dest, int *dist, int *cur, int *next)
+{
+    int cells = b->width * b->height, layer, numCur, numNext, head, s, box, player, d;
+    int px, py, bx, by, to, nextBox, result = -1;
+    long states = (long)cells * cells, i;
+
+    for (i = 0; i < states; i++)
+        dist[i] = -1;
+    CLEAR_BIT(b->boxes, origin);
+    s = origin * cells + CELL_INDEX(b, b->playerX, b->playerY);
+    dist[s] = 0;
+    cur[0] = s;
+    numCur = 1;
+    for (layer = 0; numCur > 0 && result < 0; layer++) {
+        numNext = 0;
+        for (head = 0; head < numCur && result < 0; head++) {
+            s = cur[head];
+            if (dist[s] != layer)
+                continue;
+            box = s / cells;
+            player = s % cells;
+            if (box == dest) {
+                result = layer;
+                break;
+            }
+            px = player % b->width;
+            py = player / b->width;
+            bx = box % b->width;
+            by = box / b->width;
+            for (d = 0; d < 4; d++) {
+                if (!Open(b, px + dx[d], py + dy[d]))
+                    continue;
+                to = CELL_INDEX(b, px + dx[d], py + dy[d]);
+                if (to != box) {
+                    s = box * cells + to;
+                    if (dist[s] < 0 || dist[s] > layer) {
+                        dist[s] = layer;
+                        cur[numCur++] = s;
+                    }
+                } else if (Open(b, bx + dx[d], by + dy[d])) {
+                    nextBox = CELL_INDEX(b, bx + dx[d], by + dy[d]);
+                    s = nextBox * cells + box;
+                    if (dist[s] < 0) {
+                        dist[s] = layer + 1;
+                        next[numNext++] = s;
+                    }
+                }
+            }
+        }
+        memcpy(cur, next, numNext * sizeof(int));
+        numCur = numNext;
+    }
+    SET_BIT(b->boxes, origin);
+    return result;
+}
+
+/* Play a path on a copy, every lowercase move a step and every uppercase
+   one a push. Returns the pushes, -1 if a move went otherwise */
+static int PlayPath(Board *b, const char *lurd)
+{
+    const char *p;
+    int pushes = 0, push, result;
+
+    for (; *lurd; lurd++) {
+        push = *lurd >= 'A' && *lurd <= 'Z';
+        p = strchr(steps, *lurd | 0x20);
+        if (!p)
+            return -1;
+        result = BoardMove(b, dx[p - steps], dy[p - steps]);
+        if (result != (push ? MOVE_PUSH : MOVE_STEP))
+            return -1;
+        pushes += push;
+    }
+    return pushes;
+}
+
+int main(int argc, char *argv[])
+{
+    PathFinder path;
+    SolveResult result;
+    Board level, board, check;
+    char *data, *lurd, *move;
+    long size, walks = 0, boxMoves = 0, impossible = 0, errors = 0, queries = 0;
+    long expectedFloods = 0, floods = 0, samples = 10, n;
+    int i, first, c, cells, boxes, x, y, origin, dest, want, got, ok = 0, failed = 0;
+    int *dist, *queue, *pushDist, *cur, *next, *boxCells;
+    unsigned long rng = 12345;
+    clock_t start;
+    double hoverTime = 0, floodTime = 0, walkTime = 0, pushTime = 0;
+    long hovers = 0, timedWalks = 0, timedPushes = 0;
+
+    for (first = 1; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "-n") == 0 && first + 1 < argc) {
+            samples = atol(argv[++first]);
+        } else if (strcmp(argv[first], "-s") == 0 && first + 1 < argc) {
+            rng = strtoul(argv[++first], NULL, 10);
+        } else {
+            break;
+        }
+    }
+    if (first >= argc) {
+        printf("Usage: pathbench [-n boxmoves] [-s seed] level.sok ...\n");
+        return 1;
+    }
+    if (rng == 0)
+        rng = 1;
+
+    InitZobrist();
+    memset(&board, 0, sizeof(Board));
+    memset(&check, 0, sizeof(Board));
+
+    for (i = first; i < argc; i++) {
+        long levelErrors = 0;
+
+        data = ReadTextFile(argv[i], &size);
+        if (!data || !ParseLevel(data, size, &level)) {
+            printf("%s: cannot read\n", argv[i]);
+            free(data);
+            failed++;
+            continue;
+        }
+        free(data);
+        if (SolveLevel(&level, NULL, &result) != SOLVE_FOUND) {
+            printf("%s: not solved\n", argv[i]);
+            FreeSolveResult(&result);
+            BoardFree(&level);
+            failed++;
+            continue;
+        }
+
+        cells = level.width * level.height;
+        dist = (int *)malloc(cells * sizeof(int));
+        queue = (int *)malloc(cells * sizeof(int));
+        boxCells = (int *)malloc(cells * sizeof(int));
+        pushDist = (int *)malloc((size_t)cells * cells * sizeof(int));
+        cur = (int *)malloc((size_t)cells * cells * sizeof(int));
+        next = (int *)malloc((size_t)cells * cells * sizeof(int));
+        if (!dist || !queue || !boxCells || !pushDist || !cur || !next || !PathInit(&path, &level)) {
+            printf("%s: out of memory\n", argv[i]);
+            free(dist); free(queue); free(boxCells); free(pushDist); free(cur); free(next);
+            FreeSolveResult(&result);
+            BoardFree(&level);
+            failed++;
+            continue;
+        }
+
+        BoardCopy(&board, &level);
+        for (n = 0; ; n++) {
+            int pushed = n > 0 && result.solution[n - 1] >= 'A' && result.solution[n - 1] <= 'Z';
+
+            /* Asked after every move, reach is flooded once per push */
+            PathCanReach(&path, &board, board.playerX, board.playerY);
+            queries++;
+            if (n == 0 || pushed)
+                expectedFloods++;
+
+            /* Check in full at the start and after every few pushes */
+            if (n == 0 || (pushed && NextRandom(&rng) % 4 == 0)) {
+                WalkDistances(&board, dist, queue);
+                for (c = 0; c < cells; c++) {
+                    x = c % board.width;
+                    y = c / board.width;
+                    if (PathCanReach(&path, &board, x, y) != (dist[c] >= 0)) {
+                        levelErrors++;
+                        continue;
+                    }
+                    if (dist[c] < 0)
+                        continue;
+                    move = PathWalk(&path, &board, x, y);
+                    BoardCopy(&check, &board);
+                    if (!move || (long)strlen(move) != dist[c] || PlayPath(&check, move) != 0 ||
+                        check.playerX != x || check.playerY != y)
+                        levelErrors++;
+                    free(move);
+                    walks++;
+                }
+
+                /* Random boxes to random floor cells */
+                for (boxes = 0, c = 0; c < cells; c++) {
+                    if (TEST_BIT(board.boxes, c))
+                        boxCells[boxes++] = c;
+                }
+                for (c = 0; c < samples; c++) {
+                    origin = boxCells[NextRandom(&rng) % boxes];
+                    dest = (int)(NextRandom(&rng) % cells);
+                    if (TEST_BIT(board.walls, dest) || (dest != origin && TEST_BIT(board.boxes, dest)))
+                        continue;
+                    want = FewestPushes(&board, origin, dest, pushDist, cur, next);
+                    move = PathPush(&path, &board, origin % board.width, origin / board.width,
+                                    dest % board.width, dest / board.width);
+                    boxMoves++;
+                    if (want < 0) {
+                        impossible++;
+                        if (move)
+                            levelErrors++;
+                        free(move);
+                        continue;
+                    }
+                    BoardCopy(&check, &board);
+                    got = move ? PlayPath(&check, move) : -1;
+                    CLEAR_BIT(check.boxes, dest);
+                    SET_BIT(check.boxes, origin);
+                    if (got != want || memcmp(check.boxes, board.boxes, board.numWords * sizeof(BoardWord)) != 0)
+                        levelErrors++;
+                    free(move);
+                }
+            }
+
+            if (result.solution[n] == '\0')
+                break;
+            lurd = strchr(steps, result.solution[n] | 0x20);
+            BoardMove(&board, dx[lurd - steps], dy[lurd - steps]);
+        }
+        floods += path.floods;
+
+        /* Hover over every cell with the map kept, then as if every
+           query had to flood again */
+        BoardCopy(&board, &level);
+        start = clock();
+        for (n = 0; n < 200; n++) {
+            for (c = 0; c < cells; c++)
+                PathCanReach(&path, &board, c % board.width, c / board.width);
+        }
+        hoverTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+        hovers += 200L * cells;
+        start = clock();
+        for (n = 0; n < 20; n++) {
+            for (c = 0; c < cells; c++) {
+                path.reachValid = 0;
+                PathCanReach(&path, &board, c % board.width, c / board.width);
+            }
+        }
+        floodTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        /* Walk clicks to every cell and box moves from the start */
+        start = clock();
+        for (c = 0; c < cells; c++) {
+            move = PathWalk(&path, &board, c % board.width, c / board.width);
+            free(move);
+            timedWalks++;
+        }
+        walkTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+        for (boxes = 0, c = 0; c < cells; c++) {
+            if (TEST_BIT(board.boxes, c))
+                boxCells[boxes++] = c;
+        }
+        start = clock();
+        for (c = 0; c < cells; c++) {
+            origin = boxCells[c % boxes];
+            move = PathPush(&path, &board, origin % board.width, origin / board.width,
+                            c % board.width, c / board.width);
+            free(move);
+            timedPushes++;
+        }
+        pushTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        if (levelErrors > 0)
+            printf("%s: %ld wrong paths\n", argv[i], levelErrors);
+        errors += levelErrors;
+        if (levelErrors == 0)
+            ok++;
+        else
+            failed++;
+        PathFree(&path);
+        free(dist); free(queue); free(boxCells); free(pushDist); free(cur); free(next);
+        FreeSolveResult(&result);
+        BoardFree(&level);
+    }
+
+    printf("levels: ok=%d failed=%d\n", ok, failed);
+    printf("walks checked=%ld box moves checked=%ld (impossible %ld) wrong=%ld\n",
+           walks, boxMoves, impossible, errors);
+    printf("reach floods=%ld for %ld queries, expected one per push=%ld\n",
+           floods, queries, expectedFloods);
+    if (hovers > 0) {
+        printf("hover ns: kept map=%.1f flood every time=%.1f\n",
+               hoverTime / hovers * 1e9, floodTime / (hovers / 10) * 1e9);
+        printf("click us: walk=%.2f push=%.2f\n",
+               walkTime / timedWalks * 1e6, pushTime / timedPushes * 1e6);
+    }
+    BoardFree(&board);
+    BoardFree(&check);
+    return failed || floods != expectedFloods ? 2 : 0;
+}
@@ -0,0 +1,358 @@
+/* Sokoban batch validator
+   Solves every level of a directory, collection or pack on all cores and
+   writes pushes, moves, search nodes and a difficulty score as CSV
+   Usage: sokbatch [-j threads] [-n maxnodes] [-m tablemb] [-o out.csv] path ...
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "levelset.h"
+#include "solver.h"
+#include "thread.h"
+
+typedef struct {
+    SetLevel *source;     /* Name, title and board */
+    int boxes;
+    SolveResult result;
+    double seconds;       /* Wall time, clock() would count every thread */
+    double difficulty;
+    int worker;
+} BatchLevel;
+
+/* One deque per worker: the owner takes from the tail, thieves from the
+   head, so a worker stuck on a hard level has the rest of its share
+   taken over by the others */
+typedef struct {
+    Mutex lock;
+    long *items;
+    long head, tail;
+    long solved, stolen;
+} WorkQueue;
+
+typedef struct {
+    LevelSet set;
+    BatchLevel *levels;
+    long numLevels;
+    WorkQueue *queues;
+    int numWorkers;
+    SolveOptions options;
+} Batch;
+
+typedef struct {
+    Batch *batch;
+    int id;
+} Worker;
+
+/* The owner's next level, from the tail of its own queue */
+static long TakeOwn(WorkQueue *q)
+{
+    long n = -1;
+
+    LockMutex(&q->lock);
+    if (q->tail > q->head)
+        n = q->items[--q->tail];
+    UnlockMutex(&q->lock);
+    return n;
+}
+
+/* The oldest level of someone else's queue */
+static long Steal(Batch *batch, int thief)
+{
+    WorkQueue *q;
+    long n = -1;
+    int i;
+
+    for (i = 1; i < batch->numWorkers && n < 0; i++) {
+        q = &batch->queues[(thief + i) % batch->numWorkers];
+        LockMutex(&q->lock);
+        if (q->tail > q->head)
+            n = q->items[q->head++];
+        UnlockMutex(&q->lock);
+    }
+    if (n >= 0)
+        batch->queues[thief].stolen++;
+    return n;
+}
+
+/* Difficulty grows with the length of the solution and with the search
+   it took to prove it optimal, log scaled since nodes span decades */
+static double Difficulty(const SolveResult *r)
+{
+    if (r->status != SOLVE_FOUND)
+        return 0.0;
+    return r->pushes + 10.0 * log10((double)r->nodes + 1.0);
+}
+
+static void WorkerMain(void *arg)
+{
+    Worker *w = (Worker *)arg;
+    Batch *batch = w->batch;
+    BatchLevel *level;
+    double start;
+    long n;
+
+    for (;;) {
+        n = TakeOwn(&batch->queues[w->id]);
+        if (n < 0)
+            n = Steal(batch, w->id);
+        if (n < 0)
+            break;
+
+        level = &batch->levels[n];
+        start = WallSeconds();
+        SolveLevel(&level->source->board, &batch->options, &level->result);
+        level->seconds = WallSeconds() - start;
+        level->difficulty = Difficulty(&level->result);
+        level->worker = w->id;
+        batch->queues[w->id].solved++;
+    }
+}
+
+static const char *StatusName(int status)
+{
+    return status == SOLVE_FOUND ? "solved" :
+           status == SOLVE_LIMIT ? "limit" : "unsolvable";
+}
+
+static void WriteQuoted(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"')
+            fputc('"', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+static void WriteCsv(FILE *f, Batch *batch)
+{
+    BatchLevel *level;
+    long n;
+
+    fprintf(f, "level,title,width,height,boxes,status,pushes,moves,nodes,generated,seconds,difficulty,worker\n");
+    for (n = 0; n < batch->numLevels; n++) {
+        level = &batch->levels[n];
+        WriteQuoted(f, level->source->name);
+        fputc(',', f);
+        WriteQuoted(f, level->source->title);
+        fprintf(f, ",%d,%d,%d,%s,%d,%d,%ld,%ld,%.4f,%.2f,%d\n",
+                level->source->board.width, level->source->board.height, level->boxes,
+                StatusName(level->result.status),
+                level->result.pushes, level->result.moves,
+                level->result.nodes, level->result.generated,
+                level->seconds, level->difficulty, level->worker);
+    }
+}
+
+static double *sortValues;
+
+static int CompareByValue(const void *a, const void *b)
+{
+    double x = sortValues[*(const long *)a], y = sortValues[*(const long *)b];
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* Spearman rank correlation of difficulty against level order over the
+   solved levels, 1.0 when every level is harder than the one before */
+static double RankCorrelation(const double *values, long count)
+{
+    long *order, i, j;
+    double *rank, sum = 0.0, mean;
+
+    if (count < 2)
+        return 0.0;
+    order = (long *)malloc(count * sizeof(long));
+    rank = (double *)malloc(count * sizeof(double));
+    if (!order || !rank) {
+        free(order);
+        free(rank);
+        return 0.0;
+    }
+    for (i = 0; i < count; i++)
+        order[i] = i;
+    sortValues = (double *)values;
+    qsort(order, count, sizeof(long), CompareByValue);
+
+    /* Ties share the mean of their ranks */
+    for (i = 0; i < count; i = j) {
+        for (j = i + 1; j < count && values[order[j]] == values[order[i]]; j++)
+            ;
+        for (; i < j; i++)
+            rank[order[i]] = (i + j - 1) / 2.0;
+    }
+
+    /* Pearson correlation of the ranks with 0..count-1 */
+    mean = (count - 1) / 2.0;
+    {
+        double cov = 0.0, varA = 0.0, varB = 0.0;
+        for (i = 0; i < count; i++) {
+            cov += (rank[i] - mean) * (i - mean);
+            varA += (rank[i] - mean) * (rank[i] - mean);
+            varB += (i - mean) * (i - mean);
+        }
+        sum = (varA > 0 && varB > 0) ? cov / sqrt(varA * varB) : 0.0;
+    }
+    free(order);
+    free(rank);
+    return sum;
+}
+
+int main(int argc, char *argv[])
+{
+    Batch batch;
+    Worker *workers;
+    Thread *threads;
+    FILE *csv = stdout;
+    const char *csvPath = NULL;
+    double wall, busy = 0.0, *solvedDifficulty, last = -1.0;
+    long n, share, solved = 0, unsolvable = 0, limit = 0, drops = 0, nodes = 0;
+    int i;
+
+    memset(&batch, 0, sizeof(Batch));
+    InitSolveOptions(&batch.options);
+    batch.numWorkers = CountProcessors();
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            batch.numWorkers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            batch.options.maxNodes = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            batch.options.tableMegabytes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else {
+            break;
+        }
+    }
+
+    if (i >= argc || batch.numWorkers < 1) {
+        printf("Usage: sokbatch [-j threads] [-n maxnodes] [-m tablemb] [-o out.csv] path ...\n");
+        printf("  path is a directory of .sok files, a collection or a level pack\n");
+        return 1;
+    }
+
+    for (; i < argc; i++) {
+        if (!AddLevels(&batch.set, argv[i])) {
+            printf("%s: cannot read\n", argv[i]);
+            return 1;
+        }
+    }
+    batch.numLevels = batch.set.numLevels;
+    if (batch.numLevels == 0) {
+        printf("no levels\n");
+        return 1;
+    }
+    batch.levels = (BatchLevel *)calloc(batch.numLevels, sizeof(BatchLevel));
+    if (!batch.levels) {
+        printf("out of memory\n");
+        return 1;
+    }
+    for (n = 0; n < batch.numLevels; n++) {
+        batch.levels[n].source = &batch.set.levels[n];
+        batch.levels[n].boxes = BoardCountBoxes(&batch.set.levels[n].board);
+    }
+
+    /* Each worker starts with a contiguous run of levels, the hard ones
+       at the end of a pack get spread out by stealing */
+    if (batch.numWorkers > batch.numLevels)
+        batch.numWorkers = (int)batch.numLevels;
+    batch.queues = (WorkQueue *)calloc(batch.numWorkers, sizeof(WorkQueue));
+    workers = (Worker *)calloc(batch.numWorkers, sizeof(Worker));
+    threads = (Thread *)calloc(batch.numWorkers, sizeof(Thread));
+    if (!batch.queues || !workers || !threads) {
+        printf("out of memory\n");
+        return 1;
+    }
+    share = (batch.numLevels + batch.numWorkers - 1) / batch.numWorkers;
+    for (i = 0; i < batch.numWorkers; i++) {
+        WorkQueue *q = &batch.queues[i];
+
+        InitMutex(&q->lock);
+        q->items = (long *)malloc(share * sizeof(long));
+        if (!q->items) {
+            printf("out of memory\n");
+            return 1;
+        }
+        /* Stored backwards so the owner works through its run in order */
+        for (n = (long)(i + 1) * share - 1; n >= (long)i * share; n--) {
+            if (n < batch.numLevels)
+                q->items[q->tail++] = n;
+        }
+    }
+
+    InitZobrist();
+    wall = WallSeconds();
+    for (i = 0; i < batch.numWorkers; i++) {
+        workers[i].batch = &batch;
+        workers[i].id = i;
+        if (!StartThread(&threads[i], WorkerMain, &workers[i])) {
+            /* Run it here, the others will steal what they can */
+            WorkerMain(&workers[i]);
+        }
+    }
+    for (i = 0; i < batch.numWorkers; i++)
+        JoinThread(&threads[i]);
+    wall = WallSeconds() - wall;
+
+    if (csvPath) {
+        csv = fopen(csvPath, "w");
+        if (!csv) {
+            printf("%s: cannot write\n", csvPath);
+            return 1;
+        }
+    }
+    WriteCsv(csv, &batch);
+    if (csvPath)
+        fclose(csv);
+
+    /* Summary goes to stderr when the CSV takes stdout */
+    csv = csvPath ? stdout : stderr;
+    solvedDifficulty = (double *)malloc(batch.numLevels * sizeof(double));
+    for (n = 0; n < batch.numLevels; n++) {
+        BatchLevel *level = &batch.levels[n];
+
+        busy += level->seconds;
+        nodes += level->result.nodes;
+        if (level->result.status == SOLVE_FOUND) {
+            if (level->difficulty < last)
+                drops++;
+            last = level->difficulty;
+            if (solvedDifficulty)
+                solvedDifficulty[solved] = level->difficulty;
+            solved++;
+        } else if (level->result.status == SOLVE_LIMIT) {
+            limit++;
+        } else {
+            unsolvable++;
+        }
+    }
+
+    fprintf(csv, "levels=%ld solved=%ld unsolvable=%ld limit=%ld nodes=%ld\n",
+            batch.numLevels, solved, unsolvable, limit, nodes);
+    fprintf(csv, "threads=%d wall=%.3fs summed level time=%.3fs overlap=%.2fx\n",
+            batch.numWorkers, wall, busy, wall > 0 ? busy / wall : 0.0);
+    for (i = 0; i < batch.numWorkers; i++) {
+        fprintf(csv, "  worker %d: levels=%ld stolen=%ld\n",
+                i, batch.queues[i].solved, batch.queues[i].stolen);
+    }
+    fprintf(csv, "difficulty: drops=%ld of %ld steps, rank correlation with level order=%.3f\n",
+            drops, solved > 0 ? solved - 1 : 0,
+            solvedDifficulty ? RankCorrelation(solvedDifficulty, solved) : 0.0);
+
+    for (n = 0; n < batch.numLevels; n++)
+        FreeSolveResult(&batch.levels[n].result);
+    FreeLevelSet(&batch.set);
+    for (i = 0; i < batch.numWorkers; i++) {
+        FreeMutex(&batch.queues[i].lock);
+        free(batch.queues[i].items);
+    }
+    free(solvedDifficulty);
+    free(batch.queues);
+    free(batch.levels);
+    free(workers);
+    free(threads);
+    return unsolvable || limit ? 2 : 0;
+}
@@ -0,0 +1,248 @@
+/* Sokoban regression benchmark
+   Runs the same workloads on every level given and prints them as JSON:
+   parsing and the dead square pass done at load, a random walk through
+   the moves MovePlayer makes, CheckWin calls and a solve within a node
+   limit, so a slower build shows up as numbers
+   Usage: sokbench [-r repeat] [-l length] [-c checks] [-n maxnodes] [-s seed] [-o out.json] level.sok ...
+   -n 0 leaves out the solve
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "level.h"
+#include "deadlock.h"
+#include "journal.h"
+#include "solver.h"
+
+/* LURD */
+static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+
+static double Elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static double Rate(double count, double seconds)
+{
+    return seconds > 0 ? count / seconds : 0.0;
+}
+
+/* A file name as a JSON string */
+static void PrintString(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', out);
+        if ((unsigned char)*s < ' ')
+            fprintf(out, "\\u%04x", (unsigned char)*s);
+        else
+            fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+typedef struct {
+    double parseSeconds;      /* Per parse */
+    double loadSeconds;       /* Per dead square pass */
+    long moves, pushes, deadlocks;
+    double walkSeconds;
+    long checks, wins;
+    double checkSeconds;
+    SolveResult solve;
+    int solved;               /* 0 if the solve was left out */
+} LevelBench;
+
+/* Steps as MovePlayer takes them: the move, its journal entry and the
+   deadlock check after a push, then CheckWin. Starts over
+   when the walk deadlocks or solves the level */
+static void Walk(Board *board, const Board *start, long length, unsigned long *seed,
+                 LevelBench *r)
+{
+    Journal journal;
+    clock_t t;
+    long m;
+    int d, move, to;
+
+    JournalInit(&journal);
+    r->moves = r->pushes = r->deadlocks = 0;
+    t = clock();
+    for (m = 0; m < length; m++) {
+        d = (int)(NextRandom(seed) % 4);
+        if (!JournalReserve(&journal))
+            break;
+        move = BoardMove(board, dx[d], dy[d]);
+        if (move == MOVE_NONE)
+            continue;
+        r->moves++;
+        JournalRecord(&journal, dx[d], dy[d], move == MOVE_PUSH);
+        if (move == MOVE_PUSH) {
+            r->pushes++;
+            to = CELL_INDEX(board, board->playerX + dx[d], board->playerY + dy[d]);
+            if (IS_DEADLOCK(board, to)) {
+                r->deadlocks++;
+                BoardCopy(board, start);
+                JournalRestart(&journal);
+                continue;
+            }
+        }
+        if (BoardSolved(board)) {
+            BoardCopy(board, start);
+            JournalRestart(&journal);
+        }
+    }
+    r->walkSeconds = Elapsed(t);
+    JournalFree(&journal);
+}
+
+/* CheckWin on the start and on where the walk ended, in turn */
+static void Checks(const Board *start, const Board *walked, long checks, LevelBench *r)
+{
+    clock_t t;
+    long i, wins = 0;
+
+    t = clock();
+    for (i = 0; i < checks; i++)
+        wins += BoardSolved(i & 1 ? walked : start);
+    r->checkSeconds = Elapsed(t);
+    r->checks = checks;
+    r->wins = wins;
+}
+
+static void PrintLevel(FILE *out, const char *name, const Board *b, const LevelBench *r)
+{
+    fprintf(out, "    {\"name\": ");
+    PrintString(out, name);
+    fprintf(out, ", \"width\": %d, \"height\": %d, \"boxes\": %d,\n", b->width, b->height,
+            BoardCountBoxes(b));
+    fprintf(out, "     \"parse_us\": %.3f, \"dead_squares_us\": %.3f,\n",
+            r->parseSeconds * 1e6, r->loadSeconds * 1e6);
+    fprintf(out, "     \"moves\": %ld, \"pushes\": %ld, \"deadlocks\": %ld, \"moves_per_sec\": %.0f,\n",
+            r->moves, r->pushes, r->deadlocks, Rate((double)r->moves, r->walkSeconds));
+    fprintf(out, "     \"checkwin_per_sec\": %.0f", Rate((double)r->checks, r->checkSeconds));
+    if (r->solved) {
+        fprintf(out, ",\n     \"solve\": {\"status\": \"%s\", \"pushes\": %d, \"moves\": %d, \"nodes\": %ld, \"seconds\": %.6f}",
+                r->solve.status == SOLVE_FOUND ? "solved" :
+                r->solve.status == SOLVE_LIMIT ? "limit" : "unsolvable",
+                r->solve.pushes, r->solve.moves, r->solve.nodes, r->solve.seconds);
+    }
+    fprintf(out, "}");
+}
+
+int main(int argc, char *argv[])
+{
+    long repeat = 1000, length = 200000, checks = 1000000, maxNodes = 200000, size, r;
+    long totalMoves = 0, totalChecks = 0, totalNodes = 0;
+    double totalParse = 0.0, totalLoad = 0.0, totalWalk = 0.0, totalCheck = 0.0, totalSolve = 0.0;
+    int levels = 0, solved = 0, failed = 0, i;
+    unsigned long seed = 1, state;
+    const char *outPath = NULL;
+    SolveOptions options;
+    LevelBench bench;
+    Board board, start;
+    clock_t t;
+    FILE *out;
+    char *data;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeat = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            length = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            checks = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            maxNodes = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else {
+            break;
+        }
+    }
+
+    if (i >= argc || repeat < 1 || length < 0 || checks < 0 || maxNodes < 0) {
+        printf("Usage: sokbench [-r repeat] [-l length] [-c checks] [-n maxnodes] [-s seed] [-o out.json] level.sok ...\n");
+        return 1;
+    }
+    out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        printf("%s: cannot write\n", outPath);
+        return 1;
+    }
+
+    InitSolveOptions(&options);
+    options.maxNodes = maxNodes;
+    memset(&start, 0, sizeof(start));
+
+    fprintf(out, "{\"tool\": \"sokbench\", \"repeat\": %ld, \"length\": %ld, \"checks\": %ld, \"max_nodes\": %ld, \"seed\": %lu,\n",
+            repeat, length, checks, maxNodes, seed);
+    fprintf(out, "  \"levels\": [\n");
+    for (; i < argc; i++) {
+        memset(&bench, 0, sizeof(bench));
+        data = ReadTextFile(argv[i], &size);
+        if (!data || !ParseLevel(data, size, &board)) {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            free(data);
+            failed++;
+            continue;
+        }
+
+        /* Parse again and again as LoadLevel does, then its dead squares */
+        t = clock();
+        for (r = 0; r < repeat; r++) {
+            BoardFree(&board);
+            ParseLevel(data, size, &board);
+        }
+        bench.parseSeconds = Elapsed(t) / repeat;
+        free(data);
+        t = clock();
+        for (r = 0; r < repeat; r++)
+            FindDeadSquares(&board);
+        bench.loadSeconds = Elapsed(t) / repeat;
+
+        BoardCopy(&start, &board);
+        state = seed ? seed : 1;
+        Walk(&board, &start, length, &state, &bench);
+        Checks(&start, &board, checks, &bench);
+
+        if (maxNodes > 0) {
+            bench.solved = 1;
+            SolveLevel(&start, &options, &bench.solve);
+            if (bench.solve.status == SOLVE_FOUND)
+                solved++;
+            totalNodes += bench.solve.nodes;
+            totalSolve += bench.solve.seconds;
+        }
+
+        fprintf(out, levels ? ",\n" : "");
+        PrintLevel(out, argv[i], &start, &bench);
+        levels++;
+        totalParse += bench.parseSeconds;
+        totalLoad += bench.loadSeconds;
+        totalMoves += bench.moves;
+        totalWalk += bench.walkSeconds;
+        totalChecks += bench.checks;
+        totalCheck += bench.checkSeconds;
+        if (bench.solved)
+            FreeSolveResult(&bench.solve);
+        BoardFree(&board);
+    }
+    BoardFree(&start);
+
+    fprintf(out, "\n  ],\n");
+    fprintf(out, "  \"total\": {\"levels\": %d, \"failed\": %d, \"parse_us\": %.3f, \"dead_squares_us\": %.3f, \"moves_per_sec\": %.0f, \"checkwin_per_sec\": %.0f",
+            levels, failed, levels ? totalParse * 1e6 / levels : 0.0,
+            levels ? totalLoad * 1e6 / levels : 0.0, Rate((double)totalMoves, totalWalk),
+            Rate((double)totalChecks, totalCheck));
+    if (maxNodes > 0) {
+        fprintf(out, ", \"solved\": %d, \"solve_nodes\": %ld, \"solve_seconds\": %.3f",
+                solved, totalNodes, totalSolve);
+    }
+    fprintf(out, "}}\n");
+    if (outPath)
+        fclose(out);
+    return failed ? 2 : 0;
+}
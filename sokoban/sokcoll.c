@@ -0,0 +1,99 @@
+/* Sokoban level collection tool
+   Opens a multi-level .sok/XSB file the way the game does and times it
+   Usage: sokcoll [-t] [-l level] collection.sok
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "collection.h"
+
+static double Seconds(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+    LevelCollection c;
+    Board board;
+    char title[256];
+    long n, count, level = -1, cells = 0;
+    int titles = 0, i, x, y;
+    double openSeconds, indexSeconds, parseSeconds;
+    clock_t t;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-t") == 0) {
+            titles = 1;
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            level = atol(argv[++i]) - 1;
+        } else {
+            break;
+        }
+    }
+
+    if (i != argc - 1) {
+        printf("Usage: sokcoll [-t] [-l level] collection.sok\n");
+        return 1;
+    }
+
+    /* What the game pays before showing the first level */
+    t = clock();
+    if (!OpenCollection(&c, argv[i])) {
+        printf("%s: cannot open\n", argv[i]);
+        return 1;
+    }
+    if (CollectionLevel(&c, 0, &board)) {
+        BoardFree(&board);
+    }
+    openSeconds = Seconds(t);
+
+    /* Print one level, jumping straight to it */
+    if (level >= 0) {
+        if (!CollectionLevel(&c, level, &board)) {
+            printf("%s: no level %ld\n", argv[i], level + 1);
+            CloseCollection(&c);
+            return 1;
+        }
+        CollectionTitle(&c, level, title, sizeof(title));
+        printf("%ld: %s\n", level + 1, title);
+        for (y = 0; y < board.height; y++) {
+            for (x = 0; x < board.width; x++) {
+                putchar(" #$.@*+"[BoardCell(&board, x, y)]);
+            }
+            putchar('\n');
+        }
+        BoardFree(&board);
+        CloseCollection(&c);
+        return 0;
+    }
+
+    t = clock();
+    count = CollectionCount(&c);
+    indexSeconds = Seconds(t);
+
+    t = clock();
+    for (n = 0; n < count; n++) {
+        if (CollectionLevel(&c, n, &board)) {
+            cells += board.width * board.height;
+            BoardFree(&board);
+        }
+    }
+    parseSeconds = Seconds(t);
+
+    if (titles) {
+        for (n = 0; n < count; n++) {
+            CollectionTitle(&c, n, title, sizeof(title));
+            printf("%ld: %s\n", n + 1, title);
+        }
+    }
+
+    printf("%s: levels=%ld bytes=%ld cells=%ld\n", argv[i], count, c.size, cells);
+    printf("  open+first level=%.3fms index all=%.3fms parse all=%.3fms (%.0f levels/sec)\n",
+           openSeconds * 1e3, indexSeconds * 1e3, parseSeconds * 1e3,
+           parseSeconds > 0 ? count / parseSeconds : 0.0);
+
+    CloseCollection(&c);
+    return 0;
+}
@@ -0,0 +1,818 @@
+/* Sokoban level generator
+   Builds rooms from 3x3 blocks, puts the boxes on their goals and pulls
+   them back breadth first until they are the target number of pushes
+   away. Levels are seeded by their number, so any thread count writes
+   the same files.
+   Usage: sokgen [-n levels] [-w blocks] [-h blocks] [-b boxes] [-p pushes]
+                 [-t tolerance] [-a attempts] [-s seed] [-j threads]
+                 [-m maxstates] [-o dir] [-v]
+   Ranges such as -b 2-4 ramp from the first level to the last
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#include "hash.h"
+#include "solver.h"
+#include "thread.h"
+
+#define MAX_GEN_BLOCKS 8
+#define MAX_GEN_SIDE (MAX_GEN_BLOCKS * 3 + 2)
+#define MAX_GEN_CELLS (MAX_GEN_SIDE * MAX_GEN_SIDE)
+#define MAX_GEN_BOXES 12
+#define DEFAULT_MAX_STATES 300000L
+#define MAX_LAYOUTS 1000        /* Room layouts tried per candidate */
+
+/* Rooms are flooded as 64-bit planes, one bit per cell */
+#ifdef _MSC_VER
+typedef unsigned __int64 GenWord;
+#else
+typedef unsigned long long GenWord;
+#endif
+#define MAX_GEN_WORDS ((MAX_GEN_CELLS + 63) / 64)
+#define GEN_TEST(plane, i)  (((plane)[(i) >> 6] >> ((i) & 63)) & 1)
+#define GEN_SET(plane, i)   ((plane)[(i) >> 6] |= (GenWord)1 << ((i) & 63))
+#define GEN_CLEAR(plane, i) ((plane)[(i) >> 6] &= ~((GenWord)1 << ((i) & 63)))
+
+/* Block shapes, '#' wall and '.' floor, drawn in any rotation or mirror */
+static const char *templates[] = {
+    ".........",
+    "#........",
+    "##.......",
+    "#.#......",
+    "....#....",
+    "###......",
+    "#..#.....",
+    "..#...#..",
+    ".#.......",
+    "#...#....",
+    "##.#.....",
+    "##.##....",
+    ".#..#....",
+    "###.#....",
+    "#.##.#...",
+    "..#.##...",
+    "##..#..#.",
+    "#.#...#.#"
+};
+#define NUM_TEMPLATES (int)(sizeof(templates) / sizeof(templates[0]))
+
+typedef struct {
+    int lo, hi;
+} Range;
+
+typedef struct {
+    int width, height, cells, words;
+    unsigned char floor[MAX_GEN_CELLS];
+    GenWord floorPlane[MAX_GEN_WORDS];
+    int numBoxes;
+    int goals[MAX_GEN_BOXES];
+    int boxes[MAX_GEN_BOXES];   /* Start position once pulled back */
+    int player;
+    int pushes;
+} Room;
+
+/* Pull search scratch, one per thread. States are stored in BFS order,
+   so the depth of each is the optimal push count from it */
+typedef struct {
+    int numBoxes;
+    unsigned short *boxes;      /* numBoxes sorted cells per state */
+    unsigned short *player;     /* Where the player stands */
+    unsigned short *norm;       /* Lowest cell the player can reach */
+    unsigned short *depth;
+    ZobristKey *keys;
+    long numStates, maxStates;
+    long *table;                /* Open addressing over state indices */
+    unsigned long tableMask;
+    GenWord open[MAX_GEN_WORDS];      /* Floor without boxes */
+    GenWord reach[MAX_GEN_WORDS];     /* Player cells of the state being expanded */
+    GenWord childReach[MAX_GEN_WORDS];
+} PullSearch;
+
+typedef struct {
+    int numLevels;
+    Range blocksX, blocksY, boxes, pushes;
+    int tolerance;
+    long attempts;
+    unsigned long seed;
+    long maxStates;
+    const char *dir;
+    int digits;
+    int verify;
+    volatile long next;         /* Next level to generate */
+    Mutex printLock;
+} GenOptions;
+
+typedef struct {
+    GenOptions *opt;
+    PullSearch search;
+    long layouts, candidates, accepted, missed, failed, states, mismatches;
+} GenWorker;
+
+static int RandomBelow(unsigned long *state, int n)
+{
+    return (int)(NextRandom(state) % (unsigned long)n);
+}
+
+/* Value of a range for level n of count, rounded */
+static int Ramp(Range r, int n, int count)
+{
+    if (count < 2)
+        return r.lo;
+    return r.lo + (int)(((long)(r.hi - r.lo) * n * 2 + (count - 1)) / (2 * (count - 1)));
+}
+
+static int ParseRange(const char *s, Range *r)
+{
+    char *end;
+
+    r->lo = (int)strtol(s, &end, 10);
+    r->hi = *end == '-' ? (int)strtol(end + 1, &end, 10) : r->lo;
+    return *end == '\0' && r->lo > 0 && r->hi >= r->lo;
+}
+
+static int LowestBit(GenWord x)
+{
+    int n = 0;
+
+    while (!(x & 0xFFFF)) {
+        x >>= 16;
+        n += 16;
+    }
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static int CountBits(const GenWord *plane, int words)
+{
+    GenWord x;
+    int i, n = 0;
+
+    for (i = 0; i < words; i++) {
+        for (x = plane[i]; x; x &= x - 1)
+            n++;
+    }
+    return n;
+}
+
+/* Cells of open reachable from start, grown one step in every direction
+   at a time over whole words. Rows wrap into each other but the border
+   is wall. Returns the lowest cell reached */
+static int Flood(const GenWord *open, const Room *room, int start, GenWord *reach)
+{
+    GenWord x, grown;
+    int i, w = room->width, changed = 1;
+
+    memset(reach, 0, room->words * sizeof(GenWord));
+    GEN_SET(reach, start);
+    while (changed) {
+        changed = 0;
+        for (i = 0; i < room->words; i++) {
+            x = reach[i];
+            grown = x | x << 1 | x >> 1 | x << w | x >> w;
+            if (i > 0)
+                grown |= reach[i - 1] >> 63 | reach[i - 1] >> (64 - w);
+            if (i + 1 < room->words)
+                grown |= reach[i + 1] << 63 | reach[i + 1] << (64 - w);
+            grown &= open[i];
+            if (grown != x) {
+                reach[i] = grown;
+                changed = 1;
+            }
+        }
+    }
+    for (i = 0; !reach[i]; i++)
+        ;
+    return i * 64 + LowestBit(reach[i]);
+}
+
+static int InitSearch(PullSearch *s, long maxStates)
+{
+    unsigned long size = 1;
+
+    memset(s, 0, sizeof(PullSearch));
+    while (size < (unsigned long)maxStates * 2)
+        size <<= 1;
+    s->maxStates = maxStates;
+    s->tableMask = size - 1;
+    s->boxes = (unsigned short *)malloc(maxStates * MAX_GEN_BOXES * sizeof(unsigned short));
+    s->player = (unsigned short *)malloc(maxStates * sizeof(unsigned short));
+    s->norm = (unsigned short *)malloc(maxStates * sizeof(unsigned short));
+    s->depth = (unsigned short *)malloc(maxStates * sizeof(unsigned short));
+    s->keys = (ZobristKey *)malloc(maxStates * sizeof(ZobristKey));
+    s->table = (long *)malloc(size * sizeof(long));
+    if (!s->boxes || !s->player || !s->norm || !s->depth || !s->keys || !s->table)
+        return 0;
+    memset(s->table, 0xFF, size * sizeof(long));
+    return 1;
+}
+
+static void FreeSearch(PullSearch *s)
+{
+    free(s->boxes);
+    free(s->player);
+    free(s->norm);
+    free(s->depth);
+    free(s->keys);
+    free(s->table);
+}
+
+/* Add a state unless it is known, returns 0 when the search is full */
+static int AddState(PullSearch *s, const unsigned short *boxes, int player, int norm,
+                    int depth, ZobristKey key)
+{
+    unsigned long slot = (unsigned long)(key ^ (key >> 32)) & s->tableMask;
+    long i;
+
+    while ((i = s->table[slot]) >= 0) {
+        if (s->keys[i] == key && s->norm[i] == norm &&
+            memcmp(s->boxes + i * s->numBoxes, boxes, s->numBoxes * sizeof(unsigned short)) == 0)
+            return 1;
+        slot = (slot + 1) & s->tableMask;
+    }
+    if (s->numStates >= s->maxStates)
+        return 0;
+
+    i = s->numStates++;
+    s->table[slot] = i;
+    memcpy(s->boxes + i * s->numBoxes, boxes, s->numBoxes * sizeof(unsigned short));
+    s->player[i] = (unsigned short)player;
+    s->norm[i] = (unsigned short)norm;
+    s->depth[i] = (unsigned short)depth;
+    s->keys[i] = key;
+    return 1;
+}
+
+/* Empty the table for the next room. Clearing newest first keeps every
+   older probe chain intact, so each state still finds its own slot. This
+   touches only the slots in use, not the whole table */
+static void ClearStates(PullSearch *s)
+{
+    unsigned long slot;
+    long i;
+
+    for (i = s->numStates - 1; i >= 0; i--) {
+        slot = (unsigned long)(s->keys[i] ^ (s->keys[i] >> 32)) & s->tableMask;
+        while (s->table[slot] != i)
+            slot = (slot + 1) & s->tableMask;
+        s->table[slot] = -1;
+    }
+    s->numStates = 0;
+}
+
+/* Pull the boxes back from their goals breadth first, stopping once the
+   states maxDepth pushes away are all known, and leave the farthest in
+   room. Returns its push count */
+static int PullBack(PullSearch *s, Room *room, int maxDepth)
+{
+    unsigned short boxes[MAX_GEN_BOXES], child[MAX_GEN_BOXES];
+    int offset[4];
+    int i, j, d, c, b, p, q, norm, best = 0, bestOff = -1, off;
+    long n, bestState = 0;
+    ZobristKey key;
+
+    offset[0] = -1;
+    offset[1] = 1;
+    offset[2] = -room->width;
+    offset[3] = room->width;
+
+    s->numBoxes = room->numBoxes;
+
+    /* Goals sorted, with the player in each region the boxes leave */
+    for (i = 0; i < room->numBoxes; i++) {
+        for (j = i; j > 0 && boxes[j - 1] > room->goals[i]; j--)
+            boxes[j] = boxes[j - 1];
+        boxes[j] = (unsigned short)room->goals[i];
+    }
+    key = 0;
+    memcpy(s->open, room->floorPlane, room->words * sizeof(GenWord));
+    for (i = 0; i < room->numBoxes; i++) {
+        GEN_CLEAR(s->open, boxes[i]);
+        key ^= ZOBRIST_BOX(boxes[i]);
+    }
+    memset(s->reach, 0, room->words * sizeof(GenWord));
+    for (c = 0; c < room->cells; c++) {
+        if (!GEN_TEST(s->open, c) || GEN_TEST(s->reach, c))
+            continue;
+        norm = Flood(s->open, room, c, s->childReach);
+        AddState(s, boxes, c, norm, 0, key ^ ZOBRIST_PLAYER(norm));
+        for (j = 0; j < room->words; j++)
+            s->reach[j] |= s->childReach[j];
+    }
+
+    for (n = 0; n < s->numStates && s->depth[n] < maxDepth; n++) {
+        const unsigned short *from = s->boxes + n * s->numBoxes;
+
+        memcpy(s->open, room->floorPlane, room->words * sizeof(GenWord));
+        for (i = 0; i < s->numBoxes; i++)
+            GEN_CLEAR(s->open, from[i]);
+        Flood(s->open, room, s->player[n], s->reach);
+
+        for (i = 0; i < s->numBoxes; i++) {
+            b = from[i];
+            for (d = 0; d < 4; d++) {
+                /* Player on p pulls the box from b to p and steps to q */
+                p = b + offset[d];
+                q = p + offset[d];
+                if (!GEN_TEST(s->reach, p) || !GEN_TEST(s->open, q))
+                    continue;
+
+                /* Keep the box list sorted */
+                for (j = 0; j < s->numBoxes; j++)
+                    child[j] = from[j];
+                j = i;
+                while (j > 0 && child[j - 1] > p) {
+                    child[j] = child[j - 1];
+                    j--;
+                }
+                while (j < s->numBoxes - 1 && child[j + 1] < p) {
+                    child[j] = child[j + 1];
+                    j++;
+                }
+                child[j] = (unsigned short)p;
+
+                GEN_SET(s->open, b);
+                GEN_CLEAR(s->open, p);
+                norm = Flood(s->open, room, q, s->childReach);
+                GEN_SET(s->open, p);
+                GEN_CLEAR(s->open, b);
+
+                key = s->keys[n] ^ ZOBRIST_PLAYER(s->norm[n]) ^ ZOBRIST_PLAYER(norm) ^
+                      ZOBRIST_BOX(b) ^ ZOBRIST_BOX(p);
+                if (!AddState(s, child, q, norm, s->depth[n] + 1, key))
+                    goto full;
+            }
+        }
+    }
+full:
+
+    /* Deepest state, preferring the one with the fewest boxes left on goals */
+    for (n = 0; n < s->numStates; n++) {
+        if (s->depth[n] < best)
+            continue;
+        off = 0;
+        for (i = 0; i < s->numBoxes; i++) {
+            for (j = 0; j < room->numBoxes; j++) {
+                if (s->boxes[n * s->numBoxes + i] == room->goals[j])
+                    off--;
+            }
+        }
+        if (s->depth[n] > best || off > bestOff) {
+            best = s->depth[n];
+            bestOff = off;
+            bestState = n;
+        }
+    }
+
+    for (i = 0; i < s->numBoxes; i++)
+        room->boxes[i] = s->boxes[bestState * s->numBoxes + i];
+    room->player = s->player[bestState];
+    room->pushes = best;
+    return best;
+}
+
+/* Any 4x3 or 3x4 patch of floor, which makes the level too easy */
+static int HasOpenArea(const Room *room)
+{
+    int x, y, i, j, w, h, open;
+
+    for (w = 3; w <= 4; w++) {
+        h = 7 - w;
+        for (y = 1; y + h < room->height; y++) {
+            for (x = 1; x + w < room->width; x++) {
+                open = 1;
+                for (j = 0; j < h && open; j++) {
+                    for (i = 0; i < w && open; i++)
+                        open = room->floor[(y + j) * room->width + x + i];
+                }
+                if (open)
+                    return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Wall up floor with three walls around it until none is left */
+static void FillDeadEnds(Room *room)
+{
+    int c, walls, filled = 1;
+
+    while (filled) {
+        filled = 0;
+        for (c = room->width; c < room->cells - room->width; c++) {
+            if (!room->floor[c])
+                continue;
+            walls = !room->floor[c - 1] + !room->floor[c + 1] +
+                    !room->floor[c - room->width] + !room->floor[c + room->width];
+            if (walls >= 3) {
+                room->floor[c] = 0;
+                filled = 1;
+            }
+        }
+    }
+}
+
+/* Lay out blocks, keep the biggest connected floor and scatter goals,
+   returns 0 if the room is too open or too small for the boxes */
+static int MakeRoom(PullSearch *s, Room *room, unsigned long *rng, int blocksX, int blocksY,
+                    int numBoxes)
+{
+    int bx, by, i, j, t, r, flip, x, y, c, size, bestSize = 0, bestStart = -1;
+    int floorCells[MAX_GEN_CELLS], numFloor = 0;
+
+    room->width = blocksX * 3 + 2;
+    room->height = blocksY * 3 + 2;
+    room->cells = room->width * room->height;
+    room->words = (room->cells + 63) / 64;
+    room->numBoxes = numBoxes;
+    memset(room->floor, 0, room->cells);
+
+    for (by = 0; by < blocksY; by++) {
+        for (bx = 0; bx < blocksX; bx++) {
+            t = RandomBelow(rng, NUM_TEMPLATES);
+            r = RandomBelow(rng, 4);
+            flip = RandomBelow(rng, 2);
+            for (j = 0; j < 3; j++) {
+                for (i = 0; i < 3; i++) {
+                    x = flip ? 2 - i : i;
+                    y = j;
+                    /* Rotate a quarter turn r times */
+                    for (c = 0; c < r; c++) {
+                        int tmp = x;
+                        x = 2 - y;
+                        y = tmp;
+                    }
+                    room->floor[(by * 3 + 1 + j) * room->width + bx * 3 + 1 + i] =
+                        templates[t][y * 3 + x] == '.';
+                }
+            }
+        }
+    }
+
+    FillDeadEnds(room);
+    if (HasOpenArea(room))
+        return 0;
+
+    /* Keep the largest region, the rest becomes wall */
+    memset(room->floorPlane, 0, sizeof(room->floorPlane));
+    for (c = 0; c < room->cells; c++) {
+        if (room->floor[c])
+            GEN_SET(room->floorPlane, c);
+    }
+    memset(s->reach, 0, room->words * sizeof(GenWord));
+    for (c = 0; c < room->cells; c++) {
+        if (room->floor[c] && !GEN_TEST(s->reach, c)) {
+            Flood(room->floorPlane, room, c, s->childReach);
+            size = CountBits(s->childReach, room->words);
+            for (i = 0; i < room->words; i++)
+                s->reach[i] |= s->childReach[i];
+            if (size > bestSize) {
+                bestSize = size;
+                bestStart = c;
+            }
+        }
+    }
+    if (bestStart < 0 || bestSize < numBoxes + 4)
+        return 0;
+    Flood(room->floorPlane, room, bestStart, s->childReach);
+    memcpy(room->floorPlane, s->childReach, room->words * sizeof(GenWord));
+    for (c = 0; c < room->cells; c++) {
+        room->floor[c] = (unsigned char)GEN_TEST(room->floorPlane, c);
+        if (room->floor[c])
+            floorCells[numFloor++] = c;
+    }
+
+    /* Distinct goal cells */
+    for (i = 0; i < numBoxes; i++) {
+        j = i + RandomBelow(rng, numFloor - i);
+        c = floorCells[i];
+        floorCells[i] = floorCells[j];
+        floorCells[j] = c;
+        room->goals[i] = floorCells[i];
+    }
+    return 1;
+}
+
+static int RoomCell(const Room *room, int c)
+{
+    int i, box = 0, goal = 0;
+
+    for (i = 0; i < room->numBoxes; i++) {
+        if (room->boxes[i] == c)
+            box = 1;
+        if (room->goals[i] == c)
+            goal = 1;
+    }
+    if (box)
+        return goal ? '*' : '$';
+    if (c == room->player)
+        return goal ? '+' : '@';
+    if (goal)
+        return '.';
+    return room->floor[c] ? ' ' : '#';
+}
+
+/* Walls touching no floor are outside the level and left blank */
+static int Outside(const Room *room, int x, int y)
+{
+    int i, j, nx, ny;
+
+    if (room->floor[y * room->width + x])
+        return 0;
+    for (j = -1; j <= 1; j++) {
+        for (i = -1; i <= 1; i++) {
+            nx = x + i;
+            ny = y + j;
+            if (nx >= 0 && ny >= 0 && nx < room->width && ny < room->height &&
+                room->floor[ny * room->width + nx])
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static int WriteRoom(const Room *room, const char *path)
+{
+    FILE *f = fopen(path, "w");
+    char line[MAX_GEN_SIDE + 1];
+    int x, y, len;
+
+    if (!f)
+        return 0;
+    for (y = 0; y < room->height; y++) {
+        len = 0;
+        for (x = 0; x < room->width; x++) {
+            line[x] = Outside(room, x, y) ? ' ' : (char)RoomCell(room, y * room->width + x);
+            if (line[x] != ' ')
+                len = x + 1;
+        }
+        line[len] = '\0';
+        fprintf(f, "%s\n", line);
+    }
+    return fclose(f) == 0;
+}
+
+/* Check the pull depth against the solver. Macro moves first, they are
+   quick on corridors but may miss the optimum, so a disagreement is
+   solved again push by push before it counts */
+static int VerifyRoom(const Room *room)
+{
+    Board board;
+    SolveOptions options;
+    SolveResult result;
+    int i, ok;
+
+    if (!BoardInit(&board, room->width, room->height))
+        return 0;
+    for (i = 0; i < room->cells; i++) {
+        if (!room->floor[i])
+            SET_BIT(board.walls, i);
+    }
+    for (i = 0; i < room->numBoxes; i++) {
+        SET_BIT(board.boxes, room->boxes[i]);
+        SET_BIT(board.targets, room->goals[i]);
+    }
+    board.playerX = room->player % room->width;
+    board.playerY = room->player / room->width;
+    InitSolveOptions(&options);
+    options.macros = 1;
+    SolveLevel(&board, &options, &result);
+    ok = result.status == SOLVE_FOUND && result.pushes == room->pushes;
+    FreeSolveResult(&result);
+    if (!ok) {
+        SolveLevel(&board, NULL, &result);
+        ok = result.status == SOLVE_FOUND && result.pushes == room->pushes;
+        FreeSolveResult(&result);
+    }
+    BoardFree(&board);
+    return ok;
+}
+
+static void GenerateLevel(GenWorker *w, int level)
+{
+    GenOptions *opt = w->opt;
+    Room room, best;
+    unsigned long rng = (opt->seed * 2654435761UL + (unsigned long)level * 40503UL + 1) & 0xFFFFFFFFUL;
+    int blocksX = Ramp(opt->blocksX, level, opt->numLevels);
+    int blocksY = Ramp(opt->blocksY, level, opt->numLevels);
+    int boxes = Ramp(opt->boxes, level, opt->numLevels);
+    int target = Ramp(opt->pushes, level, opt->numLevels);
+    int bestMiss = -1, miss;
+    long attempt, layout;
+    char path[300];
+
+    if (rng == 0)
+        rng = 1;
+    memset(&best, 0, sizeof(Room));
+    for (attempt = 0; attempt < opt->attempts; attempt++) {
+        for (layout = 0; layout < MAX_LAYOUTS; layout++) {
+            if (MakeRoom(&w->search, &room, &rng, blocksX, blocksY, boxes))
+                break;
+        }
+        if (layout == MAX_LAYOUTS)
+            break;
+        w->layouts += layout + 1;
+        w->candidates++;
+        PullBack(&w->search, &room, target);
+        w->states += w->search.numStates;
+        ClearStates(&w->search);
+
+        miss = room.pushes < target ? target - room.pushes : room.pushes - target;
+        if (bestMiss < 0 || miss < bestMiss) {
+            best = room;
+            bestMiss = miss;
+        }
+        if (miss <= opt->tolerance)
+            break;
+    }
+
+    if (bestMiss < 0) {
+        w->failed++;
+        LockMutex(&opt->printLock);
+        printf("level %d: no room fits %d boxes\n", level, boxes);
+        UnlockMutex(&opt->printLock);
+        return;
+    }
+    if (bestMiss > opt->tolerance)
+        w->missed++;
+    else
+        w->accepted++;
+    if (opt->verify && !VerifyRoom(&best))
+        w->mismatches++;
+
+    sprintf(path, "%.250s/l%0*d.sok", opt->dir, opt->digits, level);
+    if (!WriteRoom(&best, path)) {
+        w->failed++;
+        return;
+    }
+    LockMutex(&opt->printLock);
+    printf("%s: %dx%d boxes=%d pushes=%d target=%d%s\n", path, best.width, best.height,
+           boxes, best.pushes, target, bestMiss > opt->tolerance ? " (missed)" : "");
+    fflush(stdout);
+    UnlockMutex(&opt->printLock);
+}
+
+/* The output directory, made if it is missing, 0 if there is none */
+static int MakeDirectory(const char *dir)
+{
+    struct stat st;
+
+    if (stat(dir, &st) != 0) {
+#ifdef _WIN32
+        _mkdir(dir);
+#else
+        mkdir(dir, 0777);
+#endif
+    }
+    return stat(dir, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+static void WorkerMain(void *arg)
+{
+    GenWorker *w = (GenWorker *)arg;
+    long level;
+
+    while ((level = AtomicAdd(&w->opt->next, 1)) < w->opt->numLevels)
+        GenerateLevel(w, (int)level);
+}
+
+int main(int argc, char *argv[])
+{
+    GenOptions opt;
+    GenWorker *workers;
+    Thread *threads;
+    long layouts = 0, candidates = 0, accepted = 0, missed = 0, failed = 0, states = 0, mismatches = 0;
+    int numWorkers = CountProcessors(), i, n;
+    double wall;
+
+    memset(&opt, 0, sizeof(GenOptions));
+    opt.numLevels = 100;
+    opt.blocksX.lo = opt.blocksY.lo = opt.boxes.lo = 2;
+    opt.blocksX.hi = opt.blocksY.hi = opt.boxes.hi = 4;
+    opt.pushes.lo = 10;
+    opt.pushes.hi = 50;
+    opt.tolerance = 2;
+    opt.attempts = 30;
+    opt.seed = 1000;
+    opt.maxStates = DEFAULT_MAX_STATES;
+    opt.dir = "levels";
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (i + 1 >= argc && strcmp(argv[i], "-v") != 0)
+            break;
+        if (strcmp(argv[i], "-n") == 0) {
+            opt.numLevels = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0) {
+            if (!ParseRange(argv[++i], &opt.blocksX))
+                break;
+        } else if (strcmp(argv[i], "-h") == 0) {
+            if (!ParseRange(argv[++i], &opt.blocksY))
+                break;
+        } else if (strcmp(argv[i], "-b") == 0) {
+            if (!ParseRange(argv[++i], &opt.boxes))
+                break;
+        } else if (strcmp(argv[i], "-p") == 0) {
+            if (!ParseRange(argv[++i], &opt.pushes))
+                break;
+        } else if (strcmp(argv[i], "-t") == 0) {
+            opt.tolerance = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-a") == 0) {
+            opt.attempts = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            opt.seed = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-j") == 0) {
+            numWorkers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0) {
+            opt.maxStates = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0) {
+            opt.dir = argv[++i];
+        } else if (strcmp(argv[i], "-v") == 0) {
+            opt.verify = 1;
+        } else {
+            break;
+        }
+    }
+
+    if (i < argc || opt.numLevels < 1 || numWorkers < 1 || opt.maxStates < 1 ||
+        opt.blocksX.hi > MAX_GEN_BLOCKS || opt.blocksY.hi > MAX_GEN_BLOCKS ||
+        opt.boxes.hi > MAX_GEN_BOXES) {
+        printf("Usage: sokgen [-n levels] [-w blocks] [-h blocks] [-b boxes] [-p pushes]\n");
+        printf("              [-t tolerance] [-a attempts] [-s seed] [-j threads]\n");
+        printf("              [-m maxstates] [-o dir] [-v]\n");
+        printf("  ranges such as -b 2-4 ramp from the first level to the last,\n");
+        printf("  at most %d blocks a side and %d boxes\n", MAX_GEN_BLOCKS, MAX_GEN_BOXES);
+        return 1;
+    }
+
+    /* Found out before generating anything rather than at every write */
+    if (!MakeDirectory(opt.dir)) {
+        printf("%s: cannot create the output directory\n", opt.dir);
+        return 2;
+    }
+
+    /* Names sort in level order, as genlevels packs them */
+    opt.digits = 2;
+    for (n = 100; n < opt.numLevels; n *= 10)
+        opt.digits++;
+    if (numWorkers > opt.numLevels)
+        numWorkers = opt.numLevels;
+
+    workers = (GenWorker *)calloc(numWorkers, sizeof(GenWorker));
+    threads = (Thread *)calloc(numWorkers, sizeof(Thread));
+    if (!workers || !threads || !InitMutex(&opt.printLock)) {
+        printf("out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < numWorkers; i++) {
+        workers[i].opt = &opt;
+        if (!InitSearch(&workers[i].search, opt.maxStates)) {
+            printf("out of memory for %ld states\n", opt.maxStates);
+            return 1;
+        }
+    }
+
+    InitZobrist();
+    wall = WallSeconds();
+    for (i = 0; i < numWorkers; i++) {
+        if (!StartThread(&threads[i], WorkerMain, &workers[i]))
+            WorkerMain(&workers[i]);
+    }
+    for (i = 0; i < numWorkers; i++)
+        JoinThread(&threads[i]);
+    wall = WallSeconds() - wall;
+
+    for (i = 0; i < numWorkers; i++) {
+        layouts += workers[i].layouts;
+        candidates += workers[i].candidates;
+        accepted += workers[i].accepted;
+        missed += workers[i].missed;
+        failed += workers[i].failed;
+        states += workers[i].states;
+        mismatches += workers[i].mismatches;
+        FreeSearch(&workers[i].search);
+    }
+
+    printf("levels=%d accepted=%ld missed band=%ld failed=%ld threads=%d time=%.3fs\n",
+           opt.numLevels, accepted, missed, failed, numWorkers, wall);
+    printf("room layouts=%ld (%.0f/sec) candidates searched=%ld (%.1f/sec)\n",
+           layouts, wall > 0 ? layouts / wall : 0.0,
+           candidates, wall > 0 ? candidates / wall : 0.0);
+    printf("accepted=%ld (%.2f/sec) states=%ld (%.0f/sec)\n",
+           accepted, wall > 0 ? accepted / wall : 0.0,
+           states, wall > 0 ? states / wall : 0.0);
+    if (opt.verify)
+        printf("verify: %ld levels where the solver disagrees with the pull depth\n", mismatches);
+
+    FreeMutex(&opt.printLock);
+    free(workers);
+    free(threads);
+    return failed || mismatches ? 2 : 0;
+}
@@ -18,11 +18,25 @@
 
 /* Level resources */
 #include "levels.h"
+#include "hash.h"
+#include "deadlock.h"
+#include "pack.h"
+#include "collection.h"
+#include "hint.h"
+#include "thread.h"
+#include "journal.h"
+#include "atlas.h"
+#include "path.h"
+#include "deadpat.h"
 
 /* Game constants */
 #define CELL_SIZE 32
-#define GRID_ROWS 20
-#define GRID_COLS 20
+
+/* Hints search for HINT_BUDGET seconds per key press, on a worker
+   thread that posts WM_HINT back. Out of time the best guess is shown,
+   pressing H again searches on from where it stopped */
+#define HINT_BUDGET 0.05
+#define WM_HINT (WM_APP + 1)
 
 /* Bitmap handles */
 HBITMAP hForkliftBitmap = NULL;
@@ -31,15 +45,6 @@ HBITMAP hTruckEmptyBitmap = NULL;
 HBITMAP hTruckFullBitmap = NULL;
 HBITMAP hWallBitmap = NULL;
 
-/* Game elements */
-#define EMPTY   0
-#define WALL    1
-#define BOX     2
-#define TARGET  3
-#define PLAYER  4
-#define BOX_ON_TARGET 5
-#define PLAYER_ON_TARGET 6
-
 /* Colors */
 #define COLOR_FLOOR    RGB(255, 255, 255)  /* White */
 #define COLOR_WALL     RGB(100, 100, 100)  /* Dark gray */
@@ -48,288 +53,255 @@ HBITMAP hWallBitmap = NULL;
 #define COLOR_PLAYER   RGB(0, 0, 255)      /* Blue */
 #define COLOR_BOX_OK   RGB(0, 128, 0)      /* Green */
 
-/* Player position */
-int playerX = 1;
-int playerY = 1;
-
 /* Level management */
-char currentLevel[100] = "";
-char levelFiles[100][100];  /* Array to store level file paths */
-int numLevels = 0;         /* Number of levels found */
-int currentLevelIndex = 0; /* Index of current level in the levelFiles array */
-
-/* Level dimensions (will be detected from the loaded level) */
-int levelWidth = 0;
-int levelHeight = 0;
-
-/* Game grid */
-int grid[GRID_ROWS][GRID_COLS] = {0};
+char currentLevel[100] = "";  /* Name shown in the title bar */
+long currentLevelIndex = 0;
+
+/* Pre-parsed levels, read in place from the locked resource */
+LevelPack levelPack;
+
+/* A collection file named on the command line replaces the built-in levels */
+LevelCollection collection;
+BOOL useCollection = FALSE;
+
+/* Game board: walls, boxes and targets as bitplanes, sized by the loaded level */
+Board board;
+
+/* Zobrist key of the current box set, updated on every push, the hint
+   engine tells positions apart by it */
+ZobristKey boxHash = 0;
+
+/* Set when a push made the level unsolvable */
+BOOL deadlocked = FALSE;
+
+/* Deadlocked windows from patgen, mapped from deadlock.pat if it is there */
+PatternTable patterns;
+
+/* Tiles indexed by BoardCell, EMPTY is bare floor */
+#define NUM_TILES (PLAYER_ON_TARGET + 1)
+SpriteAtlas atlas;
+HBRUSH floorBrush = NULL;
+HPEN hintPen = NULL;
+
+/* Back buffer kept between frames, a move draws just the cells it changed */
+#define MAX_DIRTY 16
+HDC backDC = NULL;
+HBITMAP backBitmap = NULL, backOldBitmap = NULL;
+int backWidth = 0, backHeight = 0;
+int dirtyCells[MAX_DIRTY];
+int numDirty = 0;
+BOOL redrawAll = TRUE;
+
+/* Paint timing, F cycles through off, shown, and shown while drawing
+   every cell on every frame as a baseline */
+#define PAINT_STATS_OFF  0
+#define PAINT_STATS_ON   1
+#define PAINT_STATS_FULL 2
+int paintStats = PAINT_STATS_OFF;
+double paintSeconds = 0;
+long paintFrames = 0, paintCells = 0;
+
+/* Every move made on this level, for undo, redo and the saved game */
+Journal journal;
+Board levelStart;             /* Boxes and player as the level began */
+char saveDir[MAX_PATH] = "";  /* Saved games, one file per level */
+BOOL levelLoaded = FALSE;
+
+/* Hint engine, kept warm for the whole level. The worker owns it and
+   hintBoard while hintBusy, the window only cancels */
+HintEngine hintEngine;
+BOOL hintReady = FALSE;
+BOOL hintBusy = FALSE;
+BOOL hintWanted = FALSE;      /* H pressed while a cancelled search winds down */
+Thread hintThread;
+Board hintBoard;
+ZobristKey hintKey;
+Hint hintResult;
+int hintStatus;
+long hintGeneration = 0;      /* Bumped by every move, stale answers are dropped */
+long workerGeneration = -1;   /* Position the worker is searching */
+HWND hintWindow = NULL;
+int hintBoxX = -1, hintBoxY = -1;
+char hintText[100] = "";
+
+/* Mouse play: a click walks the player there, or picks a box and the
+   next click moves it. Reach is flooded once per push */
+PathFinder pathFinder;
+BOOL pathReady = FALSE;
+int pickedX = -1, pickedY = -1;
+HPEN pickPen = NULL;
+HCURSOR arrowCursor, moveCursor;
 
 /* Function declarations */
-BOOL LoadLevel(const char *filename);
-void ScanLevelFiles(void);
+BOOL LoadLevel(long index);
+BOOL OpenLevels(const char *path);
+BOOL HaveLevel(long index);
 BOOL LoadNextLevel(void);
 void UpdateWindowTitle(HWND hwnd, const char *levelPath);
+void StopHint(BOOL wait);
+void SaveGame(void);
+void MarkCell(HWND hwnd, int col, int row);
+void MarkAll(HWND hwnd);
+void DropPick(HWND hwnd);
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
-/* String comparison function for qsort */
-int CompareStrings(const void *a, const void *b) {
-    return strcmp(*(const char **)a, *(const char **)b);
-}
-
-/* Initialize the level list from embedded resources */
-void ScanLevelFiles() {
-    int i;
-    char levelName[20];
-
-    /* Reset level count */
-    numLevels = NUM_LEVELS;
-
-    /* Generate level names based on resource IDs */
-    for (i = 0; i < numLevels; i++) {
-        sprintf(levelName, "Level %d", i);
-        strcpy(levelFiles[i], levelName);
-    }
-
-    /* Find current level index */
-    {
-        int i;
-        for (i = 0; i < numLevels; i++) {
-            if (strcmp(currentLevel, levelFiles[i]) == 0) {
-                currentLevelIndex = i;
-                break;
-            }
+/* Open the collection at path, or the built-in pack when path is empty */
+BOOL OpenLevels(const char *path) {
+    HRSRC hResInfo;
+    HGLOBAL hResData;
+    LPVOID pData;
+    char fileName[MAX_PATH];
+    int len;
+
+    /* Explorer quotes paths with spaces */
+    while (*path == ' ' || *path == '"')
+        path++;
+    strncpy(fileName, path, MAX_PATH - 1);
+    fileName[MAX_PATH - 1] = '\0';
+    len = strlen(fileName);
+    while (len > 0 && (fileName[len - 1] == ' ' || fileName[len - 1] == '"'))
+        fileName[--len] = '\0';
+
+    /* Levels are indexed as they are asked for, opening is instant */
+    if (fileName[0] != '\0') {
+        if (OpenCollection(&collection, fileName)) {
+            useCollection = TRUE;
+            return TRUE;
         }
+        MessageBox(NULL, "Failed to open level collection!", "Warning", MB_ICONWARNING | MB_OK);
     }
+
+    /* The pack stays locked for the life of the process */
+    hResInfo = FindResource(NULL, MAKEINTRESOURCE(IDR_LEVEL_PACK), RT_RCDATA);
+    if (!hResInfo)
+        return FALSE;
+    hResData = LoadResource(NULL, hResInfo);
+    if (!hResData)
+        return FALSE;
+    pData = LockResource(hResData);
+    if (!pData)
+        return FALSE;
+    return OpenPack(&levelPack, pData, (long)SizeofResource(NULL, hResInfo));
+}
+
+/* Does the level exist, without counting every level in a collection */
+BOOL HaveLevel(long index) {
+    if (useCollection)
+        return CollectionHasLevel(&collection, index);
+    return index >= 0 && index < levelPack.numLevels;
 }
 
 /* Load the next level in sequence */
 BOOL LoadNextLevel() {
-    if (numLevels == 0 || currentLevelIndex >= numLevels - 1) {
+    if (!HaveLevel(currentLevelIndex + 1)) {
         /* We're at the last level or no levels found */
         MessageBox(NULL, "Congratulations! You completed all levels!", "Sokoban", MB_OK | MB_ICONINFORMATION);
         return FALSE;
     }
 
     /* Move to the next level */
-    currentLevelIndex++;
-    return LoadLevel(levelFiles[currentLevelIndex]);
+    return LoadLevel(currentLevelIndex + 1);
 }
 
-/* Load a level from embedded resource */
-BOOL LoadLevel(const char *levelName)
+/* Any box already lost, after a saved game or an undo */
+BOOL IsStuck(void)
 {
-    HRSRC hResInfo;
-    HGLOBAL hResData;
-    LPVOID pData;
-    DWORD resSize;
-    char *levelData, *line, *nextLine;
-    int row = 0, col = 0;
-    int i, j;
-    int levelIndex;
-    HWND hwnd;
-
-    /* Save the current level name */
-    strcpy(currentLevel, levelName);
+    int c, cells = board.width * board.height;
 
-    /* Convert level name to resource index */
-    if (sscanf(levelName, "Level %d", &levelIndex) != 1) {
-        /* If not in our format, find by string comparison */
-        for (i = 0; i < numLevels; i++) {
-            if (strcmp(levelName, levelFiles[i]) == 0) {
-                levelIndex = i;
-                break;
-            }
-        }
-    }
-
-    /* Verify level index is valid */
-    if (levelIndex < 0 || levelIndex >= numLevels) {
-        MessageBox(NULL, "Invalid level index!", "Error", MB_ICONERROR | MB_OK);
-        return FALSE;
-    }
-
-    /* Reset the grid */
-    for (i = 0; i < GRID_ROWS; i++) {
-        for (j = 0; j < GRID_COLS; j++) {
-            grid[i][j] = EMPTY;
-        }
-    }
-
-    /* Load level resource by ID */
-    hResInfo = FindResource(NULL, MAKEINTRESOURCE(3000 + levelIndex), RT_RCDATA);
-
-    if (!hResInfo) {
-        MessageBox(NULL, "Failed to find level resource!", "Error", MB_ICONERROR | MB_OK);
-        return FALSE;
+    for (c = 0; c < cells; c++) {
+        if (TEST_BIT(board.boxes, c) &&
+            (IS_DEADLOCK(&board, c) || PatternDeadlock(&patterns, &board, c)))
+            return TRUE;
     }
+    return FALSE;
+}
 
-    hResData = LoadResource(NULL, hResInfo);
-    if (!hResData) {
-        MessageBox(NULL, "Failed to load level resource!", "Error", MB_ICONERROR | MB_OK);
-        return FALSE;
-    }
+/* Write the moves made on this level to its saved game */
+void SaveGame(void)
+{
+    char path[MAX_PATH + 16];
 
-    pData = LockResource(hResData);
-    if (!pData) {
-        MessageBox(NULL, "Failed to lock level resource!", "Error", MB_ICONERROR | MB_OK);
-        return FALSE;
-    }
+    if (!levelLoaded || saveDir[0] == '\0')
+        return;
+    strcpy(path, saveDir);
+    JournalName(&levelStart, path + strlen(path), 16);
+    if (journal.length > 0)
+        JournalSave(&journal, path);
+    else
+        DeleteFile(path);
+}
 
-    resSize = SizeofResource(NULL, hResInfo);
+/* Load a level from the collection or the embedded pack */
+BOOL LoadLevel(long index)
+{
+    HWND hwnd;
+    BOOL loaded;
 
-    /* Create a null-terminated copy of the resource data */
-    levelData = (char *)malloc(resSize + 1);
-    if (!levelData) {
-        MessageBox(NULL, "Out of memory!", "Error", MB_ICONERROR | MB_OK);
+    /* Verify level index is valid */
+    if (!HaveLevel(index)) {
+        MessageBox(NULL, "Invalid level index!", "Error", MB_ICONERROR | MB_OK);
         return FALSE;
     }
 
-    memcpy(levelData, pData, resSize);
-    levelData[resSize] = '\0';
-
-    /* Level data loaded successfully */
-
-    /* First pass: determine level dimensions */
-    levelWidth = 0;
-    levelHeight = 0;
-
-    line = levelData;
-    while (line && *line) {
-        /* Find end of line */
-        nextLine = strpbrk(line, "\r\n");
-        if (nextLine) {
-            char *endLine = nextLine; /* Save position for measuring line length */
-
-            /* Skip all newline characters */
-            while (*nextLine == '\r' || *nextLine == '\n') {
-                nextLine++;
-            }
-
-            /* Null-terminate this line for processing */
-            *endLine = '\0';
-        }
-
-        /* Measure line length */
-        col = strlen(line);
-
-        if (col > 0) {
-            /* Count only lines with content */
-            if (col > levelWidth) {
-                levelWidth = col;
-            }
-            levelHeight++;
-        }
-
-        /* Move to next line or break if no more lines */
-        if (!nextLine || !*nextLine) {
-            break;
-        }
-        line = nextLine;
+    /* The engine belongs to the old level, wait for the worker to let go */
+    StopHint(TRUE);
+    SaveGame();
+    levelLoaded = FALSE;
+    if (hintReady)
+        HintFree(&hintEngine);
+    hintReady = FALSE;
+
+    /* Pack boards point into the resource and only copy the boxes,
+       collection levels are parsed straight from the mapped file */
+    BoardFree(&board);
+    if (useCollection) {
+        loaded = CollectionLevel(&collection, index, &board);
+        if (loaded)
+            FindDeadSquares(&board);
+    } else {
+        loaded = PackLevel(&levelPack, index, &board);
     }
-
-    /* Level dimensions now determined */
-
-    /* CRITICAL FIX: Re-read the data for the second pass */
-    /* Reset the resource pointer and parse again */
-    free(levelData);
-
-    /* Create a fresh null-terminated copy of the resource data */
-    levelData = (char *)malloc(resSize + 1);
-    if (!levelData) {
-        MessageBox(NULL, "Out of memory!", "Error", MB_ICONERROR | MB_OK);
+    if (!loaded) {
+        MessageBox(NULL, "Failed to load level!", "Error", MB_ICONERROR | MB_OK);
         return FALSE;
     }
 
-    memcpy(levelData, pData, resSize);
-    levelData[resSize] = '\0';
-
-    /* Second pass: actually load the level */
-    row = 0;
-    line = levelData;
-
-    while (line && *line && row < levelHeight) {
-        nextLine = strpbrk(line, "\r\n");
-        if (nextLine) {
-            char *endLine = nextLine;
-
-            /* Skip all newline characters */
-            while (*nextLine == '\r' || *nextLine == '\n') {
-                nextLine++;
-            }
-
-            /* Null-terminate this line for processing */
-            *endLine = '\0';
+    currentLevelIndex = index;
+    currentLevel[0] = '\0';
+    if (useCollection)
+        CollectionTitle(&collection, index, currentLevel, sizeof(currentLevel));
+    if (currentLevel[0] == '\0')
+        sprintf(currentLevel, "Level %ld", index + 1);
+
+    /* Levels too big for the solver just have no hints */
+    hintReady = HintInit(&hintEngine, &board);
+    if (pathReady)
+        PathFree(&pathFinder);
+    pathReady = PathInit(&pathFinder, &board);
+    pickedX = pickedY = -1;
+
+    /* Carry on from the saved game, a solved one starts over with the
+       solution left to redo */
+    BoardCopy(&levelStart, &board);
+    JournalFree(&journal);
+    if (saveDir[0] != '\0') {
+        char path[MAX_PATH + 16];
+
+        strcpy(path, saveDir);
+        JournalName(&board, path + strlen(path), 16);
+        if (JournalLoad(&journal, &board, path) && BoardSolved(&board)) {
+            memcpy(board.boxes, levelStart.boxes, board.numWords * sizeof(BoardWord));
+            board.playerX = levelStart.playerX;
+            board.playerY = levelStart.playerY;
+            JournalRestart(&journal);
         }
-
-        /* Process row */
-
-        col = 0;
-        for (i = 0; line[i] != '\0' && col < levelWidth; i++) {
-            switch (line[i]) {
-                case '#': /* Wall */
-                    grid[row][col] = WALL;
-                    col++;
-                    break;
-
-                case '@': /* Player */
-                    grid[row][col] = PLAYER;
-                    playerX = col;
-                    playerY = row;
-                    col++;
-                    break;
-
-                case '+': /* Player on target */
-                    grid[row][col] = PLAYER_ON_TARGET;
-                    playerX = col;
-                    playerY = row;
-                    col++;
-                    break;
-
-                case '$': /* Box */
-                    grid[row][col] = BOX;
-                    col++;
-                    break;
-
-                case '*': /* Box on target */
-                    grid[row][col] = BOX_ON_TARGET;
-                    col++;
-                    break;
-
-                case '.': /* Target */
-                    grid[row][col] = TARGET;
-                    col++;
-                    break;
-
-                case ' ': /* Empty space */
-                    grid[row][col] = EMPTY;
-                    col++;
-                    break;
-
-                default:
-                    /* Skip unknown characters */
-                    break;
-            }
-        }
-
-        /* Fill in the rest of the row with empty spaces */
-        while (col < levelWidth) {
-            grid[row][col] = EMPTY;
-            col++;
-        }
-
-        row++;
-
-        /* Move to next line or break if no more lines */
-        if (!nextLine || !*nextLine) {
-            break;
-        }
-        line = nextLine;
     }
+    levelLoaded = TRUE;
 
-    /* Level loading complete */
+    boxHash = HashBoxes(&board);
 
-    free(levelData);
+    /* Dead squares are checked on every push */
+    deadlocked = IsStuck();
 
     /* Resize the window to match the level dimensions plus small pixel margin */
     hwnd = FindWindow("SokobanClass", NULL);
@@ -339,8 +311,8 @@ BOOL LoadLevel(const char *levelName)
         /* Set desired client area size (with margin) */
         rect.left = 0;
         rect.top = 0;
-        rect.right = CELL_SIZE * levelWidth + 20; /* extra space for margin */
-        rect.bottom = CELL_SIZE * levelHeight + 20; /* extra space for margin */
+        rect.right = CELL_SIZE * board.width + 20; /* extra space for margin */
+        rect.bottom = CELL_SIZE * board.height + 20; /* extra space for margin */
 
         /* Adjust the rectangle to include non-client area (borders, title bar, etc.) */
         AdjustWindowRect(&rect, WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX, FALSE);
@@ -352,7 +324,7 @@ BOOL LoadLevel(const char *levelName)
                      SWP_NOMOVE | SWP_NOZORDER);
 
         /* Update the window title with the current level name */
-        UpdateWindowTitle(hwnd, levelName);
+        UpdateWindowTitle(hwnd, currentLevel);
     }
 
     return TRUE;
@@ -559,188 +531,487 @@ void DrawPlayer(HDC hdc, int x, int y)
     }
 }
 
-/* Draw the game grid */
-void DrawGrid(HDC hdc)
+/* Draw a tile, one of the BoardCell elements, the slow way */
+void DrawTile(HDC memDC, int x, int y, int cell)
 {
-    int i, j;
-    RECT cellRect, clientRect;
-    HBRUSH brush;
-    HWND hwnd;
-    HDC memDC;
-    HBITMAP memBitmap, oldBitmap;
-    int windowWidth, windowHeight;
+    RECT cellRect;
+
+    cellRect.left = x;
+    cellRect.top = y;
+    cellRect.right = x + CELL_SIZE;
+    cellRect.bottom = y + CELL_SIZE;
+
+    /* Draw floor for all cells except walls */
+    if(cell != WALL) {
+        FillRect(memDC, &cellRect, floorBrush);
+    }
+
+    /* Draw game elements */
+    switch(cell)
+    {
+        case WALL:
+            DrawWall(memDC, x, y);
+            break;
+
+        case BOX:
+            DrawBox(memDC, x, y, FALSE);
+            break;
+
+        case TARGET:
+            DrawTarget(memDC, x, y);
+            break;
+
+        case PLAYER:
+            DrawPlayer(memDC, x, y);
+            break;
+
+        case BOX_ON_TARGET:
+            if (hTruckFullBitmap != NULL) {
+                /* Draw loaded truck bitmap */
+                HDC bitmapDC = CreateCompatibleDC(memDC);
+                HBITMAP oldBmp = SelectObject(bitmapDC, hTruckFullBitmap);
+                BitBlt(memDC, x, y, CELL_SIZE, CELL_SIZE, bitmapDC, 0, 0, SRCCOPY);
+                SelectObject(bitmapDC, oldBmp);
+                DeleteDC(bitmapDC);
+            } else {
+                /* Fallback to old method */
+                DrawTarget(memDC, x, y);
+                DrawBox(memDC, x, y, TRUE);
+            }
+            break;
+
+        case PLAYER_ON_TARGET:
+            DrawTarget(memDC, x, y);
+            DrawPlayer(memDC, x, y);
+            break;
+    }
+}
+
+/* Render every tile into the atlas once, bitmaps and fallback drawings
+   alike, so frames only ever blit from it */
+void BuildAtlas(void)
+{
+    int tile;
+
+    if (!AtlasInit(&atlas, CELL_SIZE, NUM_TILES))
+        return;
+    for (tile = 0; tile < NUM_TILES; tile++)
+        DrawTile(atlas.dc, ATLAS_X(&atlas, tile), 0, tile);
+}
+
+/* Draw one cell of the board into the back buffer */
+void DrawCell(HDC memDC, int col, int row)
+{
+    int x = col * CELL_SIZE + 10; /* 10px margin */
+    int y = row * CELL_SIZE + 10; /* 10px margin */
+    int cell = BoardCell(&board, col, row);
+
+    if (atlas.dc != NULL)
+        AtlasDraw(&atlas, memDC, x, y, cell);
+    else
+        DrawTile(memDC, x, y, cell);
+
+    /* Frame the box the hint says to push */
+    if (col == hintBoxX && row == hintBoxY) {
+        HPEN oldPen = SelectObject(memDC, hintPen);
+        HBRUSH oldBrush = SelectObject(memDC, GetStockObject(NULL_BRUSH));
+
+        Rectangle(memDC, x + 1, y + 1, x + CELL_SIZE - 1, y + CELL_SIZE - 1);
+        SelectObject(memDC, oldBrush);
+        SelectObject(memDC, oldPen);
+    }
+
+    /* And the box picked with the mouse */
+    if (col == pickedX && row == pickedY) {
+        HPEN oldPen = SelectObject(memDC, pickPen);
+        HBRUSH oldBrush = SelectObject(memDC, GetStockObject(NULL_BRUSH));
+
+        Rectangle(memDC, x + 4, y + 4, x + CELL_SIZE - 4, y + CELL_SIZE - 4);
+        SelectObject(memDC, oldBrush);
+        SelectObject(memDC, oldPen);
+    }
+}
+
+/* A cell changed, draw it again on the next paint */
+void MarkCell(HWND hwnd, int col, int row)
+{
+    RECT cellRect;
+
+    if (col < 0 || row < 0 || col >= board.width || row >= board.height)
+        return;
+    if (numDirty < MAX_DIRTY)
+        dirtyCells[numDirty++] = CELL_INDEX(&board, col, row);
+    else
+        redrawAll = TRUE;
+
+    cellRect.left = col * CELL_SIZE + 10;
+    cellRect.top = row * CELL_SIZE + 10;
+    cellRect.right = cellRect.left + CELL_SIZE;
+    cellRect.bottom = cellRect.top + CELL_SIZE;
+    InvalidateRect(hwnd, &cellRect, FALSE);
+}
+
+/* Everything changed, a new level, an undo or a resize */
+void MarkAll(HWND hwnd)
+{
+    redrawAll = TRUE;
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+void FreeBackBuffer(void)
+{
+    if (backDC != NULL) {
+        SelectObject(backDC, backOldBitmap);
+        DeleteObject(backBitmap);
+        DeleteDC(backDC);
+        backDC = NULL;
+    }
+}
 
-    /* Get the window handle */
-    hwnd = WindowFromDC(hdc);
+/* Bring the back buffer up to date and copy the area asked for */
+void DrawGrid(HWND hwnd, HDC hdc, const RECT *area)
+{
+    RECT clientRect;
+    int i, j, windowWidth, windowHeight;
+    double start = WallSeconds();
 
     /* Get the client area dimensions */
     GetClientRect(hwnd, &clientRect);
     windowWidth = clientRect.right - clientRect.left;
     windowHeight = clientRect.bottom - clientRect.top;
 
-    /* Create memory DC for double-buffering */
-    memDC = CreateCompatibleDC(hdc);
-    memBitmap = CreateCompatibleBitmap(hdc, windowWidth, windowHeight);
-    oldBitmap = (HBITMAP)SelectObject(memDC, memBitmap);
+    /* The back buffer lives until the window changes size */
+    if (backDC == NULL || windowWidth != backWidth || windowHeight != backHeight) {
+        FreeBackBuffer();
+        backDC = CreateCompatibleDC(hdc);
+        backBitmap = CreateCompatibleBitmap(hdc, windowWidth, windowHeight);
+        backOldBitmap = (HBITMAP)SelectObject(backDC, backBitmap);
+        backWidth = windowWidth;
+        backHeight = windowHeight;
+        redrawAll = TRUE;
+    }
 
-    /* Clear background with white */
-    brush = CreateSolidBrush(RGB(255, 255, 255));
-    FillRect(memDC, &clientRect, brush);
-    DeleteObject(brush);
+    if (redrawAll || paintStats == PAINT_STATS_FULL) {
+        /* Clear background with white */
+        FillRect(backDC, &clientRect, (HBRUSH)GetStockObject(WHITE_BRUSH));
+        for (i = 0; i < board.height; i++) {
+            for (j = 0; j < board.width; j++)
+                DrawCell(backDC, j, i);
+        }
+        paintCells += board.width * board.height;
+    } else {
+        for (i = 0; i < numDirty; i++)
+            DrawCell(backDC, dirtyCells[i] % board.width, dirtyCells[i] / board.width);
+        paintCells += numDirty;
+    }
+    redrawAll = FALSE;
+    numDirty = 0;
 
-    /* Draw the game grid */
-    for(i = 0; i < levelHeight; i++)
-    {
-        for(j = 0; j < levelWidth; j++)
-        {
-            int x = j * CELL_SIZE + 10; /* 10px margin */
-            int y = i * CELL_SIZE + 10; /* 10px margin */
-
-            cellRect.left = x;
-            cellRect.top = y;
-            cellRect.right = x + CELL_SIZE;
-            cellRect.bottom = y + CELL_SIZE;
-
-            /* Draw floor for all cells except walls */
-            if(grid[i][j] != WALL) {
-                brush = CreateSolidBrush(COLOR_FLOOR);
-                FillRect(memDC, &cellRect, brush);
-                DeleteObject(brush);
-            }
+    /* Only the invalid part goes to the screen */
+    BitBlt(hdc, area->left, area->top, area->right - area->left, area->bottom - area->top,
+           backDC, area->left, area->top, SRCCOPY);
 
-            /* Draw game elements */
-            switch(grid[i][j])
-            {
-                case WALL:
-                    DrawWall(memDC, x, y);
-                    break;
+    paintSeconds += WallSeconds() - start;
+    paintFrames++;
+}
 
-                case BOX:
-                    DrawBox(memDC, x, y, FALSE);
-                    break;
+/* Search for a hint on the worker thread */
+void HintWorker(void *arg)
+{
+    hintStatus = HintNext(&hintEngine, &hintBoard, hintKey, HINT_BUDGET, &hintResult);
+    PostMessage(hintWindow, WM_HINT, (WPARAM)workerGeneration, 0);
+}
 
-                case TARGET:
-                    DrawTarget(memDC, x, y);
-                    break;
+/* Hand the current position to the worker */
+void StartHint(HWND hwnd)
+{
+    if (!hintReady) {
+        strcpy(hintText, " - No hints for this level");
+        UpdateWindowTitle(hwnd, currentLevel);
+        return;
+    }
 
-                case PLAYER:
-                    DrawPlayer(memDC, x, y);
-                    break;
+    /* A cancelled search is still winding down, WM_HINT starts this one */
+    if (hintBusy) {
+        hintWanted = TRUE;
+        return;
+    }
 
-                case BOX_ON_TARGET:
-                    if (hTruckFullBitmap != NULL) {
-                        /* Draw loaded truck bitmap */
-                        HDC bitmapDC = CreateCompatibleDC(memDC);
-                        HBITMAP oldBmp = SelectObject(bitmapDC, hTruckFullBitmap);
-                        BitBlt(memDC, x, y, CELL_SIZE, CELL_SIZE, bitmapDC, 0, 0, SRCCOPY);
-                        SelectObject(bitmapDC, oldBmp);
-                        DeleteDC(bitmapDC);
-                    } else {
-                        /* Fallback to old method */
-                        DrawTarget(memDC, x, y);
-                        DrawBox(memDC, x, y, TRUE);
-                    }
-                    break;
+    if (!BoardCopy(&hintBoard, &board))
+        return;
+    hintKey = boxHash;
+    hintWindow = hwnd;
+    hintEngine.cancel = 0;
+    hintBusy = TRUE;
+    hintWanted = FALSE;
+    workerGeneration = hintGeneration;
+    if (!StartThread(&hintThread, HintWorker, NULL)) {
+        hintBusy = FALSE;
+        return;
+    }
+    strcpy(hintText, " - Thinking...");
+    UpdateWindowTitle(hwnd, currentLevel);
+}
 
-                case PLAYER_ON_TARGET:
-                    DrawTarget(memDC, x, y);
-                    DrawPlayer(memDC, x, y);
-                    break;
-            }
+/* Drop the hint for a position that is gone. The worker stops within a
+   few expansions, wait is only needed before freeing the engine */
+void StopHint(BOOL wait)
+{
+    hintGeneration++;
+    hintWanted = FALSE;
+    if (hintBoxX >= 0 && hintWindow != NULL)
+        MarkCell(hintWindow, hintBoxX, hintBoxY);
+    hintBoxX = hintBoxY = -1;
+    hintText[0] = '\0';
+    if (hintBusy) {
+        HintCancel(&hintEngine);
+        if (wait) {
+            JoinThread(&hintThread);
+            hintBusy = FALSE;
         }
     }
+}
+
+/* The worker found a hint or ran out of time */
+void HintDone(HWND hwnd, long generation)
+{
+    static const char *dirNames[4] = {"left", "up", "right", "down"};
+    int dir;
+
+    /* From a worker StopHint already waited for */
+    if (!hintBusy || generation != workerGeneration)
+        return;
+    JoinThread(&hintThread);
+    hintBusy = FALSE;
+
+    /* The player moved on, maybe asking again meanwhile */
+    if (generation != hintGeneration) {
+        if (hintWanted)
+            StartHint(hwnd);
+        return;
+    }
 
-    /* Copy the memory DC to the window DC */
-    BitBlt(hdc, 0, 0, windowWidth, windowHeight, memDC, 0, 0, SRCCOPY);
+    switch (hintStatus) {
+        case HINT_FOUND:
+        case HINT_GUESS:
+            dir = hintResult.dx < 0 ? 0 : hintResult.dy < 0 ? 1 : hintResult.dx > 0 ? 2 : 3;
+            if (hintStatus == HINT_FOUND)
+                sprintf(hintText, " - Hint: push %s, %d pushes to go",
+                        dirNames[dir], hintResult.pushesLeft);
+            else
+                sprintf(hintText, " - Guess: push %s, %d or more pushes to go, press H to think more",
+                        dirNames[dir], hintResult.pushesLeft);
+            if (hintBoxX >= 0)
+                MarkCell(hwnd, hintBoxX, hintBoxY);
+            hintBoxX = hintResult.boxX;
+            hintBoxY = hintResult.boxY;
+            MarkCell(hwnd, hintBoxX, hintBoxY);
+            break;
+
+        case HINT_TIMEOUT:
+            strcpy(hintText, " - No hint yet, press H to think more");
+            break;
+
+        case HINT_CANCELLED:
+            return;
 
-    /* Clean up */
-    SelectObject(memDC, oldBitmap);
-    DeleteObject(memBitmap);
-    DeleteDC(memDC);
+        default:
+            strcpy(hintText, " - No solution from here, press U to undo");
+            break;
+    }
+    UpdateWindowTitle(hwnd, currentLevel);
 }
 
 /* Move player in a direction */
 void MovePlayer(HWND hwnd, int dx, int dy)
 {
-    int newX = playerX + dx;
-    int newY = playerY + dy;
+    int oldX = board.playerX, oldY = board.playerY;
+    int move;
 
-    /* Check if the move is valid */
-    if(newX < 0 || newY < 0 || newX >= levelWidth || newY >= levelHeight)
+    /* Out of memory for the journal the move is refused, the board and
+       the journal must stay in step for undo and the saved game */
+    if (!JournalReserve(&journal)) {
+        MessageBeep(MB_OK);
         return;
-
-    if(grid[newY][newX] == WALL)
+    }
+    move = BoardMove(&board, dx, dy);
+    if (move == MOVE_NONE)
         return;
+    JournalRecord(&journal, dx, dy, move == MOVE_PUSH);
 
-    /* Moving to an empty space or target */
-    if(grid[newY][newX] == EMPTY || grid[newY][newX] == TARGET)
-    {
-        /* Update player's current position */
-        if(grid[playerY][playerX] == PLAYER_ON_TARGET)
-            grid[playerY][playerX] = TARGET;
-        else
-            grid[playerY][playerX] = EMPTY;
-
-        /* Update player's new position */
-        if(grid[newY][newX] == TARGET)
-            grid[newY][newX] = PLAYER_ON_TARGET;
-        else
-            grid[newY][newX] = PLAYER;
-
-        playerX = newX;
-        playerY = newY;
-    }
-    /* Moving a box */
-    else if(grid[newY][newX] == BOX || grid[newY][newX] == BOX_ON_TARGET)
+    /* Any step makes the hint stale, a search under way is cut short */
+    if (hintBusy || hintText[0] != '\0') {
+        StopHint(FALSE);
+        UpdateWindowTitle(hwnd, currentLevel);
+    }
+
+    /* Only the cells left, entered and pushed into change */
+    MarkCell(hwnd, oldX, oldY);
+    MarkCell(hwnd, board.playerX, board.playerY);
+    if (move == MOVE_PUSH)
+        MarkCell(hwnd, board.playerX + dx, board.playerY + dy);
+
+    /* A push moves the box from the player's new cell one step further */
+    if(move == MOVE_PUSH)
     {
-        int boxNewX = newX + dx;
-        int boxNewY = newY + dy;
+        int from = CELL_INDEX(&board, board.playerX, board.playerY);
+        int to = from + dx + dy * board.width;
 
-        /* Check if the box can be moved */
-        if(boxNewX < 0 || boxNewY < 0 || boxNewX >= levelWidth || boxNewY >= levelHeight)
-            return;
+        DropPick(hwnd);
+        boxHash ^= ZOBRIST_BOX(from) ^ ZOBRIST_BOX(to);
 
-        if(grid[boxNewY][boxNewX] == WALL || grid[boxNewY][boxNewX] == BOX || grid[boxNewY][boxNewX] == BOX_ON_TARGET)
-            return;
+        /* Tell the player straight away instead of letting them wander.
+           The pattern table costs several freeze checks, it is only
+           asked when the dead squares and the freeze check find nothing */
+        if(!deadlocked && (IS_DEADLOCK(&board, to) || PatternDeadlock(&patterns, &board, to)))
+        {
+            deadlocked = TRUE;
+            UpdateWindowTitle(hwnd, currentLevel);
+        }
+    }
+}
 
-        /* Move the box */
-        if(grid[boxNewY][boxNewX] == TARGET)
-            grid[boxNewY][boxNewX] = BOX_ON_TARGET;
-        else
-            grid[boxNewY][boxNewX] = BOX;
+/* Let go of the box picked with the mouse */
+void DropPick(HWND hwnd)
+{
+    if (pickedX >= 0)
+        MarkCell(hwnd, pickedX, pickedY);
+    pickedX = pickedY = -1;
+}
 
-        /* Update player's current position */
-        if(grid[playerY][playerX] == PLAYER_ON_TARGET)
-            grid[playerY][playerX] = TARGET;
-        else
-            grid[playerY][playerX] = EMPTY;
+/* The cell under a point in the client area, FALSE off the board */
+BOOL CellAt(int x, int y, int *col, int *row)
+{
+    if (x < 10 || y < 10)
+        return FALSE;
+    *col = (x - 10) / CELL_SIZE; /* 10px margin */
+    *row = (y - 10) / CELL_SIZE;
+    return *col < board.width && *row < board.height;
+}
 
-        /* Update player's new position */
-        if(grid[newY][newX] == BOX_ON_TARGET)
-            grid[newY][newX] = PLAYER_ON_TARGET;
-        else
-            grid[newY][newX] = PLAYER;
+/* Make the moves of a LURD path one at a time, as if keyed in */
+void PlayPath(HWND hwnd, const char *lurd)
+{
+    static const char steps[] = "lurd";
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    const char *p;
+
+    for (; *lurd; lurd++) {
+        p = strchr(steps, *lurd | 0x20);
+        if (p)
+            MovePlayer(hwnd, dx[p - steps], dy[p - steps]);
+    }
+}
+
+/* A click on a box picks it, or lets it go if it was picked. Anywhere
+   else the picked box is pushed there, or the player walks there */
+void ClickCell(HWND hwnd, int col, int row)
+{
+    char *path;
+    int cell = BoardCell(&board, col, row);
 
-        playerX = newX;
-        playerY = newY;
+    if (!pathReady)
+        return;
+    if (cell == BOX || cell == BOX_ON_TARGET) {
+        BOOL picked = col == pickedX && row == pickedY;
+
+        DropPick(hwnd);
+        if (!picked) {
+            pickedX = col;
+            pickedY = row;
+            MarkCell(hwnd, col, row);
+        }
+        return;
     }
 
-    /* Redraw the window - FALSE means don't erase background first (prevents flicker) */
-    InvalidateRect(hwnd, NULL, FALSE);
+    if (pickedX >= 0) {
+        path = PathPush(&pathFinder, &board, pickedX, pickedY, col, row);
+        DropPick(hwnd);
+    } else {
+        path = PathWalk(&pathFinder, &board, col, row);
+    }
+    if (path == NULL) {
+        MessageBeep(MB_OK);
+        return;
+    }
+    PlayPath(hwnd, path);
+    free(path);
+}
+
+/* Undo or redo to move n of the journal */
+void JumpToMove(HWND hwnd, long n)
+{
+    if (n < 0)
+        n = 0;
+    if (n > journal.length)
+        n = journal.length;
+    if (n == journal.position)
+        return;
+    JournalSeek(&journal, &board, n);
+    pickedX = pickedY = -1;
+    boxHash = HashBoxes(&board);
+    deadlocked = IsStuck();
+    StopHint(FALSE);
+    UpdateWindowTitle(hwnd, currentLevel);
+    MarkAll(hwnd);
+}
+
+/* Back to just after the push before the last one */
+void UndoPush(HWND hwnd)
+{
+    long n = journal.position;
+
+    while (n > 0 && !JournalIsPush(&journal, n - 1))
+        n--;
+    if (n > 0)
+        n--;
+    while (n > 0 && !JournalIsPush(&journal, n - 1))
+        n--;
+    JumpToMove(hwnd, n);
+}
+
+/* On to just after the next push */
+void RedoPush(HWND hwnd)
+{
+    long n = journal.position;
+
+    while (n < journal.length && !JournalIsPush(&journal, n))
+        n++;
+    JumpToMove(hwnd, n + 1);
+}
+
+/* Put the level back as it began without parsing it again, the moves
+   stay in the journal for redo */
+void RestartLevel(HWND hwnd)
+{
+    memcpy(board.boxes, levelStart.boxes, board.numWords * sizeof(BoardWord));
+    board.playerX = levelStart.playerX;
+    board.playerY = levelStart.playerY;
+    JournalRestart(&journal);
+    pickedX = pickedY = -1;
+    boxHash = HashBoxes(&board);
+    deadlocked = FALSE;
+    StopHint(FALSE);
+    UpdateWindowTitle(hwnd, currentLevel);
+    MarkAll(hwnd);
 }
 
 /* Update window title with level name */
 void UpdateWindowTitle(HWND hwnd, const char *levelName)
 {
     char title[256];
-    int levelIndex;
 
     /* Create window title with the level name */
-    if (sscanf(levelName, "Level %d", &levelIndex) == 1) {
-        /* If using our internal format, add 1 to make it 1-based for display */
-        sprintf(title, "Sokoban - Level %d", levelIndex + 1);
+    sprintf(title, "Sokoban - %s", levelName);
+    if (deadlocked) {
+        strcat(title, " - Stuck! Press U to undo");
     } else {
-        sprintf(title, "Sokoban - %s", levelName);
+        strcat(title, hintText);
+    }
+    if (paintStats != PAINT_STATS_OFF && paintFrames > 0) {
+        sprintf(title + strlen(title), " - %s %.0f us/frame, %.1f cells/frame",
+                paintStats == PAINT_STATS_FULL ? "Full" : "Paint",
+                paintSeconds / paintFrames * 1e6, (double)paintCells / paintFrames);
     }
 
     /* Set the window title */
@@ -750,20 +1021,8 @@ void UpdateWindowTitle(HWND hwnd, const char *levelName)
 /* Check if the game is complete */
 BOOL CheckWin(void)
 {
-    int i, j;
-
-    for(i = 0; i < levelHeight; i++)
-    {
-        for(j = 0; j < levelWidth; j++)
-        {
-            /* If there's a target without a box, game is not complete */
-            if(grid[i][j] == TARGET || grid[i][j] == PLAYER_ON_TARGET)
-                return FALSE;
-        }
-    }
-
     /* All targets have boxes on them */
-    return TRUE;
+    return BoardSolved(&board);
 }
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -794,25 +1053,46 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                     MovePlayer(hwnd, 1, 0);
                     break;
                 case VK_PRIOR: /* Page Up - Next level */
-                    if (currentLevelIndex < numLevels - 1) {
-                        currentLevelIndex++;
-                        LoadLevel(levelFiles[currentLevelIndex]);
-                        InvalidateRect(hwnd, NULL, FALSE);
+                    if (HaveLevel(currentLevelIndex + 1)) {
+                        LoadLevel(currentLevelIndex + 1);
+                        MarkAll(hwnd);
                     }
                     break;
                 case VK_NEXT: /* Page Down - Previous level */
                     if (currentLevelIndex > 0) {
-                        currentLevelIndex--;
-                        LoadLevel(levelFiles[currentLevelIndex]);
-                        InvalidateRect(hwnd, NULL, FALSE);
+                        LoadLevel(currentLevelIndex - 1);
+                        MarkAll(hwnd);
                     }
                     break;
+                case 'F': /* Paint timing, then the full redraw baseline, then off */
+                    paintStats = (paintStats + 1) % 3;
+                    paintSeconds = 0;
+                    paintFrames = paintCells = 0;
+                    UpdateWindowTitle(hwnd, currentLevel);
+                    break;
+                case 'H': /* Hint for the next push */
+                    StartHint(hwnd);
+                    break;
                 case 'R': /* Reset current level */
-                    /* Reset the current level */
-                    LoadLevel(currentLevel);
-
-                    /* Redraw the window */
-                    InvalidateRect(hwnd, NULL, FALSE);
+                    RestartLevel(hwnd);
+                    break;
+                case 'U': /* Undo a step */
+                    JumpToMove(hwnd, journal.position - 1);
+                    break;
+                case 'Y': /* Redo a step */
+                    JumpToMove(hwnd, journal.position + 1);
+                    break;
+                case VK_BACK: /* Undo back to the push before */
+                    UndoPush(hwnd);
+                    break;
+                case VK_SPACE: /* Redo up to the next push */
+                    RedoPush(hwnd);
+                    break;
+                case VK_HOME: /* First move */
+                    JumpToMove(hwnd, 0);
+                    break;
+                case VK_END: /* Last move recorded */
+                    JumpToMove(hwnd, journal.length);
                     break;
 
                 /* Level selection with number keys */
@@ -820,9 +1100,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                 case '6': case '7': case '8': case '9': case '0':
                     {
                         int levelNum = (wParam == '0') ? 9 : (wParam - '1');
-                        if (levelNum >= 0 && levelNum < numLevels) {
-                            LoadLevel(levelFiles[levelNum]);
-                            InvalidateRect(hwnd, NULL, FALSE);
+                        if (HaveLevel(levelNum)) {
+                            LoadLevel(levelNum);
+                            MarkAll(hwnd);
                         }
                     }
                     break;
@@ -833,26 +1113,72 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                 /* Load the next level instead of showing a message */
                 LoadNextLevel();
                 /* Redraw the window immediately */
-                InvalidateRect(hwnd, NULL, FALSE);
+                MarkAll(hwnd);
             }
 
             break;
 
+        case WM_LBUTTONDOWN:
+            {
+                int col, row;
+
+                if (CellAt((short)LOWORD(lParam), (short)HIWORD(lParam), &col, &row))
+                    ClickCell(hwnd, col, row);
+                else
+                    DropPick(hwnd);
+            }
+
+            if(CheckWin()) {
+                LoadNextLevel();
+                MarkAll(hwnd);
+            }
+            break;
+
+        case WM_SETCURSOR:
+            /* A cross over anywhere a click does something, found from
+               the reach map without searching */
+            if (LOWORD(lParam) == HTCLIENT) {
+                POINT pt;
+                int col, row, cell;
+                BOOL live = FALSE;
+
+                GetCursorPos(&pt);
+                ScreenToClient(hwnd, &pt);
+                if (pathReady && CellAt(pt.x, pt.y, &col, &row)) {
+                    cell = BoardCell(&board, col, row);
+                    if (cell == BOX || cell == BOX_ON_TARGET)
+                        live = TRUE;
+                    else if (pickedX >= 0)
+                        live = cell != WALL;
+                    else
+                        live = PathCanReach(&pathFinder, &board, col, row);
+                }
+                SetCursor(live ? moveCursor : arrowCursor);
+                return TRUE;
+            }
+            return DefWindowProc(hwnd, msg, wParam, lParam);
+
+        case WM_HINT:
+            HintDone(hwnd, (long)wParam);
+            break;
+
         case WM_PAINT:
             {
                 PAINTSTRUCT ps;
                 HDC hdc = BeginPaint(hwnd, &ps);
 
-                /* Draw the game grid with double-buffering */
-                DrawGrid(hdc);
+                /* Bring the back buffer up to date and copy what is invalid */
+                DrawGrid(hwnd, hdc, &ps.rcPaint);
 
                 EndPaint(hwnd, &ps);
+                if (paintStats != PAINT_STATS_OFF)
+                    UpdateWindowTitle(hwnd, currentLevel);
             }
             break;
 
         case WM_SIZE:
             /* Handle window size changes */
-            InvalidateRect(hwnd, NULL, FALSE);
+            MarkAll(hwnd);
             break;
 
         /* Remove scrollbar handling */
@@ -876,20 +1202,45 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     hTruckFullBitmap = LoadBitmap(hInstance, MAKEINTRESOURCE(IDB_TRUCK_FULL));
     hWallBitmap = LoadBitmap(hInstance, MAKEINTRESOURCE(IDB_WALL));
 
-    /* Scan for level files and sort them */
-    ScanLevelFiles();
+    /* Every tile is drawn once here, frames copy them from the atlas */
+    floorBrush = CreateSolidBrush(COLOR_FLOOR);
+    hintPen = CreatePen(PS_SOLID, 3, COLOR_BOX_OK);
+    pickPen = CreatePen(PS_SOLID, 3, COLOR_PLAYER);
+    arrowCursor = LoadCursor(NULL, IDC_ARROW);
+    moveCursor = LoadCursor(NULL, IDC_CROSS);
+    BuildAtlas();
+
+    /* Keys for the incremental board hash */
+    InitZobrist();
+
+    /* Levels from the collection on the command line, or built in */
+    OpenLevels(lpCmdLine);
+
+    /* Saved games and the deadlock patterns live next to the program */
+    {
+        char *slash;
+        DWORD len = GetModuleFileName(NULL, saveDir, MAX_PATH - 24);
+
+        slash = strrchr(saveDir, '\\');
+        if (len > 0 && len < MAX_PATH - 24 && slash != NULL) {
+            strcpy(slash + 1, "deadlock.pat");
+            OpenPatterns(&patterns, saveDir);
+            strcpy(slash + 1, "saves\\");
+            CreateDirectory(saveDir, NULL);
+        } else {
+            saveDir[0] = '\0';
+        }
+    }
 
     /* Load the first level */
-    if (numLevels > 0) {
-        /* Start with the first level in alphabetical order */
-        LoadLevel(levelFiles[0]);
+    if (HaveLevel(0)) {
+        LoadLevel(0);
     } else {
         /* Fallback if no levels found */
         MessageBox(NULL, "No level files found in 'levels' directory!", "Warning", MB_ICONWARNING | MB_OK);
         /* Create a dummy level in memory */
         strcpy(currentLevel, "No Levels");
-        levelWidth = 5;
-        levelHeight = 5;
+        BoardInit(&board, 5, 5);
     }
 
     /* Register the Window Class */
@@ -919,8 +1270,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         /* Set desired client area size */
         rect.left = 0;
         rect.top = 0;
-        rect.right = CELL_SIZE * levelWidth + 20;  /* Client area width with margin */
-        rect.bottom = CELL_SIZE * levelHeight + 20; /* Client area height with margin */
+        rect.right = CELL_SIZE * board.width + 20;  /* Client area width with margin */
+        rect.bottom = CELL_SIZE * board.height + 20; /* Client area height with margin */
 
         /* Adjust the rectangle to include non-client area */
         AdjustWindowRect(&rect, WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX, FALSE);
@@ -956,6 +1307,16 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     }
 
     /* Clean up resources */
+    StopHint(TRUE);
+    SaveGame();
+    FreeBackBuffer();
+    AtlasFree(&atlas);
+    ClosePatterns(&patterns);
+    DeleteObject(floorBrush);
+    DeleteObject(hintPen);
+    DeleteObject(pickPen);
+    if (pathReady)
+        PathFree(&pathFinder);
     if (hForkliftBitmap != NULL) {
         DeleteObject(hForkliftBitmap);
     }
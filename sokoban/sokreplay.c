@@ -0,0 +1,229 @@
+/* Sokoban replay check
+   Solves every level, plays the solution through the move journal and
+   checks undo, redo, jumps and saved games against replaying from the
+   start, then times restarting a level each way
+   Usage: sokreplay [-r jumps] [-s seed] level.sok ...
+          sokreplay -p level.sok game.lurd
+   -p plays a saved game or LURD solution and says whether it solves the level
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "level.h"
+#include "solver.h"
+#include "journal.h"
+#include "hash.h"
+
+#define SAVE_FILE "sokreplay.tmp"
+
+static int SamePosition(const Board *a, const Board *b)
+{
+    return a->playerX == b->playerX && a->playerY == b->playerY &&
+           memcmp(a->boxes, b->boxes, a->numWords * sizeof(BoardWord)) == 0;
+}
+
+/* The first n moves of lurd played on a copy of the level, the slow way */
+static void PlayFromStart(const Board *level, const char *lurd, long n, Board *out)
+{
+    static const char steps[] = "lurd";
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    const char *p;
+    long i;
+
+    BoardCopy(out, level);
+    for (i = 0; i < n; i++) {
+        p = strchr(steps, lurd[i] | 0x20);
+        if (p)
+            BoardMove(out, dx[p - steps], dy[p - steps]);
+    }
+}
+
+/* Play one saved game, 0 when it solves the level */
+static int PlayGame(const char *levelPath, const char *gamePath)
+{
+    Board board;
+    Journal journal;
+    char *data;
+    long size;
+    int solved;
+
+    data = ReadTextFile(levelPath, &size);
+    if (!data || !ParseLevel(data, size, &board)) {
+        printf("%s: cannot read\n", levelPath);
+        free(data);
+        return 2;
+    }
+    free(data);
+
+    JournalInit(&journal);
+    if (!JournalLoad(&journal, &board, gamePath)) {
+        printf("%s: does not play on %s\n", gamePath, levelPath);
+        BoardFree(&board);
+        return 2;
+    }
+    JournalSeek(&journal, &board, journal.length);
+    solved = BoardSolved(&board);
+    printf("%s: %ld moves, %s\n", gamePath, journal.length, solved ? "solved" : "not solved");
+    JournalFree(&journal);
+    BoardFree(&board);
+    return solved ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    SolveResult result;
+    Journal journal, loaded;
+    Board level, board, check;
+    char *data, *lurd;
+    long size, n, played, jumps = 1000, checked = 0, mismatches = 0, steps = 0;
+    long totalMoves = 0, restarts = 0;
+    int i, first, r, ok = 0, failed = 0;
+    unsigned long rng = 12345;
+    clock_t start;
+    double seekTime = 0, copyTime = 0, parseTime = 0;
+
+    for (first = 1; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "-r") == 0 && first + 1 < argc) {
+            jumps = atol(argv[++first]);
+        } else if (strcmp(argv[first], "-s") == 0 && first + 1 < argc) {
+            rng = strtoul(argv[++first], NULL, 10);
+        } else if (strcmp(argv[first], "-p") == 0 && first + 2 < argc) {
+            return PlayGame(argv[first + 1], argv[first + 2]);
+        } else {
+            break;
+        }
+    }
+    if (first >= argc) {
+        printf("Usage: sokreplay [-r jumps] [-s seed] level.sok ...\n");
+        printf("       sokreplay -p level.sok game.lurd\n");
+        return 1;
+    }
+    if (rng == 0)
+        rng = 1;
+
+    InitZobrist();
+    memset(&board, 0, sizeof(Board));
+    memset(&check, 0, sizeof(Board));
+
+    for (i = first; i < argc; i++) {
+        data = ReadTextFile(argv[i], &size);
+        if (!data || !ParseLevel(data, size, &level)) {
+            printf("%s: cannot read\n", argv[i]);
+            free(data);
+            failed++;
+            continue;
+        }
+
+        if (SolveLevel(&level, NULL, &result) != SOLVE_FOUND) {
+            printf("%s: not solved\n", argv[i]);
+            FreeSolveResult(&result);
+            BoardFree(&level);
+            free(data);
+            failed++;
+            continue;
+        }
+
+        /* The solution goes in as it would be played */
+        JournalInit(&journal);
+        BoardCopy(&board, &level);
+        played = JournalPlayLurd(&journal, &board, result.solution);
+        lurd = JournalToLurd(&journal);
+        r = played == result.moves && BoardSolved(&board) && lurd &&
+            strcmp(lurd, result.solution) == 0;
+
+        /* Random jumps and single steps, each checked against a replay */
+        for (n = 0; r && n < jumps; n++) {
+            long target = (long)(NextRandom(&rng) % (unsigned long)(journal.length + 1));
+
+            switch (NextRandom(&rng) % 3) {
+                case 0:
+                    JournalUndo(&journal, &board);
+                    break;
+                case 1:
+                    JournalRedo(&journal, &board);
+                    break;
+                default:
+                    steps += labs(target - journal.position);
+                    JournalSeek(&journal, &board, target);
+                    break;
+            }
+            PlayFromStart(&level, lurd, journal.position, &check);
+            checked++;
+            if (!SamePosition(&board, &check)) {
+                printf("%s: wrong position at move %ld\n", argv[i], journal.position);
+                mismatches++;
+                r = 0;
+            }
+        }
+
+        /* A saved game comes back at the same move with the same redo */
+        if (r) {
+            JournalSeek(&journal, &board, journal.length / 2);
+            JournalInit(&loaded);
+            BoardCopy(&check, &level);
+            r = JournalSave(&journal, SAVE_FILE) && JournalLoad(&loaded, &check, SAVE_FILE) &&
+                loaded.length == journal.length && loaded.position == journal.position &&
+                SamePosition(&board, &check);
+            if (!r)
+                printf("%s: saved game did not load back\n", argv[i]);
+            JournalFree(&loaded);
+        }
+
+        /* Restart: undo every move, copy the start boxes back, or parse
+           the level again as R used to */
+        if (r) {
+            long repeat = 200, k;
+
+            JournalSeek(&journal, &board, journal.length);
+            start = clock();
+            for (k = 0; k < repeat; k++) {
+                JournalSeek(&journal, &board, 0);
+                JournalSeek(&journal, &board, journal.length);
+            }
+            seekTime += (double)(clock() - start) / CLOCKS_PER_SEC / 2;
+
+            start = clock();
+            for (k = 0; k < repeat; k++) {
+                memcpy(board.boxes, level.boxes, board.numWords * sizeof(BoardWord));
+                board.playerX = level.playerX;
+                board.playerY = level.playerY;
+                JournalRestart(&journal);
+            }
+            copyTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+            start = clock();
+            for (k = 0; k < repeat; k++) {
+                Board parsed;
+
+                if (ParseLevel(data, size, &parsed))
+                    BoardFree(&parsed);
+            }
+            parseTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+            restarts += repeat;
+            totalMoves += journal.length;
+        }
+
+        if (r)
+            ok++;
+        else
+            failed++;
+        free(lurd);
+        JournalFree(&journal);
+        FreeSolveResult(&result);
+        BoardFree(&level);
+        free(data);
+    }
+    remove(SAVE_FILE);
+
+    printf("levels: ok=%d failed=%d\n", ok, failed);
+    printf("positions checked=%ld mismatches=%ld moves jumped=%ld\n", checked, mismatches, steps);
+    if (restarts > 0) {
+        printf("restart us: undo all=%.3f copy start=%.3f reparse=%.3f (mean %.0f moves)\n",
+               seekTime / restarts * 1e6, copyTime / restarts * 1e6, parseTime / restarts * 1e6,
+               (double)totalMoves / ok);
+    }
+    BoardFree(&board);
+    BoardFree(&check);
+    return failed ? 2 : 0;
+}
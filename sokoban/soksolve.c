@@ -0,0 +1,173 @@
+/* Sokoban headless solver
+   Usage: soksolve [-n maxnodes] [-m tablemb] [-F] [-b] [-M] [-p patterns] [-t types] [-q] level.sok ...
+   -b searches from both ends, pushing from the start and pulling from
+   the goal, -M makes tunnel and goal room pushes one move each, -p cuts
+   pushes that leave a window from a patgen table, -t deals boxes and
+   targets that many types as RISCoban does and only counts a box on a
+   target of its type
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "level.h"
+#include "solver.h"
+#include "assign.h"
+
+/* Play a solution carrying the box types along, then check every target
+   holds a box of its own type */
+static int TypedSolution(const Board *level, const char *solution, unsigned char *boxTypes,
+                         const unsigned char *goalTypes)
+{
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    Board board;
+    const char *m;
+    int d, from, to, c, ok = 1;
+
+    memset(&board, 0, sizeof(Board));
+    if (!BoardCopy(&board, level)) {
+        return 0;
+    }
+    for (m = solution; *m; m++) {
+        d = (int)(strchr("lurd", *m >= 'a' ? *m : *m - 'A' + 'a') - "lurd");
+        from = CELL_INDEX(&board, board.playerX + dx[d], board.playerY + dy[d]);
+        if (BoardMove(&board, dx[d], dy[d]) == MOVE_PUSH) {
+            to = CELL_INDEX(&board, board.playerX + dx[d], board.playerY + dy[d]);
+            boxTypes[to] = boxTypes[from];
+        }
+    }
+    for (c = 0; c < board.width * board.height; c++) {
+        if (TEST_BIT(board.targets, c) &&
+            (!TEST_BIT(board.boxes, c) || boxTypes[c] != goalTypes[c])) {
+            ok = 0;
+        }
+    }
+    BoardFree(&board);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    Board board;
+    long size, totalNodes = 0;
+    double peakMegabytes = 0.0;
+    int quiet = 0, solved = 0, failed = 0, types = 0, typedOk, i;
+    unsigned char *boxTypes = NULL, *goalTypes = NULL;
+    double totalSeconds = 0.0;
+    SolveOptions options;
+    SolveResult result;
+    PatternTable patterns;
+    char *data;
+
+    InitSolveOptions(&options);
+    memset(&patterns, 0, sizeof(patterns));
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            options.maxNodes = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            options.tableMegabytes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-F") == 0) {
+            options.freezeCheck = 0;
+        } else if (strcmp(argv[i], "-b") == 0) {
+            options.bidirectional = 1;
+        } else if (strcmp(argv[i], "-M") == 0) {
+            options.macros = 1;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            if (!OpenPatterns(&patterns, argv[++i])) {
+                printf("%s: not a pattern table\n", argv[i]);
+                return 1;
+            }
+            options.patterns = &patterns;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            types = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else {
+            break;
+        }
+    }
+
+    if (i >= argc || types < 0 || types > 255) {
+        printf("Usage: soksolve [-n maxnodes] [-m tablemb] [-F] [-b] [-M] [-p patterns] [-t types] [-q] level.sok ...\n");
+        return 1;
+    }
+
+    for (; i < argc; i++) {
+        data = ReadTextFile(argv[i], &size);
+        if (!data) {
+            printf("%s: cannot read\n", argv[i]);
+            failed++;
+            continue;
+        }
+        if (!ParseLevel(data, size, &board)) {
+            printf("%s: out of memory\n", argv[i]);
+            free(data);
+            failed++;
+            continue;
+        }
+        free(data);
+
+        if (types > 0) {
+            boxTypes = (unsigned char *)malloc(board.width * board.height);
+            goalTypes = (unsigned char *)malloc(board.width * board.height);
+            if (!boxTypes || !goalTypes) {
+                printf("%s: out of memory\n", argv[i]);
+                return 2;
+            }
+            DealTypes(&board, types, boxTypes, goalTypes);
+            options.boxTypes = boxTypes;
+            options.goalTypes = goalTypes;
+        }
+
+        SolveLevel(&board, &options, &result);
+
+        /* A typed solution must also sort the boxes */
+        typedOk = 1;
+        if (types > 0) {
+            if (result.status == SOLVE_FOUND && result.solution) {
+                typedOk = TypedSolution(&board, result.solution, boxTypes, goalTypes);
+            }
+            free(boxTypes);
+            free(goalTypes);
+        }
+        BoardFree(&board);
+
+        printf("%s: %s pushes=%d moves=%d nodes=%ld time=%.3fs nodes/sec=%.0f\n",
+               argv[i],
+               result.status == SOLVE_FOUND ? "solved" :
+               result.status == SOLVE_LIMIT ? "limit" : "unsolvable",
+               result.pushes, result.moves, result.nodes, result.seconds,
+               result.seconds > 0 ? result.nodes / result.seconds : 0.0);
+        if (!typedOk) {
+            printf("  typed: solution leaves a box on a target of another type\n");
+        }
+        printf("  table: hits=%lu misses=%lu collisions=%lu replaced=%lu frozen=%ld patterns=%ld macros=%ld steps=%d\n",
+               result.ttHits, result.ttMisses, result.ttCollisions, result.ttReplaced,
+               result.frozen, result.patternCuts, result.macros, result.steps);
+        printf("  forward: nodes=%ld states=%ld mem=%.1fMB  backward: nodes=%ld states=%ld mem=%.1fMB  peak=%.1fMB\n",
+               result.forwardNodes, result.forwardStates, result.forwardMegabytes,
+               result.backwardNodes, result.backwardStates, result.backwardMegabytes,
+               result.peakMegabytes);
+        if (!quiet && result.solution) {
+            printf("  %s\n", result.solution);
+        }
+
+        if (result.status == SOLVE_FOUND && typedOk) {
+            solved++;
+        } else {
+            failed++;
+        }
+        totalNodes += result.nodes;
+        totalSeconds += result.seconds;
+        if (result.peakMegabytes > peakMegabytes) {
+            peakMegabytes = result.peakMegabytes;
+        }
+        FreeSolveResult(&result);
+    }
+
+    printf("total: solved=%d failed=%d nodes=%ld time=%.3fs nodes/sec=%.0f peak=%.1fMB\n",
+           solved, failed, totalNodes, totalSeconds,
+           totalSeconds > 0 ? totalNodes / totalSeconds : 0.0, peakMegabytes);
+    ClosePatterns(&patterns);
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,266 @@
+/* Sokoban solution verifier
+   Plays LURD solutions on their levels on all cores and says whether
+   each one solves its level, with its moves and pushes
+   Usage: sokverify [-j threads] [-r repeat] [-q] solutions.txt path ...
+   The solutions file has one line per level, in the order the levels
+   of every path come in. Text up to the last ':' of a line is a label,
+   blank lines and lines starting with ';' or '#' are skipped
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "levelset.h"
+#include "level.h"
+#include "thread.h"
+
+/* Outcome of one solution */
+#define VERIFY_SOLVED   0
+#define VERIFY_UNSOLVED 1     /* Every move made, some box is off target */
+#define VERIFY_BLOCKED  2     /* A move ran into a wall or a stuck box */
+#define VERIFY_BADCHAR  3     /* Not a LURD letter */
+#define VERIFY_MISSING  4     /* Fewer solutions than levels */
+
+typedef struct {
+    SetLevel *source;
+    const char *solution;     /* Points into the solutions file */
+    long length;
+    int status;
+    long moves, pushes;
+    long caseMismatches;      /* Case said push and the board said step or back */
+} VerifyLevel;
+
+typedef struct {
+    VerifyLevel *levels;
+    long numLevels;
+    volatile long next;       /* Next level to hand out */
+    int repeat;
+    long chunk;
+} Verify;
+
+/* LURD, as the solver numbers directions, indexed by letter */
+static signed char moveDir[256];
+
+static void InitMoves(void)
+{
+    static const char steps[] = "lurd", pushes[] = "LURD";
+    int d;
+
+    memset(moveDir, -1, sizeof(moveDir));
+    for (d = 0; d < 4; d++) {
+        moveDir[(unsigned char)steps[d]] = (signed char)d;
+        moveDir[(unsigned char)pushes[d]] = (signed char)(d | 4);
+    }
+}
+
+/* Play one solution from the level's start, on a board of the caller's */
+static void Play(VerifyLevel *v, Board *board)
+{
+    static const int dx[4] = {-1, 0, 1, 0}, dy[4] = {0, -1, 0, 1};
+    const Board *level = &v->source->board;
+    long n;
+    int d, result;
+
+    memcpy(board->boxes, level->boxes, level->numWords * sizeof(BoardWord));
+    board->playerX = level->playerX;
+    board->playerY = level->playerY;
+    v->moves = v->pushes = v->caseMismatches = 0;
+
+    for (n = 0; n < v->length; n++) {
+        d = moveDir[(unsigned char)v->solution[n]];
+        if (d < 0) {
+            v->status = VERIFY_BADCHAR;
+            return;
+        }
+        result = BoardMove(board, dx[d & 3], dy[d & 3]);
+        if (result == MOVE_NONE) {
+            v->status = VERIFY_BLOCKED;
+            return;
+        }
+        v->moves++;
+        if (result == MOVE_PUSH)
+            v->pushes++;
+        if ((result == MOVE_PUSH) != ((d & 4) != 0))
+            v->caseMismatches++;
+    }
+    v->status = BoardSolved(board) ? VERIFY_SOLVED : VERIFY_UNSOLVED;
+}
+
+static void WorkerMain(void *arg)
+{
+    Verify *verify = (Verify *)arg;
+    Board board;
+    long first, n;
+    int r;
+
+    memset(&board, 0, sizeof(Board));
+    for (;;) {
+        first = AtomicAdd(&verify->next, verify->chunk);
+        if (first >= verify->numLevels)
+            break;
+        for (n = first; n < first + verify->chunk && n < verify->numLevels; n++) {
+            VerifyLevel *v = &verify->levels[n];
+
+            if (v->status == VERIFY_MISSING)
+                continue;
+            if (!BoardCopy(&board, &v->source->board)) {
+                v->status = VERIFY_MISSING;
+                continue;
+            }
+            for (r = 0; r < verify->repeat; r++)
+                Play(v, &board);
+        }
+    }
+    BoardFree(&board);
+}
+
+/* Split the file into lines in place and hand one to each level */
+static long ReadSolutions(char *data, VerifyLevel *levels, long numLevels)
+{
+    char *line = data, *end, *colon, *start;
+    long n = 0;
+
+    while (*line && n < numLevels) {
+        end = strchr(line, '\n');
+        if (end)
+            *end = '\0';
+        while (*line == ' ' || *line == '\t')
+            line++;
+        if (*line != '\0' && *line != '\r' && *line != ';' && *line != '#') {
+            colon = strrchr(line, ':');
+            start = colon ? colon + 1 : line;
+            while (*start == ' ' || *start == '\t')
+                start++;
+            levels[n].solution = start;
+            levels[n].length = (long)strlen(start);
+            while (levels[n].length > 0 && (start[levels[n].length - 1] == '\r' ||
+                   start[levels[n].length - 1] == ' ' || start[levels[n].length - 1] == '\t'))
+                levels[n].length--;
+            levels[n].status = VERIFY_UNSOLVED;
+            n++;
+        }
+        if (!end)
+            break;
+        line = end + 1;
+    }
+    return n;
+}
+
+static const char *StatusName(int status)
+{
+    switch (status) {
+        case VERIFY_SOLVED:
+            return "solved";
+        case VERIFY_UNSOLVED:
+            return "not solved";
+        case VERIFY_BLOCKED:
+            return "blocked";
+        case VERIFY_BADCHAR:
+            return "bad move";
+        default:
+            return "no solution";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    LevelSet set;
+    Verify verify;
+    Thread *threads;
+    char *solutions;
+    long size, n, found, counts[VERIFY_MISSING + 1], moves = 0, pushes = 0, mismatches = 0;
+    int i, numThreads = CountProcessors(), quiet = 0;
+    double wall;
+
+    memset(&set, 0, sizeof(LevelSet));
+    memset(&verify, 0, sizeof(Verify));
+    memset(counts, 0, sizeof(counts));
+    verify.repeat = 1;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            verify.repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else {
+            break;
+        }
+    }
+    if (i + 1 >= argc || numThreads < 1 || verify.repeat < 1) {
+        printf("Usage: sokverify [-j threads] [-r repeat] [-q] solutions.txt path ...\n");
+        printf("  path is a directory of .sok files, a collection or a level pack\n");
+        return 2;
+    }
+
+    solutions = ReadTextFile(argv[i], &size);
+    if (!solutions) {
+        printf("%s: cannot read\n", argv[i]);
+        return 2;
+    }
+    for (i++; i < argc; i++) {
+        if (!AddLevels(&set, argv[i])) {
+            printf("%s: cannot read\n", argv[i]);
+            return 2;
+        }
+    }
+    if (set.numLevels == 0) {
+        printf("no levels\n");
+        return 2;
+    }
+
+    verify.numLevels = set.numLevels;
+    verify.levels = (VerifyLevel *)calloc(set.numLevels, sizeof(VerifyLevel));
+    threads = (Thread *)calloc(numThreads, sizeof(Thread));
+    if (!verify.levels || !threads) {
+        printf("out of memory\n");
+        return 2;
+    }
+    for (n = 0; n < set.numLevels; n++) {
+        verify.levels[n].source = &set.levels[n];
+        verify.levels[n].status = VERIFY_MISSING;
+    }
+    found = ReadSolutions(solutions, verify.levels, set.numLevels);
+
+    /* Small chunks keep threads busy when solution lengths vary a lot,
+       big enough that the shared counter is not fought over */
+    InitMoves();
+    verify.chunk = set.numLevels / (numThreads * 16) + 1;
+    wall = WallSeconds();
+    for (i = 0; i < numThreads; i++) {
+        if (!StartThread(&threads[i], WorkerMain, &verify))
+            WorkerMain(&verify);
+    }
+    for (i = 0; i < numThreads; i++)
+        JoinThread(&threads[i]);
+    wall = WallSeconds() - wall;
+
+    for (n = 0; n < verify.numLevels; n++) {
+        VerifyLevel *v = &verify.levels[n];
+
+        counts[v->status]++;
+        moves += v->moves;
+        pushes += v->pushes;
+        mismatches += v->caseMismatches;
+        if (quiet && v->status == VERIFY_SOLVED && v->caseMismatches == 0)
+            continue;
+        printf("%s: %s moves=%ld pushes=%ld", v->source->name, StatusName(v->status),
+               v->moves, v->pushes);
+        if (v->caseMismatches > 0)
+            printf(" case mismatches=%ld", v->caseMismatches);
+        printf("\n");
+    }
+
+    printf("levels=%ld solutions=%ld solved=%ld not solved=%ld blocked=%ld bad=%ld missing=%ld\n",
+           verify.numLevels, found, counts[VERIFY_SOLVED], counts[VERIFY_UNSOLVED],
+           counts[VERIFY_BLOCKED], counts[VERIFY_BADCHAR], counts[VERIFY_MISSING]);
+    printf("moves=%ld pushes=%ld case mismatches=%ld\n", moves, pushes, mismatches);
+    printf("threads=%d repeat=%d wall=%.3fs moves/sec=%.0f\n", numThreads, verify.repeat, wall,
+           wall > 0 ? (double)moves * verify.repeat / wall : 0.0);
+
+    FreeLevelSet(&set);
+    free(verify.levels);
+    free(threads);
+    free(solutions);
+    return counts[VERIFY_SOLVED] == verify.numLevels ? 0 : 1;
+}
@@ -0,0 +1,1526 @@
+/* Sokoban solver
+   A* over push states, push-optimal, or pushes from the start and
+   pulls from the goal meeting in the middle. Bounded below by the
+   cheapest assignment of boxes to targets
+   Public Domain          */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "solver.h"
+#include "deadlock.h"
+#include "assign.h"
+#include "macro.h"
+
+#define MAX_CELLS ZOBRIST_CELLS  /* Largest board, one key per cell */
+#define MAX_SOLVER_BOXES 32
+#define DEFAULT_MAX_NODES 4000000L
+#define DEFAULT_TABLE_MB 64
+#define INFINITE 0xFFFF
+#define MAX_KNOWN 65536       /* Solved states remembered between searches */
+#define KNOWN_TABLE_MB 1
+#define STOP_INTERVAL 4       /* Expansions between asking whether to stop */
+#define PULLED 4              /* pushDir flag of a node the backward search made */
+#define MACRO 8               /* pushDir flag of a node a macro move made, its pushes follow from the first */
+#define BACKWARD_KEY (((ZobristKey)0x9E3779B9UL << 32) | 0x7F4A7C15UL)  /* Salts backward keys */
+#define MAX_BOX_TYPE 254      /* Goal types are stored plus one in a byte */
+
+/* Key of a box of type t on cell c, type 0 keys as an untyped box */
+#define TYPED_BOX(c, t) (ZOBRIST_BOX(c) * (ZobristKey)(2 * (t) + 1))
+
+/* Directions in LURD order, opposite of d is (d + 2) & 3 */
+static const int dirX[4] = {-1, 0, 1, 0};
+static const int dirY[4] = {0, -1, 0, 1};
+static const char dirName[4] = {'l', 'u', 'r', 'd'};
+
+/* A search node, the box set lives in the parallel boxes array */
+typedef struct {
+    ZobristKey boxKey;        /* Zobrist key of the box set alone */
+    int parent;
+    unsigned short player;    /* Normalized: lowest reachable cell */
+    unsigned short g;         /* Pushes so far */
+    unsigned short h;         /* Lower bound on remaining pushes */
+    unsigned short pushFrom;  /* Box cell before the push that made us */
+    unsigned char pushDir;
+    unsigned char stale;      /* Superseded by a cheaper copy */
+} SolverNode;
+
+typedef struct {
+    unsigned long key;
+    int node;
+} HeapEntry;
+
+typedef struct {
+    HeapEntry *entries;
+    long size, capacity;
+} OpenList;
+
+/* Smallest f on an open list */
+#define OPEN_MIN_F(open) ((int)((open)->entries[0].key >> 16))
+
+/* A state on a solution found earlier, its remaining pushes are optimal */
+typedef struct {
+    unsigned short player;
+    unsigned short remaining;
+    unsigned short pushFrom;  /* Next push, box cell and direction */
+    unsigned char pushDir;
+} KnownState;
+
+struct Solver {
+    int numCells, numBoxes, numGoals;
+    int next[MAX_CELLS][4];   /* Neighbour cell, -1 for wall or outside */
+    unsigned short goals[MAX_SOLVER_BOXES];
+    unsigned short goalDist[MAX_SOLVER_BOXES][MAX_CELLS];
+    unsigned short (*startDist)[MAX_CELLS];  /* Pulls back to each start box, bidirectional */
+    unsigned char isGoal[MAX_CELLS];       /* Goal type plus one, 0 off the goals */
+
+    /* Typed boxes only count on goals of their type. Each type has its
+       own run of slots in the box arrays, so states compare as before */
+    int typed;
+    const unsigned char *boxTypes;         /* Per cell, from the options */
+    unsigned char boxType[MAX_SOLVER_BOXES];
+    unsigned char goalType[MAX_SOLVER_BOXES];
+    unsigned char groupStart[MAX_SOLVER_BOXES], groupEnd[MAX_SOLVER_BOXES];
+    Board board;              /* Walls, targets and dead squares, boxes of the node */
+    int freezeCheck;
+    int macros;               /* Push through tunnels and into goal rooms as one move */
+    LevelMacros levelMacros;
+    const PatternTable *patterns;  /* Deadlock windows, or NULL */
+
+    /* Node storage */
+    SolverNode *nodes;
+    unsigned short *boxes;
+    long numNodes, nodeCapacity, maxNodes;
+
+    /* Closed set, values are node indices. Both directions share it,
+       backward keys are salted with BACKWARD_KEY */
+    TransTable table;
+
+    /* Open lists, backward only used by the bidirectional search */
+    OpenList open, backOpen;
+
+    /* Scratch */
+    unsigned char occupied[MAX_CELLS];
+    unsigned long reach[MAX_CELLS];     /* Player region of the expanded node */
+    unsigned long childReach[MAX_CELLS];
+    unsigned long stamp;
+    unsigned short queue[MAX_CELLS];
+    unsigned short parentBoxes[MAX_SOLVER_BOXES];
+    unsigned short *childBoxes;
+    unsigned short macroFrom[MAX_MACRO_PUSHES];  /* Pushes of one macro move */
+    unsigned char macroDir[MAX_MACRO_PUSHES];
+    Assignment match;         /* Goals to boxes of the node being expanded */
+    Assignment childMatch;    /* Matched again for each push */
+
+    /* Current search */
+    int root, goal;           /* goal is a solved node or one leading into a known state */
+    int meet;                 /* Backward node goal meets, bidirectional */
+    int bestCost;             /* Pushes through goal */
+    int rootKnown;            /* Known state matching the root, or -1 */
+    int goalKnown;
+    int status;
+
+    /* Solutions from earlier searches, kept across SolverStart */
+    KnownState *known;
+    unsigned short *knownBoxes;
+    long numKnown;
+    TransTable knownTable;
+};
+
+/* Flood fill from the player, returns the lowest reachable cell */
+static int FloodPlayer(Solver *s, int start, unsigned long *reach)
+{
+    int head = 0, tail = 0, lowest = start, c, d, n;
+
+    s->stamp++;
+    reach[start] = s->stamp;
+    s->queue[tail++] = (unsigned short)start;
+
+    while (head < tail) {
+        c = s->queue[head++];
+        if (c < lowest) {
+            lowest = c;
+        }
+        for (d = 0; d < 4; d++) {
+            n = s->next[c][d];
+            if (n >= 0 && !s->occupied[n] && reach[n] != s->stamp) {
+                reach[n] = s->stamp;
+                s->queue[tail++] = (unsigned short)n;
+            }
+        }
+    }
+
+    return lowest;
+}
+
+/* Pushes needed to get a box from each cell onto goal, ignoring other boxes */
+static void ComputeGoalDistance(Solver *s, int goal, unsigned short *dist)
+{
+    int head = 0, tail = 0, c, d, p, q;
+
+    for (c = 0; c < s->numCells; c++) {
+        dist[c] = INFINITE;
+    }
+
+    dist[goal] = 0;
+    s->queue[tail++] = (unsigned short)goal;
+
+    while (head < tail) {
+        c = s->queue[head++];
+        for (d = 0; d < 4; d++) {
+            /* Box came from p, pushed by a player standing at q */
+            p = s->next[c][(d + 2) & 3];
+            if (p < 0 || dist[p] != INFINITE) {
+                continue;
+            }
+            q = s->next[p][(d + 2) & 3];
+            if (q < 0) {
+                continue;
+            }
+            dist[p] = (unsigned short)(dist[c] + 1);
+            s->queue[tail++] = (unsigned short)p;
+        }
+    }
+}
+
+/* Pushes from cell onto goal g for the box in slot i, none for a box of
+   another type */
+static long PushCost(Solver *s, unsigned short (*dist)[MAX_CELLS], int g, int i, int cell)
+{
+    if (dist[g][cell] == INFINITE || s->goalType[g] != s->boxType[i]) {
+        return ASSIGN_INFINITE;
+    }
+    return dist[g][cell];
+}
+
+/* Lower bound: cheapest assignment of goals to distinct boxes, dist holds
+   the pushes from each cell to each goal. The matching stays in s->match
+   for ChildMatching */
+static int Matching(Solver *s, unsigned short (*dist)[MAX_CELLS], const unsigned short *boxes)
+{
+    long total;
+    int i, g;
+
+    for (g = 0; g < s->numGoals; g++) {
+        for (i = 0; i < s->numBoxes; i++) {
+            ASSIGN_COST(&s->match, g, i) = PushCost(s, dist, g, i, boxes[i]);
+            ASSIGN_COST(&s->childMatch, g, i) = ASSIGN_COST(&s->match, g, i);
+        }
+    }
+    total = AssignSolve(&s->match);
+    return total >= INFINITE ? INFINITE : (int)total;
+}
+
+/* The bound once the box in slot i of the last Matching is pushed to
+   cell to: only its goal is matched again, from the parent's potentials */
+static int ChildMatching(Solver *s, unsigned short (*dist)[MAX_CELLS], int i, int to)
+{
+    long total;
+    int g;
+
+    for (g = 0; g < s->numGoals; g++) {
+        ASSIGN_COST(&s->childMatch, g, i) = PushCost(s, dist, g, i, to);
+    }
+    total = AssignColumn(&s->childMatch, &s->match, i);
+    for (g = 0; g < s->numGoals; g++) {
+        ASSIGN_COST(&s->childMatch, g, i) = ASSIGN_COST(&s->match, g, i);
+    }
+    return total >= INFINITE ? INFINITE : (int)total;
+}
+
+static int Heuristic(Solver *s, const unsigned short *boxes)
+{
+    return Matching(s, s->goalDist, boxes);
+}
+
+/* Binary heap ordered by f, deeper nodes first on ties */
+static int HeapPush(Solver *s, OpenList *open, int node)
+{
+    HeapEntry e;
+    long i;
+
+    if (open->size == open->capacity) {
+        long cap = open->capacity ? open->capacity * 2 : 1024;
+        HeapEntry *h = (HeapEntry *)realloc(open->entries, cap * sizeof(HeapEntry));
+        if (!h) {
+            return 0;
+        }
+        open->entries = h;
+        open->capacity = cap;
+    }
+
+    e.key = ((unsigned long)(s->nodes[node].g + s->nodes[node].h) << 16) |
+            (unsigned long)(0xFFFF - s->nodes[node].g);
+    e.node = node;
+
+    i = open->size++;
+    while (i > 0 && open->entries[(i - 1) / 2].key > e.key) {
+        open->entries[i] = open->entries[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    open->entries[i] = e;
+    return 1;
+}
+
+static int HeapPop(OpenList *open)
+{
+    HeapEntry last;
+    long i, child;
+    int top;
+
+    top = open->entries[0].node;
+    last = open->entries[--open->size];
+
+    i = 0;
+    for (;;) {
+        child = i * 2 + 1;
+        if (child >= open->size) {
+            break;
+        }
+        if (child + 1 < open->size && open->entries[child + 1].key < open->entries[child].key) {
+            child++;
+        }
+        if (open->entries[child].key >= last.key) {
+            break;
+        }
+        open->entries[i] = open->entries[child];
+        i = child;
+    }
+    if (open->size > 0) {
+        open->entries[i] = last;
+    }
+    return top;
+}
+
+/* Look up a state, counting keys that match a different state as collisions */
+static int TableFind(Solver *s, ZobristKey key, const unsigned short *boxes, int player)
+{
+    TTEntry *e = TTProbe(&s->table, key);
+    int n;
+
+    if (!e) {
+        return -1;
+    }
+    n = (int)e->value;
+    if (n < s->numNodes && s->nodes[n].player == player &&
+        memcmp(s->boxes + (long)n * s->numBoxes, boxes,
+               s->numBoxes * sizeof(unsigned short)) == 0) {
+        return n;
+    }
+    s->table.collisions++;
+    return -1;
+}
+
+/* Append a node, returns its index or -1 when out of room */
+static int NewNode(Solver *s, const unsigned short *boxes, ZobristKey boxKey,
+                   int parent, int player, int g, int h, int pushFrom, int pushDir)
+{
+    SolverNode *node;
+    int index;
+
+    if (s->numNodes >= s->maxNodes) {
+        return -1;
+    }
+
+    if (s->numNodes == s->nodeCapacity) {
+        long cap = s->nodeCapacity ? s->nodeCapacity * 2 : 4096;
+        SolverNode *nodes;
+        unsigned short *boxStore;
+
+        if (cap > s->maxNodes) {
+            cap = s->maxNodes;
+        }
+        nodes = (SolverNode *)realloc(s->nodes, cap * sizeof(SolverNode));
+        if (!nodes) {
+            return -1;
+        }
+        s->nodes = nodes;
+        boxStore = (unsigned short *)realloc(s->boxes, cap * s->numBoxes * sizeof(unsigned short));
+        if (!boxStore) {
+            return -1;
+        }
+        s->boxes = boxStore;
+        s->nodeCapacity = cap;
+    }
+
+    index = (int)s->numNodes++;
+    node = &s->nodes[index];
+    node->boxKey = boxKey;
+    node->parent = parent;
+    node->player = (unsigned short)player;
+    node->g = (unsigned short)g;
+    node->h = (unsigned short)h;
+    node->pushFrom = (unsigned short)pushFrom;
+    node->pushDir = (unsigned char)pushDir;
+    node->stale = 0;
+    memcpy(s->boxes + (long)index * s->numBoxes, boxes, s->numBoxes * sizeof(unsigned short));
+    return index;
+}
+
+/* Child box set: boxes with box i moved to cell to, kept sorted within
+   its type */
+static void MoveChildBox(Solver *s, const unsigned short *boxes, int i, int to)
+{
+    int j = i;
+
+    memcpy(s->childBoxes, boxes, s->numBoxes * sizeof(unsigned short));
+    s->childBoxes[j] = (unsigned short)to;
+    while (j > s->groupStart[i] && s->childBoxes[j - 1] > s->childBoxes[j]) {
+        unsigned short t = s->childBoxes[j];
+        s->childBoxes[j] = s->childBoxes[j - 1];
+        s->childBoxes[--j] = t;
+    }
+    while (j < s->groupEnd[i] - 1 && s->childBoxes[j + 1] < s->childBoxes[j]) {
+        unsigned short t = s->childBoxes[j];
+        s->childBoxes[j] = s->childBoxes[j + 1];
+        s->childBoxes[++j] = t;
+    }
+}
+
+/* A push from b to to that freezes a box off target or leaves a
+   deadlocked pattern, on the board of the node being expanded */
+static int PushDeadlocked(Solver *s, int b, int to, SolveResult *result)
+{
+    int frozen = 0, patterned = 0;
+
+    if (!s->freezeCheck && !s->patterns) {
+        return 0;
+    }
+    CLEAR_BIT(s->board.boxes, b);
+    SET_BIT(s->board.boxes, to);
+    if (s->freezeCheck) {
+        frozen = IsFreezeDeadlock(&s->board, to);
+    }
+    if (!frozen && s->patterns) {
+        patterned = PatternDeadlock(s->patterns, &s->board, to);
+    }
+    CLEAR_BIT(s->board.boxes, to);
+    SET_BIT(s->board.boxes, b);
+
+    if (frozen) {
+        result->frozen++;
+    } else if (patterned) {
+        result->patternCuts++;
+    }
+    return frozen || patterned;
+}
+
+/* Check if every goal holds a box of its type */
+static int IsSolved(Solver *s, const unsigned short *boxes)
+{
+    int g, i;
+
+    for (g = 0; g < s->numGoals; g++) {
+        if (!s->occupied[s->goals[g]]) {
+            return 0;
+        }
+    }
+    if (s->typed) {
+        for (i = 0; i < s->numBoxes; i++) {
+            if (s->isGoal[boxes[i]] && s->isGoal[boxes[i]] != s->boxType[i] + 1) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Boxes in a goal room are on the first targets of its fill order and
+   nowhere else. Returns how many, or -1 */
+static int RoomFilled(Solver *s, const GoalRoom *room)
+{
+    int i, k = 0;
+
+    while (k < room->numGoals && s->occupied[room->goals[k]]) {
+        k++;
+    }
+    for (i = 0; i < room->numCells; i++) {
+        if (s->occupied[room->cells[i]] && s->levelMacros.fill[room->cells[i]] >= k) {
+            return -1;
+        }
+    }
+    return k;
+}
+
+/* Pushes of the move that starts with the box on b going d, with the
+   boxes in s->occupied. With macros on a box pushed along a tunnel with
+   the player behind it carries on to the end, and one pushed through the
+   door of a goal room on to the room's next target. Returns how many
+   pushes, 1 for a plain push */
+static int MacroPushes(Solver *s, int b, int d, unsigned short *from, unsigned char *dir)
+{
+    const LevelMacros *m = &s->levelMacros;
+    const GoalRoom *room;
+    int n = 0, box = b, to = s->next[b][d], after, k;
+
+    from[n] = (unsigned short)b;
+    dir[n++] = (unsigned char)d;
+    if (!s->macros) {
+        return n;
+    }
+    for (;;) {
+        /* Rooms fill in a fixed order, which knows nothing of types */
+        room = m->door[to] && !s->typed ? &m->rooms[m->door[to] - 1] : NULL;
+        if (room && room->dir == d && (k = RoomFilled(s, room)) >= 0 && k < room->numGoals) {
+            memcpy(from + n, m->pathFrom + room->pathStart[k],
+                   room->pathLength[k] * sizeof(unsigned short));
+            memcpy(dir + n, m->pathDir + room->pathStart[k], room->pathLength[k]);
+            return n + room->pathLength[k];
+        }
+
+        after = s->next[to][d];
+        if (s->isGoal[to] || !IN_TUNNEL(m, box, d) || !IN_TUNNEL(m, to, d) ||
+            after < 0 || s->occupied[after] || TEST_BIT(s->board.dead, after)) {
+            return n;
+        }
+        from[n] = (unsigned short)to;
+        dir[n++] = (unsigned char)d;
+        box = to;
+        to = after;
+    }
+}
+
+/* Walk from the player to target avoiding boxes, appending the steps */
+static int WalkTo(Solver *s, int from, int to, char *out)
+{
+    static const int noCell = -1;
+    int prev[MAX_CELLS];
+    int head = 0, tail = 0, c, d, n, len = 0, i;
+    char steps[MAX_CELLS];
+
+    for (c = 0; c < s->numCells; c++) {
+        prev[c] = noCell;
+    }
+    prev[from] = from;
+    s->queue[tail++] = (unsigned short)from;
+
+    while (head < tail && prev[to] == noCell) {
+        c = s->queue[head++];
+        for (d = 0; d < 4; d++) {
+            n = s->next[c][d];
+            if (n >= 0 && !s->occupied[n] && prev[n] == noCell) {
+                prev[n] = c;
+                s->queue[tail++] = (unsigned short)n;
+            }
+        }
+    }
+
+    /* Backtrack from the target, steps come out reversed */
+    for (c = to; c != from; c = prev[c]) {
+        for (d = 0; d < 4; d++) {
+            if (s->next[prev[c]][d] == c) {
+                break;
+            }
+        }
+        steps[len++] = dirName[d];
+    }
+    for (i = 0; i < len; i++) {
+        out[i] = steps[len - 1 - i];
+    }
+    return len;
+}
+
+/* Replay moves from the root boxes, the box at from[i] goes dir[i] and
+   on as far as a macro move takes it, walking the player up to each push
+   in turn */
+static void BuildPushes(Solver *s, const unsigned short *from, const unsigned char *dir,
+                        int steps, int pushes, int playerStart, SolveResult *result)
+{
+    int i, j, n, player, to, len = 0;
+
+    result->solution = (char *)malloc((size_t)(pushes + 1) * s->numCells + 1);
+    if (!result->solution) {
+        return;
+    }
+
+    memset(s->occupied, 0, sizeof(s->occupied));
+    for (i = 0; i < s->numBoxes; i++) {
+        s->occupied[s->boxes[i]] = 1;
+    }
+    player = playerStart;
+
+    for (i = 0; i < steps; i++) {
+        if (dir[i] & MACRO) {
+            n = MacroPushes(s, from[i], dir[i] & 3, s->macroFrom, s->macroDir);
+        } else {
+            s->macroFrom[0] = from[i];
+            s->macroDir[0] = dir[i];
+            n = 1;
+        }
+        for (j = 0; j < n; j++) {
+            to = s->next[s->macroFrom[j]][s->macroDir[j]];
+
+            len += WalkTo(s, player, s->next[s->macroFrom[j]][(s->macroDir[j] + 2) & 3],
+                          result->solution + len);
+            result->solution[len++] = (char)(dirName[s->macroDir[j]] - 'a' + 'A');
+
+            s->occupied[s->macroFrom[j]] = 0;
+            s->occupied[to] = 1;
+            player = s->macroFrom[j];
+        }
+    }
+
+    result->solution[len] = '\0';
+    result->pushes = pushes;
+    result->moves = len;
+}
+
+/* Rebuild the LURD string from the start position and the push chain */
+static void BuildSolution(Solver *s, int last, int playerStart, SolveResult *result)
+{
+    int pushes = s->nodes[last].g, steps = 0;
+    unsigned short *from;
+    unsigned char *dir;
+    int i, n;
+
+    for (n = last; n > 0; n = s->nodes[n].parent) {
+        steps++;
+    }
+    result->steps = steps;
+    from = (unsigned short *)malloc((steps + 1) * sizeof(unsigned short));
+    dir = (unsigned char *)malloc(steps + 1);
+    if (from && dir) {
+        for (i = steps, n = last; n > 0; n = s->nodes[n].parent) {
+            from[--i] = s->nodes[n].pushFrom;
+            dir[i] = s->nodes[n].pushDir;
+        }
+        BuildPushes(s, from, dir, steps, pushes, playerStart, result);
+    }
+    free(from);
+    free(dir);
+}
+
+/* Known state for a key, or -1 */
+static int KnownFind(Solver *s, ZobristKey key, const unsigned short *boxes, int player)
+{
+    TTEntry *e;
+    long n;
+
+    if (s->numKnown == 0) {
+        return -1;
+    }
+    e = TTProbe(&s->knownTable, key);
+    if (!e) {
+        return -1;
+    }
+    n = e->value;
+    if (n < s->numKnown && s->known[n].player == player &&
+        memcmp(s->knownBoxes + n * s->numBoxes, boxes,
+               s->numBoxes * sizeof(unsigned short)) == 0) {
+        return (int)n;
+    }
+    return -1;
+}
+
+/* Remember every state on the path from the root to the goal */
+static void RememberSolution(Solver *s)
+{
+    int n, next = -1, cost = s->bestCost;
+    KnownState *k;
+    ZobristKey key;
+
+    for (n = s->goal; n >= 0; next = n, n = s->nodes[n].parent) {
+        if (next < 0 && s->goalKnown >= 0) {
+            continue;     /* Already known */
+        }
+        if (s->numKnown == MAX_KNOWN) {
+            return;
+        }
+        key = s->nodes[n].boxKey ^ ZOBRIST_PLAYER(s->nodes[n].player);
+        if (KnownFind(s, key, s->boxes + (long)n * s->numBoxes, s->nodes[n].player) >= 0) {
+            continue;
+        }
+        k = &s->known[s->numKnown];
+        k->player = s->nodes[n].player;
+        k->remaining = (unsigned short)(cost - s->nodes[n].g);
+        if (next >= 0) {
+            k->pushFrom = s->nodes[next].pushFrom;
+            k->pushDir = s->nodes[next].pushDir;
+        } else if (s->goalKnown >= 0) {
+            k->pushFrom = s->known[s->goalKnown].pushFrom;
+            k->pushDir = s->known[s->goalKnown].pushDir;
+        } else {
+            k->pushFrom = 0;
+            k->pushDir = 0;
+        }
+        memcpy(s->knownBoxes + s->numKnown * s->numBoxes, s->boxes + (long)n * s->numBoxes,
+               s->numBoxes * sizeof(unsigned short));
+        TTStore(&s->knownTable, key, s->numKnown, 0xFFFF);
+        s->numKnown++;
+    }
+}
+
+/* Run A* from the prepared root until the goal is proven, the open list
+   runs dry or stop says so. Sets s->goal and returns the status */
+static int Search(Solver *s, SolverStopProc stop, void *stopArg, SolveResult *result)
+{
+    int node, i, d, b, from, to, h, player, child, g, k, n, cost, dir;
+    unsigned long expandStamp;
+    unsigned short *boxes;
+    ZobristKey boxKey, childKey;
+    long expanded = 0;
+
+    while (s->open.size > 0) {
+        /* A path into a known state is optimal once nothing open can beat it */
+        if (s->goal >= 0 && OPEN_MIN_F(&s->open) >= s->bestCost) {
+            return SOLVE_FOUND;
+        }
+        if (stop && (++expanded % STOP_INTERVAL) == 0 && stop(stopArg)) {
+            return SOLVE_RUNNING;
+        }
+
+        node = HeapPop(&s->open);
+        if (s->nodes[node].stale) {
+            continue;
+        }
+        result->nodes++;
+
+        /* Node storage may move while children are added */
+        boxes = s->parentBoxes;
+        memcpy(boxes, s->boxes + (long)node * s->numBoxes, s->numBoxes * sizeof(unsigned short));
+        boxKey = s->nodes[node].boxKey;
+        g = s->nodes[node].g + 1;
+        for (i = 0; i < s->numBoxes; i++) {
+            s->occupied[boxes[i]] = 1;
+            SET_BIT(s->board.boxes, boxes[i]);
+        }
+        FloodPlayer(s, s->nodes[node].player, s->reach);
+        expandStamp = s->stamp;
+
+        /* Children are matched again from this one box at a time */
+        Heuristic(s, boxes);
+
+        for (i = 0; i < s->numBoxes; i++) {
+            b = boxes[i];
+            for (d = 0; d < 4; d++) {
+                from = s->next[b][(d + 2) & 3];
+                to = s->next[b][d];
+                if (from < 0 || to < 0 || s->reach[from] != expandStamp || s->occupied[to]) {
+                    continue;
+                }
+
+                /* A macro move makes n pushes, the player ends behind the last */
+                n = MacroPushes(s, b, d, s->macroFrom, s->macroDir);
+                to = s->next[s->macroFrom[n - 1]][s->macroDir[n - 1]];
+                cost = g + n - 1;
+                dir = n > 1 ? d | MACRO : d;
+
+                MoveChildBox(s, boxes, i, to);
+                if (TEST_BIT(s->board.dead, to)) {
+                    continue;
+                }
+                h = ChildMatching(s, s->goalDist, i, to);
+                if (h == INFINITE) {
+                    continue;
+                }
+
+                /* Normalize the player region of the child */
+                s->occupied[b] = 0;
+                s->occupied[to] = 1;
+                player = FloodPlayer(s, s->macroFrom[n - 1], s->childReach);
+                childKey = boxKey ^ TYPED_BOX(b, s->boxType[i]) ^ TYPED_BOX(to, s->boxType[i]);
+                if (IsSolved(s, s->childBoxes)) {
+                    /* One push is optimal at once, a longer move only once
+                       nothing open can beat it */
+                    if (n == 1 || s->goal < 0 || cost < s->bestCost) {
+                        child = NewNode(s, s->childBoxes, childKey, node, player, cost, 0, b, dir);
+                        if (child < 0) {
+                            return SOLVE_LIMIT;
+                        }
+                        result->generated++;
+                        result->macros += n > 1;
+                        s->goal = child;
+                        s->goalKnown = -1;
+                        s->bestCost = cost;
+                    }
+                    if (n == 1) {
+                        return SOLVE_FOUND;
+                    }
+                    s->occupied[to] = 0;
+                    s->occupied[b] = 1;
+                    continue;
+                }
+
+                s->occupied[to] = 0;
+                s->occupied[b] = 1;
+                if (PushDeadlocked(s, b, to, result)) {
+                    continue;
+                }
+
+                /* The rest of the way is known, keep the cheapest such path */
+                k = KnownFind(s, childKey ^ ZOBRIST_PLAYER(player), s->childBoxes, player);
+                if (k >= 0) {
+                    if (s->goal < 0 || cost + s->known[k].remaining < s->bestCost) {
+                        child = NewNode(s, s->childBoxes, childKey, node, player, cost, 0, b, dir);
+                        if (child < 0) {
+                            return SOLVE_LIMIT;
+                        }
+                        result->generated++;
+                        result->macros += n > 1;
+                        s->goal = child;
+                        s->goalKnown = k;
+                        s->bestCost = cost + s->known[k].remaining;
+                    }
+                    continue;
+                }
+
+                child = TableFind(s, childKey ^ ZOBRIST_PLAYER(player), s->childBoxes, player);
+                if (child >= 0) {
+                    if (s->nodes[child].g <= cost) {
+                        continue;
+                    }
+                    s->nodes[child].stale = 1;
+                }
+
+                child = NewNode(s, s->childBoxes, childKey, node, player, cost, h, b, dir);
+                if (child < 0 || !HeapPush(s, &s->open, child)) {
+                    return SOLVE_LIMIT;
+                }
+                result->generated++;
+                result->macros += n > 1;
+
+                /* Shallow entries cut the biggest subtrees, keep them longest */
+                TTStore(&s->table, childKey ^ ZOBRIST_PLAYER(player), child,
+                        (unsigned short)(0xFFFF - cost));
+            }
+        }
+
+        for (i = 0; i < s->numBoxes; i++) {
+            s->occupied[boxes[i]] = 0;
+            CLEAR_BIT(s->board.boxes, boxes[i]);
+        }
+    }
+
+    return s->goal >= 0 ? SOLVE_FOUND : SOLVE_UNSOLVABLE;
+}
+
+/* Fill in the default limits */
+void InitSolveOptions(SolveOptions *options)
+{
+    options->maxNodes = DEFAULT_MAX_NODES;
+    options->tableMegabytes = DEFAULT_TABLE_MB;
+    options->freezeCheck = 1;
+    options->bidirectional = 0;
+    options->patterns = NULL;
+    options->macros = 0;
+    options->boxTypes = NULL;
+    options->goalTypes = NULL;
+}
+
+static void DestroySolver(Solver *s)
+{
+    free(s->nodes);
+    free(s->boxes);
+    TTFree(&s->table);
+    TTFree(&s->knownTable);
+    free(s->open.entries);
+    free(s->backOpen.entries);
+    free(s->startDist);
+    free(s->childBoxes);
+    AssignFree(&s->match);
+    AssignFree(&s->childMatch);
+    FreeMacros(&s->levelMacros);
+    free(s->known);
+    free(s->knownBoxes);
+    BoardFree(&s->board);
+    free(s);
+}
+
+/* Prepare to search the level on board, options may be NULL for defaults.
+   Returns NULL if the level is too big or out of memory */
+Solver *CreateSolver(const Board *board, const SolveOptions *options)
+{
+    Solver *s;
+    SolveOptions defaults;
+    unsigned short levelBoxes[MAX_SOLVER_BOXES];
+    int row, col, c, d, nx, ny, t, i;
+
+    if (!options) {
+        InitSolveOptions(&defaults);
+        options = &defaults;
+    }
+
+    if (board->width * board->height > MAX_CELLS) {
+        return NULL;
+    }
+
+    s = (Solver *)calloc(1, sizeof(Solver));
+    if (!s) {
+        return NULL;
+    }
+    s->maxNodes = options->maxNodes > 0 ? options->maxNodes : DEFAULT_MAX_NODES;
+    s->numCells = board->width * board->height;
+    s->freezeCheck = options->freezeCheck;
+    s->patterns = options->patterns;
+    s->macros = options->macros;
+    s->root = s->goal = s->meet = s->rootKnown = s->goalKnown = -1;
+
+    /* Private copy for the deadlock checks, boxes are set per expanded node */
+    if (!BoardCopy(&s->board, board)) {
+        free(s);
+        return NULL;
+    }
+    FindDeadSquares(&s->board);
+    if (s->macros && !FindMacros(board, &s->levelMacros)) {
+        BoardFree(&s->board);
+        free(s);
+        return NULL;
+    }
+    memset(s->board.boxes, 0, s->board.numWords * sizeof(BoardWord));
+
+    /* Build the neighbour table and collect boxes and goals */
+    for (c = 0; c < s->numCells; c++) {
+        for (d = 0; d < 4; d++) {
+            s->next[c][d] = -1;
+        }
+    }
+    for (row = 0; row < board->height; row++) {
+        for (col = 0; col < board->width; col++) {
+            c = CELL_INDEX(board, col, row);
+
+            if (TEST_BIT(board->walls, c)) {
+                continue;
+            }
+            for (d = 0; d < 4; d++) {
+                nx = col + dirX[d];
+                ny = row + dirY[d];
+                if (nx >= 0 && ny >= 0 && nx < board->width && ny < board->height &&
+                    !TEST_BIT(board->walls, CELL_INDEX(board, nx, ny))) {
+                    s->next[c][d] = CELL_INDEX(board, nx, ny);
+                }
+            }
+
+            if (TEST_BIT(board->boxes, c)) {
+                if (s->numBoxes == MAX_SOLVER_BOXES) {
+                    DestroySolver(s);
+                    return NULL;
+                }
+                levelBoxes[s->numBoxes++] = (unsigned short)c;
+            }
+            if (TEST_BIT(board->targets, c)) {
+                if (s->numGoals == MAX_SOLVER_BOXES) {
+                    DestroySolver(s);
+                    return NULL;
+                }
+                s->goalType[s->numGoals] = options->goalTypes ? options->goalTypes[c] : 0;
+                s->isGoal[c] = (unsigned char)(s->goalType[s->numGoals] + 1);
+                s->goals[s->numGoals++] = (unsigned short)c;
+            }
+        }
+    }
+
+    for (c = 0; c < s->numGoals; c++) {
+        ComputeGoalDistance(s, s->goals[c], s->goalDist[c]);
+    }
+
+    /* Slots by type, as many of each as the level has boxes of it */
+    s->typed = options->boxTypes && options->goalTypes;
+    s->boxTypes = s->typed ? options->boxTypes : NULL;
+    for (t = 0, i = 0; t <= MAX_BOX_TYPE && s->typed; t++) {
+        for (c = 0; c < s->numBoxes; c++) {
+            if (s->boxTypes[levelBoxes[c]] == t) {
+                s->boxType[i++] = (unsigned char)t;
+            }
+        }
+    }
+    for (i = 0; i < s->numBoxes; i++) {
+        s->groupStart[i] = (unsigned char)(i > 0 && s->boxType[i - 1] == s->boxType[i] ?
+                                           s->groupStart[i - 1] : i);
+    }
+    for (i = s->numBoxes - 1; i >= 0; i--) {
+        s->groupEnd[i] = (unsigned char)(i < s->numBoxes - 1 && s->boxType[i + 1] == s->boxType[i] ?
+                                         s->groupEnd[i + 1] : i + 1);
+    }
+
+    InitZobrist();
+
+    /* More goals than boxes never gets as far as matching */
+    s->childBoxes = (unsigned short *)malloc((s->numBoxes + 1) * sizeof(unsigned short));
+    if (!s->childBoxes || !TTInit(&s->table, options->tableMegabytes) ||
+        (s->numGoals <= s->numBoxes && (!AssignInit(&s->match, s->numGoals, s->numBoxes) ||
+                                        !AssignInit(&s->childMatch, s->numGoals, s->numBoxes)))) {
+        DestroySolver(s);
+        return NULL;
+    }
+    return s;
+}
+
+void FreeSolver(Solver *s)
+{
+    if (s) {
+        DestroySolver(s);
+    }
+}
+
+/* Move typed boxes, in cell order, into the slots of their type. Returns
+   0 if the boxes are not the level's mix of types */
+static int SortByType(Solver *s, unsigned short *boxes)
+{
+    unsigned short sorted[MAX_SOLVER_BOXES];
+    unsigned char taken[MAX_SOLVER_BOXES];
+    int i, k;
+
+    memset(taken, 0, sizeof(taken));
+    for (i = 0; i < s->numBoxes; i++) {
+        for (k = 0; k < s->numBoxes; k++) {
+            if (!taken[k] && s->boxTypes[boxes[k]] == s->boxType[i]) {
+                break;
+            }
+        }
+        if (k == s->numBoxes) {
+            return 0;
+        }
+        taken[k] = 1;
+        sorted[i] = boxes[k];
+    }
+    memcpy(boxes, sorted, s->numBoxes * sizeof(unsigned short));
+    return 1;
+}
+
+/* Start a new search from the boxes and player on board, which must be
+   the level the solver was created for. Node storage and the tables stay
+   allocated, entries left from the last search fail their state check
+   and are overwritten. Returns SOLVE_RUNNING, or the outcome if the
+   start decides it */
+int SolverStart(Solver *s, const Board *board)
+{
+    unsigned short startBoxes[MAX_SOLVER_BOXES];
+    int c, n = 0, player, h, solved;
+    ZobristKey boxKey;
+
+    s->numNodes = 0;
+    s->open.size = 0;
+    s->root = s->goal = s->rootKnown = s->goalKnown = -1;
+
+    /* A search that ended mid-expansion leaves its boxes behind */
+    memset(s->occupied, 0, sizeof(s->occupied));
+    memset(s->board.boxes, 0, s->board.numWords * sizeof(BoardWord));
+
+    for (c = 0; c < s->numCells; c++) {
+        if (TEST_BIT(board->boxes, c)) {
+            if (n == s->numBoxes) {
+                return s->status = SOLVE_UNSOLVABLE;
+            }
+            startBoxes[n++] = (unsigned short)c;
+        }
+    }
+    if (n != s->numBoxes || s->numGoals > s->numBoxes ||
+        (s->typed && !SortByType(s, startBoxes))) {
+        return s->status = SOLVE_UNSOLVABLE;
+    }
+
+    /* Root node, box cells are already in ascending order within each type */
+    boxKey = 0;
+    for (c = 0; c < s->numBoxes; c++) {
+        boxKey ^= TYPED_BOX(startBoxes[c], s->boxType[c]);
+    }
+    player = CELL_INDEX(board, board->playerX, board->playerY);
+    for (c = 0; c < s->numBoxes; c++) {
+        s->occupied[startBoxes[c]] = 1;
+    }
+    solved = IsSolved(s, startBoxes);
+    player = FloodPlayer(s, player, s->reach);
+    for (c = 0; c < s->numBoxes; c++) {
+        s->occupied[startBoxes[c]] = 0;
+    }
+
+    h = Heuristic(s, startBoxes);
+    if (!solved && h == INFINITE) {
+        return s->status = SOLVE_UNSOLVABLE;
+    }
+    s->root = NewNode(s, startBoxes, boxKey, -1, player, 0, h, 0, 0);
+    if (s->root < 0) {
+        return s->status = SOLVE_LIMIT;
+    }
+    TTStore(&s->table, boxKey ^ ZOBRIST_PLAYER(player), s->root, 0xFFFF);
+
+    if (solved) {
+        s->goal = s->root;
+        s->bestCost = 0;
+        return s->status = SOLVE_FOUND;
+    }
+    s->rootKnown = KnownFind(s, boxKey ^ ZOBRIST_PLAYER(player), startBoxes, player);
+    if (s->rootKnown >= 0) {
+        s->goal = s->root;
+        s->goalKnown = s->rootKnown;
+        s->bestCost = s->known[s->rootKnown].remaining;
+        return s->status = SOLVE_FOUND;
+    }
+    if (!HeapPush(s, &s->open, s->root)) {
+        return s->status = SOLVE_LIMIT;
+    }
+    return s->status = SOLVE_RUNNING;
+}
+
+/* Search on from where the last call stopped. stop(arg) is asked every
+   few expansions and may be NULL. Counters add up in result, which the
+   caller clears before the first call */
+int SolverRun(Solver *s, SolverStopProc stop, void *stopArg, SolveResult *result)
+{
+    if (s->status != SOLVE_RUNNING) {
+        return s->status;
+    }
+    s->status = Search(s, stop, stopArg, result);
+    if (s->status == SOLVE_FOUND) {
+        result->pushes = s->bestCost;
+
+        /* Worth keeping only when there is room for the whole path */
+        if (!s->known) {
+            s->known = (KnownState *)malloc(MAX_KNOWN * sizeof(KnownState));
+            s->knownBoxes = (unsigned short *)malloc((long)MAX_KNOWN * s->numBoxes *
+                                                     sizeof(unsigned short));
+            if (s->known && s->knownBoxes && !TTInit(&s->knownTable, KNOWN_TABLE_MB)) {
+                free(s->known);
+                s->known = NULL;
+            }
+        }
+        if (s->known && s->knownBoxes) {
+            RememberSolution(s);
+        }
+    }
+    result->status = s->status;
+    result->ttHits = s->table.hits;
+    result->ttMisses = s->table.misses;
+    result->ttCollisions = s->table.collisions;
+    result->ttReplaced = s->table.replaced;
+    return s->status;
+}
+
+/* First push of the solution found, returns 0 if there is none */
+int SolverFirstPush(Solver *s, int *boxCell, int *dir, int *pushesLeft)
+{
+    int n;
+
+    if (s->status != SOLVE_FOUND || s->bestCost == 0) {
+        return 0;
+    }
+    if (s->goal == s->root) {
+        *boxCell = s->known[s->rootKnown].pushFrom;
+        *dir = s->known[s->rootKnown].pushDir & 3;
+    } else {
+        for (n = s->goal; s->nodes[n].parent != s->root; n = s->nodes[n].parent)
+            ;
+        *boxCell = s->nodes[n].pushFrom;
+        *dir = s->nodes[n].pushDir & 3;
+    }
+    *pushesLeft = s->bestCost;
+    return 1;
+}
+
+/* First push along the path into a known state if one was reached,
+   otherwise towards the open node with the lowest bound. Returns 0 if
+   the root has not been expanded yet */
+int SolverBestPush(Solver *s, int *boxCell, int *dir, int *bound)
+{
+    int n;
+
+    if (s->status != SOLVE_RUNNING || s->open.size == 0) {
+        return 0;
+    }
+    n = s->goal >= 0 ? s->goal : s->open.entries[0].node;
+    *bound = OPEN_MIN_F(&s->open);
+    if (n == s->root) {
+        return 0;
+    }
+    for (; s->nodes[n].parent != s->root; n = s->nodes[n].parent)
+        ;
+    *boxCell = s->nodes[n].pushFrom;
+    *dir = s->nodes[n].pushDir & 3;
+    return 1;
+}
+
+/* Bidirectional search: A* pushing from the start towards the goal and
+   A* pulling from the goal back towards the start, expanding whichever
+   side has the smaller open list. Backward nodes carry PULLED in pushDir
+   and pushFrom is the box cell before the pull. A state one side stores
+   that the other side already has is a meeting, and the cheapest is
+   optimal once no open node on either side can beat it */
+
+/* Pulls needed to bring a box from each cell back to start, ignoring other boxes */
+static void ComputeStartDistance(Solver *s, int start, unsigned short *dist)
+{
+    int head = 0, tail = 0, c, d, to;
+
+    for (c = 0; c < s->numCells; c++) {
+        dist[c] = INFINITE;
+    }
+
+    dist[start] = 0;
+    s->queue[tail++] = (unsigned short)start;
+
+    while (head < tail) {
+        c = s->queue[head++];
+        for (d = 0; d < 4; d++) {
+            /* Pushed from c to the next cell by a player behind it */
+            to = s->next[c][d];
+            if (to < 0 || dist[to] != INFINITE || s->next[c][(d + 2) & 3] < 0) {
+                continue;
+            }
+            dist[to] = (unsigned short)(dist[c] + 1);
+            s->queue[tail++] = (unsigned short)to;
+        }
+    }
+}
+
+/* A state stored by one side, pulled is PULLED for the backward side */
+static int SideFind(Solver *s, ZobristKey key, const unsigned short *boxes, int player,
+                    int pulled)
+{
+    int n = TableFind(s, pulled ? key ^ BACKWARD_KEY : key, boxes, player);
+
+    if (n >= 0 && (s->nodes[n].pushDir & PULLED) != pulled) {
+        return -1;
+    }
+    return n;
+}
+
+/* Add the child in s->childBoxes to one side unless that side has it as
+   cheap already, then look for it on the other side. Returns 0 out of room */
+static int AddSideChild(Solver *s, int pulled, ZobristKey boxKey, int parent, int player,
+                        int g, int h, int from, int dir, SolveResult *result)
+{
+    ZobristKey key = boxKey ^ ZOBRIST_PLAYER(player);
+    int child, other;
+
+    child = SideFind(s, key, s->childBoxes, player, pulled);
+    if (child >= 0) {
+        if (s->nodes[child].g <= g) {
+            return 1;
+        }
+        s->nodes[child].stale = 1;
+    }
+
+    child = NewNode(s, s->childBoxes, boxKey, parent, player, g, h, from, dir | pulled);
+    if (child < 0 || !HeapPush(s, pulled ? &s->backOpen : &s->open, child)) {
+        return 0;
+    }
+    result->generated++;
+    if (pulled) {
+        result->backwardStates++;
+    } else {
+        result->forwardStates++;
+    }
+    TTStore(&s->table, pulled ? key ^ BACKWARD_KEY : key, child, (unsigned short)(0xFFFF - g));
+
+    other = SideFind(s, key, s->childBoxes, player, pulled ^ PULLED);
+    if (other >= 0 && g + s->nodes[other].g < s->bestCost) {
+        s->bestCost = g + s->nodes[other].g;
+        s->goal = pulled ? other : child;
+        s->meet = pulled ? child : other;
+    }
+    return 1;
+}
+
+/* Every push from a forward node, returns 0 out of room */
+static int ExpandForward(Solver *s, int node, SolveResult *result)
+{
+    int i, d, b, from, to, h, player, g, ok = 1;
+    unsigned long expandStamp;
+    unsigned short *boxes = s->parentBoxes;
+    ZobristKey boxKey;
+
+    memcpy(boxes, s->boxes + (long)node * s->numBoxes, s->numBoxes * sizeof(unsigned short));
+    boxKey = s->nodes[node].boxKey;
+    g = s->nodes[node].g + 1;
+    for (i = 0; i < s->numBoxes; i++) {
+        s->occupied[boxes[i]] = 1;
+        SET_BIT(s->board.boxes, boxes[i]);
+    }
+    FloodPlayer(s, s->nodes[node].player, s->reach);
+    expandStamp = s->stamp;
+    Heuristic(s, boxes);
+
+    for (i = 0; i < s->numBoxes && ok; i++) {
+        b = boxes[i];
+        for (d = 0; d < 4 && ok; d++) {
+            from = s->next[b][(d + 2) & 3];
+            to = s->next[b][d];
+            if (from < 0 || to < 0 || s->reach[from] != expandStamp || s->occupied[to] ||
+                TEST_BIT(s->board.dead, to)) {
+                continue;
+            }
+            MoveChildBox(s, boxes, i, to);
+            h = ChildMatching(s, s->goalDist, i, to);
+            if (h == INFINITE || g + h >= s->bestCost) {
+                continue;
+            }
+
+            s->occupied[b] = 0;
+            s->occupied[to] = 1;
+            player = FloodPlayer(s, b, s->childReach);
+            s->occupied[to] = 0;
+            s->occupied[b] = 1;
+            if (PushDeadlocked(s, b, to, result)) {
+                continue;
+            }
+
+            ok = AddSideChild(s, 0, boxKey ^ TYPED_BOX(b, s->boxType[i]) ^
+                              TYPED_BOX(to, s->boxType[i]), node, player, g, h, b, d, result);
+        }
+    }
+
+    for (i = 0; i < s->numBoxes; i++) {
+        s->occupied[boxes[i]] = 0;
+        CLEAR_BIT(s->board.boxes, boxes[i]);
+    }
+    return ok;
+}
+
+/* Every pull from a backward node: the player next to a box steps away
+   from it, taking the box along. Returns 0 out of room */
+static int ExpandBackward(Solver *s, int node, SolveResult *result)
+{
+    int i, d, b, to, behind, h, player, g, ok = 1;
+    unsigned long expandStamp;
+    unsigned short *boxes = s->parentBoxes;
+    ZobristKey boxKey;
+
+    memcpy(boxes, s->boxes + (long)node * s->numBoxes, s->numBoxes * sizeof(unsigned short));
+    boxKey = s->nodes[node].boxKey;
+    g = s->nodes[node].g + 1;
+    for (i = 0; i < s->numBoxes; i++) {
+        s->occupied[boxes[i]] = 1;
+    }
+    FloodPlayer(s, s->nodes[node].player, s->reach);
+    expandStamp = s->stamp;
+    Matching(s, s->startDist, boxes);
+
+    for (i = 0; i < s->numBoxes && ok; i++) {
+        b = boxes[i];
+        for (d = 0; d < 4 && ok; d++) {
+            to = s->next[b][d];
+            if (to < 0 || s->reach[to] != expandStamp) {
+                continue;
+            }
+            behind = s->next[to][d];
+            if (behind < 0 || s->occupied[behind]) {
+                continue;
+            }
+            MoveChildBox(s, boxes, i, to);
+            h = ChildMatching(s, s->startDist, i, to);
+            if (h == INFINITE || g + h >= s->bestCost) {
+                continue;
+            }
+
+            s->occupied[b] = 0;
+            s->occupied[to] = 1;
+            player = FloodPlayer(s, behind, s->childReach);
+            s->occupied[to] = 0;
+            s->occupied[b] = 1;
+
+            ok = AddSideChild(s, PULLED, boxKey ^ TYPED_BOX(b, s->boxType[i]) ^
+                              TYPED_BOX(to, s->boxType[i]), node, player, g, h, b, d, result);
+        }
+    }
+
+    for (i = 0; i < s->numBoxes; i++) {
+        s->occupied[boxes[i]] = 0;
+    }
+    return ok;
+}
+
+/* Backward roots: every box on a goal, one per region the player can end
+   the level in next to a box it could pull */
+static int StartBackward(Solver *s, SolveResult *result)
+{
+    unsigned char seen[MAX_CELLS];
+    int i, c, d, n, b, h, player, pullable, ok = 1;
+    ZobristKey boxKey = 0;
+
+    for (i = 0; i < s->numBoxes; i++) {
+        ComputeStartDistance(s, s->boxes[i], s->startDist[i]);
+    }
+    h = Matching(s, s->startDist, s->goals);
+    if (h == INFINITE) {
+        return 1;
+    }
+
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < s->numGoals; i++) {
+        s->occupied[s->goals[i]] = 1;
+        boxKey ^= ZOBRIST_BOX(s->goals[i]);
+    }
+    for (c = 0; c < s->numCells && ok; c++) {
+        if (seen[c] || s->occupied[c] || TEST_BIT(s->board.walls, c)) {
+            continue;
+        }
+        player = FloodPlayer(s, c, s->childReach);
+        for (n = c; n < s->numCells; n++) {
+            if (s->childReach[n] == s->stamp) {
+                seen[n] = 1;
+            }
+        }
+
+        pullable = 0;
+        for (i = 0; i < s->numGoals && !pullable; i++) {
+            b = s->goals[i];
+            for (d = 0; d < 4; d++) {
+                n = s->next[b][d];
+                if (n >= 0 && s->childReach[n] == s->stamp && s->next[n][d] >= 0 &&
+                    !s->occupied[s->next[n][d]]) {
+                    pullable = 1;
+                }
+            }
+        }
+        if (pullable) {
+            memcpy(s->childBoxes, s->goals, s->numBoxes * sizeof(unsigned short));
+            ok = AddSideChild(s, PULLED, boxKey, -1, player, 0, h, 0, 0, result);
+        }
+    }
+    for (i = 0; i < s->numGoals; i++) {
+        s->occupied[s->goals[i]] = 0;
+    }
+    return ok;
+}
+
+/* Run both sides from the root SolverStart made until they meet for good */
+static int BiSearch(Solver *s, SolveResult *result)
+{
+    int node, pulled;
+
+    s->bestCost = INFINITE;
+    s->goal = s->meet = -1;
+    s->backOpen.size = 0;
+    result->forwardStates = 1;
+    if (!StartBackward(s, result)) {
+        return SOLVE_LIMIT;
+    }
+
+    while (s->open.size > 0 && s->backOpen.size > 0) {
+        /* Any cheaper path still has an open node on each side */
+        if (s->bestCost <= OPEN_MIN_F(&s->open) || s->bestCost <= OPEN_MIN_F(&s->backOpen)) {
+            break;
+        }
+
+        pulled = s->backOpen.size < s->open.size ? PULLED : 0;
+        node = HeapPop(pulled ? &s->backOpen : &s->open);
+        if (s->nodes[node].stale || s->nodes[node].g + s->nodes[node].h >= s->bestCost) {
+            continue;
+        }
+        result->nodes++;
+        if (pulled) {
+            result->backwardNodes++;
+        } else {
+            result->forwardNodes++;
+        }
+        if (!(pulled ? ExpandBackward(s, node, result) : ExpandForward(s, node, result))) {
+            return SOLVE_LIMIT;
+        }
+    }
+
+    return s->bestCost < INFINITE ? SOLVE_FOUND : SOLVE_UNSOLVABLE;
+}
+
+/* The forward pushes to the meeting, then the backward pulls undone */
+static void BuildMeeting(Solver *s, int playerStart, SolveResult *result)
+{
+    int forward = s->nodes[s->goal].g, pushes = s->bestCost;
+    unsigned short *from;
+    unsigned char *dir;
+    int i, n, d;
+
+    from = (unsigned short *)malloc((pushes + 1) * sizeof(unsigned short));
+    dir = (unsigned char *)malloc(pushes + 1);
+    if (from && dir) {
+        for (i = forward, n = s->goal; n > 0; n = s->nodes[n].parent) {
+            from[--i] = s->nodes[n].pushFrom;
+            dir[i] = s->nodes[n].pushDir;
+        }
+
+        /* A pull from b towards d is a push back from the cell it went to */
+        for (i = forward, n = s->meet; s->nodes[n].parent >= 0; n = s->nodes[n].parent, i++) {
+            d = s->nodes[n].pushDir & 3;
+            from[i] = (unsigned short)s->next[s->nodes[n].pushFrom][d];
+            dir[i] = (unsigned char)((d + 2) & 3);
+        }
+        result->steps = pushes;
+        BuildPushes(s, from, dir, pushes, pushes, playerStart, result);
+    }
+    free(from);
+    free(dir);
+}
+
+/* Node storage, open lists and table in megabytes, split by side */
+static void ReportMemory(Solver *s, SolveResult *result)
+{
+    double nodeBytes = sizeof(SolverNode) + s->numBoxes * sizeof(unsigned short);
+    double megabyte = 1024.0 * 1024.0;
+
+    if (result->backwardStates == 0) {
+        result->forwardNodes = result->nodes;
+        result->forwardStates = s->numNodes;
+    }
+    result->forwardMegabytes = (result->forwardStates * nodeBytes +
+                                s->open.capacity * (double)sizeof(HeapEntry)) / megabyte;
+    result->backwardMegabytes = (result->backwardStates * nodeBytes +
+                                 s->backOpen.capacity * (double)sizeof(HeapEntry)) / megabyte;
+    result->peakMegabytes = (s->nodeCapacity * nodeBytes +
+                             (s->open.capacity + s->backOpen.capacity) * (double)sizeof(HeapEntry) +
+                             s->table.numBuckets * (double)(TT_BUCKET * sizeof(TTEntry))) / megabyte;
+}
+
+/* Solve the level on board, options may be NULL for defaults */
+int SolveLevel(const Board *board, const SolveOptions *options, SolveResult *result)
+{
+    Solver *s;
+    clock_t startTime = clock();
+    int bidirectional;
+
+    memset(result, 0, sizeof(SolveResult));
+    result->status = SOLVE_UNSOLVABLE;
+
+    s = CreateSolver(board, options);
+    if (!s) {
+        result->status = SOLVE_LIMIT;
+        return result->status;
+    }
+
+    /* Pulling back from the goal needs a box for every target, and any
+       box may end on any of them */
+    bidirectional = options && options->bidirectional && s->numBoxes == s->numGoals && !s->typed;
+    if (bidirectional) {
+        s->startDist = (unsigned short (*)[MAX_CELLS])malloc(s->numBoxes *
+                                                              sizeof(*s->startDist));
+        if (!s->startDist) {
+            FreeSolver(s);
+            result->status = SOLVE_LIMIT;
+            return result->status;
+        }
+    }
+
+    if (SolverStart(s, board) == SOLVE_RUNNING) {
+        if (bidirectional) {
+            s->status = BiSearch(s, result);
+        } else {
+            SolverRun(s, NULL, NULL, result);
+        }
+    }
+    result->status = s->status;
+    if (s->status == SOLVE_FOUND) {
+        result->pushes = s->bestCost;
+        if (s->goal == s->root && s->meet < 0) {
+            result->solution = (char *)calloc(1, 1);
+        } else if (s->meet >= 0) {
+            BuildMeeting(s, CELL_INDEX(board, board->playerX, board->playerY), result);
+        } else {
+            BuildSolution(s, s->goal, CELL_INDEX(board, board->playerX, board->playerY), result);
+        }
+    }
+    ReportMemory(s, result);
+
+    result->ttHits = s->table.hits;
+    result->ttMisses = s->table.misses;
+    result->ttCollisions = s->table.collisions;
+    result->ttReplaced = s->table.replaced;
+    FreeSolver(s);
+
+    result->seconds = (double)(clock() - startTime) / CLOCKS_PER_SEC;
+    return result->status;
+}
+
+/* Release the solution string */
+void FreeSolveResult(SolveResult *result)
+{
+    free(result->solution);
+    result->solution = NULL;
+}
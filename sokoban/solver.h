@@ -0,0 +1,100 @@
+/* Sokoban solver
+   A* over push states, push-optimal, or pushes from the start and
+   pulls from the goal meeting in the middle. Bounded below by the
+   cheapest assignment of boxes to targets
+   Public Domain          */
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "board.h"
+#include "hash.h"
+#include "deadpat.h"
+
+/* Solver outcome */
+#define SOLVE_UNSOLVABLE 0
+#define SOLVE_FOUND      1
+#define SOLVE_LIMIT      2
+#define SOLVE_RUNNING    3  /* Stopped early, SolverRun carries on */
+
+typedef struct {
+    int status;         /* SOLVE_UNSOLVABLE, SOLVE_FOUND or SOLVE_LIMIT */
+    int pushes;         /* Optimal number of pushes */
+    int moves;          /* Player steps including pushes */
+    long nodes;         /* States expanded */
+    long generated;     /* States created */
+    long frozen;        /* Pushes cut as freeze deadlocks */
+    long patternCuts;   /* Pushes cut by the deadlock pattern table */
+    long macros;        /* States created by a macro move */
+    int steps;          /* Moves on the solution found, a macro move counting one */
+    double seconds;     /* Time to solve */
+    char *solution;     /* LURD string, uppercase letters are pushes */
+    unsigned long ttHits, ttMisses, ttCollisions, ttReplaced;
+    long forwardNodes, backwardNodes;     /* Expanded by each side */
+    long forwardStates, backwardStates;   /* Stored by each side */
+    double forwardMegabytes, backwardMegabytes;  /* Their nodes and open lists */
+    double peakMegabytes;                 /* All nodes, open lists and the table */
+} SolveResult;
+
+typedef struct {
+    long maxNodes;      /* Give up after this many states */
+    int tableMegabytes; /* Transposition table size */
+    int freezeCheck;    /* Cut pushes that freeze a box off target */
+    int bidirectional;  /* Pull back from the goal too, levels with a box per target */
+    const PatternTable *patterns;  /* Deadlock windows to cut pushes with, or NULL */
+
+    /* Push a box along a tunnel to its end, and one through the door of
+       a goal room on to the room's next target, as one move. Far fewer
+       states on levels of corridors and rooms, the pushes found are
+       optimal for those moves, which is not always optimal overall.
+       Pushing from the start only, not bidirectional */
+    int macros;
+
+    /* Typed boxes, as RISCoban's chips: the type, 0 to 254, of the box
+       and of the target on each cell. With both set a box only counts on
+       a target of its own type and the search is never bidirectional.
+       SolverStart reads boxTypes again for the boxes it starts from, so
+       a caller playing on keeps it in step with the board */
+    const unsigned char *boxTypes;
+    const unsigned char *goalTypes;
+} SolveOptions;
+
+/* Fill in the default limits */
+void InitSolveOptions(SolveOptions *options);
+
+/* Solve the level on board, options may be NULL for defaults */
+int SolveLevel(const Board *board, const SolveOptions *options, SolveResult *result);
+
+/* Release the solution string */
+void FreeSolveResult(SolveResult *result);
+
+/* Incremental use, as the hint engine does: one solver per level keeps
+   its precomputed tables, storage and every solution it has found, so a
+   later search from a position on an earlier solution is answered at
+   once and one near it stops as soon as it reaches that solution */
+typedef struct Solver Solver;
+
+/* Return nonzero to pause the search */
+typedef int (*SolverStopProc)(void *arg);
+
+/* Prepare to search the level on board, NULL if it is too big */
+Solver *CreateSolver(const Board *board, const SolveOptions *options);
+void FreeSolver(Solver *s);
+
+/* Start a new search from the boxes and player on board, returns
+   SOLVE_RUNNING or the outcome if the start decides it */
+int SolverStart(Solver *s, const Board *board);
+
+/* Search on until the outcome is known or stop asks to pause, which
+   returns SOLVE_RUNNING */
+int SolverRun(Solver *s, SolverStopProc stop, void *stopArg, SolveResult *result);
+
+/* First push of the solution found: the box cell, its direction in LURD
+   order and the optimal pushes left. Returns 0 if there is none */
+int SolverFirstPush(Solver *s, int *boxCell, int *dir, int *pushesLeft);
+
+/* While paused, the first push towards the most promising position so
+   far and a lower bound on the pushes left. Returns 0 if there is none
+   yet */
+int SolverBestPush(Solver *s, int *boxCell, int *dir, int *bound);
+
+#endif /* SOLVER_H */
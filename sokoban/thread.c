@@ -0,0 +1,169 @@
+/* Sokoban threads
+   Just enough of Win32 threads or pthreads for the tools and hints
+   Public Domain          */
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#include "thread.h"
+
+/* The OS entry point takes its own signature, proc and arg ride along */
+typedef struct {
+    ThreadProc proc;
+    void *arg;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI ThreadMain(LPVOID param)
+#else
+static void *ThreadMain(void *param)
+#endif
+{
+    ThreadStart start = *(ThreadStart *)param;
+
+    free(param);
+    start.proc(start.arg);
+    return 0;
+}
+
+/* Run proc(arg) on a new thread, returns 0 on failure */
+int StartThread(Thread *t, ThreadProc proc, void *arg)
+{
+    ThreadStart *start = (ThreadStart *)malloc(sizeof(ThreadStart));
+#ifdef _WIN32
+    DWORD id;
+#else
+    pthread_t *thread;
+#endif
+
+    t->handle = NULL;
+    if (!start)
+        return 0;
+    start->proc = proc;
+    start->arg = arg;
+
+#ifdef _WIN32
+    t->handle = (void *)CreateThread(NULL, 0, ThreadMain, start, 0, &id);
+#else
+    thread = (pthread_t *)malloc(sizeof(pthread_t));
+    if (thread && pthread_create(thread, NULL, ThreadMain, start) == 0) {
+        t->handle = thread;
+    } else {
+        free(thread);
+    }
+#endif
+    if (!t->handle) {
+        free(start);
+        return 0;
+    }
+    return 1;
+}
+
+/* Wait for the thread to finish */
+void JoinThread(Thread *t)
+{
+    if (!t->handle)
+        return;
+#ifdef _WIN32
+    WaitForSingleObject((HANDLE)t->handle, INFINITE);
+    CloseHandle((HANDLE)t->handle);
+#else
+    pthread_join(*(pthread_t *)t->handle, NULL);
+    free(t->handle);
+#endif
+    t->handle = NULL;
+}
+
+int InitMutex(Mutex *m)
+{
+#ifdef _WIN32
+    m->lock = malloc(sizeof(CRITICAL_SECTION));
+    if (!m->lock)
+        return 0;
+    InitializeCriticalSection((CRITICAL_SECTION *)m->lock);
+#else
+    m->lock = malloc(sizeof(pthread_mutex_t));
+    if (!m->lock)
+        return 0;
+    pthread_mutex_init((pthread_mutex_t *)m->lock, NULL);
+#endif
+    return 1;
+}
+
+void FreeMutex(Mutex *m)
+{
+    if (!m->lock)
+        return;
+#ifdef _WIN32
+    DeleteCriticalSection((CRITICAL_SECTION *)m->lock);
+#else
+    pthread_mutex_destroy((pthread_mutex_t *)m->lock);
+#endif
+    free(m->lock);
+    m->lock = NULL;
+}
+
+void LockMutex(Mutex *m)
+{
+#ifdef _WIN32
+    EnterCriticalSection((CRITICAL_SECTION *)m->lock);
+#else
+    pthread_mutex_lock((pthread_mutex_t *)m->lock);
+#endif
+}
+
+void UnlockMutex(Mutex *m)
+{
+#ifdef _WIN32
+    LeaveCriticalSection((CRITICAL_SECTION *)m->lock);
+#else
+    pthread_mutex_unlock((pthread_mutex_t *)m->lock);
+#endif
+}
+
+/* Add to a shared counter, returns the value before */
+long AtomicAdd(volatile long *value, long add)
+{
+#ifdef _WIN32
+    return InterlockedExchangeAdd((LONG volatile *)value, add);
+#else
+    return __sync_fetch_and_add(value, add);
+#endif
+}
+
+/* Processors available to run threads on */
+int CountProcessors(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/* Wall clock seconds from an arbitrary start, clock() is process CPU
+   time on POSIX and adds up every thread */
+double WallSeconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
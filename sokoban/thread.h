@@ -0,0 +1,38 @@
+/* Sokoban threads
+   Just enough of Win32 threads or pthreads for the tools and hints
+   Public Domain          */
+#ifndef THREAD_H
+#define THREAD_H
+
+typedef void (*ThreadProc)(void *arg);
+
+typedef struct {
+    void *handle;
+} Thread;
+
+typedef struct {
+    void *lock;
+} Mutex;
+
+/* Run proc(arg) on a new thread, returns 0 on failure */
+int StartThread(Thread *t, ThreadProc proc, void *arg);
+
+/* Wait for the thread to finish */
+void JoinThread(Thread *t);
+
+int InitMutex(Mutex *m);
+void FreeMutex(Mutex *m);
+void LockMutex(Mutex *m);
+void UnlockMutex(Mutex *m);
+
+/* Add to a shared counter, returns the value before */
+long AtomicAdd(volatile long *value, long add);
+
+/* Processors available to run threads on */
+int CountProcessors(void);
+
+/* Wall clock seconds from an arbitrary start, clock() is process CPU
+   time on POSIX and adds up every thread */
+double WallSeconds(void);
+
+#endif /* THREAD_H */